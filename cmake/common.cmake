@@ -44,6 +44,7 @@ include(CMakeDependentOption)
 option(DV_SHARED "Динамическая версия (а не статическая)" FALSE)
 option(DV_LOGGING "Логирование" TRUE)
 option(DV_THREADING "Многопоточность" TRUE)
+option(DV_AVX2 "Инструкции SSE4.1, AVX2 и FMA (процессоры Haswell и новее)" FALSE)
 option(DV_URHO2D "2D-графика" TRUE)
 option(DV_NETWORK "Сеть" TRUE)
 option(DV_FILEWATCHER "Filewatcher" TRUE)
@@ -4,18 +4,73 @@
 
 #include "allocator.h"
 
+#include <atomic>
 #include <cassert>
+#include <mutex>
 
 #include "../common/debug_new.h"
 
 namespace dviglo
 {
 
+/// Container allocation count of one thread. Only the owning thread changes it, so counting needs no atomic read-modify-write.
+/// The counters of the running threads are kept in a linked list, so that they can be summed.
+struct ThreadAllocationCounter
+{
+    /// Construct and add to the list.
+    ThreadAllocationCounter();
+    /// Add the count to the count of the exited threads and remove from the list.
+    ~ThreadAllocationCounter();
+
+    /// Number of allocations.
+    std::atomic<i64> count_{0};
+    /// Previous counter in the list.
+    ThreadAllocationCounter* prev_{};
+    /// Next counter in the list.
+    ThreadAllocationCounter* next_{};
+};
+
+/// Return the mutex guarding the counter list.
+static std::mutex& GetCounterMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+/// First counter in the list.
+static ThreadAllocationCounter* firstCounter = nullptr;
+/// Number of allocations made by the exited threads.
+static i64 numExitedThreadAllocations = 0;
+
+ThreadAllocationCounter::ThreadAllocationCounter()
+{
+    std::scoped_lock lock(GetCounterMutex());
+    next_ = firstCounter;
+    if (next_)
+        next_->prev_ = this;
+    firstCounter = this;
+}
+
+ThreadAllocationCounter::~ThreadAllocationCounter()
+{
+    std::scoped_lock lock(GetCounterMutex());
+    numExitedThreadAllocations += count_.load(std::memory_order_relaxed);
+    if (prev_)
+        prev_->next_ = next_;
+    else
+        firstCounter = next_;
+    if (next_)
+        next_->prev_ = prev_;
+}
+
+static thread_local ThreadAllocationCounter threadCounter;
+
 static AllocatorBlock* AllocatorReserveBlock(AllocatorBlock* allocator, i32 nodeSize, i32 capacity)
 {
     assert(nodeSize > 0 && capacity > 0);
 
     u8* blockPtr = new u8[sizeof(AllocatorBlock) + capacity * (sizeof(AllocatorNode) + nodeSize)];
+    CountContainerAllocation();
     AllocatorBlock* newBlock = reinterpret_cast<AllocatorBlock*>(blockPtr);
     newBlock->nodeSize_ = nodeSize;
     newBlock->capacity_ = capacity;
@@ -104,4 +159,18 @@ void AllocatorFree(AllocatorBlock* allocator, void* ptr)
     allocator->free_ = node;
 }
 
+void CountContainerAllocation()
+{
+    threadCounter.count_.store(threadCounter.count_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+i64 GetNumContainerAllocations()
+{
+    std::scoped_lock lock(GetCounterMutex());
+    i64 count = numExitedThreadAllocations;
+    for (ThreadAllocationCounter* counter = firstCounter; counter; counter = counter->next_)
+        count += counter->count_.load(std::memory_order_relaxed);
+    return count;
+}
+
 }
@@ -56,6 +56,12 @@ DV_API void* AllocatorReserve(AllocatorBlock* allocator);
 /// Free a node. Does not free any blocks.
 DV_API void AllocatorFree(AllocatorBlock* allocator, void* ptr);
 
+/// Count a heap allocation made by a container. Called internally.
+DV_API void CountContainerAllocation();
+
+/// Return number of heap allocations made by the containers since the program start. The counts are kept per thread and summed here.
+DV_API i64 GetNumContainerAllocations();
+
 /// %Allocator template class. Allocates objects of a specific class.
 template <class T> class Allocator
 {
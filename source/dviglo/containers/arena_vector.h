@@ -0,0 +1,239 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "allocator.h"
+#include "frame_arena.h"
+
+namespace dviglo
+{
+
+/// %Vector for trivially copyable temporaries that takes its memory from a frame arena. Memory from the arena is never freed
+/// individually, so the vector must not be used after the arena has been reset. Without an arena the memory comes from the heap.
+template <class T> class ArenaVector
+{
+    static_assert(std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value,
+        "ArenaVector requires a trivially copyable type");
+
+public:
+    using ValueType = T;
+    using Iterator = RandomAccessIterator<T>;
+    using ConstIterator = RandomAccessConstIterator<T>;
+
+    /// Construct empty, allocating from the heap.
+    ArenaVector() noexcept = default;
+
+    /// Construct empty, allocating from an arena.
+    explicit ArenaVector(FrameArena* arena) noexcept :
+        arena_(arena)
+    {
+    }
+
+    /// Copy-construct from another vector. Allocates from the same arena.
+    ArenaVector(const ArenaVector<T>& rhs) :
+        arena_(rhs.arena_)
+    {
+        *this = rhs;
+    }
+
+    /// Move-construct from another vector.
+    ArenaVector(ArenaVector<T>&& rhs) noexcept
+    {
+        Swap(rhs);
+    }
+
+    /// Destruct.
+    ~ArenaVector()
+    {
+        if (!arena_)
+            delete[] reinterpret_cast<u8*>(buffer_);
+    }
+
+    /// Assign from another vector. Keeps the own arena.
+    ArenaVector<T>& operator =(const ArenaVector<T>& rhs)
+    {
+        if (&rhs != this)
+        {
+            Resize(rhs.size_);
+            if (size_)
+                memcpy(buffer_, rhs.buffer_, size_ * sizeof(T));
+        }
+
+        return *this;
+    }
+
+    /// Move-assign from another vector.
+    ArenaVector<T>& operator =(ArenaVector<T>&& rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Return element at index.
+    T& operator [](i32 index)
+    {
+        assert(index >= 0 && index < size_);
+        return buffer_[index];
+    }
+
+    /// Return const element at index.
+    const T& operator [](i32 index) const
+    {
+        assert(index >= 0 && index < size_);
+        return buffer_[index];
+    }
+
+    /// Set the arena to allocate from, or null to allocate from the heap. Clears the vector and releases its memory.
+    void SetArena(FrameArena* arena)
+    {
+        if (!arena_)
+            delete[] reinterpret_cast<u8*>(buffer_);
+
+        buffer_ = nullptr;
+        size_ = 0;
+        capacity_ = 0;
+        arena_ = arena;
+    }
+
+    /// Add an element at the end.
+    void Push(const T& value)
+    {
+        if (size_ == capacity_)
+            Grow(size_ + 1);
+
+        buffer_[size_++] = value;
+    }
+
+    /// Remove the last element.
+    void Pop()
+    {
+        assert(size_);
+        --size_;
+    }
+
+    /// Resize the vector. New elements are left uninitialized.
+    void Resize(i32 newSize)
+    {
+        assert(newSize >= 0);
+
+        if (newSize > capacity_)
+            Grow(newSize);
+
+        size_ = newSize;
+    }
+
+    /// Set new capacity. Never shrinks.
+    void Reserve(i32 newCapacity)
+    {
+        if (newCapacity > capacity_)
+            Reallocate(newCapacity);
+    }
+
+    /// Clear the vector. Keeps the memory.
+    void Clear() { size_ = 0; }
+
+    /// Swap with another vector.
+    void Swap(ArenaVector<T>& rhs)
+    {
+        std::swap(buffer_, rhs.buffer_);
+        std::swap(size_, rhs.size_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(arena_, rhs.arena_);
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(buffer_); }
+
+    /// Return const iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(buffer_); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(buffer_ + size_); }
+
+    /// Return const iterator to the end.
+    ConstIterator End() const { return ConstIterator(buffer_ + size_); }
+
+    /// Return first element.
+    T& Front()
+    {
+        assert(size_);
+        return buffer_[0];
+    }
+
+    /// Return last element.
+    T& Back()
+    {
+        assert(size_);
+        return buffer_[size_ - 1];
+    }
+
+    /// Return number of elements.
+    i32 Size() const { return size_; }
+
+    /// Return capacity.
+    i32 Capacity() const { return capacity_; }
+
+    /// Return whether vector is empty.
+    bool Empty() const { return size_ == 0; }
+
+    /// Return the buffer.
+    T* Buffer() const { return buffer_; }
+
+    /// Return the arena, or null if allocating from the heap.
+    FrameArena* GetArena() const { return arena_; }
+
+private:
+    /// Grow the capacity to hold at least the given number of elements.
+    void Grow(i32 minCapacity)
+    {
+        i32 newCapacity = capacity_ ? capacity_ * 2 : 8;
+        while (newCapacity < minCapacity)
+            newCapacity *= 2;
+
+        Reallocate(newCapacity);
+    }
+
+    /// Move the elements to a new buffer. The old buffer is left to the arena.
+    void Reallocate(i32 newCapacity)
+    {
+        T* newBuffer;
+        if (arena_)
+            newBuffer = arena_->Allocate<T>(newCapacity);
+        else
+        {
+            CountContainerAllocation();
+            newBuffer = reinterpret_cast<T*>(new u8[newCapacity * sizeof(T)]);
+        }
+
+        if (size_)
+            memcpy(newBuffer, buffer_, size_ * sizeof(T));
+
+        if (!arena_)
+            delete[] reinterpret_cast<u8*>(buffer_);
+
+        buffer_ = newBuffer;
+        capacity_ = newCapacity;
+    }
+
+    /// Buffer.
+    T* buffer_{};
+    /// Number of elements.
+    i32 size_{};
+    /// Buffer capacity.
+    i32 capacity_{};
+    /// Arena to allocate from, or null.
+    FrameArena* arena_{};
+};
+
+template <class T> typename dviglo::ArenaVector<T>::ConstIterator begin(const dviglo::ArenaVector<T>& v) { return v.Begin(); }
+
+template <class T> typename dviglo::ArenaVector<T>::ConstIterator end(const dviglo::ArenaVector<T>& v) { return v.End(); }
+
+template <class T> typename dviglo::ArenaVector<T>::Iterator begin(dviglo::ArenaVector<T>& v) { return v.Begin(); }
+
+template <class T> typename dviglo::ArenaVector<T>::Iterator end(dviglo::ArenaVector<T>& v) { return v.End(); }
+
+}
@@ -0,0 +1,137 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "allocator.h"
+#include "flat_hash_base.h"
+
+#include <cassert>
+#include <cstring>
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+i32 FlatHashBase::FindPositionSlot(hash32 hash, i32 position) const
+{
+    i32 slot = FindSlot(hash, [position](i32 other) { return other == position; });
+    assert(slot >= 0);
+    return slot;
+}
+
+void FlatHashBase::InsertPosition(hash32 hash, i32 position)
+{
+    assert(numSlots_ > 0);
+
+    const u32 groupMask = (u32)(numSlots_ / GROUP_SIZE - 1);
+    u32 group = (hash >> 7) & groupMask;
+
+    // The load factor guarantees a free slot, so the loop always terminates
+    for (u32 probe = 1;; ++probe)
+    {
+        const i32 groupStart = (i32)group * GROUP_SIZE;
+        u32 mask = MatchFree(ctrl_ + groupStart);
+        if (mask)
+        {
+            i32 slot = groupStart + LowestBit(mask);
+            if (ctrl_[slot] == CTRL_DELETED)
+                --numDeleted_;
+            ctrl_[slot] = ControlByte(hash);
+            slots_[slot] = position;
+            return;
+        }
+
+        group = (group + probe) & groupMask;
+    }
+}
+
+void FlatHashBase::EraseSlot(i32 slot)
+{
+    // If the group still has an empty slot, no probe sequence has passed through it, so the slot can become empty too
+    const u8* group = ctrl_ + slot / GROUP_SIZE * GROUP_SIZE;
+    if (MatchByte(group, CTRL_EMPTY))
+        ctrl_[slot] = CTRL_EMPTY;
+    else
+    {
+        ctrl_[slot] = CTRL_DELETED;
+        ++numDeleted_;
+    }
+}
+
+void FlatHashBase::MoveLastPosition(i32 position)
+{
+    i32 last = size_ - 1;
+    assert(position >= 0 && position < last);
+
+    slots_[FindPositionSlot(hashes_[last], last)] = position;
+    hashes_[position] = hashes_[last];
+}
+
+void FlatHashBase::AllocateIndex(i32 numSlots)
+{
+    assert(numSlots >= GROUP_SIZE && (numSlots & (numSlots - 1)) == 0);
+
+    delete[] ctrl_;
+    delete[] slots_;
+    ctrl_ = new u8[numSlots];
+    slots_ = new i32[numSlots];
+    numSlots_ = numSlots;
+
+    // Keep at least 1/8 of the slots empty so that unsuccessful lookups end early
+    capacity_ = numSlots - numSlots / 8;
+    assert(size_ <= capacity_);
+
+    hash32* hashes = new hash32[capacity_];
+    if (size_)
+        memcpy(hashes, hashes_, size_ * sizeof(hash32));
+    delete[] hashes_;
+    hashes_ = hashes;
+
+    CountContainerAllocation();
+    RebuildIndex();
+}
+
+void FlatHashBase::RebuildIndex()
+{
+    if (!numSlots_)
+        return;
+
+    memset(ctrl_, CTRL_EMPTY, numSlots_);
+    numDeleted_ = 0;
+
+    for (i32 i = 0; i < size_; ++i)
+        InsertPosition(hashes_[i], i);
+}
+
+void FlatHashBase::ResetIndex()
+{
+    if (numSlots_)
+        memset(ctrl_, CTRL_EMPTY, numSlots_);
+
+    size_ = 0;
+    numDeleted_ = 0;
+}
+
+void FlatHashBase::FreeIndex()
+{
+    delete[] ctrl_;
+    delete[] slots_;
+    delete[] hashes_;
+    ctrl_ = nullptr;
+    slots_ = nullptr;
+    hashes_ = nullptr;
+    numSlots_ = 0;
+    size_ = 0;
+    capacity_ = 0;
+    numDeleted_ = 0;
+}
+
+i32 FlatHashBase::SlotsForCapacity(i32 capacity)
+{
+    i32 numSlots = MIN_SLOTS;
+    while (numSlots - numSlots / 8 < capacity)
+        numSlots <<= 1;
+    return numSlots;
+}
+
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "../common/config.h"
+
+#include "hash.h"
+
+#include <emmintrin.h>
+#include <utility>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dviglo
+{
+
+/// Flat hash set/map base class. Keeps the open-addressing index which maps hashes to positions in the contiguous element array of the derived container.
+/** The index consists of control bytes and element positions. Control bytes are probed in groups of 16 with SSE2:
+    a full slot stores 7 bits of the hash, so that usually only one key comparison is needed per lookup.
+    Note that to prevent extra memory use due to vtable pointer, %FlatHashBase intentionally does not declare a virtual destructor
+    and therefore %FlatHashBase pointers should never be used.
+  */
+class DV_API FlatHashBase
+{
+public:
+    /// Number of control bytes probed at once.
+    static inline constexpr i32 GROUP_SIZE = 16;
+
+    /// Initial amount of index slots.
+    static inline constexpr i32 MIN_SLOTS = 16;
+
+    /// Construct. Does not allocate.
+    FlatHashBase() :
+        ctrl_(nullptr),
+        slots_(nullptr),
+        hashes_(nullptr),
+        numSlots_(0),
+        size_(0),
+        capacity_(0),
+        numDeleted_(0)
+    {
+    }
+
+    /// Swap with another flat hash set or map.
+    void Swap(FlatHashBase& rhs)
+    {
+        std::swap(ctrl_, rhs.ctrl_);
+        std::swap(slots_, rhs.slots_);
+        std::swap(hashes_, rhs.hashes_);
+        std::swap(numSlots_, rhs.numSlots_);
+        std::swap(size_, rhs.size_);
+        std::swap(capacity_, rhs.capacity_);
+        std::swap(numDeleted_, rhs.numDeleted_);
+    }
+
+    /// Return number of elements.
+    i32 Size() const { return size_; }
+
+    /// Return number of elements that fit without reallocation.
+    i32 Capacity() const { return capacity_; }
+
+    /// Return number of index slots.
+    i32 NumSlots() const { return numSlots_; }
+
+    /// Return whether has no elements.
+    bool Empty() const { return size_ == 0; }
+
+protected:
+    /// Control byte of a slot that has never been used. Probing stops at a group that contains one.
+    static inline constexpr u8 CTRL_EMPTY = 0x80;
+    /// Control byte of a slot whose element has been erased. Probing continues past it.
+    static inline constexpr u8 CTRL_DELETED = 0xfe;
+
+    /// Scramble the bits of a key hash. Pointer and integer hashes are often sequential, which would cluster in the index.
+    static hash32 MixHash(hash32 hash)
+    {
+        hash ^= hash >> 16;
+        hash *= 0x85ebca6bu;
+        hash ^= hash >> 13;
+        hash *= 0xc2b2ae35u;
+        hash ^= hash >> 16;
+        return hash;
+    }
+
+    /// Return the 7 hash bits stored in the control byte.
+    static u8 ControlByte(hash32 hash) { return (u8)(hash & 0x7fu); }
+
+    /// Return bit mask of the control bytes in a group that are equal to a value.
+    static u32 MatchByte(const u8* group, u8 value)
+    {
+        __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8((char)value)));
+    }
+
+    /// Return bit mask of the empty or deleted slots in a group. Only those have the high bit set.
+    static u32 MatchFree(const u8* group)
+    {
+        return (u32)_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+    }
+
+    /// Return index of the lowest set bit. The mask must not be zero.
+    static i32 LowestBit(u32 mask)
+    {
+#ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return (i32)index;
+#else
+        return __builtin_ctz(mask);
+#endif
+    }
+
+    /// Return the slot of the element for which the predicate returns true, or -1 if not found. The predicate receives the element position.
+    template <class Equal> i32 FindSlot(hash32 hash, const Equal& equal) const
+    {
+        if (!numSlots_)
+            return -1;
+
+        const u32 groupMask = (u32)(numSlots_ / GROUP_SIZE - 1);
+        const u8 value = ControlByte(hash);
+        u32 group = (hash >> 7) & groupMask;
+
+        // Triangular probing visits every group when the group count is a power of two
+        for (u32 probe = 1; probe <= groupMask + 1; ++probe)
+        {
+            const i32 groupStart = (i32)group * GROUP_SIZE;
+            const u8* ctrl = ctrl_ + groupStart;
+
+            for (u32 mask = MatchByte(ctrl, value); mask; mask &= mask - 1)
+            {
+                i32 slot = groupStart + LowestBit(mask);
+                if (equal(slots_[slot]))
+                    return slot;
+            }
+
+            // An empty slot means the key was never placed further along the probe sequence
+            if (MatchByte(ctrl, CTRL_EMPTY))
+                return -1;
+
+            group = (group + probe) & groupMask;
+        }
+
+        return -1;
+    }
+
+    /// Return the slot that refers to an element position. The element must exist.
+    i32 FindPositionSlot(hash32 hash, i32 position) const;
+    /// Add an element position to the index. The element hash must already be stored.
+    void InsertPosition(hash32 hash, i32 position);
+    /// Mark a slot as free.
+    void EraseSlot(i32 slot);
+    /// Point the index and the hash array to a new position of the last element after the derived class has moved it to fill a hole.
+    void MoveLastPosition(i32 position);
+    /// Resize the index and the hash array. The slot count must be a power of two and fit the current elements.
+    void AllocateIndex(i32 numSlots);
+    /// Rebuild the index from the hash array, removing deleted slots.
+    void RebuildIndex();
+    /// Mark all slots empty and set size to zero. Keeps the allocation.
+    void ResetIndex();
+    /// Free the index and the hash array.
+    void FreeIndex();
+    /// Return slot count needed to hold a number of elements.
+    static i32 SlotsForCapacity(i32 capacity);
+
+    /// Control bytes, one per slot.
+    u8* ctrl_;
+    /// Element positions, one per slot.
+    i32* slots_;
+    /// Mixed key hashes, one per element in the same order as the elements.
+    hash32* hashes_;
+    /// Number of index slots. Zero or a power of two not less than GROUP_SIZE.
+    i32 numSlots_;
+    /// Number of elements.
+    i32 size_;
+    /// Maximum number of elements before the index grows.
+    i32 capacity_;
+    /// Number of deleted slots.
+    i32 numDeleted_;
+};
+
+}
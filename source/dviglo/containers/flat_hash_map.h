@@ -0,0 +1,580 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "flat_hash_base.h"
+#include "allocator.h"
+#include "pair.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <new>
+
+namespace dviglo
+{
+
+/// Open-addressing hash map template class. Has the same interface as HashMap, but stores the pairs contiguously.
+/** Iteration is a linear walk over an array, and lookup usually touches one group of control bytes and one pair.
+    Unlike HashMap, inserting may move the pairs, so pointers and references to them are invalidated. Erasing moves
+    the last pair into the hole, so the iteration order is the insertion order only until the first erase.
+  */
+template <class T, class U> class FlatHashMap : public FlatHashBase
+{
+public:
+    using KeyType = T;
+    using ValueType = U;
+
+    /// Hash map key-value pair with const key.
+    class KeyValue
+    {
+    public:
+        /// Construct with key and value.
+        KeyValue(const T& first, const U& second) :
+            first_(first),
+            second_(second)
+        {
+        }
+
+        /// Copy-construct.
+        KeyValue(const KeyValue& value) :
+            first_(value.first_),
+            second_(value.second_)
+        {
+        }
+
+        /// Move-construct. The key is copied, as it is const.
+        KeyValue(KeyValue&& value) noexcept :
+            first_(value.first_),
+            second_(std::move(value.second_))
+        {
+        }
+
+        /// Prevent assignment.
+        KeyValue& operator =(const KeyValue& rhs) = delete;
+
+        /// Test for equality with another pair.
+        bool operator ==(const KeyValue& rhs) const { return first_ == rhs.first_ && second_ == rhs.second_; }
+        /// Test for inequality with another pair.
+        bool operator !=(const KeyValue& rhs) const { return first_ != rhs.first_ || second_ != rhs.second_; }
+
+        /// Key.
+        const T first_;
+        /// Value.
+        U second_;
+    };
+
+    /// Hash map iterator.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(nullptr)
+        {
+        }
+
+        /// Construct with a pair pointer.
+        explicit Iterator(KeyValue* ptr) :
+            ptr_(ptr)
+        {
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const Iterator& rhs) const { return ptr_ == rhs.ptr_; }
+        /// Test for inequality with another iterator.
+        bool operator !=(const Iterator& rhs) const { return ptr_ != rhs.ptr_; }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            ++ptr_;
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            ++ptr_;
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        Iterator& operator --()
+        {
+            --ptr_;
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        Iterator operator --(int)
+        {
+            Iterator it = *this;
+            --ptr_;
+            return it;
+        }
+
+        /// Point to the pair.
+        KeyValue* operator ->() const { return ptr_; }
+
+        /// Dereference the pair.
+        KeyValue& operator *() const { return *ptr_; }
+
+        /// Pair pointer.
+        KeyValue* ptr_;
+    };
+
+    /// Hash map const iterator.
+    struct ConstIterator
+    {
+        /// Construct.
+        ConstIterator() :
+            ptr_(nullptr)
+        {
+        }
+
+        /// Construct with a pair pointer.
+        explicit ConstIterator(const KeyValue* ptr) :
+            ptr_(ptr)
+        {
+        }
+
+        /// Construct from a non-const iterator.
+        ConstIterator(const Iterator& rhs) :        // NOLINT(google-explicit-constructor)
+            ptr_(rhs.ptr_)
+        {
+        }
+
+        /// Assign from a non-const iterator.
+        ConstIterator& operator =(const Iterator& rhs)
+        {
+            ptr_ = rhs.ptr_;
+            return *this;
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const ConstIterator& rhs) const { return ptr_ == rhs.ptr_; }
+        /// Test for inequality with another iterator.
+        bool operator !=(const ConstIterator& rhs) const { return ptr_ != rhs.ptr_; }
+
+        /// Preincrement the pointer.
+        ConstIterator& operator ++()
+        {
+            ++ptr_;
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        ConstIterator operator ++(int)
+        {
+            ConstIterator it = *this;
+            ++ptr_;
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        ConstIterator& operator --()
+        {
+            --ptr_;
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        ConstIterator operator --(int)
+        {
+            ConstIterator it = *this;
+            --ptr_;
+            return it;
+        }
+
+        /// Point to the pair.
+        const KeyValue* operator ->() const { return ptr_; }
+
+        /// Dereference the pair.
+        const KeyValue& operator *() const { return *ptr_; }
+
+        /// Pair pointer.
+        const KeyValue* ptr_;
+    };
+
+    /// Construct empty. Does not allocate.
+    FlatHashMap() :
+        pairs_(nullptr)
+    {
+    }
+
+    /// Construct from another hash map.
+    FlatHashMap(const FlatHashMap<T, U>& map) :
+        pairs_(nullptr)
+    {
+        *this = map;
+    }
+
+    /// Move-construct from another hash map.
+    FlatHashMap(FlatHashMap<T, U>&& map) noexcept :
+        pairs_(nullptr)
+    {
+        Swap(map);
+    }
+
+    /// Aggregate initialization constructor.
+    FlatHashMap(const std::initializer_list<Pair<T, U>>& list) :
+        pairs_(nullptr)
+    {
+        Reserve((i32)list.size());
+        for (auto it = list.begin(); it != list.end(); it++)
+            Insert(*it);
+    }
+
+    /// Destruct.
+    ~FlatHashMap()
+    {
+        Clear();
+        FreeIndex();
+        delete[] reinterpret_cast<u8*>(pairs_);
+    }
+
+    /// Assign a hash map.
+    FlatHashMap& operator =(const FlatHashMap<T, U>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Move-assign a hash map.
+    FlatHashMap& operator =(FlatHashMap<T, U>&& rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Add-assign a pair.
+    FlatHashMap& operator +=(const Pair<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash map.
+    FlatHashMap& operator +=(const FlatHashMap<T, U>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash map.
+    bool operator ==(const FlatHashMap<T, U>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (ConstIterator i = Begin(); i != End(); ++i)
+        {
+            ConstIterator j = rhs.Find(i->first_);
+            if (j == rhs.End() || j->second_ != i->second_)
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash map.
+    bool operator !=(const FlatHashMap<T, U>& rhs) const { return !(*this == rhs); }
+
+    /// Index the map. Create a new pair if key not found.
+    U& operator [](const T& key)
+    {
+        hash32 hash = MixHash(MakeHash(key));
+        i32 position = FindPosition(key, hash);
+        if (position < 0)
+            position = InsertPair(key, U(), hash);
+        return pairs_[position].second_;
+    }
+
+    /// Index the map. Return null if key is not found, does not create a new pair.
+    U* operator [](const T& key) const
+    {
+        i32 position = FindPosition(key, MixHash(MakeHash(key)));
+        return position >= 0 ? &pairs_[position].second_ : nullptr;
+    }
+
+    /// Populate the map using variadic template. This handles the base case.
+    FlatHashMap& Populate(const T& key, const U& value)
+    {
+        this->operator [](key) = value;
+        return *this;
+    }
+
+    /// Populate the map using variadic template.
+    template <typename... Args> FlatHashMap& Populate(const T& key, const U& value, const Args&... args)
+    {
+        this->operator [](key) = value;
+        return Populate(args...);
+    }
+
+    /// Insert a pair. Return an iterator to it.
+    Iterator Insert(const Pair<T, U>& pair)
+    {
+        bool exists;
+        return Insert(pair, exists);
+    }
+
+    /// Insert a pair. Return iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const Pair<T, U>& pair, bool& exists)
+    {
+        hash32 hash = MixHash(MakeHash(pair.first_));
+        i32 position = FindPosition(pair.first_, hash);
+        exists = position >= 0;
+
+        // If exists, just change the value
+        if (exists)
+            pairs_[position].second_ = pair.second_;
+        else
+            position = InsertPair(pair.first_, pair.second_, hash);
+
+        return Iterator(pairs_ + position);
+    }
+
+    /// Insert a map.
+    void Insert(const FlatHashMap<T, U>& map)
+    {
+        Reserve(Size() + map.Size());
+        for (ConstIterator it = map.Begin(); it != map.End(); ++it)
+            Insert(MakePair(it->first_, it->second_));
+    }
+
+    /// Insert a pair by iterator. Return iterator to the value.
+    Iterator Insert(const ConstIterator& it) { return Insert(MakePair(it->first_, it->second_)); }
+
+    /// Insert a range by iterators.
+    void Insert(const ConstIterator& start, const ConstIterator& end)
+    {
+        for (ConstIterator it = start; it != end; ++it)
+            Insert(it);
+    }
+
+    /// Erase a pair by key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        hash32 hash = MixHash(MakeHash(key));
+        i32 slot = FindSlot(hash, [this, &key](i32 position) { return pairs_[position].first_ == key; });
+        if (slot < 0)
+            return false;
+
+        ErasePosition(slot, slots_[slot]);
+        return true;
+    }
+
+    /// Erase a pair by iterator. The last pair is moved in its place, so return iterator to the same position.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!it.ptr_ || it.ptr_ < pairs_ || it.ptr_ >= pairs_ + size_)
+            return End();
+
+        i32 position = (i32)(it.ptr_ - pairs_);
+        ErasePosition(FindPositionSlot(hashes_[position], position), position);
+        return Iterator(pairs_ + position);
+    }
+
+    /// Clear the map. Keeps the allocated memory.
+    void Clear()
+    {
+        for (i32 i = 0; i < size_; ++i)
+            pairs_[i].~KeyValue();
+
+        ResetIndex();
+    }
+
+    /// Sort pairs. After sorting the map can be iterated in order until new elements are inserted or erased.
+    void Sort()
+    {
+        if (size_ < 2)
+            return;
+
+        Vector<i32> order(size_);
+        for (i32 i = 0; i < size_; ++i)
+            order[i] = i;
+
+        std::sort(order.Begin(), order.End(), [this](i32 lhs, i32 rhs) { return pairs_[lhs].first_ < pairs_[rhs].first_; });
+
+        // Move the pairs and their hashes to new storage in sorted order
+        KeyValue* pairs = AllocatePairs(capacity_);
+        Vector<hash32> hashes(size_);
+        for (i32 i = 0; i < size_; ++i)
+        {
+            new(pairs + i) KeyValue(std::move(pairs_[order[i]]));
+            pairs_[order[i]].~KeyValue();
+            hashes[i] = hashes_[order[i]];
+        }
+
+        delete[] reinterpret_cast<u8*>(pairs_);
+        pairs_ = pairs;
+        for (i32 i = 0; i < size_; ++i)
+            hashes_[i] = hashes[i];
+
+        RebuildIndex();
+    }
+
+    /// Reserve space for a number of pairs.
+    void Reserve(i32 capacity)
+    {
+        if (capacity > capacity_)
+            Grow(SlotsForCapacity(capacity));
+    }
+
+    /// Return iterator to the pair with key, or end iterator if not found.
+    Iterator Find(const T& key)
+    {
+        i32 position = FindPosition(key, MixHash(MakeHash(key)));
+        return position >= 0 ? Iterator(pairs_ + position) : End();
+    }
+
+    /// Return const iterator to the pair with key, or end iterator if not found.
+    ConstIterator Find(const T& key) const
+    {
+        i32 position = FindPosition(key, MixHash(MakeHash(key)));
+        return position >= 0 ? ConstIterator(pairs_ + position) : End();
+    }
+
+    /// Return whether contains a pair with key.
+    bool Contains(const T& key) const { return FindPosition(key, MixHash(MakeHash(key))) >= 0; }
+
+    /// Try to copy value to output. Return true if was found.
+    bool TryGetValue(const T& key, U& out) const
+    {
+        i32 position = FindPosition(key, MixHash(MakeHash(key)));
+        if (position < 0)
+            return false;
+
+        out = pairs_[position].second_;
+        return true;
+    }
+
+    /// Return all the keys.
+    Vector<T> Keys() const
+    {
+        Vector<T> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->first_);
+        return result;
+    }
+
+    /// Return all the values.
+    Vector<U> Values() const
+    {
+        Vector<U> result;
+        result.Reserve(Size());
+        for (ConstIterator i = Begin(); i != End(); ++i)
+            result.Push(i->second_);
+        return result;
+    }
+
+    /// Swap with another hash map.
+    void Swap(FlatHashMap<T, U>& rhs)
+    {
+        FlatHashBase::Swap(rhs);
+        std::swap(pairs_, rhs.pairs_);
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() { return Iterator(pairs_); }
+
+    /// Return iterator to the beginning.
+    ConstIterator Begin() const { return ConstIterator(pairs_); }
+
+    /// Return iterator to the end.
+    Iterator End() { return Iterator(pairs_ + size_); }
+
+    /// Return iterator to the end.
+    ConstIterator End() const { return ConstIterator(pairs_ + size_); }
+
+    /// Return first pair.
+    const KeyValue& Front() const { return pairs_[0]; }
+
+    /// Return last pair.
+    const KeyValue& Back() const { return pairs_[size_ - 1]; }
+
+private:
+    /// Return position of the pair with key, or -1 if not found.
+    i32 FindPosition(const T& key, hash32 hash) const
+    {
+        i32 slot = FindSlot(hash, [this, &key](i32 position) { return pairs_[position].first_ == key; });
+        return slot >= 0 ? slots_[slot] : -1;
+    }
+
+    /// Append a pair whose key does not exist yet. Return its position.
+    i32 InsertPair(const T& key, const U& value, hash32 hash)
+    {
+        if (size_ == capacity_)
+            Grow(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+        else if (size_ + numDeleted_ >= capacity_)
+            RebuildIndex();
+
+        i32 position = size_;
+        new(pairs_ + position) KeyValue(key, value);
+        hashes_[position] = hash;
+        InsertPosition(hash, position);
+        ++size_;
+        return position;
+    }
+
+    /// Erase the pair at a position and fill the hole with the last pair.
+    void ErasePosition(i32 slot, i32 position)
+    {
+        EraseSlot(slot);
+
+        i32 last = size_ - 1;
+        pairs_[position].~KeyValue();
+        if (position != last)
+        {
+            new(pairs_ + position) KeyValue(std::move(pairs_[last]));
+            pairs_[last].~KeyValue();
+            MoveLastPosition(position);
+        }
+
+        --size_;
+    }
+
+    /// Reallocate the pairs and the index for a new slot count.
+    void Grow(i32 numSlots)
+    {
+        KeyValue* pairs = AllocatePairs(numSlots - numSlots / 8);
+        for (i32 i = 0; i < size_; ++i)
+        {
+            new(pairs + i) KeyValue(std::move(pairs_[i]));
+            pairs_[i].~KeyValue();
+        }
+
+        delete[] reinterpret_cast<u8*>(pairs_);
+        pairs_ = pairs;
+        AllocateIndex(numSlots);
+    }
+
+    /// Allocate uninitialized storage for pairs.
+    static KeyValue* AllocatePairs(i32 capacity)
+    {
+        CountContainerAllocation();
+        return reinterpret_cast<KeyValue*>(new u8[capacity * sizeof(KeyValue)]);
+    }
+
+    /// Pairs in contiguous storage.
+    KeyValue* pairs_;
+};
+
+template <class T, class U> typename dviglo::FlatHashMap<T, U>::ConstIterator begin(const dviglo::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename dviglo::FlatHashMap<T, U>::ConstIterator end(const dviglo::FlatHashMap<T, U>& v) { return v.End(); }
+
+template <class T, class U> typename dviglo::FlatHashMap<T, U>::Iterator begin(dviglo::FlatHashMap<T, U>& v) { return v.Begin(); }
+
+template <class T, class U> typename dviglo::FlatHashMap<T, U>::Iterator end(dviglo::FlatHashMap<T, U>& v) { return v.End(); }
+
+}
@@ -0,0 +1,372 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "flat_hash_base.h"
+#include "allocator.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <cassert>
+#include <initializer_list>
+#include <new>
+
+namespace dviglo
+{
+
+/// Open-addressing hash set template class. Has the same interface as HashSet, but stores the keys contiguously.
+/** Inserting may move the keys, so pointers and references to them are invalidated. Erasing moves the last key
+    into the hole, so the iteration order is the insertion order only until the first erase.
+  */
+template <class T> class FlatHashSet : public FlatHashBase
+{
+public:
+    /// Hash set iterator. Keys can not be modified.
+    struct Iterator
+    {
+        /// Construct.
+        Iterator() :
+            ptr_(nullptr)
+        {
+        }
+
+        /// Construct with a key pointer.
+        explicit Iterator(const T* ptr) :
+            ptr_(ptr)
+        {
+        }
+
+        /// Test for equality with another iterator.
+        bool operator ==(const Iterator& rhs) const { return ptr_ == rhs.ptr_; }
+        /// Test for inequality with another iterator.
+        bool operator !=(const Iterator& rhs) const { return ptr_ != rhs.ptr_; }
+
+        /// Preincrement the pointer.
+        Iterator& operator ++()
+        {
+            ++ptr_;
+            return *this;
+        }
+
+        /// Postincrement the pointer.
+        Iterator operator ++(int)
+        {
+            Iterator it = *this;
+            ++ptr_;
+            return it;
+        }
+
+        /// Predecrement the pointer.
+        Iterator& operator --()
+        {
+            --ptr_;
+            return *this;
+        }
+
+        /// Postdecrement the pointer.
+        Iterator operator --(int)
+        {
+            Iterator it = *this;
+            --ptr_;
+            return it;
+        }
+
+        /// Point to the key.
+        const T* operator ->() const { return ptr_; }
+
+        /// Dereference the key.
+        const T& operator *() const { return *ptr_; }
+
+        /// Key pointer.
+        const T* ptr_;
+    };
+
+    /// Hash set const iterator. Same as the iterator, as keys can not be modified.
+    using ConstIterator = Iterator;
+
+    /// Construct empty. Does not allocate.
+    FlatHashSet() :
+        keys_(nullptr)
+    {
+    }
+
+    /// Construct from another hash set.
+    FlatHashSet(const FlatHashSet<T>& set) :
+        keys_(nullptr)
+    {
+        *this = set;
+    }
+
+    /// Move-construct from another hash set.
+    FlatHashSet(FlatHashSet<T>&& set) noexcept :
+        keys_(nullptr)
+    {
+        Swap(set);
+    }
+
+    /// Aggregate initialization constructor.
+    FlatHashSet(const std::initializer_list<T>& list) :
+        keys_(nullptr)
+    {
+        Reserve((i32)list.size());
+        for (auto it = list.begin(); it != list.end(); it++)
+            Insert(*it);
+    }
+
+    /// Destruct.
+    ~FlatHashSet()
+    {
+        Clear();
+        FreeIndex();
+        delete[] reinterpret_cast<u8*>(keys_);
+    }
+
+    /// Assign a hash set.
+    FlatHashSet& operator =(const FlatHashSet<T>& rhs)
+    {
+        // In case of self-assignment do nothing
+        if (&rhs != this)
+        {
+            Clear();
+            Insert(rhs);
+        }
+        return *this;
+    }
+
+    /// Move-assign a hash set.
+    FlatHashSet& operator =(FlatHashSet<T>&& rhs) noexcept
+    {
+        Swap(rhs);
+        return *this;
+    }
+
+    /// Add-assign a key.
+    FlatHashSet& operator +=(const T& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Add-assign a hash set.
+    FlatHashSet& operator +=(const FlatHashSet<T>& rhs)
+    {
+        Insert(rhs);
+        return *this;
+    }
+
+    /// Test for equality with another hash set.
+    bool operator ==(const FlatHashSet<T>& rhs) const
+    {
+        if (rhs.Size() != Size())
+            return false;
+
+        for (Iterator it = Begin(); it != End(); ++it)
+        {
+            if (!rhs.Contains(*it))
+                return false;
+        }
+
+        return true;
+    }
+
+    /// Test for inequality with another hash set.
+    bool operator !=(const FlatHashSet<T>& rhs) const { return !(*this == rhs); }
+
+    /// Insert a key. Return an iterator to it.
+    Iterator Insert(const T& key)
+    {
+        bool exists;
+        return Insert(key, exists);
+    }
+
+    /// Insert a key. Return iterator and set exists flag according to whether the key already existed.
+    Iterator Insert(const T& key, bool& exists)
+    {
+        hash32 hash = MixHash(MakeHash(key));
+        i32 position = FindPosition(key, hash);
+        exists = position >= 0;
+        if (!exists)
+            position = InsertKey(key, hash);
+
+        return Iterator(keys_ + position);
+    }
+
+    /// Insert a set.
+    void Insert(const FlatHashSet<T>& set)
+    {
+        Reserve(Size() + set.Size());
+        for (Iterator it = set.Begin(); it != set.End(); ++it)
+            Insert(*it);
+    }
+
+    /// Erase a key. Return true if was found.
+    bool Erase(const T& key)
+    {
+        hash32 hash = MixHash(MakeHash(key));
+        i32 slot = FindSlot(hash, [this, &key](i32 position) { return keys_[position] == key; });
+        if (slot < 0)
+            return false;
+
+        ErasePosition(slot, slots_[slot]);
+        return true;
+    }
+
+    /// Erase a key by iterator. The last key is moved in its place, so return iterator to the same position.
+    Iterator Erase(const Iterator& it)
+    {
+        if (!it.ptr_ || it.ptr_ < keys_ || it.ptr_ >= keys_ + size_)
+            return End();
+
+        i32 position = (i32)(it.ptr_ - keys_);
+        ErasePosition(FindPositionSlot(hashes_[position], position), position);
+        return Iterator(keys_ + position);
+    }
+
+    /// Clear the set. Keeps the allocated memory.
+    void Clear()
+    {
+        for (i32 i = 0; i < size_; ++i)
+            (keys_ + i)->~T();
+
+        ResetIndex();
+    }
+
+    /// Sort keys. After sorting the set can be iterated in order until new keys are inserted or erased.
+    void Sort()
+    {
+        if (size_ < 2)
+            return;
+
+        Vector<i32> order(size_);
+        for (i32 i = 0; i < size_; ++i)
+            order[i] = i;
+
+        std::sort(order.Begin(), order.End(), [this](i32 lhs, i32 rhs) { return keys_[lhs] < keys_[rhs]; });
+
+        // Move the keys and their hashes to new storage in sorted order
+        T* keys = AllocateKeys(capacity_);
+        Vector<hash32> hashes(size_);
+        for (i32 i = 0; i < size_; ++i)
+        {
+            new(keys + i) T(std::move(keys_[order[i]]));
+            (keys_ + order[i])->~T();
+            hashes[i] = hashes_[order[i]];
+        }
+
+        delete[] reinterpret_cast<u8*>(keys_);
+        keys_ = keys;
+        for (i32 i = 0; i < size_; ++i)
+            hashes_[i] = hashes[i];
+
+        RebuildIndex();
+    }
+
+    /// Reserve space for a number of keys.
+    void Reserve(i32 capacity)
+    {
+        if (capacity > capacity_)
+            Grow(SlotsForCapacity(capacity));
+    }
+
+    /// Return iterator to the key, or end iterator if not found.
+    Iterator Find(const T& key) const
+    {
+        i32 position = FindPosition(key, MixHash(MakeHash(key)));
+        return position >= 0 ? Iterator(keys_ + position) : End();
+    }
+
+    /// Return whether contains a key.
+    bool Contains(const T& key) const { return FindPosition(key, MixHash(MakeHash(key))) >= 0; }
+
+    /// Swap with another hash set.
+    void Swap(FlatHashSet<T>& rhs)
+    {
+        FlatHashBase::Swap(rhs);
+        std::swap(keys_, rhs.keys_);
+    }
+
+    /// Return iterator to the beginning.
+    Iterator Begin() const { return Iterator(keys_); }
+
+    /// Return iterator to the end.
+    Iterator End() const { return Iterator(keys_ + size_); }
+
+    /// Return first key.
+    const T& Front() const { return keys_[0]; }
+
+    /// Return last key.
+    const T& Back() const { return keys_[size_ - 1]; }
+
+private:
+    /// Return position of the key, or -1 if not found.
+    i32 FindPosition(const T& key, hash32 hash) const
+    {
+        i32 slot = FindSlot(hash, [this, &key](i32 position) { return keys_[position] == key; });
+        return slot >= 0 ? slots_[slot] : -1;
+    }
+
+    /// Append a key that does not exist yet. Return its position.
+    i32 InsertKey(const T& key, hash32 hash)
+    {
+        if (size_ == capacity_)
+            Grow(numSlots_ ? numSlots_ << 1 : MIN_SLOTS);
+        else if (size_ + numDeleted_ >= capacity_)
+            RebuildIndex();
+
+        i32 position = size_;
+        new(keys_ + position) T(key);
+        hashes_[position] = hash;
+        InsertPosition(hash, position);
+        ++size_;
+        return position;
+    }
+
+    /// Erase the key at a position and fill the hole with the last key.
+    void ErasePosition(i32 slot, i32 position)
+    {
+        EraseSlot(slot);
+
+        i32 last = size_ - 1;
+        (keys_ + position)->~T();
+        if (position != last)
+        {
+            new(keys_ + position) T(std::move(keys_[last]));
+            (keys_ + last)->~T();
+            MoveLastPosition(position);
+        }
+
+        --size_;
+    }
+
+    /// Reallocate the keys and the index for a new slot count.
+    void Grow(i32 numSlots)
+    {
+        T* keys = AllocateKeys(numSlots - numSlots / 8);
+        for (i32 i = 0; i < size_; ++i)
+        {
+            new(keys + i) T(std::move(keys_[i]));
+            (keys_ + i)->~T();
+        }
+
+        delete[] reinterpret_cast<u8*>(keys_);
+        keys_ = keys;
+        AllocateIndex(numSlots);
+    }
+
+    /// Allocate uninitialized storage for keys.
+    static T* AllocateKeys(i32 capacity)
+    {
+        CountContainerAllocation();
+        return reinterpret_cast<T*>(new u8[capacity * sizeof(T)]);
+    }
+
+    /// Keys in contiguous storage.
+    T* keys_;
+};
+
+template <class T> typename dviglo::FlatHashSet<T>::Iterator begin(const dviglo::FlatHashSet<T>& v) { return v.Begin(); }
+
+template <class T> typename dviglo::FlatHashSet<T>::Iterator end(const dviglo::FlatHashSet<T>& v) { return v.End(); }
+
+}
@@ -0,0 +1,113 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "allocator.h"
+#include "frame_arena.h"
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+FrameArena::FrameArena(i32 blockSize) :
+    blockSize_(blockSize)
+{
+    assert(blockSize > 0);
+}
+
+FrameArena::FrameArena(FrameArena&& rhs) noexcept :
+    blockSize_(rhs.blockSize_),
+    offset_(rhs.offset_),
+    usedSize_(rhs.usedSize_),
+    capacity_(rhs.capacity_)
+{
+    blocks_.Swap(rhs.blocks_);
+    rhs.offset_ = 0;
+    rhs.usedSize_ = 0;
+    rhs.capacity_ = 0;
+}
+
+FrameArena::~FrameArena()
+{
+    FreeBlocks();
+}
+
+FrameArena& FrameArena::operator =(FrameArena&& rhs) noexcept
+{
+    if (&rhs != this)
+    {
+        FreeBlocks();
+        blocks_.Swap(rhs.blocks_);
+        blockSize_ = rhs.blockSize_;
+        offset_ = rhs.offset_;
+        usedSize_ = rhs.usedSize_;
+        capacity_ = rhs.capacity_;
+        rhs.offset_ = 0;
+        rhs.usedSize_ = 0;
+        rhs.capacity_ = 0;
+    }
+
+    return *this;
+}
+
+void* FrameArena::Allocate(i32 size, i32 alignment)
+{
+    assert(size >= 0);
+    assert(alignment > 0 && !(alignment & (alignment - 1)));
+
+    i32 start = blocks_.Empty() ? 0 : AlignOffset(offset_, alignment);
+    if (blocks_.Empty() || start + size > blockSize_)
+    {
+        AllocateBlock(size + alignment - 1);
+        start = AlignOffset(0, alignment);
+    }
+
+    usedSize_ += start + size - offset_;
+    offset_ = start + size;
+    return blocks_.Back() + start;
+}
+
+void FrameArena::Reset()
+{
+    if (blocks_.Size() > 1)
+    {
+        i32 size = capacity_;
+        FreeBlocks();
+        AllocateBlock(size);
+    }
+
+    offset_ = 0;
+    usedSize_ = 0;
+}
+
+void FrameArena::AllocateBlock(i32 minSize)
+{
+    // Double the block size each time, so that a frame needs only a few blocks even if the first one is much too small
+    if (!blocks_.Empty())
+        blockSize_ *= 2;
+    while (blockSize_ < minSize)
+        blockSize_ *= 2;
+
+    blocks_.Push(new u8[blockSize_]);
+    CountContainerAllocation();
+    capacity_ += blockSize_;
+    offset_ = 0;
+}
+
+i32 FrameArena::AlignOffset(i32 offset, i32 alignment) const
+{
+    uintptr_t block = reinterpret_cast<uintptr_t>(blocks_.Back());
+    uintptr_t aligned = (block + offset + alignment - 1) & ~(uintptr_t)(alignment - 1);
+    return (i32)(aligned - block);
+}
+
+void FrameArena::FreeBlocks()
+{
+    for (u8* block : blocks_)
+        delete[] block;
+
+    blocks_.Clear();
+    capacity_ = 0;
+}
+
+}
@@ -0,0 +1,76 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "vector.h"
+
+namespace dviglo
+{
+
+/// Default size of the first frame arena block in bytes.
+inline constexpr i32 FRAME_ARENA_DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+/// Default alignment of frame arena allocations.
+inline constexpr i32 FRAME_ARENA_DEFAULT_ALIGNMENT = 16;
+
+/// Linear allocator for temporary data that lives until the end of a frame. Allocating only moves an offset forward,
+/// and the memory is freed all at once by Reset(). Not thread-safe, so each thread should use its own arena.
+class DV_API FrameArena
+{
+public:
+    /// Construct with the size of the first block.
+    explicit FrameArena(i32 blockSize = FRAME_ARENA_DEFAULT_BLOCK_SIZE);
+    /// Move-construct from another arena.
+    FrameArena(FrameArena&& rhs) noexcept;
+    /// Destruct. Frees all blocks.
+    ~FrameArena();
+
+    /// Prevent copy construction.
+    FrameArena(const FrameArena& rhs) = delete;
+    /// Prevent copy assignment.
+    FrameArena& operator =(const FrameArena& rhs) = delete;
+    /// Move-assign from another arena.
+    FrameArena& operator =(FrameArena&& rhs) noexcept;
+
+    /// Allocate memory. Alignment must be a power of two.
+    void* Allocate(i32 size, i32 alignment = FRAME_ARENA_DEFAULT_ALIGNMENT);
+
+    /// Allocate memory for an array of objects. The objects are not constructed.
+    template <class T> T* Allocate(i32 count) { return static_cast<T*>(Allocate(count * (i32)sizeof(T), (i32)alignof(T))); }
+
+    /// Free all allocations. If the data did not fit in one block, the blocks are replaced with one block large enough for all of it.
+    void Reset();
+
+    /// Return number of bytes allocated since the last reset, including the alignment padding.
+    i32 GetUsedSize() const { return usedSize_; }
+
+    /// Return total size of the blocks in bytes.
+    i32 GetCapacity() const { return capacity_; }
+
+    /// Return number of blocks.
+    i32 GetNumBlocks() const { return blocks_.Size(); }
+
+private:
+    /// Allocate a new block that can hold at least the given number of bytes.
+    void AllocateBlock(i32 minSize);
+    /// Return the offset in the last block aligned up to the given alignment.
+    i32 AlignOffset(i32 offset, i32 alignment) const;
+    /// Free all blocks.
+    void FreeBlocks();
+
+    /// Memory blocks. Allocations are made from the last block.
+    Vector<u8*> blocks_;
+    /// Size of the last block.
+    i32 blockSize_;
+    /// Offset of the free space in the last block.
+    i32 offset_{};
+    /// Bytes allocated since the last reset.
+    i32 usedSize_{};
+    /// Total size of the blocks.
+    i32 capacity_{};
+};
+
+}
@@ -2,6 +2,7 @@
 // Copyright (c) 2022-2023 the Dviglo project
 // License: MIT
 
+#include "allocator.h"
 #include "hash_base.h"
 
 #include <cassert>
@@ -18,6 +19,7 @@ void HashBase::AllocateBuckets(i32 size, i32 numBuckets)
     delete[] ptrs_;
 
     HashNodeBase** ptrs = new HashNodeBase* [numBuckets + 2];
+    CountContainerAllocation();
     i32* data = reinterpret_cast<i32*>(ptrs);
     data[0] = size;
     data[1] = numBuckets;
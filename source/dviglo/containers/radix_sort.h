@@ -0,0 +1,70 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "vector.h"
+
+#include <utility>
+
+namespace dviglo
+{
+
+/// Value with a 64-bit sort key for RadixSort().
+template <class T> struct RadixSortItem
+{
+    /// Sort key.
+    u64 key_;
+    /// Value.
+    T value_;
+};
+
+/// Sort items by their keys with a stable least significant digit radix sort, 8 bits per pass. Passes in which all keys
+/// have the same digit are skipped. The temporary vector is resized as needed and can be kept between calls to avoid allocations.
+template <class T> void RadixSort(Vector<RadixSortItem<T>>& items, Vector<RadixSortItem<T>>& temp)
+{
+    i32 size = items.Size();
+    if (size < 2)
+        return;
+
+    temp.Resize(size);
+
+    // Count the digits of all passes at once
+    i32 counts[8][256] = {};
+    for (const RadixSortItem<T>& item : items)
+    {
+        for (i32 pass = 0; pass < 8; ++pass)
+            ++counts[pass][(item.key_ >> (pass * 8)) & 0xffu];
+    }
+
+    RadixSortItem<T>* src = &items[0];
+    RadixSortItem<T>* dest = &temp[0];
+    bool swapped = false;
+
+    for (i32 pass = 0; pass < 8; ++pass)
+    {
+        i32 shift = pass * 8;
+        i32* offsets = counts[pass];
+        if (offsets[(src[0].key_ >> shift) & 0xffu] == size)
+            continue;
+
+        i32 offset = 0;
+        for (i32 i = 0; i < 256; ++i)
+        {
+            i32 count = offsets[i];
+            offsets[i] = offset;
+            offset += count;
+        }
+
+        for (i32 i = 0; i < size; ++i)
+            dest[offsets[(src[i].key_ >> shift) & 0xffu]++] = src[i];
+
+        std::swap(src, dest);
+        swapped = !swapped;
+    }
+
+    if (swapped)
+        items.Swap(temp);
+}
+
+}
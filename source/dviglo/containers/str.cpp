@@ -2,6 +2,7 @@
 // Copyright (c) 2022-2023 the Dviglo project
 // License: MIT
 
+#include "allocator.h"
 #include "../io/log.h"
 
 #include <cstdio>
@@ -399,6 +400,7 @@ void String::Resize(i32 newLength)
         assert(capacity > SHORT_STRING_CAPACITY);
 
         char* newBuffer = new char[capacity];
+        CountContainerAllocation();
 
         // Move the existing data to the new buffer
         i32 oldLength = Length();
@@ -447,6 +449,7 @@ void String::Reserve(i32 newCapacity)
     if (newCapacity > SHORT_STRING_CAPACITY) // New buffer in heap
     {
         char* newBuffer = new char[newCapacity];
+        CountContainerAllocation();
 
         // Move the existing data to the new buffer
         CopyChars(newBuffer, GetBuffer(), length + 1);
@@ -2,6 +2,7 @@
 // Copyright (c) 2022-2023 the Dviglo project
 // License: MIT
 
+#include "allocator.h"
 #include "vector_base.h"
 
 #include "../common/debug_new.h"
@@ -11,6 +12,7 @@ namespace dviglo
 
 u8* VectorBase::AllocateBuffer(i32 size)
 {
+    CountContainerAllocation();
     return new u8[size];
 }
 
@@ -0,0 +1,71 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "attribute.h"
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+AttributeQuantization AttributeQuantization::Range(float min, float max, float precision)
+{
+    AttributeQuantization ret;
+    ret.mode_ = QM_RANGE;
+    ret.min_ = Min(min, max);
+    ret.max_ = Max(min, max);
+
+    // Quantization step is at most twice the precision, so rounding error is at most the precision
+    double numSteps = (ret.max_ - ret.min_) / (2.0 * Max(precision, M_EPSILON)) + 1.0;
+    ret.bits_ = Clamp(CeilToInt(log2(numSteps)), 1, 32);
+    return ret;
+}
+
+AttributeQuantization AttributeQuantization::SmallestThree(i32 numBits)
+{
+    AttributeQuantization ret;
+    ret.mode_ = QM_SMALLEST_THREE;
+    ret.bits_ = Clamp(numBits, 2, 32);
+    return ret;
+}
+
+bool AttributeQuantization::IsSupported(VariantType type) const
+{
+    switch (mode_)
+    {
+    case QM_RANGE:
+        return type == VAR_FLOAT || type == VAR_VECTOR2 || type == VAR_VECTOR3 || type == VAR_VECTOR4;
+
+    case QM_SMALLEST_THREE:
+        return type == VAR_QUATERNION;
+
+    default:
+        return false;
+    }
+}
+
+i32 AttributeQuantization::GetNumBits(VariantType type) const
+{
+    switch (type)
+    {
+    case VAR_FLOAT:
+        return bits_;
+
+    case VAR_VECTOR2:
+        return bits_ * 2;
+
+    case VAR_VECTOR3:
+        return bits_ * 3;
+
+    case VAR_VECTOR4:
+        return bits_ * 4;
+
+    case VAR_QUATERNION:
+        return 2 + bits_ * 3;
+
+    default:
+        return 0;
+    }
+}
+
+}
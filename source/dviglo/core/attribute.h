@@ -38,7 +38,9 @@ enum AttributeMode
 };
 DV_FLAGSET(AttributeMode, AttributeModeFlags);
 
+class Deserializer;
 class Serializable;
+class Serializer;
 
 /// Abstract base class for invoking attribute accessors.
 class DV_API AttributeAccessor : public RefCounted
@@ -48,6 +50,61 @@ public:
     virtual void Get(const Serializable* ptr, Variant& dest) const = 0;
     /// Set the attribute.
     virtual void Set(Serializable* ptr, const Variant& src) = 0;
+
+    /// Return whether the accessor knows the value type at compile time and implements Write(), Read() and Equals().
+    virtual bool IsTyped() const { return false; }
+    /// Write the attribute in Serializer::WriteVariantData() format without a Variant. Return true if successful.
+    virtual bool Write(const Serializable* ptr, Serializer& dest) const { return false; }
+    /// Read the attribute written by Write() and set it without a Variant.
+    virtual void Read(Serializable* ptr, Deserializer& source) { }
+    /// Return whether the attribute is equal to the value without a Variant. Return false if types differ.
+    virtual bool Equals(const Serializable* ptr, const Variant& value) const { return false; }
+};
+
+/// Lossy encoding of an attribute in network replication.
+enum QuantizationMode
+{
+    /// Attribute is written at full precision.
+    QM_NONE = 0,
+    /// Float or vector components are clamped to a range and quantized to a fixed number of bits.
+    QM_RANGE,
+    /// Quaternion is written as the index of its largest component and the other three components quantized to a fixed number of bits.
+    QM_SMALLEST_THREE,
+};
+
+/// Network quantization of a float, vector or quaternion attribute. Quantized attributes are bit-packed in network updates.
+struct DV_API AttributeQuantization
+{
+    /// Construct as no quantization.
+    AttributeQuantization() = default;
+
+    /// Return quantization of float or vector components to a range. The bit count is chosen so that values are reproduced within the precision.
+    static AttributeQuantization Range(float min, float max, float precision);
+    /// Return smallest three quantization of a quaternion with the given number of bits per component.
+    static AttributeQuantization SmallestThree(i32 numBits);
+
+    /// Return whether an attribute of the type can use this quantization.
+    bool IsSupported(VariantType type) const;
+    /// Return number of bits used by a value of the type.
+    i32 GetNumBits(VariantType type) const;
+
+    /// Test for equality with another quantization.
+    bool operator ==(const AttributeQuantization& rhs) const
+    {
+        return mode_ == rhs.mode_ && min_ == rhs.min_ && max_ == rhs.max_ && bits_ == rhs.bits_;
+    }
+
+    /// Test for inequality with another quantization.
+    bool operator !=(const AttributeQuantization& rhs) const { return !(*this == rhs); }
+
+    /// Quantization mode.
+    QuantizationMode mode_ = QM_NONE;
+    /// Range minimum.
+    float min_ = 0.0f;
+    /// Range maximum.
+    float max_ = 0.0f;
+    /// Bits per component.
+    i32 bits_ = 0;
 };
 
 /// Description of an automatically serializable variable.
@@ -94,6 +151,8 @@ struct AttributeInfo
     AttributeModeFlags mode_ = AM_DEFAULT;
     /// Attribute metadata.
     VariantMap metadata_;
+    /// Network quantization.
+    AttributeQuantization quantization_;
     /// Attribute data pointer if elsewhere than in the Serializable.
     void* ptr_ = nullptr;
 };
@@ -121,6 +180,16 @@ public:
             networkAttributeInfo_->metadata_[key] = value;
         return *this;
     }
+
+    /// Set network quantization.
+    AttributeHandle& SetQuantization(const AttributeQuantization& quantization)
+    {
+        if (attributeInfo_)
+            attributeInfo_->quantization_ = quantization;
+        if (networkAttributeInfo_)
+            networkAttributeInfo_->quantization_ = quantization;
+        return *this;
+    }
 };
 
 }
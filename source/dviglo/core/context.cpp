@@ -78,6 +78,21 @@ void RemoveNamedAttribute(HashMap<StringHash, Vector<AttributeInfo>>& attributes
         attributes.Erase(i);
 }
 
+static AttributeInfo* FindNamedAttribute(HashMap<StringHash, Vector<AttributeInfo>>& attributes, StringHash objectType, const char* name)
+{
+    HashMap<StringHash, Vector<AttributeInfo>>::Iterator i = attributes.Find(objectType);
+    if (i == attributes.End())
+        return nullptr;
+
+    for (Vector<AttributeInfo>::Iterator j = i->second_.Begin(); j != i->second_.End(); ++j)
+    {
+        if (!j->name_.Compare(name, true))
+            return &(*j);
+    }
+
+    return nullptr;
+}
+
 #ifdef _DEBUG
 // Проверяем, что не происходит обращения к синглтону после вызова деструктора
 static bool context_destructed = false;
@@ -117,6 +132,14 @@ Context::~Context()
         delete *i;
     eventDataMaps_.Clear();
 
+    for (Vector<VariantMap*>::Iterator i = typedEventDataMaps_.Begin(); i != typedEventDataMaps_.End(); ++i)
+        delete *i;
+    typedEventDataMaps_.Clear();
+
+    for (Vector<FlatHashSet<Object*>*>::Iterator i = processedEventReceivers_.Begin(); i != processedEventReceivers_.End(); ++i)
+        delete *i;
+    processedEventReceivers_.Clear();
+
     // Контекст разрушается после лога, поэтому в лог вывести ничего не можем
 
 #ifdef _DEBUG
@@ -126,7 +149,7 @@ Context::~Context()
 
 SharedPtr<Object> Context::CreateObject(StringHash objectType)
 {
-    HashMap<StringHash, SharedPtr<ObjectFactory>>::ConstIterator i = factories_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory>>::ConstIterator i = factories_.Find(objectType);
     if (i != factories_.End())
         return i->second_->CreateObject();
     else
@@ -211,6 +234,26 @@ void Context::UpdateAttributeDefaultValue(StringHash objectType, const char* nam
         info->defaultValue_ = defaultValue;
 }
 
+void Context::SetAttributeQuantization(StringHash objectType, const char* name, const AttributeQuantization& quantization)
+{
+    AttributeInfo* info = FindNamedAttribute(attributes_, objectType, name);
+    if (!info)
+        return;
+
+    if (quantization.mode_ != QM_NONE && !quantization.IsSupported(info->type_))
+    {
+        DV_LOGWARNING("Attempt to set unsupported network quantization to attribute " + info->name_ + " of type " +
+            Variant::GetTypeName(info->type_));
+        return;
+    }
+
+    info->quantization_ = quantization;
+
+    AttributeInfo* networkInfo = FindNamedAttribute(networkAttributes_, objectType, name);
+    if (networkInfo)
+        networkInfo->quantization_ = quantization;
+}
+
 VariantMap& Context::GetEventDataMap()
 {
     unsigned nestingLevel = eventSenders_.Size();
@@ -222,6 +265,18 @@ VariantMap& Context::GetEventDataMap()
     return ret;
 }
 
+VariantMap& Context::GetTypedEventDataMap()
+{
+    // Called during the send, after the sender has been pushed to the stack
+    unsigned nestingLevel = eventSenders_.Size();
+    while (typedEventDataMaps_.Size() < nestingLevel + 1)
+        typedEventDataMaps_.Push(new VariantMap());
+
+    VariantMap& ret = *typedEventDataMaps_[nestingLevel];
+    ret.Clear();
+    return ret;
+}
+
 void Context::CopyBaseAttributes(StringHash baseType, StringHash derivedType)
 {
     // Prevent endless loop if mistakenly copying attributes from same class as derived
@@ -275,7 +330,7 @@ Object* Context::GetEventSender() const
 const String& Context::GetTypeName(StringHash objectType) const
 {
     // Search factories to find the hash-to-name mapping
-    HashMap<StringHash, SharedPtr<ObjectFactory>>::ConstIterator i = factories_.Find(objectType);
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory>>::ConstIterator i = factories_.Find(objectType);
     return i != factories_.End() ? i->second_->GetTypeName() : String::EMPTY;
 }
 
@@ -354,4 +409,17 @@ void Context::EndSendEvent()
     eventSenders_.Pop();
 }
 
+FlatHashSet<Object*>& Context::GetProcessedEventReceivers()
+{
+    // Called during the send, after the sender has been pushed to the stack
+    unsigned nestingLevel = eventSenders_.Size();
+    while (processedEventReceivers_.Size() < nestingLevel + 1)
+        processedEventReceivers_.Push(new FlatHashSet<Object*>());
+
+    FlatHashSet<Object*>& ret = *processedEventReceivers_[nestingLevel];
+    if (!ret.Empty())
+        ret.Clear();
+    return ret;
+}
+
 }
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include "../containers/flat_hash_map.h"
+#include "../containers/flat_hash_set.h"
 #include "../containers/hash_set.h"
 #include "attribute.h"
 #include "object.h"
@@ -84,8 +86,12 @@ public:
     void RemoveAllAttributes(StringHash objectType);
     /// Update object attribute's default value.
     void UpdateAttributeDefaultValue(StringHash objectType, const char* name, const Variant& defaultValue);
+    /// Set object attribute's network quantization. Must be done identically on the server and the clients before replication starts.
+    void SetAttributeQuantization(StringHash objectType, const char* name, const AttributeQuantization& quantization);
     /// Return a preallocated map for event data. Used for optimization to avoid constant re-allocation of event data maps.
     VariantMap& GetEventDataMap();
+    /// Return a preallocated map for converting the typed payload of the event being sent. Separate from GetEventDataMap() so that nested sends from handlers do not overwrite it.
+    VariantMap& GetTypedEventDataMap();
 
     /// Copy base class attributes to derived class.
     void CopyBaseAttributes(StringHash baseType, StringHash derivedType);
@@ -107,6 +113,8 @@ public:
     template <class T, class U> void CopyBaseAttributes();
     /// Template version of updating an object attribute's default value.
     template <class T> void UpdateAttributeDefaultValue(const char* name, const Variant& defaultValue);
+    /// Template version of setting an object attribute's network quantization.
+    template <class T> void SetAttributeQuantization(const char* name, const AttributeQuantization& quantization);
 
     /// Return subsystem by type.
     Object* GetSubsystem(StringHash type) const;
@@ -124,7 +132,7 @@ public:
     const HashMap<StringHash, SharedPtr<Object>>& GetSubsystems() const { return subsystems_; }
 
     /// Return all object factories.
-    const HashMap<StringHash, SharedPtr<ObjectFactory>>& GetObjectFactories() const { return factories_; }
+    const FlatHashMap<StringHash, SharedPtr<ObjectFactory>>& GetObjectFactories() const { return factories_; }
 
     /// Return all object categories.
     const HashMap<String, Vector<StringHash>>& GetObjectCategories() const { return objectCategories_; }
@@ -177,7 +185,7 @@ public:
     /// Return event receivers for an event type, or null if they do not exist.
     EventReceiverGroup* GetEventReceivers(StringHash eventType)
     {
-        HashMap<StringHash, SharedPtr<EventReceiverGroup>>::Iterator i = eventReceivers_.Find(eventType);
+        FlatHashMap<StringHash, SharedPtr<EventReceiverGroup>>::Iterator i = eventReceivers_.Find(eventType);
         return i != eventReceivers_.End() ? i->second_ : nullptr;
     }
 
@@ -196,26 +204,32 @@ private:
     void BeginSendEvent(Object* sender, StringHash eventType);
     /// End event send. Clean up event receivers removed in the meanwhile.
     void EndSendEvent();
+    /// Return a preallocated set for the receivers already processed by the event being sent. Reused to avoid allocating on every send.
+    FlatHashSet<Object*>& GetProcessedEventReceivers();
 
     /// Set current event handler. Called by Object.
     void SetEventHandler(EventHandler* handler) { eventHandler_ = handler; }
 
     /// Object factories.
-    HashMap<StringHash, SharedPtr<ObjectFactory>> factories_;
+    FlatHashMap<StringHash, SharedPtr<ObjectFactory>> factories_;
     /// Subsystems.
     HashMap<StringHash, SharedPtr<Object>> subsystems_;
-    /// Attribute descriptions per object type.
+    /// Attribute descriptions per object type. Node-based, as the network states keep pointers to the vectors.
     HashMap<StringHash, Vector<AttributeInfo>> attributes_;
     /// Network replication attribute descriptions per object type.
     HashMap<StringHash, Vector<AttributeInfo>> networkAttributes_;
     /// Event receivers for non-specific events.
-    HashMap<StringHash, SharedPtr<EventReceiverGroup>> eventReceivers_;
+    FlatHashMap<StringHash, SharedPtr<EventReceiverGroup>> eventReceivers_;
     /// Event receivers for specific senders' events.
     HashMap<Object*, HashMap<StringHash, SharedPtr<EventReceiverGroup>>> specificEventReceivers_;
     /// Event sender stack.
     Vector<Object*> eventSenders_;
     /// Event data stack.
     Vector<VariantMap*> eventDataMaps_;
+    /// Typed event payload conversion stack.
+    Vector<VariantMap*> typedEventDataMaps_;
+    /// Processed event receivers stack.
+    Vector<FlatHashSet<Object*>*> processedEventReceivers_;
     /// Active event handler. Not stored in a stack for performance reasons; is needed only in esoteric cases.
     EventHandler* eventHandler_;
     /// Object categories.
@@ -257,6 +271,11 @@ template <class T> void Context::UpdateAttributeDefaultValue(const char* name, c
     UpdateAttributeDefaultValue(T::GetTypeStatic(), name, defaultValue);
 }
 
+template <class T> void Context::SetAttributeQuantization(const char* name, const AttributeQuantization& quantization)
+{
+    SetAttributeQuantization(T::GetTypeStatic(), name, quantization);
+}
+
 }
 
 #define DV_CONTEXT (dviglo::Context::get_instance())
@@ -22,24 +22,64 @@ DV_EVENT(E_UPDATE, Update)
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of the frame update events, which carry only the timestep.
+struct TimeStepEventData
+{
+    /// Timestep in seconds.
+    float timeStep_{};
+
+    /// Write to event parameters.
+    void ToVariantMap(VariantMap& eventData) const { eventData[Update::P_TIMESTEP] = timeStep_; }
+    /// Read from event parameters.
+    void FromVariantMap(VariantMap& eventData) { timeStep_ = eventData[Update::P_TIMESTEP].GetFloat(); }
+};
+
+/// Typed payload of E_UPDATE.
+struct UpdateEventData : TimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_UPDATE; }
+};
+
 /// Application-wide logic post-update event.
 DV_EVENT(E_POSTUPDATE, PostUpdate)
 {
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_POSTUPDATE.
+struct PostUpdateEventData : TimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_POSTUPDATE; }
+};
+
 /// Render update event.
 DV_EVENT(E_RENDERUPDATE, RenderUpdate)
 {
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_RENDERUPDATE.
+struct RenderUpdateEventData : TimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_RENDERUPDATE; }
+};
+
 /// Post-render update event.
 DV_EVENT(E_POSTRENDERUPDATE, PostRenderUpdate)
 {
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_POSTRENDERUPDATE.
+struct PostRenderUpdateEventData : TimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_POSTRENDERUPDATE; }
+};
+
 /// Frame end event.
 DV_EVENT(E_ENDFRAME, EndFrame)
 {
@@ -72,38 +72,25 @@ void Object::OnEvent(Object* sender, StringHash eventType, VariantMap& eventData
     if (blockEvents_)
         return;
 
-    EventHandler* specific = nullptr;
-    EventHandler* nonSpecific = nullptr;
-
-    EventHandler* handler = eventHandlers_.First();
-    while (handler)
+    EventHandler* handler = FindInvokedEventHandler(sender, eventType);
+    if (handler)
     {
-        if (handler->GetEventType() == eventType)
-        {
-            if (!handler->GetSender())
-                nonSpecific = handler;
-            else if (handler->GetSender() == sender)
-            {
-                specific = handler;
-                break;
-            }
-        }
-        handler = eventHandlers_.Next(handler);
+        DV_CONTEXT.SetEventHandler(handler);
+        handler->Invoke(eventData);
+        DV_CONTEXT.SetEventHandler(nullptr);
     }
+}
 
-    // Specific event handlers have priority, so if found, invoke first
-    if (specific)
-    {
-        DV_CONTEXT.SetEventHandler(specific);
-        specific->Invoke(eventData);
-        DV_CONTEXT.SetEventHandler(nullptr);
+void Object::OnTypedEvent(Object* sender, StringHash eventType, TypedEventData& eventData)
+{
+    if (blockEvents_)
         return;
-    }
 
-    if (nonSpecific)
+    EventHandler* handler = FindInvokedEventHandler(sender, eventType);
+    if (handler)
     {
-        DV_CONTEXT.SetEventHandler(nonSpecific);
-        nonSpecific->Invoke(eventData);
+        DV_CONTEXT.SetEventHandler(handler);
+        handler->InvokeTyped(eventData);
         DV_CONTEXT.SetEventHandler(nullptr);
     }
 }
@@ -277,6 +264,12 @@ void Object::SendEvent(StringHash eventType)
 }
 
 void Object::SendEvent(StringHash eventType, VariantMap& eventData)
+{
+    TypedEventData typedData(eventData);
+    SendEvent(eventType, typedData);
+}
+
+void Object::SendEvent(StringHash eventType, TypedEventData& eventData)
 {
     if (!Thread::IsMainThread())
     {
@@ -294,12 +287,23 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     DV_PROFILE_STR(eventName.c_str(), eventName.Length());
 #endif
 
+    // Events with a typed payload go through OnTypedEvent(), VariantMap events through the virtual OnEvent()
+    auto deliverEvent = [this, eventType, &eventData](Object* receiver)
+    {
+        if (eventData.HasPayload())
+            receiver->OnTypedEvent(this, eventType, eventData);
+        else
+            receiver->OnEvent(this, eventType, eventData.GetVariantMap());
+    };
+
     // Make a weak pointer to self to check for destruction during event handling
     WeakPtr<Object> self(this);
-    HashSet<Object*> processed;
 
     DV_CONTEXT.BeginSendEvent(this, eventType);
 
+    // Pooled per nesting level, so that sending an event does not allocate
+    FlatHashSet<Object*>& processed = DV_CONTEXT.GetProcessedEventReceivers();
+
     // Check first the specific event receivers
     // Note: group is held alive with a shared ptr, as it may get destroyed along with the sender
     SharedPtr<EventReceiverGroup> group(DV_CONTEXT.GetEventReceivers(this, eventType));
@@ -315,7 +319,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
             if (!receiver)
                 continue;
 
-            receiver->OnEvent(this, eventType, eventData);
+            deliverEvent(receiver);
 
             // If self has been destroyed as a result of event handling, exit
             if (self.Expired())
@@ -346,7 +350,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 if (!receiver)
                     continue;
 
-                receiver->OnEvent(this, eventType, eventData);
+                deliverEvent(receiver);
 
                 if (self.Expired())
                 {
@@ -366,7 +370,7 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
                 if (!receiver || processed.Contains(receiver))
                     continue;
 
-                receiver->OnEvent(this, eventType, eventData);
+                deliverEvent(receiver);
 
                 if (self.Expired())
                 {
@@ -383,6 +387,17 @@ void Object::SendEvent(StringHash eventType, VariantMap& eventData)
     DV_CONTEXT.EndSendEvent();
 }
 
+VariantMap& TypedEventData::GetVariantMap()
+{
+    if (!variantMap_)
+    {
+        variantMap_ = &DV_CONTEXT.GetTypedEventDataMap();
+        toVariantMap_(payload_, *variantMap_);
+    }
+
+    return *variantMap_;
+}
+
 VariantMap& Object::GetEventDataMap() const
 {
     return DV_CONTEXT.GetEventDataMap();
@@ -443,6 +458,26 @@ const String& Object::GetCategory() const
     return String::EMPTY;
 }
 
+EventHandler* Object::FindInvokedEventHandler(Object* sender, StringHash eventType) const
+{
+    EventHandler* nonSpecific = nullptr;
+
+    EventHandler* handler = eventHandlers_.First();
+    while (handler)
+    {
+        if (handler->GetEventType() == eventType)
+        {
+            if (!handler->GetSender())
+                nonSpecific = handler;
+            else if (handler->GetSender() == sender)
+                return handler;
+        }
+        handler = eventHandlers_.Next(handler);
+    }
+
+    return nonSpecific;
+}
+
 EventHandler* Object::FindEventHandler(StringHash eventType, EventHandler** previous) const
 {
     EventHandler* handler = eventHandlers_.First();
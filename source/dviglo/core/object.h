@@ -15,6 +15,7 @@ namespace dviglo
 
 class Context;
 class EventHandler;
+class TypedEventData;
 
 /// Type info.
 class DV_API TypeInfo
@@ -121,6 +122,12 @@ public:
     {
         SendEvent(eventType, GetEventDataMap().Populate(args...));
     }
+    /// Send event with a typed payload to all subscribers. The payload struct defines GetEventType(), ToVariantMap() and FromVariantMap(). No VariantMap is built unless a subscriber uses a VariantMap handler.
+    template <class Data, class = decltype(Data::GetEventType())> void SendEvent(const Data& eventData);
+    /// Subscribe to a typed event that can be sent by any sender. The event type is taken from the payload struct.
+    template <class T, class Data> void SubscribeToEvent(void (T::*function)(const Data&));
+    /// Subscribe to a specific sender's typed event. The event type is taken from the payload struct.
+    template <class T, class Data> void SubscribeToEvent(Object* sender, void (T::*function)(const Data&));
 
     /// Return global variable based on key.
     const Variant& GetGlobalVar(StringHash key) const;
@@ -153,6 +160,12 @@ public:
     bool GetBlockEvents() const { return blockEvents_; }
 
 private:
+    /// Send event to all subscribers. Shared by the VariantMap and typed versions.
+    void SendEvent(StringHash eventType, TypedEventData& eventData);
+    /// Handle event sent with a typed payload.
+    void OnTypedEvent(Object* sender, StringHash eventType, TypedEventData& eventData);
+    /// Find the handler to invoke for an event. Handlers with specific sender have priority.
+    EventHandler* FindInvokedEventHandler(Object* sender, StringHash eventType) const;
     /// Find the first event handler with no specific sender.
     EventHandler* FindEventHandler(StringHash eventType, EventHandler** previous = nullptr) const;
     /// Find the first event handler with specific sender.
@@ -211,6 +224,64 @@ public:
     SharedPtr<Object> CreateObject() override { return SharedPtr<Object>(new T()); }
 };
 
+/// Event parameters during sending: a typed payload, a VariantMap or both. The VariantMap is built from the payload only when a handler asks for it.
+class DV_API TypedEventData
+{
+public:
+    /// Construct with a typed payload.
+    template <class Data> explicit TypedEventData(const Data& payload) :
+        payload_(&payload),
+        payloadType_(GetPayloadType<Data>()),
+        toVariantMap_(&ToVariantMapImpl<Data>),
+        variantMap_(nullptr)
+    {
+    }
+
+    /// Construct with VariantMap parameters.
+    explicit TypedEventData(VariantMap& variantMap) :
+        payload_(nullptr),
+        payloadType_(nullptr),
+        toVariantMap_(nullptr),
+        variantMap_(&variantMap)
+    {
+    }
+
+    /// Return the typed payload, or null if the event was sent with another payload type or as a VariantMap.
+    template <class Data> const Data* GetPayload() const
+    {
+        return payloadType_ == GetPayloadType<Data>() ? static_cast<const Data*>(payload_) : nullptr;
+    }
+
+    /// Return whether the event was sent with a typed payload.
+    bool HasPayload() const { return payload_ != nullptr; }
+
+    /// Return the parameters as a VariantMap. Converts the typed payload on first call.
+    VariantMap& GetVariantMap();
+
+private:
+    /// Return an unique identifier of the payload type.
+    template <class Data> static const void* GetPayloadType()
+    {
+        static const char id = 0;
+        return &id;
+    }
+
+    /// Convert the payload to a VariantMap.
+    template <class Data> static void ToVariantMapImpl(const void* payload, VariantMap& variantMap)
+    {
+        static_cast<const Data*>(payload)->ToVariantMap(variantMap);
+    }
+
+    /// Typed payload.
+    const void* payload_;
+    /// Payload type identifier.
+    const void* payloadType_;
+    /// Payload conversion function.
+    void (*toVariantMap_)(const void*, VariantMap&);
+    /// VariantMap parameters. Null until requested if sent with a typed payload.
+    VariantMap* variantMap_;
+};
+
 /// Internal helper class for invoking event handler functions.
 class DV_API EventHandler : public LinkedListNode
 {
@@ -235,6 +306,8 @@ public:
 
     /// Invoke event handler function.
     virtual void Invoke(VariantMap& eventData) = 0;
+    /// Invoke event handler function for an event sent with a typed payload. By default converts the payload to a VariantMap.
+    virtual void InvokeTyped(TypedEventData& eventData) { Invoke(eventData.GetVariantMap()); }
     /// Return a unique copy of the event handler.
     virtual EventHandler* Clone() const = 0;
 
@@ -294,6 +367,70 @@ private:
     HandlerFunctionPtr function_;
 };
 
+/// Template implementation of the event handler invoke helper (stores a pointer to a function taking a typed payload).
+template <class T, class Data> class TypedEventHandlerImpl : public EventHandler
+{
+public:
+    using HandlerFunctionPtr = void (T::*)(const Data&);
+
+    /// Construct with receiver and function pointers and userdata.
+    TypedEventHandlerImpl(T* receiver, HandlerFunctionPtr function, void* userData = nullptr) :
+        EventHandler(receiver, userData),
+        function_(function)
+    {
+        assert(receiver_);
+        assert(function_);
+    }
+
+    /// Invoke event handler function. Converts the VariantMap parameters to the payload struct.
+    void Invoke(VariantMap& eventData) override
+    {
+        Data payload;
+        payload.FromVariantMap(eventData);
+        auto* receiver = static_cast<T*>(receiver_);
+        (receiver->*function_)(payload);
+    }
+
+    /// Invoke event handler function with the typed payload directly.
+    void InvokeTyped(TypedEventData& eventData) override
+    {
+        const Data* payload = eventData.GetPayload<Data>();
+        if (payload)
+        {
+            auto* receiver = static_cast<T*>(receiver_);
+            (receiver->*function_)(*payload);
+        }
+        else
+            Invoke(eventData.GetVariantMap());
+    }
+
+    /// Return a unique copy of the event handler.
+    EventHandler* Clone() const override
+    {
+        return new TypedEventHandlerImpl(static_cast<T*>(receiver_), function_, userData_);
+    }
+
+private:
+    /// Class-specific pointer to handler function.
+    HandlerFunctionPtr function_;
+};
+
+template <class Data, class> void Object::SendEvent(const Data& eventData)
+{
+    TypedEventData typedData(eventData);
+    SendEvent(Data::GetEventType(), typedData);
+}
+
+template <class T, class Data> void Object::SubscribeToEvent(void (T::*function)(const Data&))
+{
+    SubscribeToEvent(Data::GetEventType(), new TypedEventHandlerImpl<T, Data>(static_cast<T*>(this), function));
+}
+
+template <class T, class Data> void Object::SubscribeToEvent(Object* sender, void (T::*function)(const Data&))
+{
+    SubscribeToEvent(sender, Data::GetEventType(), new TypedEventHandlerImpl<T, Data>(static_cast<T*>(this), function));
+}
+
 /// Template implementation of the event handler invoke helper (std::function instance).
 class EventHandler11Impl : public EventHandler
 {
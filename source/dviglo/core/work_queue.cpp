@@ -14,6 +14,102 @@
 namespace dviglo
 {
 
+/// Insert an item before the first item with lower or equal priority.
+static void InsertByPriority(List<WorkItem*>& list, WorkItem* item)
+{
+    for (List<WorkItem*>::Iterator i = list.Begin(); i != list.End(); ++i)
+    {
+        if ((*i)->priority_ <= item->priority_)
+        {
+            list.Insert(i, item);
+            return;
+        }
+    }
+
+    list.Push(item);
+}
+
+/// Fixed-capacity lock-free deque (Chase-Lev). Only the owner thread pushes and pops at the bottom, any thread can steal from the top.
+class WorkStealingDeque
+{
+public:
+    /// Maximum number of items. Must be a power of two.
+    static constexpr i64 CAPACITY = 1 << 12;
+
+    /// Add an item to the bottom. Return false if the deque is full. Owner thread only.
+    bool Push(WorkItem* item)
+    {
+        i64 bottom = bottom_.load(std::memory_order_relaxed);
+        i64 top = top_.load(std::memory_order_acquire);
+        if (bottom - top >= CAPACITY)
+            return false;
+
+        items_[bottom & (CAPACITY - 1)].store(item, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Take the most recently added item. Return null if empty. Owner thread only.
+    WorkItem* Pop()
+    {
+        i64 bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        i64 top = top_.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        WorkItem* item = items_[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+
+        // Last item: race against thieves
+        if (top == bottom)
+        {
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                item = nullptr;
+
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+
+        return item;
+    }
+
+    /// Take the oldest item. Return null if empty or if lost the race to another thread. Thread-safe.
+    WorkItem* Steal()
+    {
+        i64 top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        i64 bottom = bottom_.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return nullptr;
+
+        WorkItem* item = items_[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+
+        return item;
+    }
+
+    /// Return whether the deque looks empty. The result may be outdated immediately when other threads are stealing.
+    bool Empty() const
+    {
+        return top_.load(std::memory_order_acquire) >= bottom_.load(std::memory_order_acquire);
+    }
+
+private:
+    /// Index of the oldest item. Modified by thieves.
+    alignas(64) std::atomic<i64> top_{0};
+    /// Index after the newest item. Modified by the owner thread.
+    alignas(64) std::atomic<i64> bottom_{0};
+    /// Ring buffer of items.
+    std::atomic<WorkItem*> items_[CAPACITY]{};
+};
+
 /// Worker thread managed by the work queue.
 class WorkerThread : public Thread, public RefCounted
 {
@@ -42,7 +138,12 @@ public:
     /// Return thread index.
     i32 GetIndex() const { return index_; }
 
+    /// Return the work stealing deque.
+    WorkStealingDeque& GetDeque() { return deque_; }
+
 private:
+    /// Work stealing deque owned by this thread. Holds only WI_MAX_PRIORITY items.
+    WorkStealingDeque deque_;
     /// Work queue.
     WorkQueue* owner_;
     /// Thread index.
@@ -65,6 +166,10 @@ WorkQueue& WorkQueue::get_instance()
 }
 
 WorkQueue::WorkQueue() :
+    mainDeque_(new WorkStealingDeque()),
+    numReleasedItems_(0),
+    numMainThreadItems_(0),
+    mode_(WQM_SHARED_QUEUE),
     shutDown_(false),
     pausing_(false),
     paused_(false),
@@ -93,7 +198,7 @@ WorkQueue::~WorkQueue()
 #endif
 }
 
-void WorkQueue::CreateThreads(i32 numThreads)
+void WorkQueue::CreateThreads(i32 numThreads, WorkQueueMode mode)
 {
 #ifdef DV_THREADING
     assert(numThreads >= 0);
@@ -103,15 +208,17 @@ void WorkQueue::CreateThreads(i32 numThreads)
     if (!threads_.Empty())
         return;
 
+    mode_ = mode;
+
     // Start threads in paused mode
     Pause();
 
+    // Worker threads access each other's deques, so create all of them before starting
     for (i32 i = 0; i < numThreads; ++i)
-    {
-        SharedPtr<WorkerThread> thread(new WorkerThread(this, i + 1));
+        threads_.Push(SharedPtr<WorkerThread>(new WorkerThread(this, i + 1)));
+
+    for (const SharedPtr<WorkerThread>& thread : threads_)
         thread->Run();
-        threads_.Push(thread);
-    }
 #else
     DV_LOGERROR("Can not create worker threads as threading is disabled");
 #endif
@@ -150,31 +257,31 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     workItems_.Push(item);
     item->completed_ = false;
 
-    // Make sure worker threads' list is safe to modify
-    if (threads_.Size() && !paused_)
-        queueMutex_.lock();
+    // If predecessors are still pending, the last completed one will queue the item
+    if (--item->numPendingDependencies_ > 0)
+        return;
 
-    // Find position for new item
-    if (queue_.Empty())
-        queue_.Push(item);
-    else
+    if (item->mainThread_)
     {
-        bool inserted = false;
-
-        for (List<WorkItem*>::Iterator i = queue_.Begin(); i != queue_.End(); ++i)
-        {
-            if ((*i)->priority_ <= item->priority_)
-            {
-                queue_.Insert(i, item);
-                inserted = true;
-                break;
-            }
-        }
+        ReleaseItem(item);
+        return;
+    }
 
-        if (!inserted)
-            queue_.Push(item);
+    // The deques do not keep the items ordered, so only the items of the highest priority go to them.
+    // Items of other priorities go to the shared queue, which is ordered by the full priority value.
+    // The main thread owns its own deque, from which the worker threads steal. If the deque is full, fall back to the shared queue
+    if (UseDeques(item) && mainDeque_->Push(item))
+    {
+        Resume();
+        return;
     }
 
+    // Make sure worker threads' list is safe to modify
+    if (threads_.Size() && !paused_)
+        queueMutex_.lock();
+
+    InsertByPriority(queue_, item);
+
     if (threads_.Size())
     {
         queueMutex_.unlock();
@@ -182,6 +289,22 @@ void WorkQueue::AddWorkItem(const SharedPtr<WorkItem>& item)
     }
 }
 
+void WorkQueue::AddDependency(const SharedPtr<WorkItem>& item, const SharedPtr<WorkItem>& predecessor)
+{
+    if (!item || !predecessor)
+    {
+        DV_LOGERROR("Null work item passed as a dependency");
+        return;
+    }
+
+    // Completing the item would otherwise wait for work that Complete() does not execute
+    assert(predecessor->priority_ >= item->priority_);
+    assert(!workItems_.Contains(item) && !workItems_.Contains(predecessor));
+
+    predecessor->continuations_.Push(item);
+    ++item->numPendingDependencies_;
+}
+
 bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
 {
     if (!item)
@@ -197,6 +320,7 @@ bool WorkQueue::RemoveWorkItem(SharedPtr<WorkItem> item)
         if (j != workItems_.End())
         {
             queue_.Erase(i);
+            item->numPendingDependencies_ = 1;
             ReturnToPool(item);
             workItems_.Erase(j);
             return true;
@@ -220,6 +344,7 @@ i32 WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem>>& items)
             if (k != workItems_.End())
             {
                 queue_.Erase(j);
+                (*k)->numPendingDependencies_ = 1;
                 ReturnToPool(*k);
                 workItems_.Erase(k);
                 ++removed;
@@ -230,6 +355,12 @@ i32 WorkQueue::RemoveWorkItems(const Vector<SharedPtr<WorkItem>>& items)
     return removed;
 }
 
+void WorkQueue::SetMode(WorkQueueMode mode)
+{
+    // Worker threads always check both the deques and the shared queue, so the mode can be changed at any time
+    mode_ = mode;
+}
+
 void WorkQueue::Pause()
 {
     if (!paused_)
@@ -261,6 +392,10 @@ void WorkQueue::Complete(i32 priority)
     {
         Resume();
 
+        // Take work items from the own deque. The deques hold only WI_MAX_PRIORITY items, so all of them are within the priority
+        while (WorkItem* item = mainDeque_->Pop())
+            ExecuteItem(item, 0);
+
         // Take work items also in the main thread until queue empty or no high-priority items anymore
         while (!queue_.Empty())
         {
@@ -270,8 +405,7 @@ void WorkQueue::Complete(i32 priority)
                 WorkItem* item = queue_.Front();
                 queue_.PopFront();
                 queueMutex_.unlock();
-                item->workFunction_(item, 0);
-                item->completed_ = true;
+                ExecuteItem(item, 0);
             }
             else
             {
@@ -280,24 +414,40 @@ void WorkQueue::Complete(i32 priority)
             }
         }
 
-        // Wait for threaded work to complete
+        // Wait for threaded work to complete. Meanwhile execute the main thread items and help with the released continuations
+        // and with the continuations queued by the worker threads to their own deques
         while (!IsCompleted(priority))
         {
+            WorkItem* item = TakeReleasedItem(priority, true);
+            if (!item)
+                item = StealItem(0);
+
+            if (item)
+                ExecuteItem(item, 0);
         }
 
         // If no work at all remaining, pause worker threads by leaving the mutex locked
-        if (queue_.Empty())
+        if (!HasQueuedItems())
             Pause();
     }
     else
     {
-        // No worker threads: ensure all high-priority items are completed in the main thread
-        while (!queue_.Empty() && queue_.Front()->priority_ >= priority)
+        // No worker threads: ensure all high-priority items are completed in the main thread.
+        // Released continuations go first, as they may have been waiting for the previous item
+        for (;;)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = TakeReleasedItem(priority, true);
+
+            if (!item && !queue_.Empty() && queue_.Front()->priority_ >= priority)
+            {
+                item = queue_.Front();
+                queue_.PopFront();
+            }
+
+            if (!item)
+                break;
+
+            ExecuteItem(item, 0);
         }
     }
 
@@ -328,7 +478,21 @@ void WorkQueue::ProcessItems(i32 threadIndex)
         if (shutDown_)
             return;
 
-        if (pausing_ && !wasActive)
+        // Deques are lock-free, so check them before contending for the queue mutex. The own deque holds the continuations
+        // of the items executed by this thread, which are likely to use the same data, so it goes first.
+        // Released continuations must be checked before the queue mutex too, as it is held while paused
+        WorkItem* item = GetDeque(threadIndex).Pop();
+        if (!item)
+            item = StealItem(threadIndex);
+        if (!item)
+            item = TakeReleasedItem(M_MIN_INT, false);
+
+        if (item)
+        {
+            wasActive = true;
+            ExecuteItem(item, threadIndex);
+        }
+        else if (pausing_ && !wasActive)
             Time::Sleep(0);
         else
         {
@@ -337,11 +501,10 @@ void WorkQueue::ProcessItems(i32 threadIndex)
             {
                 wasActive = true;
 
-                WorkItem* item = queue_.Front();
+                item = queue_.Front();
                 queue_.PopFront();
                 queueMutex_.unlock();
-                item->workFunction_(item, threadIndex);
-                item->completed_ = true;
+                ExecuteItem(item, threadIndex);
             }
             else
             {
@@ -354,6 +517,115 @@ void WorkQueue::ProcessItems(i32 threadIndex)
     }
 }
 
+void WorkQueue::ExecuteItem(WorkItem* item, i32 threadIndex)
+{
+    // Nobody else references the counter anymore, prepare it for reuse of the item
+    item->numPendingDependencies_ = 1;
+
+    item->workFunction_(item, threadIndex);
+
+    for (const SharedPtr<WorkItem>& continuation : item->continuations_)
+    {
+        if (--continuation->numPendingDependencies_ > 0)
+            continue;
+
+        // A continuation that any thread can execute goes to the deque of this thread, so that this thread continues with it.
+        // Other threads steal it if this one is busy
+        if (!continuation->mainThread_ && UseDeques(continuation) && GetDeque(threadIndex).Push(continuation))
+            continue;
+
+        ReleaseItem(continuation);
+    }
+
+    item->completed_ = true;
+}
+
+void WorkQueue::ReleaseItem(WorkItem* item)
+{
+    std::scoped_lock lock(releasedMutex_);
+
+    if (item->mainThread_)
+    {
+        InsertByPriority(mainThreadItems_, item);
+        ++numMainThreadItems_;
+    }
+    else
+    {
+        InsertByPriority(releasedItems_, item);
+        ++numReleasedItems_;
+    }
+}
+
+WorkItem* WorkQueue::TakeReleasedItem(i32 priority, bool mainThread)
+{
+    if (!numReleasedItems_ && !(mainThread && numMainThreadItems_))
+        return nullptr;
+
+    std::scoped_lock lock(releasedMutex_);
+
+    if (mainThread && !mainThreadItems_.Empty() && mainThreadItems_.Front()->priority_ >= priority)
+    {
+        WorkItem* item = mainThreadItems_.Front();
+        mainThreadItems_.PopFront();
+        --numMainThreadItems_;
+        return item;
+    }
+
+    if (!releasedItems_.Empty() && releasedItems_.Front()->priority_ >= priority)
+    {
+        WorkItem* item = releasedItems_.Front();
+        releasedItems_.PopFront();
+        --numReleasedItems_;
+        return item;
+    }
+
+    return nullptr;
+}
+
+bool WorkQueue::UseDeques(const WorkItem* item) const
+{
+    return mode_ == WQM_WORK_STEALING && threads_.Size() && item->priority_ == WI_MAX_PRIORITY;
+}
+
+WorkStealingDeque& WorkQueue::GetDeque(i32 threadIndex)
+{
+    return threadIndex ? threads_[threadIndex - 1]->GetDeque() : *mainDeque_;
+}
+
+WorkItem* WorkQueue::StealItem(i32 threadIndex)
+{
+    i32 numDeques = threads_.Size() + 1;
+
+    // Start from the next thread's deque, so that the threads do not all steal from the same one
+    for (i32 i = 1; i < numDeques; ++i)
+    {
+        WorkStealingDeque& deque = GetDeque((threadIndex + i) % numDeques);
+
+        // Steal() can fail spuriously because of a race, so retry while items remain
+        while (!deque.Empty())
+        {
+            if (WorkItem* item = deque.Steal())
+                return item;
+        }
+    }
+
+    return nullptr;
+}
+
+bool WorkQueue::HasQueuedItems() const
+{
+    if (!queue_.Empty() || numReleasedItems_ || numMainThreadItems_ || !mainDeque_->Empty())
+        return true;
+
+    for (const SharedPtr<WorkerThread>& thread : threads_)
+    {
+        if (!thread->GetDeque().Empty())
+            return true;
+    }
+
+    return false;
+}
+
 void WorkQueue::PurgeCompleted(i32 priority)
 {
     assert(priority >= 0);
@@ -374,6 +646,8 @@ void WorkQueue::PurgeCompleted(i32 priority)
                 SendEvent(E_WORKITEMCOMPLETED, eventData);
             }
 
+            // Continuations are kept alive by the work item collection, drop the references in the main thread
+            (*i)->continuations_.Clear();
             ReturnToPool(*i);
             i = workItems_.Erase(i);
         }
@@ -409,7 +683,9 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
         item->workFunction_ = nullptr;
         item->priority_ = WI_MAX_PRIORITY;
         item->sendEvent_ = false;
+        item->mainThread_ = false;
         item->completed_ = false;
+        item->continuations_.Clear();
 
         poolItems_.Push(item);
     }
@@ -417,19 +693,27 @@ void WorkQueue::ReturnToPool(SharedPtr<WorkItem>& item)
 
 void WorkQueue::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
-    // If no worker threads, complete low-priority work here
-    if (threads_.Empty() && !queue_.Empty())
+    // If no worker threads, complete low-priority work here. Main thread items are executed here also when there are threads
+    if ((threads_.Empty() && !queue_.Empty()) || numReleasedItems_ || numMainThreadItems_)
     {
         DV_PROFILE(CompleteWorkNonthreaded);
 
         HiresTimer timer;
 
-        while (!queue_.Empty() && timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
+        while (timer.GetUSec(false) < maxNonThreadedWorkMs_ * 1000LL)
         {
-            WorkItem* item = queue_.Front();
-            queue_.PopFront();
-            item->workFunction_(item, 0);
-            item->completed_ = true;
+            WorkItem* item = TakeReleasedItem(M_MIN_INT, true);
+
+            if (!item && threads_.Empty() && !queue_.Empty())
+            {
+                item = queue_.Front();
+                queue_.PopFront();
+            }
+
+            if (!item)
+                break;
+
+            ExecuteItem(item, 0);
         }
     }
 
@@ -6,8 +6,12 @@
 
 #include "../containers/list.h"
 #include "object.h"
+#include "thread.h"
+#include "timer.h"
 
 #include <atomic>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 
 namespace dviglo
@@ -21,7 +25,38 @@ DV_EVENT(E_WORKITEMCOMPLETED, WorkItemCompleted)
 
 inline constexpr i32 WI_MAX_PRIORITY = M_MAX_INT;
 
+/// ParallelFor() loops estimated to be shorter than this (in nanoseconds) are executed in the main thread.
+inline constexpr float PARALLEL_FOR_MIN_NS = 20000.0f;
+/// Target duration of a ParallelFor() chunk in nanoseconds.
+inline constexpr float PARALLEL_FOR_CHUNK_NS = 50000.0f;
+
+/// Work item scheduling mode.
+enum WorkQueueMode
+{
+    /// Single prioritized queue shared by all threads and guarded by a mutex.
+    WQM_SHARED_QUEUE = 0,
+    /// Per-thread lock-free deques for WI_MAX_PRIORITY items. The main thread adds items to its own deque, and continuations go to the deque of the thread that released them.
+    /// Idle threads steal work from other threads' deques. Items of other priorities use the shared queue.
+    WQM_WORK_STEALING
+};
+
 class WorkerThread;
+class WorkStealingDeque;
+
+/// Measured cost of a ParallelFor() loop body.
+struct ParallelForCost
+{
+    /// Smoothed cost of one item in a single thread, in nanoseconds. Zero until measured.
+    float nsPerItem_{};
+
+    /// Update with the duration of a loop.
+    void Update(i64 usec, i32 numItems, i32 numThreads)
+    {
+        // Timer resolution is a microsecond, so treat zero as half of it
+        float sample = (usec > 0 ? usec * 1000.0f : 500.0f) * numThreads / numItems;
+        nsPerItem_ = nsPerItem_ > 0.0f ? Lerp(nsPerItem_, sample, 0.25f) : sample;
+    }
+};
 
 /// Work queue item.
 struct WorkItem : public RefCounted
@@ -41,11 +76,17 @@ public:
     i32 priority_{};
     /// Whether to send event on completion.
     bool sendEvent_{};
+    /// Whether the item must be executed in the main thread. Such items are executed by WorkQueue::Complete().
+    bool mainThread_{};
     /// Completed flag.
     std::atomic<bool> completed_{};
 
 private:
     bool pooled_{};
+    /// Items that can start only after this item has completed.
+    Vector<SharedPtr<WorkItem>> continuations_;
+    /// Number of predecessors that have not completed yet, plus one until the item has been added to the queue.
+    std::atomic<i32> numPendingDependencies_{1};
 };
 
 /// Work queue subsystem for multithreading.
@@ -70,15 +111,22 @@ public:
     WorkQueue& operator =(const WorkQueue&) = delete;
 
     /// Create worker threads. Can only be called once.
-    void CreateThreads(i32 numThreads);
+    void CreateThreads(i32 numThreads, WorkQueueMode mode = WQM_SHARED_QUEUE);
     /// Get pointer to an usable WorkItem from the item pool. Allocate one if no more free items.
     SharedPtr<WorkItem> GetFreeItem();
-    /// Add a work item and resume worker threads.
+    /// Add a work item and resume worker threads. If the item has predecessors, it is queued when all of them have completed.
     void AddWorkItem(const SharedPtr<WorkItem>& item);
+    /// Declare that the item can start only after the predecessor has completed. Must be called before either of the items is added. The predecessor must have at least the priority of the item.
+    void AddDependency(const SharedPtr<WorkItem>& item, const SharedPtr<WorkItem>& predecessor);
     /// Remove a work item before it has started executing. Return true if successfully removed.
+    /// Items in the work stealing deques can not be removed, as other threads may be taking them at the same time.
     bool RemoveWorkItem(SharedPtr<WorkItem> item);
-    /// Remove a number of work items before they have started executing. Return the number of items successfully removed.
+    /// Remove a number of work items before they have started executing. Return the number of items successfully removed. Items in the work stealing deques are not removed.
     i32 RemoveWorkItems(const Vector<SharedPtr<WorkItem>>& items);
+    /// Call func(begin, end, threadIndex) for chunks of the index range [begin, end) in the worker threads and the main thread, and wait for completion.
+    /// Chunks have at least grain items. Chunk size is chosen from the measured per-item cost of the previous calls with the same callable type,
+    /// and loops too cheap for threading are executed in the main thread. Completes also all other WI_MAX_PRIORITY work, so must be called from the main thread.
+    template <class Func> void ParallelFor(i32 begin, i32 end, i32 grain, const Func& func);
     /// Pause worker threads.
     void Pause();
     /// Resume worker threads.
@@ -86,6 +134,9 @@ public:
     /// Finish all queued work which has at least the specified priority. Main thread will also execute priority work. Pause worker threads if no more work remains.
     void Complete(i32 priority);
 
+    /// Set scheduling mode for subsequently added work items. Items already queued are still executed.
+    void SetMode(WorkQueueMode mode);
+
     /// Set the pool telerance before it starts deleting pool items.
     void SetTolerance(int tolerance) { tolerance_ = tolerance; }
 
@@ -95,6 +146,9 @@ public:
     /// Return number of worker threads.
     i32 GetNumThreads() const { return threads_.Size(); }
 
+    /// Return scheduling mode.
+    WorkQueueMode GetMode() const { return mode_; }
+
     /// Return whether all work with at least the specified priority is finished.
     bool IsCompleted(i32 priority) const;
     /// Return whether the queue is currently completing work in the main thread.
@@ -109,6 +163,20 @@ public:
 private:
     /// Process work items until shut down. Called by the worker threads.
     void ProcessItems(i32 threadIndex);
+    /// Execute an item in the current thread, mark it completed and queue the continuations which have no more pending predecessors.
+    void ExecuteItem(WorkItem* item, i32 threadIndex);
+    /// Queue an item whose predecessors have all completed. Can be called from any thread.
+    void ReleaseItem(WorkItem* item);
+    /// Take a released item with at least the specified priority. Main thread items are taken only if requested. Return null if none.
+    WorkItem* TakeReleasedItem(i32 priority, bool mainThread);
+    /// Return whether the item goes to the work stealing deques.
+    bool UseDeques(const WorkItem* item) const;
+    /// Return the deque owned by the specified thread (0 = main thread).
+    WorkStealingDeque& GetDeque(i32 threadIndex);
+    /// Take an item from the deques of the other threads. Return null if all are empty.
+    WorkItem* StealItem(i32 threadIndex);
+    /// Return whether any item is still waiting in the shared queue or in the worker deques.
+    bool HasQueuedItems() const;
     /// Purge completed work items which have at least the specified priority, and send completion events as necessary.
     void PurgeCompleted(i32 priority);
     /// Purge the pool to reduce allocation where its unneeded.
@@ -120,6 +188,8 @@ private:
 
     /// Worker threads.
     Vector<SharedPtr<WorkerThread>> threads_;
+    /// Work stealing deque owned by the main thread.
+    std::unique_ptr<WorkStealingDeque> mainDeque_;
     /// Work item pool for reuse to cut down on allocation. The bool is a flag for item pooling and whether it is available or not.
     List<SharedPtr<WorkItem>> poolItems_;
     /// Work item collection. Accessed only by the main thread.
@@ -128,6 +198,18 @@ private:
     List<WorkItem*> queue_;
     /// Worker queue mutex.
     std::mutex queueMutex_;
+    /// Items released by their predecessors, in priority order. Can be executed by any thread.
+    List<WorkItem*> releasedItems_;
+    /// Items that must be executed by the main thread, in priority order.
+    List<WorkItem*> mainThreadItems_;
+    /// Mutex for the released and main thread items. Unlike the queue mutex it is never held while paused.
+    std::mutex releasedMutex_;
+    /// Number of released items. Used to check for work without locking.
+    std::atomic<i32> numReleasedItems_;
+    /// Number of main thread items.
+    std::atomic<i32> numMainThreadItems_;
+    /// Scheduling mode.
+    WorkQueueMode mode_;
     /// Shutting down flag.
     std::atomic<bool> shutDown_;
     /// Pausing flag. Indicates the worker threads should not contend for the queue mutex.
@@ -144,6 +226,59 @@ private:
     int maxNonThreadedWorkMs_;
 };
 
+/// Work function of a ParallelFor() chunk. The range is stored in the start and end pointers.
+template <class Func> void ParallelForWork(const WorkItem* item, i32 threadIndex)
+{
+    const Func& func = *reinterpret_cast<const Func*>(item->aux_);
+    func((i32)reinterpret_cast<intptr_t>(item->start_), (i32)reinterpret_cast<intptr_t>(item->end_), threadIndex);
+}
+
+template <class Func> void WorkQueue::ParallelFor(i32 begin, i32 end, i32 grain, const Func& func)
+{
+    assert(grain > 0);
+    // Waits with Complete(), which is main thread only
+    assert(Thread::IsMainThread());
+
+    i32 numItems = end - begin;
+    if (numItems <= 0)
+        return;
+
+    // Each lambda has its own type, so the cost is tracked per call site
+    static ParallelForCost cost;
+
+    i32 numThreads = GetNumThreads() + 1; // Worker threads + main thread
+    HiresTimer timer;
+
+    if (numThreads == 1 || numItems <= grain || (cost.nsPerItem_ > 0.0f && cost.nsPerItem_ * numItems < PARALLEL_FOR_MIN_NS))
+    {
+        func(begin, end, 0);
+        cost.Update(timer.GetUSec(false), numItems, 1);
+        return;
+    }
+
+    // Until the cost is known, make one chunk per thread. Then make the chunks short enough for load balancing
+    i32 chunkSize = (numItems + numThreads - 1) / numThreads;
+    if (cost.nsPerItem_ > 0.0f)
+        chunkSize = Min(chunkSize, (i32)(PARALLEL_FOR_CHUNK_NS / cost.nsPerItem_));
+    chunkSize = Max(chunkSize, grain);
+
+    for (i32 chunkBegin = begin; chunkBegin < end; chunkBegin += chunkSize)
+    {
+        SharedPtr<WorkItem> item = GetFreeItem();
+        item->priority_ = WI_MAX_PRIORITY;
+        item->workFunction_ = ParallelForWork<Func>;
+        item->aux_ = const_cast<Func*>(&func);
+        item->start_ = reinterpret_cast<void*>((intptr_t)chunkBegin);
+        item->end_ = reinterpret_cast<void*>((intptr_t)Min(chunkBegin + chunkSize, end));
+        AddWorkItem(item);
+    }
+
+    Complete(WI_MAX_PRIORITY);
+
+    i32 numChunks = (numItems + chunkSize - 1) / chunkSize;
+    cost.Update(timer.GetUSec(false), numItems, Min(numChunks, numThreads));
+}
+
 #define DV_WORK_QUEUE (dviglo::WorkQueue::get_instance())
 
 }
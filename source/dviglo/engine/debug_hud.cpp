@@ -105,13 +105,15 @@ void DebugHud::Update()
         }
 
         String stats;
-        stats.AppendWithFormat("Triangles %u\nBatches %u\nViews %u\nLights %u\nShadowmaps %u\nOccluders %u",
+        stats.AppendWithFormat("Triangles %u\nBatches %u\nViews %u\nLights %u\nShadowmaps %u\nOccluders %u\nAllocations %i\nFrame arena %i KB",
             primitives,
             batches,
             renderer.GetNumViews(),
             renderer.GetNumLights(true),
             renderer.GetNumShadowMaps(true),
-            renderer.GetNumOccluders(true));
+            renderer.GetNumOccluders(true),
+            renderer.GetNumFrameAllocations(),
+            renderer.GetFrameArenaUsedSize() / 1024);
 
         if (!appStats_.Empty())
         {
@@ -201,7 +201,8 @@ bool Engine::Initialize(const VariantMap& parameters)
     unsigned numThreads = GetParameter(parameters, EP_WORKER_THREADS, true).GetBool() ? GetNumPhysicalCPUs() - 1 : 0;
     if (numThreads)
     {
-        DV_WORK_QUEUE.CreateThreads(numThreads);
+        WorkQueueMode mode = GetParameter(parameters, EP_WORK_STEALING, false).GetBool() ? WQM_WORK_STEALING : WQM_SHARED_QUEUE;
+        DV_WORK_QUEUE.CreateThreads(numThreads, mode);
 
         DV_LOGINFOF("Created %u worker thread%s", numThreads, numThreads > 1 ? "s" : "");
     }
@@ -643,20 +644,24 @@ void Engine::Update()
     DV_PROFILE(Update);
 
     // Logic update event
-    using namespace Update;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_TIMESTEP] = timeStep_;
-    SendEvent(E_UPDATE, eventData);
+    UpdateEventData updateData;
+    updateData.timeStep_ = timeStep_;
+    SendEvent(updateData);
 
     // Logic post-update event
-    SendEvent(E_POSTUPDATE, eventData);
+    PostUpdateEventData postUpdateData;
+    postUpdateData.timeStep_ = timeStep_;
+    SendEvent(postUpdateData);
 
     // Rendering update event
-    SendEvent(E_RENDERUPDATE, eventData);
+    RenderUpdateEventData renderUpdateData;
+    renderUpdateData.timeStep_ = timeStep_;
+    SendEvent(renderUpdateData);
 
     // Post-render update event
-    SendEvent(E_POSTRENDERUPDATE, eventData);
+    PostRenderUpdateEventData postRenderUpdateData;
+    postRenderUpdateData.timeStep_ = timeStep_;
+    SendEvent(postRenderUpdateData);
 }
 
 void Engine::Render()
@@ -62,7 +62,14 @@ AnimatedModel::AnimatedModel() :
     isMaster_(true),
     loading_(false),
     assignBonesPending_(false),
-    forceAnimationUpdate_(false)
+    forceAnimationUpdate_(false),
+    nodeFreeAnimation_(false),
+    boneNodesDirty_(false),
+    syncingBoneNodes_(false),
+    syncBoneNodesPending_(false),
+    hasBoneNodeDependencies_(false),
+    boneNodeDependenciesDirty_(true),
+    boneNodeDependenciesVersion_(0)
 {
 }
 
@@ -94,6 +101,7 @@ void AnimatedModel::RegisterObject()
     DV_ACCESSOR_ATTRIBUTE("Shadow Distance", GetShadowDistance, SetShadowDistance, 0.0f, AM_DEFAULT);
     DV_ACCESSOR_ATTRIBUTE("LOD Bias", GetLodBias, SetLodBias, 1.0f, AM_DEFAULT);
     DV_ACCESSOR_ATTRIBUTE("Animation LOD Bias", GetAnimationLodBias, SetAnimationLodBias, 1.0f, AM_DEFAULT);
+    DV_ACCESSOR_ATTRIBUTE("Node-Free Animation", GetNodeFreeAnimation, SetNodeFreeAnimation, false, AM_DEFAULT);
     DV_COPY_BASE_ATTRIBUTES(Drawable);
     DV_ACCESSOR_ATTRIBUTE("Bone Animation Enabled", GetBonesEnabledAttr, SetBonesEnabledAttr,
         Variant::emptyVariantVector, AM_FILE | AM_NOEDIT);
@@ -131,6 +139,15 @@ bool AnimatedModel::LoadJSON(const JSONValue& source)
     return success;
 }
 
+bool AnimatedModel::LoadValues(const Vector<Variant>& values)
+{
+    loading_ = true;
+    bool success = Component::LoadValues(values);
+    loading_ = false;
+
+    return success;
+}
+
 void AnimatedModel::ApplyAttributes()
 {
     if (assignBonesPending_)
@@ -154,6 +171,10 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, Vector<RayQuery
     const Vector<Bone>& bones = skeleton_.GetBones();
     Sphere boneSphere;
 
+    // In node-free animation mode the bone nodes may be out of date, use the skeleton pose instead
+    bool usePose = isMaster_ && nodeFreeAnimation_ && skeleton_.HasPose();
+    const Vector<Matrix3x4>& poseTransforms = skeleton_.GetPose().modelTransforms_;
+
     for (i32 i = 0; i < bones.Size(); ++i)
     {
         const Bone& bone = bones[i];
@@ -167,7 +188,7 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, Vector<RayQuery
         {
             // Do an initial crude test using the bone's AABB
             const BoundingBox& box = bone.boundingBox_;
-            const Matrix3x4& transform = bone.node_->GetWorldTransform();
+            const Matrix3x4 transform = usePose ? node_->GetWorldTransform() * poseTransforms[i] : bone.node_->GetWorldTransform();
             distance = query.ray_.HitDistance(box.Transformed(transform));
             if (distance >= query.maxDistance_)
                 continue;
@@ -183,7 +204,8 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, Vector<RayQuery
         }
         else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
         {
-            boneSphere.center_ = bone.node_->GetWorldPosition();
+            boneSphere.center_ = usePose ? node_->GetWorldTransform() * poseTransforms[i].Translation() :
+                bone.node_->GetWorldPosition();
             boneSphere.radius_ = bone.radius_;
             distance = query.ray_.HitDistance(boneSphere);
             if (distance >= query.maxDistance_)
@@ -206,9 +228,11 @@ void AnimatedModel::ProcessRayQuery(const RayOctreeQuery& query, Vector<RayQuery
 
 void AnimatedModel::Update(const FrameInfo& frame)
 {
+    bool visible = frame.camera_ && Abs(frame.frameNumber_ - viewFrameNumber_) <= 1;
+
     // If node was invisible last frame, need to decide animation LOD distance here
     // If headless, retain the current animation distance (should be 0)
-    if (frame.camera_ && Abs(frame.frameNumber_ - viewFrameNumber_) > 1)
+    if (frame.camera_ && !visible)
     {
         // First check for no update at all when invisible. In that case reset LOD timer to ensure update
         // next time the model is in view
@@ -230,8 +254,18 @@ void AnimatedModel::Update(const FrameInfo& frame)
     }
 
     if (animationDirty_ || animationOrderDirty_)
+    {
         UpdateAnimation(frame);
-    else if (boneBoundingBoxDirty_)
+
+        // Node-free skinning depends only on the model's own data, so calculate it here in the same threaded pass instead of
+        // later during view preparation. Invisible models do not need skinning
+        if (visible && skinningDirty_ && isMaster_ && nodeFreeAnimation_ && skeleton_.HasPose())
+            UpdateSkinning();
+    }
+    // Only the master's bone bounding box is used, as the other models take the master's world bounding box. The dirty flag
+    // stays set, so the box is calculated if this model becomes the master. In the node-based mode skipping the non-master
+    // models also avoids reading the shared bone nodes while the master writes them in another worker thread
+    else if (boneBoundingBoxDirty_ && isMaster_)
         UpdateBoneBoundingBox();
 }
 
@@ -293,9 +327,11 @@ void AnimatedModel::UpdateGeometry(const FrameInfo& frame)
 
 UpdateGeometryType AnimatedModel::GetUpdateGeometryType()
 {
-    if (morphsDirty_ || forceAnimationUpdate_)
+    // The late animation update writes the bone nodes, which is only safe in the main thread. Node-free animation can be
+    // updated in a worker thread unless the bone nodes have to be synchronized
+    if (morphsDirty_ || (forceAnimationUpdate_ && (!nodeFreeAnimation_ || HasBoneNodeDependencies())))
         return UPDATE_MAIN_THREAD;
-    else if (skinningDirty_)
+    else if (skinningDirty_ || forceAnimationUpdate_)
         return UPDATE_WORKER_THREAD;
     else
         return UPDATE_NONE;
@@ -305,6 +341,7 @@ void AnimatedModel::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
 {
     if (debug && IsEnabledEffective())
     {
+        SyncBoneNodes();
         debug->AddBoundingBox(GetWorldBoundingBox(), Color::GREEN, depthTest);
         debug->AddSkeleton(skeleton_, Color(0.75f, 0.75f, 0.75f), depthTest);
     }
@@ -532,6 +569,39 @@ void AnimatedModel::SetUpdateInvisible(bool enable)
 }
 
 
+void AnimatedModel::SetNodeFreeAnimation(bool enable)
+{
+    if (enable == nodeFreeAnimation_)
+        return;
+
+    // Bring the bone nodes up to date before they are animated directly again
+    if (!enable)
+        SyncBoneNodes();
+
+    nodeFreeAnimation_ = enable;
+    MarkAnimationDirty();
+    MarkNetworkUpdate();
+}
+
+void AnimatedModel::SyncBoneNodes()
+{
+    if (!boneNodesDirty_)
+        return;
+
+    boneNodesDirty_ = false;
+    skeleton_.ApplyPoseSilent();
+
+    // Dirty the bone nodes only, the model's own scene node did not move
+    syncingBoneNodes_ = true;
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+    {
+        if (i->node_)
+            i->node_->MarkDirty();
+    }
+    syncingBoneNodes_ = false;
+}
+
 void AnimatedModel::SetMorphWeight(i32 index, float weight)
 {
     assert(index >= 0);
@@ -686,6 +756,8 @@ void AnimatedModel::SetSkeleton(const Skeleton& skeleton, bool createBones)
         return;
     }
 
+    boneNodeDependenciesDirty_ = true;
+
     if (isMaster_)
     {
         // Check if bone structure has stayed compatible (reloading the model). In that case retain the old bones and animations
@@ -891,7 +963,23 @@ const Vector<byte>& AnimatedModel::GetMorphsAttr() const
 
 void AnimatedModel::UpdateBoneBoundingBox()
 {
-    if (skeleton_.GetNumBones())
+    if (isMaster_ && nodeFreeAnimation_ && skeleton_.HasPose())
+    {
+        // The pose transforms are already in local space
+        boneBoundingBox_.Clear();
+
+        const Vector<Bone>& bones = skeleton_.GetBones();
+        const Vector<Matrix3x4>& poseTransforms = skeleton_.GetPose().modelTransforms_;
+        for (i32 i = 0; i < bones.Size(); ++i)
+        {
+            const Bone& bone = bones[i];
+            if (bone.collisionMask_ & BONECOLLISION_BOX)
+                boneBoundingBox_.Merge(bone.boundingBox_.Transformed(poseTransforms[i]));
+            else if (bone.collisionMask_ & BONECOLLISION_SPHERE)
+                boneBoundingBox_.Merge(Sphere(poseTransforms[i].Translation(), bone.radius_ * 0.5f));
+        }
+    }
+    else if (skeleton_.GetNumBones())
     {
         // The bone bounding box is in local space, so need the node's inverse transform
         boneBoundingBox_.Clear();
@@ -914,12 +1002,13 @@ void AnimatedModel::UpdateBoneBoundingBox()
     }
 
     boneBoundingBoxDirty_ = false;
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
 }
 
 void AnimatedModel::OnNodeSet(Node* node)
 {
     Drawable::OnNodeSet(node);
+    boneNodeDependenciesDirty_ = true;
 
     if (node)
     {
@@ -932,13 +1021,31 @@ void AnimatedModel::OnMarkedDirty(Node* node)
 {
     Drawable::OnMarkedDirty(node);
 
-    // If the scene node or any of the bone nodes move, mark skinning dirty
-    if (skeleton_.GetNumBones())
+    // Bone node write-back delayed from the threaded drawable update
+    if (syncBoneNodesPending_ && node == node_)
+    {
+        Scene* scene = GetScene();
+        if (!scene || !scene->IsThreadedUpdate())
+        {
+            syncBoneNodesPending_ = false;
+            SyncBoneNodes();
+        }
+    }
+
+    // If the scene node or any of the bone nodes move, mark skinning dirty. Bone nodes brought up to date from the skeleton
+    // pose do not change the skinning, which was already calculated from the pose
+    if (skeleton_.GetNumBones() && !(syncingBoneNodes_ && node != node_))
     {
         skinningDirty_ = true;
-        // Bone bounding box doesn't need to be marked dirty when only the base scene node moves
+        // Bone bounding box doesn't need to be marked dirty when only the base scene node moves. In node-free animation mode
+        // it is calculated from the skeleton pose, but a bone node moved by the user must be read into the pose
         if (node != node_)
-            boneBoundingBoxDirty_ = true;
+        {
+            if (!nodeFreeAnimation_)
+                boneBoundingBoxDirty_ = true;
+            else
+                MarkAnimationDirty();
+        }
     }
 }
 
@@ -969,6 +1076,8 @@ void AnimatedModel::AssignBoneNodes()
     if (!node_)
         return;
 
+    boneNodeDependenciesDirty_ = true;
+
     // Find the bone nodes from the node hierarchy and add listeners
     Vector<Bone>& bones = skeleton_.GetModifiableBones();
     bool boneFound = false;
@@ -1272,7 +1381,34 @@ void AnimatedModel::ApplyAnimation()
 
     // Reset skeleton, apply all animations, calculate bones' bounding box. Make sure this is only done for the master model
     // (first AnimatedModel in a node)
-    if (isMaster_)
+    if (isMaster_ && nodeFreeAnimation_)
+    {
+        // Animations are blended into the skeleton pose, and the bone nodes are left out of date unless something needs them
+        skeleton_.ResetPose();
+        for (Vector<SharedPtr<AnimationState>>::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
+            (*i)->Apply();
+
+        skeleton_.UpdatePoseTransforms();
+        skinningDirty_ = true;
+        boneNodesDirty_ = true;
+
+        if (HasBoneNodeDependencies())
+        {
+            // Dirtying the bone nodes notifies their components, so during the threaded drawable update write the bone nodes back
+            // later in the main thread
+            Scene* scene = GetScene();
+            if (scene && scene->IsThreadedUpdate())
+            {
+                syncBoneNodesPending_ = true;
+                scene->DelayedMarkedDirty(this);
+            }
+            else
+                SyncBoneNodes();
+        }
+
+        UpdateBoneBoundingBox();
+    }
+    else if (isMaster_)
     {
         skeleton_.ResetSilent();
         for (Vector<SharedPtr<AnimationState>>::Iterator i = animationStates_.Begin(); i != animationStates_.End(); ++i)
@@ -1295,8 +1431,25 @@ void AnimatedModel::UpdateSkinning()
     // Use model's world transform in case a bone is missing
     const Matrix3x4& worldTransform = node_->GetWorldTransform();
 
+    // Node-free animation: combine the model's world transform with the skeleton pose
+    if (isMaster_ && nodeFreeAnimation_ && skeleton_.HasPose())
+    {
+        const Vector<Matrix3x4>& poseTransforms = skeleton_.GetPose().modelTransforms_;
+        for (i32 i = 0; i < bones.Size(); ++i)
+            skinMatrices_[i] = worldTransform * poseTransforms[i] * bones[i].offsetMatrix_;
+
+        // Copy the skin matrices to per-geometry matrices as needed
+        if (geometrySkinMatrices_.Size())
+        {
+            for (i32 i = 0; i < bones.Size(); ++i)
+            {
+                for (i32 j = 0; j < geometrySkinMatrixPtrs_[i].Size(); ++j)
+                    *geometrySkinMatrixPtrs_[i][j] = skinMatrices_[i];
+            }
+        }
+    }
     // Skinning with global matrices only
-    if (!geometrySkinMatrices_.Size())
+    else if (!geometrySkinMatrices_.Size())
     {
         for (unsigned i = 0; i < bones.Size(); ++i)
         {
@@ -1327,6 +1480,51 @@ void AnimatedModel::UpdateSkinning()
     skinningDirty_ = false;
 }
 
+bool AnimatedModel::HasBoneNodeDependencies() const
+{
+    // The dependencies change only with the scene hierarchy, so check them again only after it has changed
+    Scene* scene = GetScene();
+    if (scene && !boneNodeDependenciesDirty_ && boneNodeDependenciesVersion_ == scene->GetHierarchyVersion())
+        return hasBoneNodeDependencies_;
+
+    hasBoneNodeDependencies_ = CheckBoneNodeDependencies();
+    boneNodeDependenciesDirty_ = !scene;
+    if (scene)
+        boneNodeDependenciesVersion_ = scene->GetHierarchyVersion();
+    return hasBoneNodeDependencies_;
+}
+
+bool AnimatedModel::CheckBoneNodeDependencies() const
+{
+    // Other animated models in the same node skin with the bone nodes
+    i32 numModels = 0;
+    for (Component* component : node_->GetComponents())
+    {
+        if (component->GetType() == AnimatedModel::GetTypeStatic() && ++numModels > 1)
+            return true;
+    }
+
+    // Components in the bone nodes (physics, attachments) or child nodes that are not bones
+    i32 numChildren = 0;
+    i32 numChildBones = 0;
+    const Vector<Bone>& bones = skeleton_.GetBones();
+    for (Vector<Bone>::ConstIterator i = bones.Begin(); i != bones.End(); ++i)
+    {
+        Node* boneNode = i->node_;
+        if (!boneNode)
+            continue;
+
+        if (boneNode->GetNumComponents())
+            return true;
+
+        numChildren += boneNode->GetNumChildren();
+        if (boneNode->GetParent() != node_)
+            ++numChildBones;
+    }
+
+    return numChildren > numChildBones;
+}
+
 void AnimatedModel::UpdateMorphs()
 {
     if (GParams::is_headless())
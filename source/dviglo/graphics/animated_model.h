@@ -18,6 +18,7 @@ class AnimationState;
 class DV_API AnimatedModel : public StaticModel
 {
     DV_OBJECT(AnimatedModel, StaticModel);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
     friend class AnimationState;
 
@@ -35,6 +36,8 @@ public:
     bool LoadXML(const XMLElement& source) override;
     /// Load from JSON data. Return true if successful.
     bool LoadJSON(const JSONValue& source) override;
+    /// Load from file attribute values deserialized in advance. Return true if successful.
+    bool LoadValues(const Vector<Variant>& values) override;
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     void ApplyAttributes() override;
     /// Process octree raycast. May be called from a worker thread.
@@ -80,6 +83,12 @@ public:
     void ResetMorphWeights();
     /// Apply all animation states to nodes.
     void ApplyAnimation();
+    /// Set node-free animation. When enabled, animation is blended into the skeleton pose and skinning is calculated from it,
+    /// so the bone nodes are not updated every frame. The bone nodes are synchronized automatically only when something
+    /// depends on them (components or child nodes in the bone nodes, or other animated models in the same scene node).
+    void SetNodeFreeAnimation(bool enable);
+    /// Copy the skeleton pose to the bone nodes if they are out of date. Call before reading the bone nodes in node-free animation mode.
+    void SyncBoneNodes();
 
     /// Return skeleton.
     Skeleton& GetSkeleton() { return skeleton_; }
@@ -105,6 +114,9 @@ public:
     /// Return whether to update animation when not visible.
     bool GetUpdateInvisible() const { return updateInvisible_; }
 
+    /// Return whether node-free animation is enabled.
+    bool GetNodeFreeAnimation() const { return nodeFreeAnimation_; }
+
     /// Return all vertex morphs.
     const Vector<ModelMorph>& GetMorphs() const { return morphs_; }
 
@@ -183,6 +195,10 @@ private:
     void UpdateAnimation(const FrameInfo& frame);
     /// Recalculate skinning.
     void UpdateSkinning();
+    /// Return whether the bone nodes must be kept synchronized with the skeleton pose in node-free animation mode. The result is cached until the scene hierarchy changes.
+    bool HasBoneNodeDependencies() const;
+    /// Check the bone nodes for dependencies without the cache.
+    bool CheckBoneNodeDependencies() const;
     /// Reapply all vertex morphs.
     void UpdateMorphs();
     /// Apply a vertex morph.
@@ -241,6 +257,20 @@ private:
     bool assignBonesPending_;
     /// Force animation update after becoming visible flag.
     bool forceAnimationUpdate_;
+    /// Node-free animation flag.
+    bool nodeFreeAnimation_;
+    /// Bone nodes out of date with the skeleton pose flag.
+    bool boneNodesDirty_;
+    /// Bone node synchronization in progress flag.
+    bool syncingBoneNodes_;
+    /// Bone node synchronization delayed from the threaded drawable update flag.
+    bool syncBoneNodesPending_;
+    /// Cached result of HasBoneNodeDependencies().
+    mutable bool hasBoneNodeDependencies_;
+    /// Cached bone node dependencies must be checked again flag. Set when the bone nodes are assigned.
+    mutable bool boneNodeDependenciesDirty_;
+    /// Scene hierarchy version when the bone node dependencies were checked.
+    mutable u32 boneNodeDependenciesVersion_;
 };
 
 }
@@ -11,6 +11,7 @@
 #include "../io/file_system.h"
 #include "../io/log.h"
 #include "../io/serializer.h"
+#include "../math/bounding_box.h"
 #include "../resource/json_file.h"
 #include "../resource/resource_cache.h"
 #include "../resource/xml_file.h"
@@ -32,9 +33,102 @@ inline bool CompareKeyFrames(AnimationKeyFrame& lhs, AnimationKeyFrame& rhs)
     return lhs.time_ < rhs.time_;
 }
 
+/// Maximum value of a quantized component.
+static constexpr float QUANTIZED_MAX = 65535.f;
+/// Maximum value of a rotation component encoded in 15 bits.
+static constexpr float ROTATION_QUANTIZED_MAX = 32767.f;
+/// Range of the three smallest components of a normalized quaternion is [-1/sqrt(2), 1/sqrt(2)].
+static constexpr float ROTATION_COMPONENT_MAX = 0.707106781f;
+
+/// Return angle between rotations in degrees. Computed from the distance between the quaternions, which unlike the dot
+/// product stays precise for small angles.
+static float RotationError(const Quaternion& lhs, const Quaternion& rhs)
+{
+    Quaternion delta = lhs - (lhs.DotProduct(rhs) < 0.f ? -rhs : rhs);
+    return 4.f * Asin(Sqrt(delta.DotProduct(delta)) * 0.5f);
+}
+
+/// Quantize a vector channel of keyframes into a range.
+static void QuantizeVectors(const Vector<Vector3>& values, Vector<u16>& dest, Vector3& min, Vector3& step)
+{
+    BoundingBox range(values.Front(), values.Front());
+    for (const Vector3& value : values)
+        range.Merge(value);
+
+    min = range.min_;
+    step = (range.max_ - range.min_) / QUANTIZED_MAX;
+
+    dest.Resize(values.Size() * 3);
+    for (i32 i = 0; i < values.Size(); ++i)
+    {
+        for (i32 j = 0; j < 3; ++j)
+        {
+            float s = step.Data()[j];
+            float v = values[i].Data()[j] - min.Data()[j];
+            dest[i * 3 + j] = (u16)(s > 0.f ? Clamp(RoundToInt(v / s), 0, 65535) : 0);
+        }
+    }
+}
+
+void CompressedKeyFrames::EncodeRotation(const Quaternion& rotation, u16* dest)
+{
+    Quaternion normalized = rotation.Normalized();
+    const float* c = normalized.Data();
+
+    // The largest component is restored from the others, and its sign is made positive (q and -q are the same rotation)
+    i32 largest = 0;
+    for (i32 i = 1; i < 4; ++i)
+    {
+        if (Abs(c[i]) > Abs(c[largest]))
+            largest = i;
+    }
+
+    float sign = c[largest] < 0.f ? -1.f : 1.f;
+    u64 bits = (u64)largest << 45;
+    i32 shift = 30;
+
+    for (i32 i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+
+        float v = (c[i] * sign / ROTATION_COMPONENT_MAX) * 0.5f + 0.5f;
+        bits |= (u64)Clamp(RoundToInt(v * ROTATION_QUANTIZED_MAX), 0, 32767) << shift;
+        shift -= 15;
+    }
+
+    dest[0] = (u16)(bits >> 32);
+    dest[1] = (u16)(bits >> 16);
+    dest[2] = (u16)bits;
+}
+
+Quaternion CompressedKeyFrames::DecodeRotation(const u16* src)
+{
+    u64 bits = (u64)src[0] << 32 | (u64)src[1] << 16 | src[2];
+    i32 largest = (i32)(bits >> 45) & 3;
+
+    float c[4];
+    float sum = 0.f;
+    i32 shift = 30;
+
+    for (i32 i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+            continue;
+
+        c[i] = ((bits >> shift) & 0x7fff) * (2.f * ROTATION_COMPONENT_MAX / ROTATION_QUANTIZED_MAX) - ROTATION_COMPONENT_MAX;
+        sum += c[i] * c[i];
+        shift -= 15;
+    }
+
+    c[largest] = sqrtf(Max(1.f - sum, 0.f));
+    return Quaternion(c[0], c[1], c[2], c[3]);
+}
+
 void AnimationTrack::SetKeyFrame(i32 index, const AnimationKeyFrame& keyFrame)
 {
     assert(index >= 0);
+    Decompress();
 
     if (index < keyFrames_.Size())
     {
@@ -47,6 +141,7 @@ void AnimationTrack::SetKeyFrame(i32 index, const AnimationKeyFrame& keyFrame)
 
 void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
 {
+    Decompress();
     bool needSort = keyFrames_.Size() ? keyFrames_.Back().time_ > keyFrame.time_ : false;
     keyFrames_.Push(keyFrame);
     if (needSort)
@@ -56,6 +151,7 @@ void AnimationTrack::AddKeyFrame(const AnimationKeyFrame& keyFrame)
 void AnimationTrack::InsertKeyFrame(i32 index, const AnimationKeyFrame& keyFrame)
 {
     assert(index >= 0);
+    Decompress();
     keyFrames_.Insert(index, keyFrame);
     std::sort(keyFrames_.Begin(), keyFrames_.End(), CompareKeyFrames);
 }
@@ -63,42 +159,275 @@ void AnimationTrack::InsertKeyFrame(i32 index, const AnimationKeyFrame& keyFrame
 void AnimationTrack::RemoveKeyFrame(i32 index)
 {
     assert(index >= 0);
+    Decompress();
     keyFrames_.Erase(index);
 }
 
 void AnimationTrack::RemoveAllKeyFrames()
 {
     keyFrames_.Clear();
+    compressedKeyFrames_ = CompressedKeyFrames();
 }
 
 AnimationKeyFrame* AnimationTrack::GetKeyFrame(i32 index)
 {
     assert(index >= 0);
+    Decompress();
     return index < keyFrames_.Size() ? &keyFrames_[index] : nullptr;
 }
 
 bool AnimationTrack::GetKeyFrameIndex(float time, i32& index) const
 {
-    if (keyFrames_.Empty())
+    const i32 numKeyFrames = GetNumKeyFrames();
+    if (!numKeyFrames)
         return false;
 
     if (time < 0.0f)
         time = 0.0f;
 
-    if (index >= keyFrames_.Size())
-        index = keyFrames_.Size() - 1;
+    if (index >= numKeyFrames)
+        index = numKeyFrames - 1;
+
+    if (!compressedKeyFrames_.Empty())
+    {
+        while (index && time < compressedKeyFrames_.GetTime(index))
+            --index;
+
+        while (index < numKeyFrames - 1 && time >= compressedKeyFrames_.GetTime(index + 1))
+            ++index;
+
+        return true;
+    }
 
     // Check for being too far ahead
     while (index && time < keyFrames_[index].time_)
         --index;
 
     // Check for being too far behind
-    while (index < keyFrames_.Size() - 1 && time >= keyFrames_[index + 1].time_)
+    while (index < numKeyFrames - 1 && time >= keyFrames_[index + 1].time_)
         ++index;
 
     return true;
 }
 
+bool AnimationTrack::Sample(float time, float length, bool looped, i32& index, Vector3& position, Quaternion& rotation,
+    Vector3& scale) const
+{
+    if (!GetKeyFrameIndex(time, index))
+        return false;
+
+    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
+    i32 nextIndex = index + 1;
+    bool interpolate = true;
+    if (nextIndex >= GetNumKeyFrames())
+    {
+        if (!looped)
+        {
+            nextIndex = index;
+            interpolate = false;
+        }
+        else
+            nextIndex = 0;
+    }
+
+    // Compressed keyframes are decoded only for the two keyframes being interpolated
+    if (!compressedKeyFrames_.Empty())
+    {
+        const CompressedKeyFrames& keyFrames = compressedKeyFrames_;
+        float t = 0.f;
+
+        if (interpolate)
+        {
+            float keyTime = keyFrames.GetTime(index);
+            float timeInterval = keyFrames.GetTime(nextIndex) - keyTime;
+            if (timeInterval < 0.0f)
+                timeInterval += length;
+            t = timeInterval > 0.0f ? (time - keyTime) / timeInterval : 1.0f;
+        }
+
+        if (!!(channelMask_ & AnimationChannels::Position))
+            position = keyFrames.GetPosition(index).Lerp(keyFrames.GetPosition(nextIndex), t);
+        if (!!(channelMask_ & AnimationChannels::Rotation))
+        {
+            rotation = keyFrames.rotations_.Empty() ? keyFrames.constantRotation_ :
+                keyFrames.GetRotation(index).Slerp(keyFrames.GetRotation(nextIndex), t);
+        }
+        if (!!(channelMask_ & AnimationChannels::Scale))
+            scale = keyFrames.GetScale(index).Lerp(keyFrames.GetScale(nextIndex), t);
+
+        return true;
+    }
+
+    const AnimationKeyFrame* keyFrame = &keyFrames_[index];
+
+    if (interpolate)
+    {
+        const AnimationKeyFrame* nextKeyFrame = &keyFrames_[nextIndex];
+        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
+        if (timeInterval < 0.0f)
+            timeInterval += length;
+        float t = timeInterval > 0.0f ? (time - keyFrame->time_) / timeInterval : 1.0f;
+
+        if (!!(channelMask_ & AnimationChannels::Position))
+            position = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+        if (!!(channelMask_ & AnimationChannels::Rotation))
+            rotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+        if (!!(channelMask_ & AnimationChannels::Scale))
+            scale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+    }
+    else
+    {
+        if (!!(channelMask_ & AnimationChannels::Position))
+            position = keyFrame->position_;
+        if (!!(channelMask_ & AnimationChannels::Rotation))
+            rotation = keyFrame->rotation_;
+        if (!!(channelMask_ & AnimationChannels::Scale))
+            scale = keyFrame->scale_;
+    }
+
+    return true;
+}
+
+void AnimationTrack::Compress(float length, const AnimationCompressionSettings& settings)
+{
+    if (keyFrames_.Empty())
+        return;
+
+    const i32 numKeyFrames = keyFrames_.Size();
+    const AnimationKeyFrame& first = keyFrames_.Front();
+
+    // Channels that stay within the tolerance of the first keyframe are stored as a single value
+    bool animatePosition = false;
+    bool animateRotation = false;
+    bool animateScale = false;
+
+    for (const AnimationKeyFrame& keyFrame : keyFrames_)
+    {
+        if (!!(channelMask_ & AnimationChannels::Position) && (keyFrame.position_ - first.position_).Length() > settings.positionTolerance_)
+            animatePosition = true;
+        if (!!(channelMask_ & AnimationChannels::Rotation) && RotationError(keyFrame.rotation_, first.rotation_) > settings.rotationTolerance_)
+            animateRotation = true;
+        if (!!(channelMask_ & AnimationChannels::Scale) && (keyFrame.scale_ - first.scale_).Length() > settings.scaleTolerance_)
+            animateScale = true;
+    }
+
+    // Remove keyframes that can be interpolated from the previous kept keyframe and a later one within the tolerance
+    Vector<i32> kept;
+    kept.Push(0);
+
+    if (animatePosition || animateRotation || animateScale)
+    {
+        i32 start = 0;
+
+        for (i32 end = 2; end < numKeyFrames; ++end)
+        {
+            const AnimationKeyFrame& startKey = keyFrames_[start];
+            const AnimationKeyFrame& endKey = keyFrames_[end];
+            float timeInterval = endKey.time_ - startKey.time_;
+            bool canInterpolate = true;
+
+            for (i32 i = start + 1; i < end && canInterpolate; ++i)
+            {
+                const AnimationKeyFrame& keyFrame = keyFrames_[i];
+                float t = timeInterval > 0.f ? (keyFrame.time_ - startKey.time_) / timeInterval : 0.f;
+
+                if (animatePosition && (startKey.position_.Lerp(endKey.position_, t) - keyFrame.position_).Length() >
+                    settings.positionTolerance_)
+                    canInterpolate = false;
+                else if (animateRotation && RotationError(startKey.rotation_.Slerp(endKey.rotation_, t), keyFrame.rotation_) >
+                    settings.rotationTolerance_)
+                    canInterpolate = false;
+                else if (animateScale && (startKey.scale_.Lerp(endKey.scale_, t) - keyFrame.scale_).Length() >
+                    settings.scaleTolerance_)
+                    canInterpolate = false;
+            }
+
+            // Spherical interpolation is not linear, so the rotations are also tested halfway between the original keyframes
+            for (i32 i = start; i < end && canInterpolate && animateRotation; ++i)
+            {
+                const AnimationKeyFrame& keyFrame = keyFrames_[i];
+                const AnimationKeyFrame& nextKeyFrame = keyFrames_[i + 1];
+                float time = (keyFrame.time_ + nextKeyFrame.time_) * 0.5f;
+                float t = timeInterval > 0.f ? (time - startKey.time_) / timeInterval : 0.f;
+
+                if (RotationError(startKey.rotation_.Slerp(endKey.rotation_, t), keyFrame.rotation_.Slerp(nextKeyFrame.rotation_, 0.5f)) >
+                    settings.rotationTolerance_)
+                    canInterpolate = false;
+            }
+
+            if (!canInterpolate)
+            {
+                start = end - 1;
+                kept.Push(start);
+            }
+        }
+
+        if (numKeyFrames > 1)
+            kept.Push(numKeyFrames - 1);
+    }
+
+    CompressedKeyFrames& dest = compressedKeyFrames_;
+    dest = CompressedKeyFrames();
+    dest.timeStep_ = Max(length, keyFrames_.Back().time_) / QUANTIZED_MAX;
+
+    dest.times_.Resize(kept.Size());
+    for (i32 i = 0; i < kept.Size(); ++i)
+    {
+        float time = Max(keyFrames_[kept[i]].time_, 0.f);
+        dest.times_[i] = (u16)(dest.timeStep_ > 0.f ? Clamp(RoundToInt(time / dest.timeStep_), 0, 65535) : 0);
+    }
+
+    Vector<Vector3> values(kept.Size());
+
+    if (animatePosition)
+    {
+        for (i32 i = 0; i < kept.Size(); ++i)
+            values[i] = keyFrames_[kept[i]].position_;
+        QuantizeVectors(values, dest.positions_, dest.positionMin_, dest.positionStep_);
+    }
+    else
+        dest.positionMin_ = first.position_;
+
+    if (animateRotation)
+    {
+        dest.rotations_.Resize(kept.Size() * 3);
+        for (i32 i = 0; i < kept.Size(); ++i)
+            CompressedKeyFrames::EncodeRotation(keyFrames_[kept[i]].rotation_, &dest.rotations_[i * 3]);
+    }
+    else
+        dest.constantRotation_ = first.rotation_;
+
+    if (animateScale)
+    {
+        for (i32 i = 0; i < kept.Size(); ++i)
+            values[i] = keyFrames_[kept[i]].scale_;
+        QuantizeVectors(values, dest.scales_, dest.scaleMin_, dest.scaleStep_);
+    }
+    else
+        dest.scaleMin_ = first.scale_;
+
+    keyFrames_.Clear();
+    keyFrames_.Compact();
+}
+
+void AnimationTrack::Decompress()
+{
+    if (compressedKeyFrames_.Empty())
+        return;
+
+    keyFrames_.Resize(compressedKeyFrames_.Size());
+    for (i32 i = 0; i < keyFrames_.Size(); ++i)
+    {
+        AnimationKeyFrame& keyFrame = keyFrames_[i];
+        keyFrame.time_ = compressedKeyFrames_.GetTime(i);
+        keyFrame.position_ = compressedKeyFrames_.GetPosition(i);
+        keyFrame.rotation_ = compressedKeyFrames_.GetRotation(i);
+        keyFrame.scale_ = compressedKeyFrames_.GetScale(i);
+    }
+
+    compressedKeyFrames_ = CompressedKeyFrames();
+}
+
 Animation::Animation() :
     length_(0.f)
 {
@@ -116,7 +445,9 @@ bool Animation::BeginLoad(Deserializer& source)
     unsigned memoryUse = sizeof(Animation);
 
     // Check ID
-    if (source.ReadFileID() != "UANI")
+    String fileID = source.ReadFileID();
+    bool compressed = fileID == "UANC";
+    if (fileID != "UANI" && !compressed)
     {
         DV_LOGERROR(source.GetName() + " is not a valid animation file");
         return false;
@@ -137,6 +468,13 @@ bool Animation::BeginLoad(Deserializer& source)
         AnimationTrack* newTrack = CreateTrack(source.ReadString());
         newTrack->channelMask_ = AnimationChannels(source.ReadU8());
 
+        if (compressed)
+        {
+            ReadCompressedKeyFrames(source, *newTrack);
+            memoryUse += newTrack->GetKeyFrameMemoryUse();
+            continue;
+        }
+
         unsigned keyFrames = source.ReadU32();
         newTrack->keyFrames_.Resize(keyFrames);
         memoryUse += keyFrames * sizeof(AnimationKeyFrame);
@@ -213,8 +551,10 @@ bool Animation::BeginLoad(Deserializer& source)
 
 bool Animation::Save(Serializer& dest) const
 {
+    bool compressed = IsCompressed();
+
     // Write ID, name and length
-    dest.WriteFileID("UANI");
+    dest.WriteFileID(compressed ? "UANC" : "UANI");
     dest.WriteString(animationName_);
     dest.WriteFloat(length_);
 
@@ -225,10 +565,27 @@ bool Animation::Save(Serializer& dest) const
         const AnimationTrack& track = i->second_;
         dest.WriteString(track.name_);
         dest.WriteU8(to_u8(track.channelMask_));
-        dest.WriteU32(track.keyFrames_.Size());
+
+        if (compressed)
+        {
+            WriteCompressedKeyFrames(dest, track);
+            continue;
+        }
+
+        // Some tracks are compressed, save them with full precision
+        const Vector<AnimationKeyFrame>* keyFrames = &track.keyFrames_;
+        AnimationTrack decompressed;
+        if (track.IsCompressed())
+        {
+            decompressed = track;
+            decompressed.Decompress();
+            keyFrames = &decompressed.keyFrames_;
+        }
+
+        dest.WriteU32(keyFrames->Size());
 
         // Write keyframes of the track
-        for (const AnimationKeyFrame& keyFrame : track.keyFrames_)
+        for (const AnimationKeyFrame& keyFrame : *keyFrames)
         {
             dest.WriteFloat(keyFrame.time_);
             if (!!(track.channelMask_ & AnimationChannels::Position))
@@ -360,6 +717,22 @@ void Animation::SetNumTriggers(i32 num)
     triggers_.Resize(num);
 }
 
+void Animation::Compress(const AnimationCompressionSettings& settings)
+{
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->second_.Compress(length_, settings);
+
+    UpdateMemoryUse();
+}
+
+void Animation::Decompress()
+{
+    for (HashMap<StringHash, AnimationTrack>::Iterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        i->second_.Decompress();
+
+    UpdateMemoryUse();
+}
+
 SharedPtr<Animation> Animation::Clone(const String& cloneName) const
 {
     SharedPtr<Animation> ret(new Animation());
@@ -412,4 +785,112 @@ AnimationTriggerPoint* Animation::GetTrigger(i32 index)
     return index < triggers_.Size() ? &triggers_[index] : nullptr;
 }
 
+void Animation::UpdateMemoryUse()
+{
+    i32 memoryUse = sizeof(Animation) + tracks_.Size() * sizeof(AnimationTrack) + triggers_.Size() * sizeof(AnimationTriggerPoint);
+
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+        memoryUse += i->second_.GetKeyFrameMemoryUse();
+
+    SetMemoryUse(memoryUse);
+}
+
+bool Animation::IsCompressed() const
+{
+    bool compressed = false;
+
+    // Tracks without keyframes can be saved in either format
+    for (HashMap<StringHash, AnimationTrack>::ConstIterator i = tracks_.Begin(); i != tracks_.End(); ++i)
+    {
+        if (i->second_.IsCompressed())
+            compressed = true;
+        else if (!i->second_.keyFrames_.Empty())
+            return false;
+    }
+
+    return compressed;
+}
+
+void Animation::ReadCompressedKeyFrames(Deserializer& source, AnimationTrack& track)
+{
+    CompressedKeyFrames& keyFrames = track.compressedKeyFrames_;
+
+    i32 numKeyFrames = source.ReadU32();
+    keyFrames.timeStep_ = source.ReadFloat();
+    keyFrames.times_.Resize(numKeyFrames);
+    source.Read(keyFrames.times_.Buffer(), numKeyFrames * sizeof(u16));
+
+    // Each channel is either constant or has a quantized value for every keyframe
+    if (!!(track.channelMask_ & AnimationChannels::Position))
+    {
+        keyFrames.positionMin_ = source.ReadVector3();
+        if (source.ReadBool())
+        {
+            keyFrames.positionStep_ = source.ReadVector3();
+            keyFrames.positions_.Resize(numKeyFrames * 3);
+            source.Read(keyFrames.positions_.Buffer(), numKeyFrames * 3 * sizeof(u16));
+        }
+    }
+
+    if (!!(track.channelMask_ & AnimationChannels::Rotation))
+    {
+        keyFrames.constantRotation_ = source.ReadQuaternion();
+        if (source.ReadBool())
+        {
+            keyFrames.rotations_.Resize(numKeyFrames * 3);
+            source.Read(keyFrames.rotations_.Buffer(), numKeyFrames * 3 * sizeof(u16));
+        }
+    }
+
+    if (!!(track.channelMask_ & AnimationChannels::Scale))
+    {
+        keyFrames.scaleMin_ = source.ReadVector3();
+        if (source.ReadBool())
+        {
+            keyFrames.scaleStep_ = source.ReadVector3();
+            keyFrames.scales_.Resize(numKeyFrames * 3);
+            source.Read(keyFrames.scales_.Buffer(), numKeyFrames * 3 * sizeof(u16));
+        }
+    }
+}
+
+void Animation::WriteCompressedKeyFrames(Serializer& dest, const AnimationTrack& track)
+{
+    const CompressedKeyFrames& keyFrames = track.compressedKeyFrames_;
+
+    dest.WriteU32(keyFrames.Size());
+    dest.WriteFloat(keyFrames.timeStep_);
+    dest.Write(keyFrames.times_.Buffer(), keyFrames.times_.Size() * sizeof(u16));
+
+    if (!!(track.channelMask_ & AnimationChannels::Position))
+    {
+        dest.WriteVector3(keyFrames.positionMin_);
+        dest.WriteBool(!keyFrames.positions_.Empty());
+        if (!keyFrames.positions_.Empty())
+        {
+            dest.WriteVector3(keyFrames.positionStep_);
+            dest.Write(keyFrames.positions_.Buffer(), keyFrames.positions_.Size() * sizeof(u16));
+        }
+    }
+
+    if (!!(track.channelMask_ & AnimationChannels::Rotation))
+    {
+        dest.WriteQuaternion(keyFrames.constantRotation_);
+        dest.WriteBool(!keyFrames.rotations_.Empty());
+        if (!keyFrames.rotations_.Empty())
+            dest.Write(keyFrames.rotations_.Buffer(), keyFrames.rotations_.Size() * sizeof(u16));
+    }
+
+    if (!!(track.channelMask_ & AnimationChannels::Scale))
+    {
+        dest.WriteVector3(keyFrames.scaleMin_);
+        dest.WriteBool(!keyFrames.scales_.Empty());
+        if (!keyFrames.scales_.Empty())
+        {
+            dest.WriteVector3(keyFrames.scaleStep_);
+            dest.Write(keyFrames.scales_.Buffer(), keyFrames.scales_.Size() * sizeof(u16));
+        }
+    }
+}
+
 }
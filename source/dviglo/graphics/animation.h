@@ -44,6 +44,88 @@ struct AnimationKeyFrame
     Vector3 scale_;
 };
 
+/// Settings for compressing animation tracks. A keyframe is removed only if interpolating the kept keyframes stays within the
+/// tolerances at its time, and for rotations also halfway between each pair of original keyframes. As positions and scales are
+/// interpolated linearly, the tolerances then bound their error at any time, while the rotation error between the tested times
+/// may slightly exceed the tolerance. On top of that comes the quantization error of the values, which is half of 1/65535 of
+/// the value range of the track per component, and of the keyframe times, which are rounded to 1/65535 of the animation length.
+struct AnimationCompressionSettings
+{
+    /// Position tolerance.
+    float positionTolerance_{0.001f};
+    /// Rotation tolerance in degrees.
+    float rotationTolerance_{0.1f};
+    /// Scale tolerance.
+    float scaleTolerance_{0.001f};
+};
+
+/// Keyframes of an animation track quantized to 16 bits per component. Channels that do not change are stored as a single
+/// value, and keyframes that can be interpolated from their neighbours are removed.
+struct DV_API CompressedKeyFrames
+{
+    /// Return number of keyframes.
+    i32 Size() const { return times_.Size(); }
+
+    /// Return whether there are no keyframes.
+    bool Empty() const { return times_.Empty(); }
+
+    /// Return keyframe time.
+    float GetTime(i32 index) const { return times_[index] * timeStep_; }
+
+    /// Return keyframe position.
+    Vector3 GetPosition(i32 index) const
+    {
+        if (positions_.Empty())
+            return positionMin_;
+
+        const u16* q = &positions_[index * 3];
+        return Vector3(positionMin_.x_ + q[0] * positionStep_.x_, positionMin_.y_ + q[1] * positionStep_.y_,
+            positionMin_.z_ + q[2] * positionStep_.z_);
+    }
+
+    /// Return keyframe rotation.
+    Quaternion GetRotation(i32 index) const { return rotations_.Empty() ? constantRotation_ : DecodeRotation(&rotations_[index * 3]); }
+
+    /// Return keyframe scale.
+    Vector3 GetScale(i32 index) const
+    {
+        if (scales_.Empty())
+            return scaleMin_;
+
+        const u16* q = &scales_[index * 3];
+        return Vector3(scaleMin_.x_ + q[0] * scaleStep_.x_, scaleMin_.y_ + q[1] * scaleStep_.y_, scaleMin_.z_ + q[2] * scaleStep_.z_);
+    }
+
+    /// Return memory use in bytes.
+    i32 GetMemoryUse() const { return (times_.Size() + positions_.Size() + rotations_.Size() + scales_.Size()) * (i32)sizeof(u16); }
+
+    /// Encode a rotation to 48 bits: index of the largest component and the three other components.
+    static void EncodeRotation(const Quaternion& rotation, u16* dest);
+    /// Decode a rotation from 48 bits.
+    static Quaternion DecodeRotation(const u16* src);
+
+    /// Keyframe times in time steps.
+    Vector<u16> times_;
+    /// Quantized positions, three values per keyframe. Empty if the position is constant.
+    Vector<u16> positions_;
+    /// Encoded rotations, three values per keyframe. Empty if the rotation is constant.
+    Vector<u16> rotations_;
+    /// Quantized scales, three values per keyframe. Empty if the scale is constant.
+    Vector<u16> scales_;
+    /// Length of a time step.
+    float timeStep_{};
+    /// Minimum of the position range, or the constant position.
+    Vector3 positionMin_;
+    /// Position quantization step.
+    Vector3 positionStep_;
+    /// Constant rotation.
+    Quaternion constantRotation_;
+    /// Minimum of the scale range, or the constant scale.
+    Vector3 scaleMin_{Vector3::ONE};
+    /// Scale quantization step.
+    Vector3 scaleStep_;
+};
+
 /// Skeletal animation track, stores keyframes of a single bone.
 struct DV_API AnimationTrack
 {
@@ -52,23 +134,37 @@ struct DV_API AnimationTrack
     {
     }
 
-    /// Assign keyframe at index.
+    /// Assign keyframe at index. Decompresses the track first.
     void SetKeyFrame(i32 index, const AnimationKeyFrame& keyFrame);
-    /// Add a keyframe at the end.
+    /// Add a keyframe at the end. Decompresses the track first.
     void AddKeyFrame(const AnimationKeyFrame& keyFrame);
-    /// Insert a keyframe at index.
+    /// Insert a keyframe at index. Decompresses the track first.
     void InsertKeyFrame(i32 index, const AnimationKeyFrame& keyFrame);
-    /// Remove a keyframe at index.
+    /// Remove a keyframe at index. Decompresses the track first.
     void RemoveKeyFrame(i32 index);
-    /// Remove all keyframes.
+    /// Remove all keyframes, also the compressed ones.
     void RemoveAllKeyFrames();
 
-    /// Return keyframe at index, or null if not found.
+    /// Return keyframe at index for editing, or null if not found. Decompresses the track first.
     AnimationKeyFrame* GetKeyFrame(i32 index);
     /// Return number of keyframes.
-    i32 GetNumKeyFrames() const { return keyFrames_.Size(); }
+    i32 GetNumKeyFrames() const { return compressedKeyFrames_.Empty() ? keyFrames_.Size() : compressedKeyFrames_.Size(); }
     /// Return keyframe index based on time and previous index. Return false if animation is empty.
     bool GetKeyFrameIndex(float time, i32& index) const;
+    /// Return the interpolated transform at a time position. The keyframe index is used as a starting point for the search and
+    /// is updated. Only the channels in the channel mask are written. Return false if the track is empty.
+    bool Sample(float time, float length, bool looped, i32& index, Vector3& position, Quaternion& rotation, Vector3& scale) const;
+
+    /// Replace the keyframes with compressed keyframes. Editing the keyframes decompresses the track.
+    void Compress(float length, const AnimationCompressionSettings& settings = AnimationCompressionSettings());
+    /// Replace compressed keyframes with full precision keyframes.
+    void Decompress();
+
+    /// Return whether the keyframes are compressed.
+    bool IsCompressed() const { return !compressedKeyFrames_.Empty(); }
+
+    /// Return memory use of the keyframes in bytes.
+    i32 GetKeyFrameMemoryUse() const { return keyFrames_.Size() * (i32)sizeof(AnimationKeyFrame) + compressedKeyFrames_.GetMemoryUse(); }
 
     /// Bone or scene node name.
     String name_;
@@ -78,6 +174,8 @@ struct DV_API AnimationTrack
     AnimationChannels channelMask_{};
     /// Keyframes.
     Vector<AnimationKeyFrame> keyFrames_;
+    /// Compressed keyframes. Used instead of the full precision keyframes when not empty.
+    CompressedKeyFrames compressedKeyFrames_;
 };
 
 /// %Animation trigger point.
@@ -137,6 +235,10 @@ public:
     void SetNumTriggers(i32 num);
     /// Clone the animation.
     SharedPtr<Animation> Clone(const String& cloneName = String::EMPTY) const;
+    /// Compress all tracks. The animation is saved in the compressed format when all tracks are compressed.
+    void Compress(const AnimationCompressionSettings& settings = AnimationCompressionSettings());
+    /// Decompress all tracks.
+    void Decompress();
 
     /// Return animation name.
     const String& GetAnimationName() const { return animationName_; }
@@ -170,7 +272,17 @@ public:
     /// Return a trigger point by index.
     AnimationTriggerPoint* GetTrigger(i32 index);
 
+    /// Return whether all tracks are compressed.
+    bool IsCompressed() const;
+
 private:
+    /// Recalculate memory use from the tracks and triggers.
+    void UpdateMemoryUse();
+    /// Read compressed keyframes of a track.
+    static void ReadCompressedKeyFrames(Deserializer& source, AnimationTrack& track);
+    /// Write compressed keyframes of a track.
+    static void WriteCompressedKeyFrames(Serializer& dest, const AnimationTrack& track);
+
     /// Animation name.
     String animationName_;
     /// Animation name hash.
@@ -58,7 +58,7 @@ void AnimationController::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, DV_HANDLER(AnimationController, HandleScenePostUpdate));
+            SubscribeToEvent(scene, &AnimationController::HandleScenePostUpdate);
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -818,7 +818,7 @@ VariantVector AnimationController::GetNodeAnimationStatesAttr() const
 void AnimationController::OnSceneSet(Scene* scene)
 {
     if (scene && IsEnabledEffective())
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, DV_HANDLER(AnimationController, HandleScenePostUpdate));
+        SubscribeToEvent(scene, &AnimationController::HandleScenePostUpdate);
     else if (!scene)
         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 }
@@ -887,11 +887,9 @@ void AnimationController::FindAnimation(const String& name, i32& index, Animatio
     }
 }
 
-void AnimationController::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void AnimationController::HandleScenePostUpdate(const ScenePostUpdateEventData& eventData)
 {
-    using namespace ScenePostUpdate;
-
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 }
@@ -16,6 +16,7 @@ namespace dviglo
 AnimationStateTrack::AnimationStateTrack() :
     track_(nullptr),
     bone_(nullptr),
+    boneIndex_(NINDEX),
     weight_(1.0f),
     keyFrame_(0)
 {
@@ -129,6 +130,7 @@ void AnimationState::SetStartBone(Bone* startBone)
         if (trackBone && trackBone->node_)
         {
             stateTrack.bone_ = trackBone;
+            stateTrack.boneIndex_ = skeleton.GetBoneIndex(trackBone);
             stateTrack.node_ = trackBone->node_;
             stateTracks_.Push(stateTrack);
         }
@@ -437,6 +439,25 @@ void AnimationState::Apply()
 
 void AnimationState::ApplyToModel()
 {
+    // In node-free mode the bone nodes are not touched, the animation is blended directly into the skeleton pose
+    if (model_->GetNodeFreeAnimation())
+    {
+        SkeletonPose& pose = model_->GetSkeleton().GetPose();
+
+        for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
+        {
+            AnimationStateTrack& stateTrack = *i;
+            float finalWeight = weight_ * stateTrack.weight_;
+
+            if (Equals(finalWeight, 0.0f) || !stateTrack.bone_->animated_)
+                continue;
+
+            ApplyTrackToPose(stateTrack, finalWeight, pose);
+        }
+
+        return;
+    }
+
     for (Vector<AnimationStateTrack>::Iterator i = stateTracks_.Begin(); i != stateTracks_.End(); ++i)
     {
         AnimationStateTrack& stateTrack = *i;
@@ -459,79 +480,80 @@ void AnimationState::ApplyToNodes()
 
 void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent)
 {
-    const AnimationTrack* track = stateTrack.track_;
     Node* node = stateTrack.node_;
-
-    if (track->keyFrames_.Empty() || !node)
+    if (!node)
         return;
 
-    i32& frame = stateTrack.keyFrame_;
-    track->GetKeyFrameIndex(time_, frame);
-
-    // Check if next frame to interpolate to is valid, or if wrapping is needed (looping animation only)
-    i32 nextFrame = frame + 1;
-    bool interpolate = true;
-    if (nextFrame >= track->keyFrames_.Size())
-    {
-        if (!looped_)
-        {
-            nextFrame = frame;
-            interpolate = false;
-        }
-        else
-            nextFrame = 0;
-    }
+    Vector3 newPosition = node->GetPosition();
+    Quaternion newRotation = node->GetRotation();
+    Vector3 newScale = node->GetScale();
 
-    const AnimationKeyFrame* keyFrame = &track->keyFrames_[frame];
-    const AnimationChannels channelMask = track->channelMask_;
+    if (!BlendTrack(stateTrack, weight, newPosition, newRotation, newScale))
+        return;
 
-    Vector3 newPosition;
-    Quaternion newRotation;
-    Vector3 newScale;
+    const AnimationChannels channelMask = stateTrack.track_->channelMask_;
 
-    if (interpolate)
+    if (silent)
     {
-        const AnimationKeyFrame* nextKeyFrame = &track->keyFrames_[nextFrame];
-        float timeInterval = nextKeyFrame->time_ - keyFrame->time_;
-        if (timeInterval < 0.0f)
-            timeInterval += animation_->GetLength();
-        float t = timeInterval > 0.0f ? (time_ - keyFrame->time_) / timeInterval : 1.0f;
-
         if (!!(channelMask & AnimationChannels::Position))
-            newPosition = keyFrame->position_.Lerp(nextKeyFrame->position_, t);
+            node->SetPositionSilent(newPosition);
         if (!!(channelMask & AnimationChannels::Rotation))
-            newRotation = keyFrame->rotation_.Slerp(nextKeyFrame->rotation_, t);
+            node->SetRotationSilent(newRotation);
         if (!!(channelMask & AnimationChannels::Scale))
-            newScale = keyFrame->scale_.Lerp(nextKeyFrame->scale_, t);
+            node->SetScaleSilent(newScale);
     }
     else
     {
         if (!!(channelMask & AnimationChannels::Position))
-            newPosition = keyFrame->position_;
+            node->SetPosition(newPosition);
         if (!!(channelMask & AnimationChannels::Rotation))
-            newRotation = keyFrame->rotation_;
+            node->SetRotation(newRotation);
         if (!!(channelMask & AnimationChannels::Scale))
-            newScale = keyFrame->scale_;
+            node->SetScale(newScale);
     }
+}
+
+void AnimationState::ApplyTrackToPose(AnimationStateTrack& stateTrack, float weight, SkeletonPose& pose)
+{
+    i32 index = stateTrack.boneIndex_;
+    if (index < 0 || index >= pose.positions_.Size())
+        return;
+
+    BlendTrack(stateTrack, weight, pose.positions_[index], pose.rotations_[index], pose.scales_[index]);
+}
+
+bool AnimationState::BlendTrack(AnimationStateTrack& stateTrack, float weight, Vector3& position, Quaternion& rotation,
+    Vector3& scale)
+{
+    const AnimationTrack* track = stateTrack.track_;
+    const AnimationChannels channelMask = track->channelMask_;
+
+    Vector3 newPosition;
+    Quaternion newRotation;
+    Vector3 newScale;
+
+    if (!track->Sample(time_, animation_->GetLength(), looped_, stateTrack.keyFrame_, newPosition, newRotation, newScale))
+        return false;
 
     if (blendingMode_ == ABM_ADDITIVE) // not ABM_LERP
     {
         if (!!(channelMask & AnimationChannels::Position))
         {
             Vector3 delta = newPosition - stateTrack.bone_->initialPosition_;
-            newPosition = node->GetPosition() + delta * weight;
+            position += delta * weight;
         }
         if (!!(channelMask & AnimationChannels::Rotation))
         {
             Quaternion delta = newRotation * stateTrack.bone_->initialRotation_.Inverse();
-            newRotation = (delta * node->GetRotation()).Normalized();
+            newRotation = (delta * rotation).Normalized();
             if (!Equals(weight, 1.0f))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                newRotation = rotation.Slerp(newRotation, weight);
+            rotation = newRotation;
         }
         if (!!(channelMask & AnimationChannels::Scale))
         {
             Vector3 delta = newScale - stateTrack.bone_->initialScale_;
-            newScale = node->GetScale() + delta * weight;
+            scale += delta * weight;
         }
     }
     else
@@ -539,32 +561,24 @@ void AnimationState::ApplyTrack(AnimationStateTrack& stateTrack, float weight, b
         if (!Equals(weight, 1.0f)) // not full weight
         {
             if (!!(channelMask & AnimationChannels::Position))
-                newPosition = node->GetPosition().Lerp(newPosition, weight);
+                position = position.Lerp(newPosition, weight);
             if (!!(channelMask & AnimationChannels::Rotation))
-                newRotation = node->GetRotation().Slerp(newRotation, weight);
+                rotation = rotation.Slerp(newRotation, weight);
             if (!!(channelMask & AnimationChannels::Scale))
-                newScale = node->GetScale().Lerp(newScale, weight);
+                scale = scale.Lerp(newScale, weight);
+        }
+        else
+        {
+            if (!!(channelMask & AnimationChannels::Position))
+                position = newPosition;
+            if (!!(channelMask & AnimationChannels::Rotation))
+                rotation = newRotation;
+            if (!!(channelMask & AnimationChannels::Scale))
+                scale = newScale;
         }
     }
 
-    if (silent)
-    {
-        if (!!(channelMask & AnimationChannels::Position))
-            node->SetPositionSilent(newPosition);
-        if (!!(channelMask & AnimationChannels::Rotation))
-            node->SetRotationSilent(newRotation);
-        if (!!(channelMask & AnimationChannels::Scale))
-            node->SetScaleSilent(newScale);
-    }
-    else
-    {
-        if (!!(channelMask & AnimationChannels::Position))
-            node->SetPosition(newPosition);
-        if (!!(channelMask & AnimationChannels::Rotation))
-            node->SetRotation(newRotation);
-        if (!!(channelMask & AnimationChannels::Scale))
-            node->SetScale(newScale);
-    }
+    return true;
 }
 
 }
@@ -21,6 +21,7 @@ class Skeleton;
 class StringHash;
 struct AnimationTrack;
 struct Bone;
+struct SkeletonPose;
 
 /// %Animation blending mode.
 enum AnimationBlendMode
@@ -43,6 +44,8 @@ struct AnimationStateTrack
     const AnimationTrack* track_;
     /// Bone pointer.
     Bone* bone_;
+    /// Bone index in the skeleton.
+    i32 boneIndex_;
     /// Scene node pointer.
     WeakPtr<Node> node_;
     /// Blending weight.
@@ -138,6 +141,10 @@ private:
     void ApplyToNodes();
     /// Apply track.
     void ApplyTrack(AnimationStateTrack& stateTrack, float weight, bool silent);
+    /// Apply track to the skeleton pose instead of the bone node.
+    void ApplyTrackToPose(AnimationStateTrack& stateTrack, float weight, SkeletonPose& pose);
+    /// Blend the track's value at the current time position into the given transform. Only the channels in the track are modified. Return false if the track has no keyframes.
+    bool BlendTrack(AnimationStateTrack& stateTrack, float weight, Vector3& position, Quaternion& rotation, Vector3& scale);
 
     /// Animated model (model mode).
     WeakPtr<AnimatedModel> model_;
@@ -6,6 +6,7 @@
 #include "geometry.h"
 #include "graphics.h"
 #include "../graphics_api/graphics_defs.h"
+#include "instancing_storage.h"
 #include "material.h"
 #include "renderer.h"
 #include "technique.h"
@@ -16,6 +17,9 @@
 #include "../graphics_api/vertex_buffer.h"
 #include "../scene/scene.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include "../common/debug_new.h"
 
 namespace dviglo
@@ -31,34 +35,56 @@ inline bool CompareBatchesState(Batch* lhs, Batch* rhs)
         return lhs->distance_ < rhs->distance_;
 }
 
-inline bool CompareBatchesFrontToBack(Batch* lhs, Batch* rhs)
+/// Return render order in the highest 8 bits of a packed sort key.
+static inline u64 RenderOrderSortKey(const Batch* batch)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ < rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    return (u64)(u8)(batch->renderOrder_ + 128) << 56u;
 }
 
-inline bool CompareBatchesBackToFront(Batch* lhs, Batch* rhs)
+/// Return float bits as an unsigned integer that sorts in the same order.
+static inline u32 FloatSortKey(float value)
 {
-    if (lhs->renderOrder_ != rhs->renderOrder_)
-        return lhs->renderOrder_ < rhs->renderOrder_;
-    else if (lhs->distance_ != rhs->distance_)
-        return lhs->distance_ > rhs->distance_;
-    else
-        return lhs->sortKey_ < rhs->sortKey_;
+    u32 bits;
+    memcpy(&bits, &value, sizeof bits);
+    return (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
 }
 
-inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
+/// Sort by render order, then distance, then the highest bits of the state key.
+static inline u64 FrontToBackSortKey(const Batch* batch)
 {
-    return lhs.distance_ < rhs.distance_;
+    return RenderOrderSortKey(batch) | ((u64)FloatSortKey(batch->distance_) << 24u) | (batch->sortKey_ >> 40u);
+}
+
+/// Sort by render order, then distance in reverse, then the highest bits of the state key.
+static inline u64 BackToFrontSortKey(const Batch* batch)
+{
+    return RenderOrderSortKey(batch) | ((u64)(u32)~FloatSortKey(batch->distance_) << 24u) | (batch->sortKey_ >> 40u);
+}
+
+/// Sort by render order, then the state key rewritten by the 2-pass sort: the non-base flag in bit 31 of the shader ID,
+/// a 23-bit shader ID, material ID and geometry ID.
+static inline u64 RemappedStateSortKey(const Batch* batch)
+{
+    return RenderOrderSortKey(batch) | ((batch->sortKey_ >> 63u) << 55u) | (batch->sortKey_ & 0x7fffffffffffffull);
+}
+
+/// Sort batches by packed 64-bit keys. The sort is stable.
+template <class KeyFunction> static void SortBatches(Vector<Batch*>& batches, Vector<RadixSortItem<Batch*>>& items,
+    Vector<RadixSortItem<Batch*>>& temp, KeyFunction getKey)
+{
+    items.Resize(batches.Size());
+    for (i32 i = 0; i < batches.Size(); ++i)
+        items[i] = {getKey(batches[i]), batches[i]};
+
+    RadixSort(items, temp);
+
+    for (i32 i = 0; i < batches.Size(); ++i)
+        batches[i] = items[i].value_;
 }
 
-inline bool CompareBatchGroupOrder(BatchGroup* lhs, BatchGroup* rhs)
+inline bool CompareInstancesFrontToBack(const InstanceData& lhs, const InstanceData& rhs)
 {
-    return lhs->renderOrder_ < rhs->renderOrder_;
+    return lhs.distance_ < rhs.distance_;
 }
 
 void CalculateShadowMatrix(Matrix4& dest, LightBatchQueue* queue, i32 split)
@@ -633,28 +659,13 @@ void Batch::Draw(View* view, Camera* camera, bool allowDepthWrite) const
     }
 }
 
-void BatchGroup::SetInstancingData(void* lockedData, i32 stride, i32& freeIndex)
+void BatchGroup::SetInstancingData(InstancingStorage& storage, const InstancingGroupKey& key)
 {
-    assert(stride >= 0);
-
     // Do not use up buffer space if not going to draw as instanced
     if (geometryType_ != GEOM_INSTANCED)
         return;
 
-    startIndex_ = freeIndex;
-    unsigned char* buffer = static_cast<unsigned char*>(lockedData) + startIndex_ * stride;
-
-    for (const InstanceData& instance : instances_)
-    {
-        memcpy(buffer, instance.worldTransform_, sizeof(Matrix3x4));
-
-        if (instance.instancingData_)
-            memcpy(buffer + sizeof(Matrix3x4), instance.instancingData_, stride - sizeof(Matrix3x4));
-
-        buffer += stride;
-    }
-
-    freeIndex += instances_.Size();
+    startIndex_ = storage.SetInstances(key, instances_.Buffer(), instances_.Size());
 }
 
 void BatchGroup::Draw(View* view, Camera* camera, bool allowDepthWrite) const
@@ -723,7 +734,7 @@ void BatchQueue::SortBackToFront()
     for (i32 i = 0; i < batches_.Size(); ++i)
         sortedBatches_[i] = &batches_[i];
 
-    std::sort(sortedBatches_.Begin(), sortedBatches_.End(), CompareBatchesBackToFront);
+    SortBatches(sortedBatches_, sortItems_, sortTemp_, BackToFrontSortKey);
 
     sortedBatchGroups_.Resize(batchGroups_.Size());
 
@@ -731,7 +742,7 @@ void BatchQueue::SortBackToFront()
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
         sortedBatchGroups_[index++] = &i->second_;
 
-    std::sort(sortedBatchGroups_.Begin(), sortedBatchGroups_.End(), CompareBatchGroupOrder);
+    SortBatches(reinterpret_cast<Vector<Batch*>& >(sortedBatchGroups_), sortItems_, sortTemp_, RenderOrderSortKey);
 }
 
 void BatchQueue::SortFrontToBack()
@@ -755,7 +766,7 @@ void BatchQueue::SortFrontToBack()
         else
         {
             float minDistance = M_INFINITY;
-            for (Vector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
+            for (ArenaVector<InstanceData>::ConstIterator j = i->second_.instances_.Begin(); j != i->second_.instances_.End(); ++j)
                 minDistance = Min(minDistance, j->distance_);
             i->second_.distance_ = minDistance;
         }
@@ -778,7 +789,7 @@ void BatchQueue::SortFrontToBack2Pass(Vector<Batch*>& batches)
     std::sort(batches.Begin(), batches.End(), CompareBatchesState);
 #else
     // For desktop, first sort by distance and remap shader/material/geometry IDs in the sort key
-    std::sort(batches.Begin(), batches.End(), CompareBatchesFrontToBack);
+    SortBatches(batches, sortItems_, sortTemp_, FrontToBackSortKey);
 
     hash32 freeShaderID = 0;
     hash16 freeMaterialID = 0;
@@ -825,16 +836,24 @@ void BatchQueue::SortFrontToBack2Pass(Vector<Batch*>& batches)
     materialRemapping_.Clear();
     geometryRemapping_.Clear();
 
-    // Finally sort again with the rewritten ID's
-    std::sort(batches.Begin(), batches.End(), CompareBatchesState);
+    // Finally sort again with the rewritten ID's. As the sort is stable, batches with the same state stay sorted by distance
+    if (freeShaderID <= 0x800000u)
+        SortBatches(batches, sortItems_, sortTemp_, RemappedStateSortKey);
+    else
+        std::stable_sort(batches.Begin(), batches.End(), CompareBatchesState);
 #endif
 }
 
-void BatchQueue::SetInstancingData(void* lockedData, i32 stride, i32& freeIndex)
+void BatchQueue::SetInstancingData(InstancingStorage& storage)
+{
+    for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
+        i->second_.SetInstancingData(storage, InstancingGroupKey(this, i->first_));
+}
+
+void BatchQueue::ResetInstancingData()
 {
-    assert(stride >= 0);
     for (HashMap<BatchGroupKey, BatchGroup>::Iterator i = batchGroups_.Begin(); i != batchGroups_.End(); ++i)
-        i->second_.SetInstancingData(lockedData, stride, freeIndex);
+        i->second_.startIndex_ = NINDEX;
 }
 
 void BatchQueue::Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const
@@ -4,7 +4,9 @@
 
 #pragma once
 
+#include "../containers/arena_vector.h"
 #include "../containers/ptr.h"
+#include "../containers/radix_sort.h"
 #include "drawable.h"
 #include "material.h"
 #include "../math/math_defs.h"
@@ -17,6 +19,7 @@ namespace dviglo
 class Camera;
 class Drawable;
 class Geometry;
+class InstancingStorage;
 class Light;
 class Material;
 class Matrix3x4;
@@ -26,6 +29,7 @@ class Texture2D;
 class VertexBuffer;
 class View;
 class Zone;
+struct InstancingGroupKey;
 struct LightBatchQueue;
 
 /// Queued 3D geometry draw call.
@@ -145,13 +149,13 @@ struct BatchGroup : public Batch
         }
     }
 
-    /// Pre-set the instance data. Buffer must be big enough to hold all data.
-    void SetInstancingData(void* lockedData, i32 stride, i32& freeIndex);
+    /// Pre-set the instance data to its slice of the instancing storage.
+    void SetInstancingData(InstancingStorage& storage, const InstancingGroupKey& key);
     /// Prepare and draw.
     void Draw(View* view, Camera* camera, bool allowDepthWrite) const;
 
-    /// Instance data.
-    Vector<InstanceData> instances_;
+    /// Instance data. Allocated from the frame arena of the main thread when collected by a view.
+    ArenaVector<InstanceData> instances_;
     /// Instance stream start index, or NINDEX if transforms not pre-set.
     i32 startIndex_;
 };
@@ -216,8 +220,10 @@ public:
     void SortFrontToBack();
     /// Sort batches front to back while also maintaining state sorting.
     void SortFrontToBack2Pass(Vector<Batch*>& batches);
-    /// Pre-set instance data of all groups. The vertex buffer must be big enough to hold all data.
-    void SetInstancingData(void* lockedData, i32 stride, i32& freeIndex);
+    /// Pre-set instance data of all groups to the instancing storage.
+    void SetInstancingData(InstancingStorage& storage);
+    /// Reset instance data of all groups, so that they are drawn without the instancing buffer.
+    void ResetInstancingData();
     /// Draw.
     void Draw(View* view, Camera* camera, bool markToStencil, bool usingLightOptimization, bool allowDepthWrite) const;
     /// Return the combined amount of instances.
@@ -234,6 +240,10 @@ public:
     HashMap<hash16, hash16> materialRemapping_;
     /// Geometry remapping table for 2-pass state and distance sort.
     HashMap<hash16, hash16> geometryRemapping_;
+    /// Draw calls with their packed sort keys.
+    Vector<RadixSortItem<Batch*>> sortItems_;
+    /// Temporary buffer for sorting.
+    Vector<RadixSortItem<Batch*>> sortTemp_;
 
     /// Unsorted non-instanced draw calls.
     Vector<Batch> batches_;
@@ -287,8 +297,8 @@ struct LightBatchQueue
     Vector<ShadowBatchQueue> shadowSplits_;
     /// Per-vertex lights.
     Vector<Light*> vertexLights_;
-    /// Light volume draw calls.
-    Vector<Batch> volumeBatches_;
+    /// Light volume draw calls. Allocated from the frame arena of the main thread.
+    ArenaVector<Batch> volumeBatches_;
 };
 
 }
@@ -32,6 +32,7 @@ DV_FLAGSET(ViewOverride, ViewOverrideFlags);
 class DV_API Camera : public Component
 {
     DV_OBJECT(Camera, Component);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
@@ -1124,7 +1124,7 @@ void DecalSet::UpdateEventSubscription(bool checkAllDecals)
 
     if (enabled && !subscribed_)
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, DV_HANDLER(DecalSet, HandleScenePostUpdate));
+        SubscribeToEvent(scene, &DecalSet::HandleScenePostUpdate);
         subscribed_ = true;
     }
     else if (!enabled && subscribed_)
@@ -1134,11 +1134,9 @@ void DecalSet::UpdateEventSubscription(bool checkAllDecals)
     }
 }
 
-void DecalSet::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void DecalSet::HandleScenePostUpdate(const ScenePostUpdateEventData& eventData)
 {
-    using namespace ScenePostUpdate;
-
-    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    float timeStep = eventData.timeStep_;
 
     for (List<Decal>::Iterator i = decals_.Begin(); i != decals_.End();)
     {
@@ -14,6 +14,7 @@ namespace dviglo
 
 class IndexBuffer;
 class VertexBuffer;
+struct ScenePostUpdateEventData;
 
 /// %Decal vertex.
 struct DecalVertex
@@ -195,7 +196,7 @@ private:
     /// Subscribe/unsubscribe from scene post-update as necessary.
     void UpdateEventSubscription(bool checkAllDecals);
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const ScenePostUpdateEventData& eventData);
 
     /// Geometry.
     SharedPtr<Geometry> geometry_;
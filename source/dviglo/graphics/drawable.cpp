@@ -42,6 +42,7 @@ Drawable::Drawable(DrawableTypes drawableType) :
     updateQueued_(false),
     zoneDirty_(false),
     octant_(nullptr),
+    octantIndex_(0),
     zone_(nullptr),
     viewMask_(DEFAULT_VIEWMASK),
     lightMask_(DEFAULT_LIGHTMASK),
@@ -74,7 +75,7 @@ Drawable::~Drawable()
 void Drawable::RegisterObject()
 {
     DV_ATTRIBUTE("Max Lights", maxLights_, 0, AM_DEFAULT);
-    DV_ATTRIBUTE("View Mask", viewMask_, DEFAULT_VIEWMASK, AM_DEFAULT);
+    DV_ACCESSOR_ATTRIBUTE("View Mask", GetViewMask, SetViewMask, DEFAULT_VIEWMASK, AM_DEFAULT);
     DV_ATTRIBUTE("Light Mask", lightMask_, DEFAULT_LIGHTMASK, AM_DEFAULT);
     DV_ATTRIBUTE("Shadow Mask", shadowMask_, DEFAULT_SHADOWMASK, AM_DEFAULT);
     DV_ACCESSOR_ATTRIBUTE("Zone Mask", GetZoneMask, SetZoneMask, DEFAULT_ZONEMASK, AM_DEFAULT);
@@ -169,6 +170,8 @@ void Drawable::SetLodBias(float bias)
 void Drawable::SetViewMask(mask32 mask)
 {
     viewMask_ = mask;
+    if (octant_)
+        octant_->UpdateDrawableViewMask(this);
     MarkNetworkUpdate();
 }
 
@@ -358,7 +361,7 @@ void Drawable::OnSceneSet(Scene* scene)
 
 void Drawable::OnMarkedDirty(Node* node)
 {
-    worldBoundingBoxDirty_ = true;
+    MarkWorldBoundingBoxDirty();
     if (!updateQueued_ && octant_)
         octant_->GetRoot()->QueueUpdate(this);
 
@@ -367,6 +370,13 @@ void Drawable::OnMarkedDirty(Node* node)
         zoneDirty_ = true;
 }
 
+void Drawable::MarkWorldBoundingBoxDirty()
+{
+    worldBoundingBoxDirty_ = true;
+    if (octant_)
+        octant_->MarkDrawableBoundsDirty(this);
+}
+
 void Drawable::AddToOctree()
 {
     // Do not add to octree when disabled
@@ -100,7 +100,6 @@ class DV_API Drawable : public Component
 
     friend class Octant;
     friend class Octree;
-    friend void UpdateDrawablesWork(const WorkItem* item, i32 threadIndex);
 
 public:
     /// Construct.
@@ -319,6 +318,8 @@ protected:
 
     /// Move into another octree octant.
     void SetOctant(Octant* octant) { octant_ = octant; }
+    /// Mark the world-space bounding box for recalculation. Subclasses must use this instead of setting the dirty flag directly, so that the octant's copy of the bounding box is invalidated too.
+    void MarkWorldBoundingBoxDirty();
 
     /// World-space bounding box.
     BoundingBox worldBoundingBox_;
@@ -342,6 +343,8 @@ protected:
     bool zoneDirty_;
     /// Octree octant.
     Octant* octant_;
+    /// Index in the octant's drawable list.
+    i32 octantIndex_;
     /// Current zone.
     Zone* zone_;
     /// View mask.
@@ -0,0 +1,216 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "instancing_storage.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+/// Changed ranges closer to each other than this many instances are uploaded together.
+static constexpr i32 UPLOAD_RANGE_MERGE_GAP = 8;
+
+/// The storage is repacked when the slices in use take less than this part of it.
+static constexpr i32 REPACK_USAGE_DIVISOR = 4;
+
+void InstancingStorage::SetStride(i32 stride)
+{
+    assert(stride >= (i32)sizeof(Matrix3x4));
+
+    stride_ = stride;
+    size_ = 0;
+    data_.Clear();
+    slices_.Clear();
+    freeSlices_.Clear();
+    dirtyRanges_.Clear();
+    uploadRanges_.Clear();
+}
+
+void InstancingStorage::BeginFrame(i32 frameNumber)
+{
+    if (frameNumber == frameNumber_)
+        return;
+
+    i32 usedSize = 0;
+
+    for (HashMap<InstancingGroupKey, InstancingSlice>::Iterator i = slices_.Begin(); i != slices_.End();)
+    {
+        if (i->second_.frameNumber_ != frameNumber_)
+        {
+            FreeSlice(i->second_);
+            i = slices_.Erase(i);
+        }
+        else
+        {
+            usedSize += i->second_.capacity_;
+            ++i;
+        }
+    }
+
+    if (usedSize * REPACK_USAGE_DIVISOR < size_)
+        Repack();
+
+    frameNumber_ = frameNumber;
+    numInstances_ = 0;
+    numChangedInstances_ = 0;
+    uploadedBytes_ = 0;
+}
+
+i32 InstancingStorage::SetInstances(const InstancingGroupKey& key, const InstanceData* instances, i32 count)
+{
+    assert(stride_ && count >= 0);
+
+    HashMap<InstancingGroupKey, InstancingSlice>::Iterator i = slices_.Find(key);
+    if (i == slices_.End())
+    {
+        InstancingSlice slice;
+        slice.capacity_ = (i32)NextPowerOfTwo((u32)Max(count, 1));
+        slice.start_ = AllocateSlice(slice.capacity_);
+        i = slices_.Insert(MakePair(key, slice));
+    }
+
+    InstancingSlice& slice = i->second_;
+
+    // Move to a better fitting slice when the instance count has grown past the capacity or shrunk well below it.
+    // The data left in a reused slice is what the GPU buffer contains, so the comparison below stays valid
+    if (count > slice.capacity_ || count * 4 < slice.capacity_)
+    {
+        FreeSlice(slice);
+        slice.capacity_ = (i32)NextPowerOfTwo((u32)Max(count, 1));
+        slice.start_ = AllocateSlice(slice.capacity_);
+    }
+
+    slice.frameNumber_ = frameNumber_;
+
+    const i32 extraSize = stride_ - (i32)sizeof(Matrix3x4);
+    u8* buffer = data_.Buffer() + (intptr_t)slice.start_ * stride_;
+    i32 firstChanged = NINDEX;
+    i32 lastChanged = NINDEX;
+
+    for (i32 j = 0; j < count; ++j)
+    {
+        const InstanceData& instance = instances[j];
+        bool changed = false;
+
+        if (memcmp(buffer, instance.worldTransform_, sizeof(Matrix3x4)))
+        {
+            memcpy(buffer, instance.worldTransform_, sizeof(Matrix3x4));
+            changed = true;
+        }
+
+        if (instance.instancingData_ && extraSize && memcmp(buffer + sizeof(Matrix3x4), instance.instancingData_, extraSize))
+        {
+            memcpy(buffer + sizeof(Matrix3x4), instance.instancingData_, extraSize);
+            changed = true;
+        }
+
+        if (changed)
+        {
+            if (firstChanged == NINDEX)
+                firstChanged = j;
+            lastChanged = j;
+            ++numChangedInstances_;
+        }
+
+        buffer += stride_;
+    }
+
+    if (firstChanged != NINDEX)
+        dirtyRanges_.Push(IntVector2(slice.start_ + firstChanged, lastChanged - firstChanged + 1));
+
+    numInstances_ += count;
+    return slice.start_;
+}
+
+void InstancingStorage::Invalidate()
+{
+    dirtyRanges_.Clear();
+    if (size_)
+        dirtyRanges_.Push(IntVector2(0, size_));
+}
+
+void InstancingStorage::Flush()
+{
+    uploadRanges_.Clear();
+    if (dirtyRanges_.Empty())
+        return;
+
+    std::sort(dirtyRanges_.Begin(), dirtyRanges_.End(), [](const IntVector2& lhs, const IntVector2& rhs) { return lhs.x_ < rhs.x_; });
+
+    IntVector2 current = dirtyRanges_[0];
+    for (i32 i = 1; i < dirtyRanges_.Size(); ++i)
+    {
+        const IntVector2& range = dirtyRanges_[i];
+        if (range.x_ <= current.x_ + current.y_ + UPLOAD_RANGE_MERGE_GAP)
+            current.y_ = Max(current.y_, range.x_ + range.y_ - current.x_);
+        else
+        {
+            uploadRanges_.Push(current);
+            current = range;
+        }
+    }
+    uploadRanges_.Push(current);
+    dirtyRanges_.Clear();
+
+    for (const IntVector2& range : uploadRanges_)
+        uploadedBytes_ += range.y_ * stride_;
+}
+
+void InstancingStorage::Repack()
+{
+    i32 newSize = 0;
+    for (HashMap<InstancingGroupKey, InstancingSlice>::ConstIterator i = slices_.Begin(); i != slices_.End(); ++i)
+        newSize += i->second_.capacity_;
+
+    Vector<u8> newData;
+    newData.Resize(newSize * stride_);
+
+    i32 start = 0;
+    for (HashMap<InstancingGroupKey, InstancingSlice>::Iterator i = slices_.Begin(); i != slices_.End(); ++i)
+    {
+        InstancingSlice& slice = i->second_;
+        memcpy(newData.Buffer() + (intptr_t)start * stride_, data_.Buffer() + (intptr_t)slice.start_ * stride_,
+            (size_t)slice.capacity_ * stride_);
+        slice.start_ = start;
+        start += slice.capacity_;
+    }
+
+    data_.Swap(newData);
+    size_ = newSize;
+    freeSlices_.Clear();
+
+    // The slices have moved, so the GPU buffer must be rewritten
+    Invalidate();
+}
+
+i32 InstancingStorage::AllocateSlice(i32 capacity)
+{
+    i32 sizeClass = (i32)LogBaseTwo((u32)capacity);
+    if (sizeClass < freeSlices_.Size() && !freeSlices_[sizeClass].Empty())
+    {
+        i32 start = freeSlices_[sizeClass].Back();
+        freeSlices_[sizeClass].Pop();
+        return start;
+    }
+
+    // Fill the new space with a pattern that no real data has, so that all data written there shows up as changed
+    i32 start = size_;
+    size_ += capacity;
+    data_.Resize(size_ * stride_);
+    memset(data_.Buffer() + (intptr_t)start * stride_, 0xff, (size_t)capacity * stride_);
+    return start;
+}
+
+void InstancingStorage::FreeSlice(const InstancingSlice& slice)
+{
+    i32 sizeClass = (i32)LogBaseTwo((u32)slice.capacity_);
+    if (freeSlices_.Size() <= sizeClass)
+        freeSlices_.Resize(sizeClass + 1);
+    freeSlices_[sizeClass].Push(slice.start_);
+}
+
+}
@@ -0,0 +1,128 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+/// \file
+
+#pragma once
+
+#include "batch.h"
+#include "../containers/hash_map.h"
+#include "../math/vector2.h"
+
+namespace dviglo
+{
+
+/// Identifies an instanced draw call across frames.
+struct InstancingGroupKey
+{
+    /// Construct undefined.
+    InstancingGroupKey() = default;
+
+    /// Construct from a batch queue and a batch group key.
+    InstancingGroupKey(const BatchQueue* queue, const BatchGroupKey& group) :
+        queue_(queue),
+        group_(group)
+    {
+    }
+
+    /// Batch queue.
+    const BatchQueue* queue_;
+    /// Batch group key inside the queue.
+    BatchGroupKey group_;
+
+    /// Test for equality with another key.
+    bool operator ==(const InstancingGroupKey& rhs) const { return queue_ == rhs.queue_ && group_ == rhs.group_; }
+
+    /// Test for inequality with another key.
+    bool operator !=(const InstancingGroupKey& rhs) const { return queue_ != rhs.queue_ || group_ != rhs.group_; }
+
+    /// Return hash value.
+    hash32 ToHash() const { return group_.ToHash() + (hash32)((size_t)queue_ / sizeof(BatchQueue)); }
+};
+
+/// Part of the instancing storage reserved for an instanced draw call.
+struct InstancingSlice
+{
+    /// Index of the first instance.
+    i32 start_;
+    /// Number of reserved instances. Always a power of two.
+    i32 capacity_;
+    /// Frame number when last used.
+    i32 frameNumber_;
+};
+
+/// CPU-side copy of the instancing vertex buffer. Instanced draw calls keep their slice of the buffer across frames, and only
+/// the instances whose data changed are uploaded.
+class DV_API InstancingStorage
+{
+public:
+    /// Set instance size in bytes. Frees all slices.
+    void SetStride(i32 stride);
+    /// Begin filling the storage. Several views can fill it during the same frame. When the frame number changes, the slices
+    /// not used during the previous frame are freed and the counters are reset. If most of the storage is then free, the slices
+    /// in use are moved together and the storage shrinks.
+    void BeginFrame(i32 frameNumber);
+    /// Copy the instance data of a draw call to its slice, reserving the slice if necessary. Return the index of the first instance.
+    i32 SetInstances(const InstancingGroupKey& key, const InstanceData* instances, i32 count);
+    /// Mark all data to be uploaded. Call when the GPU buffer has been recreated or its data has been lost.
+    void Invalidate();
+    /// Combine the changes since the last flush into upload ranges and add them to the counters.
+    void Flush();
+
+    /// Return instance size in bytes.
+    i32 GetStride() const { return stride_; }
+
+    /// Return number of instances the GPU buffer must hold.
+    i32 GetSize() const { return size_; }
+
+    /// Return instance data.
+    const u8* GetData() const { return data_.Buffer(); }
+
+    /// Return ranges of instances (start, count) to upload after the last flush.
+    const Vector<IntVector2>& GetUploadRanges() const { return uploadRanges_; }
+
+    /// Return number of instances set during the current frame.
+    i32 GetNumInstances() const { return numInstances_; }
+
+    /// Return number of instances whose data changed during the current frame.
+    i32 GetNumChangedInstances() const { return numChangedInstances_; }
+
+    /// Return number of bytes uploaded during the current frame.
+    i32 GetUploadedBytes() const { return uploadedBytes_; }
+
+    /// Return number of reserved slices.
+    i32 GetNumSlices() const { return slices_.Size(); }
+
+private:
+    /// Move the slices in use to the start of the storage, free the rest and mark all data to be uploaded.
+    void Repack();
+    /// Reserve a slice with a power of two capacity.
+    i32 AllocateSlice(i32 capacity);
+    /// Return a slice to the free list.
+    void FreeSlice(const InstancingSlice& slice);
+
+    /// Instance data.
+    Vector<u8> data_;
+    /// Slices by draw call.
+    HashMap<InstancingGroupKey, InstancingSlice> slices_;
+    /// Start indices of free slices by the base two logarithm of their capacity.
+    Vector<Vector<i32>> freeSlices_;
+    /// Changed ranges of instances (start, count) since the last flush.
+    Vector<IntVector2> dirtyRanges_;
+    /// Ranges of instances (start, count) to upload after the last flush.
+    Vector<IntVector2> uploadRanges_;
+    /// Instance size in bytes.
+    i32 stride_{};
+    /// Number of instances in use, including the free slices.
+    i32 size_{};
+    /// Current frame number.
+    i32 frameNumber_{-1};
+    /// Number of instances set during the current frame.
+    i32 numInstances_{};
+    /// Number of changed instances during the current frame.
+    i32 numChangedInstances_{};
+    /// Number of uploaded bytes during the current frame.
+    i32 uploadedBytes_{};
+};
+
+}
@@ -132,6 +132,7 @@ struct DV_API FocusParameters
 class DV_API Light : public Drawable
 {
     DV_OBJECT(Light, Drawable);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
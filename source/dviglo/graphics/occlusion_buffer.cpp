@@ -8,6 +8,8 @@
 #include "occlusion_buffer.h"
 #include "../io/log.h"
 
+#include <emmintrin.h>
+
 #include "../common/debug_new.h"
 
 namespace dviglo
@@ -30,12 +32,38 @@ static constexpr float OCCLUSION_RELATIVE_BIAS = 0.00001f;
 static constexpr int OCCLUSION_FIXED_BIAS = 16;
 static constexpr float OCCLUSION_X_SCALE = 65536.0f;
 static constexpr float OCCLUSION_Z_SCALE = 16777216.0f;
+static constexpr i32 OCCLUSION_TILE_MIP_LEVELS = 3;
+static constexpr int OCCLUSION_TILE_GROUPS = OCCLUSION_TILE_SIZE / 4;
+static constexpr i32 OCCLUSION_BINS_PER_THREAD = 4;
+
+/// Select integers from a where mask is set, otherwise from b.
+static inline __m128i SelectInt(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
 
-void DrawOcclusionBatchWork(const WorkItem* item, i32 threadIndex)
+/// Return the maximum of the four lanes.
+static inline int HorizontalMax(__m128i v)
 {
-    auto* buffer = reinterpret_cast<OcclusionBuffer*>(item->aux_);
-    OcclusionBatch& batch = *reinterpret_cast<OcclusionBatch*>(item->start_);
-    buffer->DrawBatch(batch, threadIndex);
+    v = SelectInt(_mm_cmpgt_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1))), v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = SelectInt(_mm_cmpgt_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2))), v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtsi128_si32(v);
+}
+
+/// Return the minimum of the four lanes.
+static inline float HorizontalMin(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
+}
+
+/// Return the maximum of the four lanes.
+static inline float HorizontalMax(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+    v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2)));
+    return _mm_cvtss_f32(v);
 }
 
 OcclusionBuffer::OcclusionBuffer()
@@ -65,6 +93,9 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
 
     width_ = width;
     height_ = height;
+    numTilesX_ = (width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE;
+    numTilesY_ = (height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE;
+    tileDepthValid_ = false;
 
     // Build work buffers for threading
     unsigned numThreadBuffers = threaded ? DV_WORK_QUEUE.GetNumThreads() + 1 : 1;
@@ -78,6 +109,15 @@ bool OcclusionBuffer::SetSize(int width, int height, bool threaded)
         buffer.used_ = false;
     }
 
+    // Build triangle bins for tiled rasterization
+    tileBins_.Resize(threaded ? numThreadBuffers * OCCLUSION_BINS_PER_THREAD : 1);
+    for (OcclusionTileBins& bins : tileBins_)
+    {
+        bins.triangles_.Clear();
+        bins.tiles_.Clear();
+        bins.tiles_.Resize(numTilesX_ * numTilesY_);
+    }
+
     mipBuffers_.Clear();
 
     // Build buffers for mip levels
@@ -130,6 +170,16 @@ void OcclusionBuffer::SetCullMode(CullMode mode)
     cullMode_ = mode;
 }
 
+void OcclusionBuffer::SetMode(OcclusionMode mode)
+{
+    if (mode != mode_)
+    {
+        mode_ = mode;
+        tileDepthValid_ = false;
+        depthHierarchyDirty_ = true;
+    }
+}
+
 void OcclusionBuffer::Reset()
 {
     numTriangles_ = 0;
@@ -145,6 +195,30 @@ void OcclusionBuffer::Clear()
     for (OcclusionBufferData& buffer : buffers_)
         buffer.used_ = false;
 
+    // In tiled mode the mip levels inside the tiles are updated along with the tiles, so they have to start cleared too
+    tileDepthValid_ = IsTiled();
+    if (tileDepthValid_)
+    {
+        int width = width_;
+        int height = height_;
+        auto fillValue = (int)OCCLUSION_Z_SCALE;
+
+        for (i32 i = 0; i < Min(OCCLUSION_TILE_MIP_LEVELS, mipBuffers_.Size()); ++i)
+        {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+
+            DepthValue* dest = mipBuffers_[i].Get();
+            DepthValue* end = dest + width * height;
+            while (dest < end)
+            {
+                dest->min_ = fillValue;
+                dest->max_ = fillValue;
+                ++dest;
+            }
+        }
+    }
+
     depthHierarchyDirty_ = true;
 }
 
@@ -186,7 +260,12 @@ bool OcclusionBuffer::AddTriangles(const Matrix3x4& model, const void* vertexDat
 
 void OcclusionBuffer::DrawTriangles()
 {
-    if (buffers_.Size() == 1)
+    if (IsTiled())
+    {
+        DrawTrianglesTiled();
+        depthHierarchyDirty_ = true;
+    }
+    else if (buffers_.Size() == 1)
     {
         // Not threaded
         for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
@@ -196,20 +275,12 @@ void OcclusionBuffer::DrawTriangles()
     }
     else if (buffers_.Size() > 1)
     {
-        // Threaded
-        WorkQueue& queue = DV_WORK_QUEUE;
-
-        for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+        // Threaded. Each thread draws into its own buffer
+        DV_WORK_QUEUE.ParallelFor(0, batches_.Size(), 1, [this](i32 begin, i32 end, i32 threadIndex)
         {
-            SharedPtr<WorkItem> item = queue.GetFreeItem();
-            item->priority_ = WI_MAX_PRIORITY;
-            item->workFunction_ = DrawOcclusionBatchWork;
-            item->aux_ = this;
-            item->start_ = &(*i);
-            queue.AddWorkItem(item);
-        }
-
-        queue.Complete(WI_MAX_PRIORITY);
+            for (i32 i = begin; i < end; ++i)
+                DrawBatch(batches_[i], threadIndex);
+        });
 
         MergeBuffers();
         depthHierarchyDirty_ = true;
@@ -225,11 +296,23 @@ void OcclusionBuffer::BuildDepthHierarchy()
 
     DV_PROFILE(BuildDepthHierarchy);
 
-    // Build the first mip level from the pixel-level data
     int width = (width_ + 1) / 2;
     int height = (height_ + 1) / 2;
-    if (mipBuffers_.Size())
+    i32 firstLevel = 1;
+
+    if (IsTiled() && tileDepthValid_)
+    {
+        // The mip levels inside the tiles were built while rasterizing
+        firstLevel = Min(OCCLUSION_TILE_MIP_LEVELS, mipBuffers_.Size());
+        for (i32 i = 1; i < firstLevel; ++i)
+        {
+            width = (width + 1) / 2;
+            height = (height + 1) / 2;
+        }
+    }
+    else if (mipBuffers_.Size())
     {
+        // Build the first mip level from the pixel-level data
         for (int y = 0; y < height; ++y)
         {
             int* src = buffers_[0].data_ + (y * 2) * width_;
@@ -268,7 +351,7 @@ void OcclusionBuffer::BuildDepthHierarchy()
     }
 
     // Build the rest of the mip levels
-    for (i32 i = 1; i < mipBuffers_.Size(); ++i)
+    for (i32 i = firstLevel; i < mipBuffers_.Size(); ++i)
     {
         int prevWidth = width;
         int prevHeight = height;
@@ -325,47 +408,52 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
     if (buffers_.Empty())
         return true;
 
-    // Transform corners to projection space
-    Vector4 vertices[8];
-    vertices[0] = ModelTransform(viewProj_, worldSpaceBox.min_);
-    vertices[1] = ModelTransform(viewProj_, Vector3(worldSpaceBox.max_.x_, worldSpaceBox.min_.y_, worldSpaceBox.min_.z_));
-    vertices[2] = ModelTransform(viewProj_, Vector3(worldSpaceBox.min_.x_, worldSpaceBox.max_.y_, worldSpaceBox.min_.z_));
-    vertices[3] = ModelTransform(viewProj_, Vector3(worldSpaceBox.max_.x_, worldSpaceBox.max_.y_, worldSpaceBox.min_.z_));
-    vertices[4] = ModelTransform(viewProj_, Vector3(worldSpaceBox.min_.x_, worldSpaceBox.min_.y_, worldSpaceBox.max_.z_));
-    vertices[5] = ModelTransform(viewProj_, Vector3(worldSpaceBox.max_.x_, worldSpaceBox.min_.y_, worldSpaceBox.max_.z_));
-    vertices[6] = ModelTransform(viewProj_, Vector3(worldSpaceBox.min_.x_, worldSpaceBox.max_.y_, worldSpaceBox.max_.z_));
-    vertices[7] = ModelTransform(viewProj_, worldSpaceBox.max_);
-
-    // Apply a far clip relative bias
-    for (auto& vertice : vertices)
-        vertice.z_ -= OCCLUSION_RELATIVE_BIAS;
-
-    // Transform to screen space. If any of the corners cross the near plane, assume visible
-    float minX, maxX, minY, maxY, minZ;
-
-    if (vertices[0].z_ <= 0.0f)
-        return true;
-
-    Vector3 projected = ViewportTransform(vertices[0]);
-    minX = maxX = projected.x_;
-    minY = maxY = projected.y_;
-    minZ = projected.z_;
-
-    // Project the rest
-    for (unsigned i = 1; i < 8; ++i)
+    // Transform corners to projection space, first the four corners at minimum Z, then the four at maximum Z
+    const Matrix4& m = viewProj_;
+    __m128 x = _mm_setr_ps(worldSpaceBox.min_.x_, worldSpaceBox.max_.x_, worldSpaceBox.min_.x_, worldSpaceBox.max_.x_);
+    __m128 y = _mm_setr_ps(worldSpaceBox.min_.y_, worldSpaceBox.min_.y_, worldSpaceBox.max_.y_, worldSpaceBox.max_.y_);
+    __m128 vMinX = _mm_set1_ps(M_INFINITY);
+    __m128 vMaxX = _mm_set1_ps(-M_INFINITY);
+    __m128 vMinY = _mm_set1_ps(M_INFINITY);
+    __m128 vMaxY = _mm_set1_ps(-M_INFINITY);
+    __m128 vMinZ = _mm_set1_ps(M_INFINITY);
+
+    for (float zValue : {worldSpaceBox.min_.z_, worldSpaceBox.max_.z_})
     {
-        if (vertices[i].z_ <= 0.0f)
+        __m128 z = _mm_set1_ps(zValue);
+        __m128 tx = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m00_), x), _mm_mul_ps(_mm_set1_ps(m.m01_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m02_), z)), _mm_set1_ps(m.m03_));
+        __m128 ty = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m10_), x), _mm_mul_ps(_mm_set1_ps(m.m11_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m12_), z)), _mm_set1_ps(m.m13_));
+        __m128 tz = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m20_), x), _mm_mul_ps(_mm_set1_ps(m.m21_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m22_), z)), _mm_set1_ps(m.m23_));
+        __m128 tw = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(m.m30_), x), _mm_mul_ps(_mm_set1_ps(m.m31_), y)),
+            _mm_mul_ps(_mm_set1_ps(m.m32_), z)), _mm_set1_ps(m.m33_));
+
+        // Apply a far clip relative bias. If any of the corners cross the near plane, assume visible
+        tz = _mm_sub_ps(tz, _mm_set1_ps(OCCLUSION_RELATIVE_BIAS));
+        if (_mm_movemask_ps(_mm_cmple_ps(tz, _mm_setzero_ps())))
             return true;
 
-        projected = ViewportTransform(vertices[i]);
-
-        if (projected.x_ < minX) minX = projected.x_;
-        if (projected.x_ > maxX) maxX = projected.x_;
-        if (projected.y_ < minY) minY = projected.y_;
-        if (projected.y_ > maxY) maxY = projected.y_;
-        if (projected.z_ < minZ) minZ = projected.z_;
+        // Transform to screen space
+        __m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), tw);
+        __m128 px = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, tx), _mm_set1_ps(scaleX_)), _mm_set1_ps(offsetX_));
+        __m128 py = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(invW, ty), _mm_set1_ps(scaleY_)), _mm_set1_ps(offsetY_));
+        __m128 pz = _mm_mul_ps(_mm_mul_ps(invW, tz), _mm_set1_ps(OCCLUSION_Z_SCALE));
+
+        vMinX = _mm_min_ps(vMinX, px);
+        vMaxX = _mm_max_ps(vMaxX, px);
+        vMinY = _mm_min_ps(vMinY, py);
+        vMaxY = _mm_max_ps(vMaxY, py);
+        vMinZ = _mm_min_ps(vMinZ, pz);
     }
 
+    float minX = HorizontalMin(vMinX);
+    float maxX = HorizontalMax(vMaxX);
+    float minY = HorizontalMin(vMinY);
+    float maxY = HorizontalMax(vMaxY);
+    float minZ = HorizontalMin(vMinZ);
+
     // Expand the bounding box 1 pixel in each direction to be conservative and correct rasterization offset
     IntRect rect((int)(minX - 1.5f), (int)(minY - 1.5f), RoundToInt(maxX), RoundToInt(maxY));
 
@@ -423,13 +511,19 @@ bool OcclusionBuffer::IsVisible(const BoundingBox& worldSpaceBox) const
         }
     }
 
-    // If no conclusive result, finally check the pixel-level data
+    // If no conclusive result, finally check the pixel-level data, four pixels at a time
+    __m128i zMinusOne = _mm_set1_epi32(z - 1);
     int* row = buffers_[0].data_ + rect.top_ * width_;
     int* endRow = buffers_[0].data_ + rect.bottom_ * width_;
     while (row <= endRow)
     {
         int* src = row + rect.left_;
         int* end = row + rect.right_;
+        for (; src + 3 <= end; src += 4)
+        {
+            if (_mm_movemask_epi8(_mm_cmpgt_epi32(_mm_loadu_si128((const __m128i*)src), zMinusOne)))
+                return true;
+        }
         while (src <= end)
         {
             if (z <= *src)
@@ -452,8 +546,8 @@ void OcclusionBuffer::DrawBatch(const OcclusionBatch& batch, i32 threadIndex)
 {
     assert(threadIndex >= 0);
 
-    // If buffer not yet used, clear it
-    if (threadIndex > 0 && !buffers_[threadIndex].used_)
+    // If buffer not yet used, clear it. Tiled rasterization bins the triangles instead and needs no thread buffers
+    if (threadIndex > 0 && !IsTiled() && !buffers_[threadIndex].used_)
     {
         ClearBuffer(threadIndex);
         buffers_[threadIndex].used_ = true;
@@ -624,7 +718,10 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, i32 threadIndex)
         bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
         if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
         {
-            DrawTriangle2D(projected, clockwise, threadIndex);
+            if (IsTiled())
+                BinTriangle(projected, threadIndex);
+            else
+                DrawTriangle2D(projected, clockwise, threadIndex);
             drawOk = true;
         }
     }
@@ -662,7 +759,10 @@ void OcclusionBuffer::DrawTriangle(Vector4* vertices, i32 threadIndex)
                 bool clockwise = SignedArea(projected[0], projected[1], projected[2]) < 0.0f;
                 if (cullMode_ == CULL_NONE || (cullMode_ == CULL_CCW && clockwise) || (cullMode_ == CULL_CW && !clockwise))
                 {
-                    DrawTriangle2D(projected, clockwise, threadIndex);
+                    if (IsTiled())
+                        BinTriangle(projected, threadIndex);
+                    else
+                        DrawTriangle2D(projected, clockwise, threadIndex);
                     drawOk = true;
                 }
             }
@@ -994,6 +1094,318 @@ void OcclusionBuffer::DrawTriangle2D(const Vector3* vertices, bool clockwise, i3
     }
 }
 
+void OcclusionBuffer::BinTriangle(const Vector3* vertices, i32 binIndex)
+{
+    assert(binIndex >= 0);
+
+    const Vector3& v0 = vertices[0];
+    const Vector3& v1 = vertices[1];
+    const Vector3& v2 = vertices[2];
+
+    // Pixels are sampled at (x + 1, y + 1) like in the scanline rasterizer. Find the pixels whose samples may be covered
+    int left = Max((int)ceilf(Min(Min(v0.x_, v1.x_), v2.x_)) - 1, 0);
+    int right = Min((int)floorf(Max(Max(v0.x_, v1.x_), v2.x_)) - 1, width_ - 1);
+    int top = Max((int)ceilf(Min(Min(v0.y_, v1.y_), v2.y_)) - 1, 0);
+    int bottom = Min((int)floorf(Max(Max(v0.y_, v1.y_), v2.y_)) - 1, height_ - 1);
+    if (left > right || top > bottom)
+        return;
+
+    float d1X = v1.x_ - v0.x_;
+    float d1Y = v1.y_ - v0.y_;
+    float d1Z = v1.z_ - v0.z_;
+    float d2X = v2.x_ - v0.x_;
+    float d2Y = v2.y_ - v0.y_;
+    float d2Z = v2.z_ - v0.z_;
+    float area = d1X * d2Y - d1Y * d2X;
+    if (area == 0.0f)
+        return;
+
+    OcclusionTileBins& bins = tileBins_[binIndex];
+    i32 triangleIndex = bins.triangles_.Size();
+    bins.triangles_.Resize(triangleIndex + 1);
+    OcclusionTriangle& triangle = bins.triangles_.Back();
+
+    // Orient the edge functions so that the inside of the triangle is positive regardless of the winding
+    float sign = area > 0.0f ? 1.0f : -1.0f;
+    for (int i = 0; i < 3; ++i)
+    {
+        const Vector3& a = vertices[i];
+        const Vector3& b = vertices[(i + 1) % 3];
+        triangle.edgeX_[i] = sign * (a.y_ - b.y_);
+        triangle.edgeY_[i] = sign * (b.x_ - a.x_);
+        triangle.edgeC_[i] = -(triangle.edgeX_[i] * a.x_ + triangle.edgeY_[i] * a.y_);
+    }
+
+    float invArea = 1.0f / area;
+    triangle.depthX_ = (d1Z * d2Y - d2Z * d1Y) * invArea;
+    triangle.depthY_ = (d2Z * d1X - d1Z * d2X) * invArea;
+    triangle.origin_ = v0;
+    triangle.minZ_ = Min(Min(v0.z_, v1.z_), v2.z_);
+    triangle.maxZ_ = Max(Max(v0.z_, v1.z_), v2.z_);
+    triangle.bounds_ = IntRect(left, top, right, bottom);
+
+    for (int tileY = top / OCCLUSION_TILE_SIZE; tileY <= bottom / OCCLUSION_TILE_SIZE; ++tileY)
+    {
+        for (int tileX = left / OCCLUSION_TILE_SIZE; tileX <= right / OCCLUSION_TILE_SIZE; ++tileX)
+            bins.tiles_[tileY * numTilesX_ + tileX].Push(triangleIndex);
+    }
+}
+
+void OcclusionBuffer::DrawTrianglesTiled()
+{
+    i32 numBins = tileBins_.Size();
+    i32 numBatches = batches_.Size();
+    i32 numTiles = numTilesX_ * numTilesY_;
+
+    if (IsThreaded())
+    {
+        // Threaded. The batches are split into consecutive ranges, each with its own bins, for the threads to set up and bin.
+        // Then the threads rasterize whole tiles to the main buffer
+        DV_WORK_QUEUE.ParallelFor(0, numBins, 1, [this, numBins, numBatches](i32 begin, i32 end, i32 /*threadIndex*/)
+        {
+            for (i32 i = begin; i < end; ++i)
+            {
+                for (i32 j = numBatches * i / numBins; j < numBatches * (i + 1) / numBins; ++j)
+                    DrawBatch(batches_[j], i);
+            }
+        });
+
+        DV_WORK_QUEUE.ParallelFor(0, numTiles, 4, [this](i32 begin, i32 end, i32 /*threadIndex*/)
+        {
+            for (i32 i = begin; i < end; ++i)
+                DrawTile(i);
+        });
+    }
+    else
+    {
+        for (Vector<OcclusionBatch>::Iterator i = batches_.Begin(); i != batches_.End(); ++i)
+            DrawBatch(*i, 0);
+
+        for (i32 i = 0; i < numTiles; ++i)
+            DrawTile(i);
+    }
+
+    for (OcclusionTileBins& bins : tileBins_)
+        bins.triangles_.Clear();
+}
+
+void OcclusionBuffer::DrawTile(i32 tileIndex)
+{
+    bool empty = true;
+    for (const OcclusionTileBins& bins : tileBins_)
+    {
+        if (!bins.tiles_[tileIndex].Empty())
+        {
+            empty = false;
+            break;
+        }
+    }
+
+    if (empty)
+        return;
+
+    int tileX = tileIndex % numTilesX_;
+    int tileY = tileIndex / numTilesX_;
+    int left = tileX * OCCLUSION_TILE_SIZE;
+    int top = tileY * OCCLUSION_TILE_SIZE;
+    int numRows = Min(OCCLUSION_TILE_SIZE, height_ - top);
+    int* tileData = buffers_[0].data_ + top * width_ + left;
+
+    // Find the farthest depth in the tile. Triangles behind it can be skipped
+    __m128i maxDepth = _mm_loadu_si128((const __m128i*)tileData);
+    for (int y = 0; y < numRows; ++y)
+    {
+        for (int x = 0; x < OCCLUSION_TILE_SIZE; x += 4)
+        {
+            __m128i depth = _mm_loadu_si128((const __m128i*)(tileData + y * width_ + x));
+            maxDepth = SelectInt(_mm_cmpgt_epi32(depth, maxDepth), depth, maxDepth);
+        }
+    }
+    int tileMax = HorizontalMax(maxDepth);
+
+    __m128 offsets = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+
+    // The bins hold consecutive ranges of batches, so going through them in order keeps the submission order. This way
+    // occluders sorted front to back let the triangles behind them be rejected early
+    for (OcclusionTileBins& bins : tileBins_)
+    {
+        Vector<i32>& tile = bins.tiles_[tileIndex];
+
+        for (i32 triangleIndex : tile)
+        {
+            const OcclusionTriangle& triangle = bins.triangles_[triangleIndex];
+            if (triangle.minZ_ >= (float)tileMax)
+                continue;
+
+            // Rows and 4 pixel wide column groups of the tile the triangle may cover
+            int firstRow = Max(triangle.bounds_.top_ - top, 0);
+            int lastRow = Min(triangle.bounds_.bottom_ - top, numRows - 1);
+            int firstGroup = Max(triangle.bounds_.left_ - left, 0) / 4;
+            int lastGroup = Min(triangle.bounds_.right_ - left, OCCLUSION_TILE_SIZE - 1) / 4;
+
+            // Sample positions of the corner pixels
+            float sampleLeft = (float)(left + firstGroup * 4 + 1);
+            float sampleRight = (float)(left + lastGroup * 4 + 4);
+            float sampleTop = (float)(top + firstRow + 1);
+            float sampleBottom = (float)(top + lastRow + 1);
+
+            // Test the corners against the edges. If the area is fully outside any edge, the triangle can be rejected.
+            // If it is fully inside all edges, the per-pixel edge tests can be skipped
+            bool outside = false;
+            bool covered = true;
+            for (int i = 0; i < 3; ++i)
+            {
+                float edgeX = triangle.edgeX_[i];
+                float edgeY = triangle.edgeY_[i];
+                float minX = edgeX * (edgeX >= 0.0f ? sampleLeft : sampleRight);
+                float maxX = edgeX * (edgeX >= 0.0f ? sampleRight : sampleLeft);
+                float minY = edgeY * (edgeY >= 0.0f ? sampleTop : sampleBottom);
+                float maxY = edgeY * (edgeY >= 0.0f ? sampleBottom : sampleTop);
+
+                if (triangle.edgeC_[i] + maxX + maxY < 0.0f)
+                {
+                    outside = true;
+                    break;
+                }
+                if (triangle.edgeC_[i] + minX + minY < 0.0f)
+                    covered = false;
+            }
+
+            if (outside)
+                continue;
+
+            // Depth range of the triangle within the area
+            float depthLeft = triangle.depthX_ * (sampleLeft - triangle.origin_.x_);
+            float depthRight = triangle.depthX_ * (sampleRight - triangle.origin_.x_);
+            float depthTop = triangle.depthY_ * (sampleTop - triangle.origin_.y_);
+            float depthBottom = triangle.depthY_ * (sampleBottom - triangle.origin_.y_);
+            float minZ = Max(triangle.origin_.z_ + Min(depthLeft, depthRight) + Min(depthTop, depthBottom), triangle.minZ_);
+            if (minZ >= (float)tileMax)
+                continue;
+
+            // Evaluate the edge functions and the depth for the first row, then step them down the rows
+            __m128 edges[3][OCCLUSION_TILE_GROUPS];
+            __m128 edgeSteps[3];
+            __m128 depths[OCCLUSION_TILE_GROUPS];
+            __m128 depthStep = _mm_set1_ps(triangle.depthY_);
+            __m128 clampMin = _mm_set1_ps(triangle.minZ_);
+            __m128 clampMax = _mm_set1_ps(triangle.maxZ_);
+
+            for (int j = firstGroup; j <= lastGroup; ++j)
+            {
+                __m128 sampleX = _mm_add_ps(_mm_set1_ps((float)(left + j * 4 + 1)), offsets);
+
+                for (int i = 0; i < 3; ++i)
+                {
+                    edges[i][j] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.edgeX_[i]), sampleX),
+                        _mm_set1_ps(triangle.edgeY_[i] * sampleTop + triangle.edgeC_[i]));
+                }
+
+                depths[j] = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(triangle.depthX_), _mm_sub_ps(sampleX, _mm_set1_ps(triangle.origin_.x_))),
+                    _mm_set1_ps(triangle.origin_.z_ + triangle.depthY_ * (sampleTop - triangle.origin_.y_)));
+            }
+
+            for (int i = 0; i < 3; ++i)
+                edgeSteps[i] = _mm_set1_ps(triangle.edgeY_[i]);
+
+            __m128i newMaxDepth = _mm_setzero_si128();
+            int* row = tileData + firstRow * width_;
+
+            for (int y = firstRow; y <= lastRow; ++y)
+            {
+                for (int j = firstGroup; j <= lastGroup; ++j)
+                {
+                    __m128i depth = _mm_cvttps_epi32(_mm_min_ps(_mm_max_ps(depths[j], clampMin), clampMax));
+                    __m128i old = _mm_loadu_si128((const __m128i*)(row + j * 4));
+                    __m128i mask = _mm_cmplt_epi32(depth, old);
+
+                    if (!covered)
+                    {
+                        __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edges[0][j], _mm_setzero_ps()),
+                            _mm_cmpge_ps(edges[1][j], _mm_setzero_ps())), _mm_cmpge_ps(edges[2][j], _mm_setzero_ps()));
+                        mask = _mm_and_si128(mask, _mm_castps_si128(inside));
+
+                        for (int i = 0; i < 3; ++i)
+                            edges[i][j] = _mm_add_ps(edges[i][j], edgeSteps[i]);
+                    }
+
+                    __m128i result = SelectInt(mask, depth, old);
+                    _mm_storeu_si128((__m128i*)(row + j * 4), result);
+                    newMaxDepth = SelectInt(_mm_cmpgt_epi32(result, newMaxDepth), result, newMaxDepth);
+                    depths[j] = _mm_add_ps(depths[j], depthStep);
+                }
+
+                row += width_;
+            }
+
+            // If the whole tile was written, the farthest depth in it is now known exactly
+            if (firstRow == 0 && lastRow == numRows - 1 && firstGroup == 0 && lastGroup == OCCLUSION_TILE_GROUPS - 1)
+                tileMax = HorizontalMax(newMaxDepth);
+        }
+
+        tile.Clear();
+    }
+
+    if (tileDepthValid_)
+        BuildTileDepthHierarchy(tileX, tileY);
+}
+
+void OcclusionBuffer::BuildTileDepthHierarchy(int tileX, int tileY)
+{
+    int width = width_;
+    int height = height_;
+
+    for (i32 i = 0; i < Min(OCCLUSION_TILE_MIP_LEVELS, mipBuffers_.Size()); ++i)
+    {
+        int prevWidth = width;
+        int prevHeight = height;
+        width = (width + 1) / 2;
+        height = (height + 1) / 2;
+
+        int shift = i + 1;
+        int left = (tileX * OCCLUSION_TILE_SIZE) >> shift;
+        int right = ((tileX + 1) * OCCLUSION_TILE_SIZE) >> shift;
+        int top = (tileY * OCCLUSION_TILE_SIZE) >> shift;
+        int bottom = Min(((tileY + 1) * OCCLUSION_TILE_SIZE) >> shift, height);
+
+        for (int y = top; y < bottom; ++y)
+        {
+            DepthValue* dest = mipBuffers_[i].Get() + y * width + left;
+            DepthValue* end = dest + (right - left);
+            bool hasLower = y * 2 + 1 < prevHeight;
+
+            if (!i)
+            {
+                int* src = buffers_[0].data_ + (y * 2) * prevWidth + left * 2;
+                int* src2 = hasLower ? src + prevWidth : src;
+                while (dest < end)
+                {
+                    dest->min_ = Min(Min(src[0], src[1]), Min(src2[0], src2[1]));
+                    dest->max_ = Max(Max(src[0], src[1]), Max(src2[0], src2[1]));
+
+                    src += 2;
+                    src2 += 2;
+                    ++dest;
+                }
+            }
+            else
+            {
+                DepthValue* src = mipBuffers_[i - 1].Get() + (y * 2) * prevWidth + left * 2;
+                DepthValue* src2 = hasLower ? src + prevWidth : src;
+                while (dest < end)
+                {
+                    dest->min_ = Min(Min(src[0].min_, src[1].min_), Min(src2[0].min_, src2[1].min_));
+                    dest->max_ = Max(Max(src[0].max_, src[1].max_), Max(src2[0].max_, src2[1].max_));
+
+                    src += 2;
+                    src2 += 2;
+                    ++dest;
+                }
+            }
+        }
+    }
+}
+
 void OcclusionBuffer::MergeBuffers()
 {
     DV_PROFILE(MergeBuffers);
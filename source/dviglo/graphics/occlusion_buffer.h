@@ -23,6 +23,19 @@ class VertexBuffer;
 struct Edge;
 struct Gradients;
 
+/// Tile size in pixels for tiled occlusion rasterization.
+static constexpr int OCCLUSION_TILE_SIZE = 8;
+
+/// Occlusion buffer rasterization mode.
+enum OcclusionMode
+{
+    /// Scanline rasterization. When threaded, each thread draws whole batches to its own buffer and the buffers are merged.
+    OCCLUSION_SCANLINE = 0,
+    /// Triangles are binned into 8x8 pixel tiles, which are rasterized with SIMD edge functions. When threaded, both the binning
+    /// and the tiles are distributed to the threads and no merge is needed.
+    OCCLUSION_TILED
+};
+
 /// Occlusion hierarchy depth value.
 struct DepthValue
 {
@@ -43,6 +56,38 @@ struct OcclusionBufferData
     bool used_;
 };
 
+/// Occlusion triangle set up for tiled rasterization.
+struct OcclusionTriangle
+{
+    /// Edge function X coefficients. A sample is inside the triangle when all edge functions are non-negative.
+    float edgeX_[3];
+    /// Edge function Y coefficients.
+    float edgeY_[3];
+    /// Edge function constants.
+    float edgeC_[3];
+    /// Horizontal depth gradient.
+    float depthX_;
+    /// Vertical depth gradient.
+    float depthY_;
+    /// Position and depth of the first vertex, from which the depth is interpolated.
+    Vector3 origin_;
+    /// Minimum vertex depth.
+    float minZ_;
+    /// Maximum vertex depth.
+    float maxZ_;
+    /// Pixels whose samples may be inside the triangle. Right and bottom are inclusive.
+    IntRect bounds_;
+};
+
+/// Triangles binned to tiles.
+struct OcclusionTileBins
+{
+    /// Triangles.
+    Vector<OcclusionTriangle> triangles_;
+    /// Indices of the triangles overlapping each tile.
+    Vector<Vector<i32>> tiles_;
+};
+
 /// Stored occlusion render job.
 struct OcclusionBatch
 {
@@ -81,6 +126,8 @@ public:
     void SetMaxTriangles(unsigned triangles);
     /// Set culling mode.
     void SetCullMode(CullMode mode);
+    /// Set rasterization mode. Takes effect from the next Clear().
+    void SetMode(OcclusionMode mode);
     /// Reset number of triangles.
     void Reset();
     /// Clear the buffer.
@@ -121,6 +168,9 @@ public:
     /// Return culling mode.
     CullMode GetCullMode() const { return cullMode_; }
 
+    /// Return rasterization mode.
+    OcclusionMode GetMode() const { return mode_; }
+
     /// Return whether is using threads to speed up rendering.
     bool IsThreaded() const { return buffers_.Size() > 1; }
 
@@ -129,7 +179,7 @@ public:
     /// Return time since last use in milliseconds.
     unsigned GetUseTimer();
 
-    /// Draw a batch. Called internally.
+    /// Draw a batch. Called internally. In tiled mode the thread index selects the triangle bins instead.
     void DrawBatch(const OcclusionBatch& batch, i32 threadIndex);
 
 private:
@@ -149,6 +199,16 @@ private:
     void ClipVertices(const Vector4& plane, Vector4* vertices, bool* triangles, unsigned& numTriangles);
     /// Draw a clipped triangle.
     void DrawTriangle2D(const Vector3* vertices, bool clockwise, i32 threadIndex);
+    /// Return whether tiled rasterization is in use.
+    bool IsTiled() const { return mode_ == OCCLUSION_TILED && width_ >= OCCLUSION_TILE_SIZE; }
+    /// Set up a clipped triangle and add it to the bins of the tiles it overlaps.
+    void BinTriangle(const Vector3* vertices, i32 binIndex);
+    /// Draw submitted batches with tiled rasterization.
+    void DrawTrianglesTiled();
+    /// Rasterize the binned triangles of a tile.
+    void DrawTile(i32 tileIndex);
+    /// Build the mip levels that fall inside a tile.
+    void BuildTileDepthHierarchy(int tileX, int tileY);
     /// Clear a thread work buffer.
     void ClearBuffer(i32 threadIndex);
     /// Merge thread work buffers into the first buffer.
@@ -158,6 +218,8 @@ private:
     Vector<OcclusionBufferData> buffers_;
     /// Reduced size depth buffers.
     Vector<SharedArrayPtr<DepthValue>> mipBuffers_;
+    /// Binned triangles for tiled rasterization. When threaded, there are several bins per thread, each for a consecutive range of batches.
+    Vector<OcclusionTileBins> tileBins_;
     /// Submitted render jobs.
     Vector<OcclusionBatch> batches_;
     /// Buffer width.
@@ -170,6 +232,14 @@ private:
     unsigned maxTriangles_;
     /// Culling mode.
     CullMode cullMode_{CULL_CCW};
+    /// Rasterization mode.
+    OcclusionMode mode_{OCCLUSION_SCANLINE};
+    /// Number of tiles horizontally.
+    int numTilesX_{};
+    /// Number of tiles vertically.
+    int numTilesY_{};
+    /// Mip levels inside the tiles are up to date flag. Set when cleared in tiled mode.
+    bool tileDepthValid_{};
     /// Depth hierarchy needs update flag.
     bool depthHierarchyDirty_{true};
     /// Culling reverse flag.
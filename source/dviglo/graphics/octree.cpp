@@ -28,21 +28,6 @@ static const int DEFAULT_OCTREE_LEVELS = 8;
 
 extern const char* SUBSYSTEM_CATEGORY;
 
-void UpdateDrawablesWork(const WorkItem* item, i32 threadIndex)
-{
-    const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
-
-    while (start != end)
-    {
-        Drawable* drawable = *start;
-        if (drawable)
-            drawable->Update(frame);
-        ++start;
-    }
-}
-
 inline bool CompareRayQueryResults(const RayQueryResult& lhs, const RayQueryResult& rhs)
 {
     return lhs.distance_ < rhs.distance_;
@@ -56,7 +41,7 @@ Octant::Octant(const BoundingBox& box, i32 level, Octant* parent, Octree* root,
 {
     assert(index >= 0 || index == ROOT_INDEX);
     assert(level >= 0);
-    Initialize(box);
+    Initialize(box, parent ? root->GetLooseness() : DEFAULT_OCTREE_LOOSENESS);
 }
 
 Octant::~Octant()
@@ -66,11 +51,11 @@ Octant::~Octant()
         // Remove the drawables (if any) from this octant to the root octant
         for (Vector<Drawable*>::Iterator i = drawables_.Begin(); i != drawables_.End(); ++i)
         {
-            (*i)->SetOctant(root_);
-            root_->drawables_.Push(*i);
+            root_->PushDrawable(*i);
             root_->QueueUpdate(*i);
         }
         drawables_.Clear();
+        drawableBounds_.Clear();
         numDrawables_ = 0;
     }
 
@@ -133,9 +118,10 @@ void Octant::InsertDrawable(Drawable* drawable)
         if (oldOctant != this)
         {
             // Add first, then remove, because drawable count going to zero deletes the octree branch in question
+            i32 oldIndex = drawable->octantIndex_;
             AddDrawable(drawable);
             if (oldOctant)
-                oldOctant->RemoveDrawable(drawable, false);
+                oldOctant->EraseDrawable(oldIndex);
         }
     }
     else
@@ -151,28 +137,40 @@ void Octant::InsertDrawable(Drawable* drawable)
 
 bool Octant::CheckDrawableFit(const BoundingBox& box) const
 {
-    Vector3 boxSize = box.Size();
+    // If max split level, size always OK
+    if (level_ >= root_->GetNumLevels())
+        return true;
 
-    // If max split level, size always OK, otherwise check that box is at least half size of octant
-    if (level_ >= root_->GetNumLevels() || boxSize.x_ >= halfSize_.x_ || boxSize.y_ >= halfSize_.y_ ||
-        boxSize.z_ >= halfSize_.z_)
+    // Otherwise check that the box fits the loose culling box of the child octant that contains its center.
+    // With looseness 1 the culling box is the octant itself, so the octree works as a tight one
+    Vector3 boxCenter = box.Center();
+    Vector3 childMin(boxCenter.x_ < center_.x_ ? worldBoundingBox_.min_.x_ : center_.x_,
+        boxCenter.y_ < center_.y_ ? worldBoundingBox_.min_.y_ : center_.y_,
+        boxCenter.z_ < center_.z_ ? worldBoundingBox_.min_.z_ : center_.z_);
+    Vector3 childMax(boxCenter.x_ < center_.x_ ? center_.x_ : worldBoundingBox_.max_.x_,
+        boxCenter.y_ < center_.y_ ? center_.y_ : worldBoundingBox_.max_.y_,
+        boxCenter.z_ < center_.z_ ? center_.z_ : worldBoundingBox_.max_.z_);
+
+    // If the box does not fit, must insert here
+    if (box.min_.x_ < childMin.x_ - childMargin_.x_ || box.max_.x_ > childMax.x_ + childMargin_.x_ ||
+        box.min_.y_ < childMin.y_ - childMargin_.y_ || box.max_.y_ > childMax.y_ + childMargin_.y_ ||
+        box.min_.z_ < childMin.z_ - childMargin_.z_ || box.max_.z_ > childMax.z_ + childMargin_.z_)
         return true;
-    // Also check if the box can not fit a child octant's culling box, in that case size OK (must insert here)
-    else
-    {
-        if (box.min_.x_ <= worldBoundingBox_.min_.x_ - 0.5f * halfSize_.x_ ||
-            box.max_.x_ >= worldBoundingBox_.max_.x_ + 0.5f * halfSize_.x_ ||
-            box.min_.y_ <= worldBoundingBox_.min_.y_ - 0.5f * halfSize_.y_ ||
-            box.max_.y_ >= worldBoundingBox_.max_.y_ + 0.5f * halfSize_.y_ ||
-            box.min_.z_ <= worldBoundingBox_.min_.z_ - 0.5f * halfSize_.z_ ||
-            box.max_.z_ >= worldBoundingBox_.max_.z_ + 0.5f * halfSize_.z_)
-            return true;
-    }
 
-    // Bounding box too small, should create a child octant
+    // Bounding box small enough, should create a child octant
     return false;
 }
 
+Octant* Octant::FindContainingOctant(const BoundingBox& box)
+{
+    Octant* octant = this;
+
+    while (octant != root_ && octant->cullingBox_.IsInside(box) != INSIDE)
+        octant = octant->parent_;
+
+    return octant;
+}
+
 void Octant::ResetRoot()
 {
     root_ = nullptr;
@@ -202,12 +200,17 @@ void Octant::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
     }
 }
 
-void Octant::Initialize(const BoundingBox& box)
+void Octant::Initialize(const BoundingBox& box, float looseness)
 {
     worldBoundingBox_ = box;
     center_ = box.Center();
     halfSize_ = 0.5f * box.Size();
-    cullingBox_ = BoundingBox(worldBoundingBox_.min_ - halfSize_, worldBoundingBox_.max_ + halfSize_);
+
+    // The culling box extends the world box by the same fraction of the octant size on each side.
+    // A child octant is half the size, so its margin is half of this
+    Vector3 margin = (looseness - 1.0f) * halfSize_;
+    cullingBox_ = BoundingBox(worldBoundingBox_.min_ - margin, worldBoundingBox_.max_ + margin);
+    childMargin_ = 0.5f * margin;
 }
 
 void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
@@ -227,8 +230,10 @@ void Octant::GetDrawablesInternal(OctreeQuery& query, bool inside) const
     if (drawables_.Size())
     {
         auto** start = const_cast<Drawable**>(&drawables_[0]);
-        Drawable** end = start + drawables_.Size();
-        query.TestDrawables(start, end, inside);
+        if (inside)
+            query.TestInsideDrawables(start, drawableBounds_);
+        else
+            query.TestDrawableBounds(start, drawableBounds_);
     }
 
     for (auto child : children_)
@@ -246,15 +251,10 @@ void Octant::GetDrawablesInternal(RayOctreeQuery& query) const
 
     if (drawables_.Size())
     {
-        auto** start = const_cast<Drawable**>(&drawables_[0]);
-        Drawable** end = start + drawables_.Size();
-
-        while (start != end)
+        for (i32 i = 0; i < drawables_.Size(); ++i)
         {
-            Drawable* drawable = *start++;
-
-            if (!!(drawable->GetDrawableType() & query.drawableTypes_) && (drawable->GetViewMask() & query.viewMask_))
-                drawable->ProcessRayQuery(query, query.result_);
+            if (drawableBounds_.Matches(i, query.drawableTypes_, query.viewMask_))
+                drawables_[i]->ProcessRayQuery(query, query.result_);
         }
     }
 
@@ -273,15 +273,10 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, Vector<Drawable*>&
 
     if (drawables_.Size())
     {
-        auto** start = const_cast<Drawable**>(&drawables_[0]);
-        Drawable** end = start + drawables_.Size();
-
-        while (start != end)
+        for (i32 i = 0; i < drawables_.Size(); ++i)
         {
-            Drawable* drawable = *start++;
-
-            if (!!(drawable->GetDrawableType() & query.drawableTypes_) && (drawable->GetViewMask() & query.viewMask_))
-                drawables.Push(drawable);
+            if (drawableBounds_.Matches(i, query.drawableTypes_, query.viewMask_))
+                drawables.Push(drawables_[i]);
         }
     }
 
@@ -294,7 +289,8 @@ void Octant::GetDrawablesOnlyInternal(RayOctreeQuery& query, Vector<Drawable*>&
 
 Octree::Octree() :
     Octant(BoundingBox(-DEFAULT_OCTREE_SIZE, DEFAULT_OCTREE_SIZE), 0, nullptr, this),
-    numLevels_(DEFAULT_OCTREE_LEVELS)
+    numLevels_(DEFAULT_OCTREE_LEVELS),
+    looseness_(DEFAULT_OCTREE_LOOSENESS)
 {
     // If the engine is running headless, subscribe to RenderUpdate events for manually updating the octree
     // to allow raycasts and animation update
@@ -319,6 +315,7 @@ void Octree::RegisterObject()
     DV_ATTRIBUTE_EX("Bounding Box Min", worldBoundingBox_.min_, UpdateOctreeSize, defaultBoundsMin, AM_DEFAULT);
     DV_ATTRIBUTE_EX("Bounding Box Max", worldBoundingBox_.max_, UpdateOctreeSize, defaultBoundsMax, AM_DEFAULT);
     DV_ATTRIBUTE_EX("Number of Levels", numLevels_, UpdateOctreeSize, DEFAULT_OCTREE_LEVELS, AM_DEFAULT);
+    DV_ACCESSOR_ATTRIBUTE("Looseness", GetLooseness, SetLooseness, DEFAULT_OCTREE_LOOSENESS, AM_DEFAULT);
 }
 
 void Octree::DrawDebugGeometry(DebugRenderer* debug, bool depthTest)
@@ -341,11 +338,21 @@ void Octree::SetSize(const BoundingBox& box, i32 numLevels)
     for (i32 i = 0; i < NUM_OCTANTS; ++i)
         DeleteChild(i);
 
-    Initialize(box);
+    Initialize(box, looseness_);
     numDrawables_ = drawables_.Size();
     numLevels_ = Max(numLevels, 1);
 }
 
+void Octree::SetLooseness(float looseness)
+{
+    looseness = Max(looseness, 1.0f);
+    if (looseness == looseness_)
+        return;
+
+    looseness_ = looseness;
+    UpdateOctreeSize();
+}
+
 void Octree::Update(const FrameInfo& frame)
 {
     if (!Thread::IsMainThread())
@@ -354,6 +361,11 @@ void Octree::Update(const FrameInfo& frame)
         return;
     }
 
+    // If the scene updates world transforms in one pass, do it before the drawables read them
+    Scene* scene = GetScene();
+    if (scene)
+        scene->UpdateTransforms();
+
     // Let drawables update themselves before reinsertion. This can be used for animation
     if (!drawableUpdates_.Empty())
     {
@@ -361,34 +373,18 @@ void Octree::Update(const FrameInfo& frame)
 
         // Perform updates in worker threads. Notify the scene that a threaded update is going on and components
         // (for example physics objects) should not perform non-threadsafe work when marked dirty
-        Scene* scene = GetScene();
-        WorkQueue& queue = DV_WORK_QUEUE;
         scene->BeginThreadedUpdate();
 
-        int numWorkItems = queue.GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = Max((int)(drawableUpdates_.Size() / numWorkItems), 1);
-
-        Vector<Drawable*>::Iterator start = drawableUpdates_.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        DV_WORK_QUEUE.ParallelFor(0, drawableUpdates_.Size(), 16, [this, &frame](i32 begin, i32 end, i32 threadIndex)
         {
-            SharedPtr<WorkItem> item = queue.GetFreeItem();
-            item->priority_ = WI_MAX_PRIORITY;
-            item->workFunction_ = UpdateDrawablesWork;
-            item->aux_ = const_cast<FrameInfo*>(&frame);
-
-            Vector<Drawable*>::Iterator end = drawableUpdates_.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue.AddWorkItem(item);
-
-            start = end;
-        }
+            for (i32 i = begin; i < end; ++i)
+            {
+                Drawable* drawable = drawableUpdates_[i];
+                if (drawable)
+                    drawable->Update(frame);
+            }
+        });
 
-        queue.Complete(WI_MAX_PRIORITY);
         scene->EndThreadedUpdate();
     }
 
@@ -411,7 +407,6 @@ void Octree::Update(const FrameInfo& frame)
     }
 
     // Notify drawable update being finished. Custom animation (eg. IK) can be done at this point
-    Scene* scene = GetScene();
     if (scene)
     {
         using namespace SceneDrawableUpdateFinished;
@@ -438,11 +433,20 @@ void Octree::Update(const FrameInfo& frame)
             // Skip if no octant or does not belong to this octree anymore
             if (!octant || octant->GetRoot() != this)
                 continue;
-            // Skip if still fits the current octant
+            // Skip if still fits the current octant. Refresh the octant's copy of the bounding box here in the main thread,
+            // as the queries only read it
             if (drawable->IsOccludee() && octant->GetCullingBox().IsInside(box) == INSIDE && octant->CheckDrawableFit(box))
+            {
+                octant->UpdateDrawableBounds(drawable);
                 continue;
+            }
 
-            InsertDrawable(drawable);
+            // Reinsert starting from the closest octant that still contains the drawable instead of the root,
+            // as moving objects usually stay in the same branch. Non-occludees must be inserted to the root
+            if (drawable->IsOccludee())
+                octant->FindContainingOctant(box)->InsertDrawable(drawable);
+            else
+                InsertDrawable(drawable);
 
 #ifdef _DEBUG
             // Verify that the drawable will be culled correctly
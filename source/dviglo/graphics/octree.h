@@ -16,6 +16,7 @@ class Octree;
 
 static const int NUM_OCTANTS = 8;
 static const i32 ROOT_INDEX = NINDEX;
+static const float DEFAULT_OCTREE_LOOSENESS = 2.0f;
 
 /// %Octree octant.
 class DV_API Octant
@@ -38,28 +39,40 @@ public:
     /// Add a drawable object to this octant.
     void AddDrawable(Drawable* drawable)
     {
-        drawable->SetOctant(this);
-        drawables_.Push(drawable);
+        PushDrawable(drawable);
         IncDrawableCount();
     }
 
     /// Remove a drawable object from this octant.
     void RemoveDrawable(Drawable* drawable, bool resetOctant = true)
     {
-        if (drawables_.Remove(drawable))
+        i32 index = drawable->octant_ == this ? drawable->octantIndex_ : drawables_.IndexOf(drawable);
+        if (index < drawables_.Size() && drawables_[index] == drawable)
         {
             if (resetOctant)
                 drawable->SetOctant(nullptr);
-            DecDrawableCount();
+            EraseDrawable(index);
         }
     }
 
+    /// Copy the recalculated world bounding box of a drawable object in this octant. Called by Octree::Update() in the main thread, never by the queries.
+    void UpdateDrawableBounds(const Drawable* drawable) { drawableBounds_.Set(drawable->octantIndex_, drawable->worldBoundingBox_); }
+
+    /// Mark the copy of the world bounding box of a drawable object in this octant outdated.
+    void MarkDrawableBoundsDirty(const Drawable* drawable) { drawableBounds_.SetDirty(drawable->octantIndex_); }
+
+    /// Copy the changed view mask of a drawable object in this octant.
+    void UpdateDrawableViewMask(const Drawable* drawable) { drawableBounds_.SetViewMask(drawable->octantIndex_, drawable->viewMask_); }
+
     /// Return world-space bounding box.
     const BoundingBox& GetWorldBoundingBox() const { return worldBoundingBox_; }
 
     /// Return bounding box used for fitting drawable objects.
     const BoundingBox& GetCullingBox() const { return cullingBox_; }
 
+    /// Return the closest octant (this or a parent) whose culling box fully contains the bounding box, or the root if none does.
+    Octant* FindContainingOctant(const BoundingBox& box);
+
     /// Return subdivision level.
     i32 GetLevel() const { return level_; }
 
@@ -81,8 +94,8 @@ public:
     void DrawDebugGeometry(DebugRenderer* debug, bool depthTest);
 
 protected:
-    /// Initialize bounding box.
-    void Initialize(const BoundingBox& box);
+    /// Initialize bounding box. Looseness is the culling box size relative to the world bounding box size.
+    void Initialize(const BoundingBox& box, float looseness);
     /// Return drawable objects by a query, called internally.
     void GetDrawablesInternal(OctreeQuery& query, bool inside) const;
     /// Return drawable objects by a ray query, called internally.
@@ -90,6 +103,25 @@ protected:
     /// Return drawable objects only for a threaded ray query, called internally.
     void GetDrawablesOnlyInternal(RayOctreeQuery& query, Vector<Drawable*>& drawables) const;
 
+    /// Add a drawable object to the list without changing the drawable counts.
+    void PushDrawable(Drawable* drawable)
+    {
+        drawable->SetOctant(this);
+        drawable->octantIndex_ = drawables_.Size();
+        drawables_.Push(drawable);
+        drawableBounds_.Push(drawable->worldBoundingBox_, drawable->worldBoundingBoxDirty_, drawable->drawableType_, drawable->viewMask_);
+    }
+
+    /// Remove a drawable object from the list by index. The last drawable object is moved in its place.
+    void EraseDrawable(i32 index)
+    {
+        drawables_.EraseSwap(index);
+        drawableBounds_.EraseSwap(index);
+        if (index < drawables_.Size())
+            drawables_[index]->octantIndex_ = index;
+        DecDrawableCount();
+    }
+
     /// Increase drawable object count recursively.
     void IncDrawableCount()
     {
@@ -120,12 +152,16 @@ protected:
     BoundingBox cullingBox_;
     /// Drawable objects.
     Vector<Drawable*> drawables_;
+    /// Copy of the drawable objects' world bounding boxes for the queries.
+    DrawableBounds drawableBounds_;
     /// Child octants.
     Octant* children_[NUM_OCTANTS]{};
     /// World bounding box center.
     Vector3 center_;
     /// World bounding box half size.
     Vector3 halfSize_;
+    /// Margin of the child octants' culling boxes.
+    Vector3 childMargin_;
     /// Subdivision level.
     i32 level_;
     /// Number of drawable objects in this octant and child octants.
@@ -156,6 +192,10 @@ public:
 
     /// Set size and maximum subdivision levels. If octree is not empty, drawable objects will be temporarily moved to the root.
     void SetSize(const BoundingBox& box, i32 numLevels);
+    /// Set octant culling box size relative to the octant size (minimum 1, which gives a tight octree). Larger values let moving drawable objects stay
+    /// in their octants longer at the cost of less precise octant culling. If octree is not empty, drawable objects will be
+    /// temporarily moved to the root.
+    void SetLooseness(float looseness);
     /// Update and reinsert drawable objects.
     void Update(const FrameInfo& frame);
     /// Add a drawable manually.
@@ -173,6 +213,9 @@ public:
     /// Return subdivision levels.
     i32 GetNumLevels() const { return numLevels_; }
 
+    /// Return octant culling box size relative to the octant size.
+    float GetLooseness() const { return looseness_; }
+
     /// Mark drawable object as requiring an update and a reinsertion.
     void QueueUpdate(Drawable* drawable);
     /// Cancel drawable object's update.
@@ -196,6 +239,8 @@ private:
     mutable Vector<Drawable*> rayQueryDrawables_;
     /// Subdivision level.
     i32 numLevels_;
+    /// Octant culling box size relative to the octant size.
+    float looseness_;
 };
 
 }
@@ -9,6 +9,91 @@
 namespace dviglo
 {
 
+/// Give the runs of drawables which match the drawable types and view mask of the query to TestDrawables().
+static void TestMatchingDrawables(OctreeQuery& query, Drawable** drawables, const DrawableBounds& bounds, bool inside)
+{
+    i32 size = bounds.Size();
+    i32 runStart = 0;
+
+    for (i32 i = 0; i < size; ++i)
+    {
+        if (!bounds.Matches(i, query.drawableTypes_, query.viewMask_))
+        {
+            if (runStart < i)
+                query.TestDrawables(drawables + runStart, drawables + i, inside);
+            runStart = i + 1;
+        }
+    }
+
+    if (runStart < size)
+        query.TestDrawables(drawables + runStart, drawables + size, inside);
+}
+
+/// Test the bounding boxes four at a time. test4 receives the min and max coordinates of four boxes and returns a mask
+/// of the boxes which are outside. Drawables which pass are given to TestDrawables() as inside, in their original order.
+/// Drawables with a dirty bounding box are given to TestDrawables() one by one for the exact test. Drawables which do not
+/// match the drawable types and view mask of the query are skipped.
+template <class Test4>
+static void CullDrawableBounds(OctreeQuery& query, Drawable** drawables, const DrawableBounds& bounds, const Test4& test4)
+{
+    const i32 MAX_CANDIDATES = 64;
+    Drawable* candidates[MAX_CANDIDATES];
+    i32 numCandidates = 0;
+    i32 size = bounds.Size();
+    DrawableTypes drawableTypes = query.drawableTypes_;
+    mask32 viewMask = query.viewMask_;
+
+    for (i32 i = 0; i < size; i += 4)
+    {
+        // The unused entries of the last block are tested too, but ignored
+        const DrawableBoundsBlock& block = bounds.blocks_[i / 4];
+        i32 count = Min(size - i, 4);
+        i32 outside = _mm_movemask_ps(test4(_mm_loadu_ps(block.minX_), _mm_loadu_ps(block.minY_), _mm_loadu_ps(block.minZ_),
+            _mm_loadu_ps(block.maxX_), _mm_loadu_ps(block.maxY_), _mm_loadu_ps(block.maxZ_)));
+
+        for (i32 j = 0; j < count; ++j)
+        {
+            if (!(block.drawableType_[j] & drawableTypes) || !(block.viewMask_[j] & viewMask))
+                continue;
+
+            Drawable** drawable = drawables + i + j;
+
+            if (block.dirty_[j])
+            {
+                if (numCandidates)
+                {
+                    query.TestDrawables(candidates, candidates + numCandidates, true);
+                    numCandidates = 0;
+                }
+
+                query.TestDrawables(drawable, drawable + 1, false);
+            }
+            else if (!(outside & (1 << j)))
+            {
+                candidates[numCandidates++] = *drawable;
+                if (numCandidates == MAX_CANDIDATES)
+                {
+                    query.TestDrawables(candidates, candidates + numCandidates, true);
+                    numCandidates = 0;
+                }
+            }
+        }
+    }
+
+    if (numCandidates)
+        query.TestDrawables(candidates, candidates + numCandidates, true);
+}
+
+void OctreeQuery::TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds)
+{
+    TestMatchingDrawables(*this, drawables, bounds, false);
+}
+
+void OctreeQuery::TestInsideDrawables(Drawable** drawables, const DrawableBounds& bounds)
+{
+    TestMatchingDrawables(*this, drawables, bounds, true);
+}
+
 Intersection PointOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -23,14 +108,25 @@ void PointOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool insi
     {
         Drawable* drawable = *start++;
 
-        if (!!(drawable->GetDrawableType() & drawableTypes_) && (drawable->GetViewMask() & viewMask_))
-        {
-            if (inside || drawable->GetWorldBoundingBox().IsInside(point_))
-                result_.Push(drawable);
-        }
+        if (inside || drawable->GetWorldBoundingBox().IsInside(point_))
+            result_.Push(drawable);
     }
 }
 
+void PointOctreeQuery::TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds)
+{
+    __m128 x = _mm_set1_ps(point_.x_);
+    __m128 y = _mm_set1_ps(point_.y_);
+    __m128 z = _mm_set1_ps(point_.z_);
+
+    CullDrawableBounds(*this, drawables, bounds, [=](__m128 minX, __m128 minY, __m128 minZ, __m128 maxX, __m128 maxY, __m128 maxZ)
+    {
+        __m128 outside = _mm_or_ps(_mm_cmplt_ps(x, minX), _mm_cmpgt_ps(x, maxX));
+        outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(y, minY), _mm_cmpgt_ps(y, maxY)));
+        return _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(z, minZ), _mm_cmpgt_ps(z, maxZ)));
+    });
+}
+
 Intersection SphereOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -45,14 +141,30 @@ void SphereOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool ins
     {
         Drawable* drawable = *start++;
 
-        if (!!(drawable->GetDrawableType() & drawableTypes_) && (drawable->GetViewMask() & viewMask_))
-        {
-            if (inside || sphere_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                result_.Push(drawable);
-        }
+        if (inside || sphere_.IsInsideFast(drawable->GetWorldBoundingBox()))
+            result_.Push(drawable);
     }
 }
 
+void SphereOctreeQuery::TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds)
+{
+    __m128 x = _mm_set1_ps(sphere_.center_.x_);
+    __m128 y = _mm_set1_ps(sphere_.center_.y_);
+    __m128 z = _mm_set1_ps(sphere_.center_.z_);
+    __m128 radiusSquared = _mm_set1_ps(sphere_.radius_ * sphere_.radius_);
+
+    CullDrawableBounds(*this, drawables, bounds, [=](__m128 minX, __m128 minY, __m128 minZ, __m128 maxX, __m128 maxY, __m128 maxZ)
+    {
+        // Distance from the sphere center to the box along each axis, zero if inside the box's extent
+        const __m128 zero = _mm_setzero_ps();
+        __m128 dx = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minX, x), zero), _mm_max_ps(_mm_sub_ps(x, maxX), zero));
+        __m128 dy = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minY, y), zero), _mm_max_ps(_mm_sub_ps(y, maxY), zero));
+        __m128 dz = _mm_add_ps(_mm_max_ps(_mm_sub_ps(minZ, z), zero), _mm_max_ps(_mm_sub_ps(z, maxZ), zero));
+        __m128 distSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+        return _mm_cmpge_ps(distSquared, radiusSquared);
+    });
+}
+
 Intersection BoxOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -67,14 +179,28 @@ void BoxOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside
     {
         Drawable* drawable = *start++;
 
-        if (!!(drawable->GetDrawableType() & drawableTypes_) && (drawable->GetViewMask() & viewMask_))
-        {
-            if (inside || box_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                result_.Push(drawable);
-        }
+        if (inside || box_.IsInsideFast(drawable->GetWorldBoundingBox()))
+            result_.Push(drawable);
     }
 }
 
+void BoxOctreeQuery::TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds)
+{
+    __m128 boxMinX = _mm_set1_ps(box_.min_.x_);
+    __m128 boxMinY = _mm_set1_ps(box_.min_.y_);
+    __m128 boxMinZ = _mm_set1_ps(box_.min_.z_);
+    __m128 boxMaxX = _mm_set1_ps(box_.max_.x_);
+    __m128 boxMaxY = _mm_set1_ps(box_.max_.y_);
+    __m128 boxMaxZ = _mm_set1_ps(box_.max_.z_);
+
+    CullDrawableBounds(*this, drawables, bounds, [=](__m128 minX, __m128 minY, __m128 minZ, __m128 maxX, __m128 maxY, __m128 maxZ)
+    {
+        __m128 outside = _mm_or_ps(_mm_cmplt_ps(maxX, boxMinX), _mm_cmpgt_ps(minX, boxMaxX));
+        outside = _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(maxY, boxMinY), _mm_cmpgt_ps(minY, boxMaxY)));
+        return _mm_or_ps(outside, _mm_or_ps(_mm_cmplt_ps(maxZ, boxMinZ), _mm_cmpgt_ps(minZ, boxMaxZ)));
+    });
+}
+
 Intersection FrustumOctreeQuery::TestOctant(const BoundingBox& box, bool inside)
 {
     if (inside)
@@ -89,12 +215,50 @@ void FrustumOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool in
     {
         Drawable* drawable = *start++;
 
-        if (!!(drawable->GetDrawableType() & drawableTypes_) && (drawable->GetViewMask() & viewMask_))
+        if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
+            result_.Push(drawable);
+    }
+}
+
+void FrustumOctreeQuery::TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds)
+{
+    // Plane normals, absolute normals and distances, each broadcast to all lanes
+    __m128 planes[NUM_FRUSTUM_PLANES][7];
+    for (i32 i = 0; i < NUM_FRUSTUM_PLANES; ++i)
+    {
+        const Plane& plane = frustum_.planes_[i];
+        planes[i][0] = _mm_set1_ps(plane.normal_.x_);
+        planes[i][1] = _mm_set1_ps(plane.normal_.y_);
+        planes[i][2] = _mm_set1_ps(plane.normal_.z_);
+        planes[i][3] = _mm_set1_ps(plane.absNormal_.x_);
+        planes[i][4] = _mm_set1_ps(plane.absNormal_.y_);
+        planes[i][5] = _mm_set1_ps(plane.absNormal_.z_);
+        planes[i][6] = _mm_set1_ps(plane.d_);
+    }
+
+    CullDrawableBounds(*this, drawables, bounds, [&planes](__m128 minX, __m128 minY, __m128 minZ, __m128 maxX, __m128 maxY, __m128 maxZ)
+    {
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+        __m128 centerX = _mm_mul_ps(_mm_add_ps(maxX, minX), half);
+        __m128 centerY = _mm_mul_ps(_mm_add_ps(maxY, minY), half);
+        __m128 centerZ = _mm_mul_ps(_mm_add_ps(maxZ, minZ), half);
+        __m128 edgeX = _mm_sub_ps(centerX, minX);
+        __m128 edgeY = _mm_sub_ps(centerY, minY);
+        __m128 edgeZ = _mm_sub_ps(centerZ, minZ);
+        __m128 outside = _mm_setzero_ps();
+
+        for (const __m128* plane : planes)
         {
-            if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                result_.Push(drawable);
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[0], centerX), _mm_mul_ps(plane[1], centerY)),
+                _mm_mul_ps(plane[2], centerZ)), plane[6]);
+            __m128 absDist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(plane[3], edgeX), _mm_mul_ps(plane[4], edgeY)),
+                _mm_mul_ps(plane[5], edgeZ));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(dist, _mm_xor_ps(absDist, signMask)));
         }
-    }
+
+        return outside;
+    });
 }
 
 
@@ -105,13 +269,7 @@ Intersection AllContentOctreeQuery::TestOctant(const BoundingBox& box, bool insi
 
 void AllContentOctreeQuery::TestDrawables(Drawable** start, Drawable** end, bool inside)
 {
-    while (start != end)
-    {
-        Drawable* drawable = *start++;
-
-        if (!!(drawable->GetDrawableType() & drawableTypes_) && (drawable->GetViewMask() & viewMask_))
-            result_.Push(drawable);
-    }
+    result_.Insert(result_.End(), start, end);
 }
 
 }
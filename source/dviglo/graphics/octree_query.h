@@ -18,6 +18,123 @@ namespace dviglo
 class Drawable;
 class Node;
 
+/// World bounding boxes, drawable types and view masks of four drawables in structure-of-arrays layout.
+struct DrawableBoundsBlock
+{
+    /// Minimum X coordinates.
+    float minX_[4];
+    /// Minimum Y coordinates.
+    float minY_[4];
+    /// Minimum Z coordinates.
+    float minZ_[4];
+    /// Maximum X coordinates.
+    float maxX_[4];
+    /// Maximum Y coordinates.
+    float maxY_[4];
+    /// Maximum Z coordinates.
+    float maxZ_[4];
+    /// Whether the drawable's bounding box has been dirtied since it was copied. Such drawables are tested by TestDrawables().
+    bool dirty_[4];
+    /// Drawable types.
+    DrawableTypes drawableType_[4];
+    /// View masks.
+    mask32 viewMask_[4];
+};
+
+/// Copy of the world bounding boxes, drawable types and view masks of the drawables in an octant, in the same order as the drawables.
+/// Allows the queries to test several bounding boxes at once and to reject drawables by type and view mask without touching the drawable objects.
+/// The boxes are stored in blocks of four, so that an octant needs only one allocation for them.
+struct DV_API DrawableBounds
+{
+    /// Return number of bounding boxes.
+    i32 Size() const { return size_; }
+
+    /// Add a bounding box to the end.
+    void Push(const BoundingBox& box, bool dirty, DrawableTypes drawableType, mask32 viewMask)
+    {
+        if (size_ % 4 == 0)
+            blocks_.Push(DrawableBoundsBlock{});
+
+        ++size_;
+        Set(size_ - 1, box);
+
+        DrawableBoundsBlock& block = blocks_[(size_ - 1) / 4];
+        i32 i = (size_ - 1) % 4;
+        block.dirty_[i] = dirty;
+        block.drawableType_[i] = drawableType;
+        block.viewMask_[i] = viewMask;
+    }
+
+    /// Remove a bounding box by moving the last one in its place.
+    void EraseSwap(i32 index)
+    {
+        i32 last = size_ - 1;
+
+        if (index != last)
+        {
+            DrawableBoundsBlock& dest = blocks_[index / 4];
+            const DrawableBoundsBlock& src = blocks_[last / 4];
+            i32 d = index % 4;
+            i32 s = last % 4;
+
+            dest.minX_[d] = src.minX_[s];
+            dest.minY_[d] = src.minY_[s];
+            dest.minZ_[d] = src.minZ_[s];
+            dest.maxX_[d] = src.maxX_[s];
+            dest.maxY_[d] = src.maxY_[s];
+            dest.maxZ_[d] = src.maxZ_[s];
+            dest.dirty_[d] = src.dirty_[s];
+            dest.drawableType_[d] = src.drawableType_[s];
+            dest.viewMask_[d] = src.viewMask_[s];
+        }
+
+        size_ = last;
+        if (size_ % 4 == 0)
+            blocks_.Resize(size_ / 4);
+    }
+
+    /// Set a bounding box and mark it up to date.
+    void Set(i32 index, const BoundingBox& box)
+    {
+        DrawableBoundsBlock& block = blocks_[index / 4];
+        i32 i = index % 4;
+
+        block.minX_[i] = box.min_.x_;
+        block.minY_[i] = box.min_.y_;
+        block.minZ_[i] = box.min_.z_;
+        block.maxX_[i] = box.max_.x_;
+        block.maxY_[i] = box.max_.y_;
+        block.maxZ_[i] = box.max_.z_;
+        block.dirty_[i] = false;
+    }
+
+    /// Mark a bounding box outdated.
+    void SetDirty(i32 index) { blocks_[index / 4].dirty_[index % 4] = true; }
+
+    /// Set a view mask.
+    void SetViewMask(i32 index, mask32 viewMask) { blocks_[index / 4].viewMask_[index % 4] = viewMask; }
+
+    /// Return whether a drawable has one of the drawable types and shares a bit with the view mask.
+    bool Matches(i32 index, DrawableTypes drawableTypes, mask32 viewMask) const
+    {
+        const DrawableBoundsBlock& block = blocks_[index / 4];
+        i32 i = index % 4;
+        return !!(block.drawableType_[i] & drawableTypes) && (block.viewMask_[i] & viewMask);
+    }
+
+    /// Remove all bounding boxes.
+    void Clear()
+    {
+        blocks_.Clear();
+        size_ = 0;
+    }
+
+    /// Blocks of four bounding boxes. Unused entries of the last block are undefined.
+    Vector<DrawableBoundsBlock> blocks_;
+    /// Number of bounding boxes.
+    i32 size_{};
+};
+
 /// Base class for octree queries.
 class DV_API OctreeQuery
 {
@@ -40,8 +157,12 @@ public:
 
     /// Intersection test for an octant.
     virtual Intersection TestOctant(const BoundingBox& box, bool inside) = 0;
-    /// Intersection test for drawables.
+    /// Intersection test for drawables. The drawables have already been matched against the drawable types and view mask.
     virtual void TestDrawables(Drawable** start, Drawable** end, bool inside) = 0;
+    /// Intersection test for the drawables of an octant which is not fully inside. Drawables whose bounding box passes are given to TestDrawables() as inside. By default calls TestDrawables() for all matching drawables.
+    virtual void TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds);
+    /// Give the matching drawables of an octant which is fully inside to TestDrawables().
+    void TestInsideDrawables(Drawable** drawables, const DrawableBounds& bounds);
 
     /// Result vector reference.
     Vector<Drawable*>& result_;
@@ -67,6 +188,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for the drawables of an octant which is not fully inside.
+    void TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds) override;
 
     /// Point.
     Vector3 point_;
@@ -88,6 +211,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for the drawables of an octant which is not fully inside.
+    void TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds) override;
 
     /// Sphere.
     Sphere sphere_;
@@ -109,6 +234,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for the drawables of an octant which is not fully inside.
+    void TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds) override;
 
     /// Bounding box.
     BoundingBox box_;
@@ -130,6 +257,8 @@ public:
     Intersection TestOctant(const BoundingBox& box, bool inside) override;
     /// Intersection test for drawables.
     void TestDrawables(Drawable** start, Drawable** end, bool inside) override;
+    /// Intersection test for the drawables of an octant which is not fully inside.
+    void TestDrawableBounds(Drawable** drawables, const DrawableBounds& bounds) override;
 
     /// Frustum.
     Frustum frustum_;
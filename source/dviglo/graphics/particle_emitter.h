@@ -10,6 +10,7 @@ namespace dviglo
 {
 
 class ParticleEffect;
+struct ScenePostUpdateEventData;
 
 /// One particle in the particle system.
 struct Particle
@@ -108,7 +109,7 @@ protected:
 
 private:
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const ScenePostUpdateEventData& eventData);
     /// Handle live reload of the particle effect.
     void HandleEffectReloadFinished(StringHash eventType, VariantMap& eventData);
 
@@ -4,6 +4,7 @@
 
 #include "../core/core_events.h"
 #include "../core/profiler.h"
+#include "../core/work_queue.h"
 #include "camera.h"
 #include "debug_renderer.h"
 #include "geometry.h"
@@ -262,6 +263,7 @@ Renderer::Renderer() :
     assert(!GParams::is_headless());
 
     SubscribeToEvent(E_SCREENMODE, DV_HANDLER(Renderer, HandleScreenMode));
+    SubscribeToEvent(E_ENDFRAME, DV_HANDLER(Renderer, HandleEndFrame));
 
     // Try to initialize right now, but skip if screen mode is not yet set
     Initialize();
@@ -527,6 +529,11 @@ void Renderer::SetThreadedOcclusion(bool enable)
     }
 }
 
+void Renderer::SetOcclusionMode(OcclusionMode mode)
+{
+    occlusionMode_ = mode;
+}
+
 void Renderer::ReloadShaders()
 {
     shadersDirty_ = true;
@@ -674,6 +681,11 @@ void Renderer::Update(float timeStep)
     numOcclusionBuffers_ = 0;
     updatedOctrees_.Clear();
 
+    // One frame arena for each worker thread and the main thread
+    i32 numArenas = DV_WORK_QUEUE.GetNumThreads() + 1;
+    while (frameArenas_.Size() < numArenas)
+        frameArenas_.EmplaceBack();
+
     // Reload shaders now if needed
     if (shadersDirty_)
         LoadShaders();
@@ -1143,6 +1155,7 @@ OcclusionBuffer* Renderer::GetOcclusionBuffer(Camera* camera)
 
     OcclusionBuffer* buffer = occlusionBuffers_[numOcclusionBuffers_++];
     buffer->SetSize(width, height, threadedOcclusion_);
+    buffer->SetMode(occlusionMode_);
     buffer->SetView(camera);
     buffer->ResetUseTimer();
 
@@ -1389,7 +1402,9 @@ bool Renderer::ResizeInstancingBuffer(i32 numInstances)
     while (newSize < numInstances)
         newSize <<= 1;
 
+    // The buffer contents are lost in any case, so all the instance data needs to be uploaded again
     const Vector<VertexElement> instancingBufferElements = CreateInstancingBufferElements(numExtraInstancingBufferElements_);
+    instancingStorage_.Invalidate();
     if (!instancingBuffer_->SetSize(newSize, instancingBufferElements, true))
     {
         DV_LOGERROR("Failed to resize instancing buffer to " + String(newSize));
@@ -1934,7 +1949,10 @@ void Renderer::CreateInstancingBuffer()
     {
         instancingBuffer_.Reset();
         dynamicInstancing_ = false;
+        return;
     }
+
+    instancingStorage_.SetStride(instancingBuffer_->GetVertexSize());
 }
 
 void Renderer::ResetShadowMaps()
@@ -2006,6 +2024,21 @@ void Renderer::HandleRenderUpdate(StringHash eventType, VariantMap& eventData)
     Update(eventData[P_TIMESTEP].GetFloat());
 }
 
+void Renderer::HandleEndFrame(StringHash eventType, VariantMap& eventData)
+{
+    // The render-time temporaries are no longer needed
+    frameArenaUsedSize_ = 0;
+    for (FrameArena& arena : frameArenas_)
+    {
+        frameArenaUsedSize_ += arena.GetUsedSize();
+        arena.Reset();
+    }
+
+    i64 numAllocations = GetNumContainerAllocations();
+    numFrameAllocations_ = (i32)(numAllocations - lastNumAllocations_);
+    lastNumAllocations_ = numAllocations;
+}
+
 
 void Renderer::BlurShadowMap(View* view, Texture2D* shadowMap, float blurScale)
 {
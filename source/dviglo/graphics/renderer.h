@@ -6,9 +6,12 @@
 
 #pragma once
 
+#include "../containers/frame_arena.h"
 #include "../containers/hash_set.h"
 #include "batch.h"
 #include "drawable.h"
+#include "instancing_storage.h"
+#include "occlusion_buffer.h"
 #include "viewport.h"
 #include "../math/color.h"
 
@@ -230,6 +233,8 @@ public:
     void SetOccluderSizeThreshold(float screenSize);
     /// Set whether to thread occluder rendering. Default false.
     void SetThreadedOcclusion(bool enable);
+    /// Set occlusion buffer rasterization mode. Default scanline.
+    void SetOcclusionMode(OcclusionMode mode);
     /// Set shadow depth bias multiplier for mobile platforms to counteract possible worse shadow map precision. Default 1.0 (no effect).
     void SetMobileShadowBiasMul(float mul);
     /// Set shadow depth bias addition for mobile platforms to counteract possible worse shadow map precision. Default 0.0 (no effect).
@@ -320,6 +325,9 @@ public:
     /// Return whether occlusion rendering is threaded.
     bool GetThreadedOcclusion() const { return threadedOcclusion_; }
 
+    /// Return occlusion buffer rasterization mode.
+    OcclusionMode GetOcclusionMode() const { return occlusionMode_; }
+
     /// Return shadow depth bias multiplier for mobile platforms.
     float GetMobileShadowBiasMul() const { return mobileShadowBiasMul_; }
 
@@ -347,6 +355,20 @@ public:
     /// Return number of occluders rendered.
     i32 GetNumOccluders(bool allViews = false) const;
 
+    /// Return number of container heap allocations during the last frame.
+    i32 GetNumFrameAllocations() const { return numFrameAllocations_; }
+
+    /// Return number of bytes allocated from the frame arenas during the last frame.
+    i32 GetFrameArenaUsedSize() const { return frameArenaUsedSize_; }
+
+    /// Return the frame arena of a thread for render-time temporaries. Index 0 is the main thread. The arenas are reset
+    /// at the end of the frame.
+    FrameArena& GetFrameArena(i32 threadIndex = 0)
+    {
+        assert(threadIndex >= 0 && threadIndex < frameArenas_.Size());
+        return frameArenas_[threadIndex];
+    }
+
     /// Return the default zone.
     Zone* GetDefaultZone() const { return defaultZone_; }
 
@@ -368,6 +390,12 @@ public:
     /// Return the instancing vertex buffer.
     VertexBuffer* GetInstancingBuffer() const { return dynamicInstancing_ ? instancingBuffer_.Get() : nullptr; }
 
+    /// Return the CPU-side copy of the instancing vertex buffer, which also counts the uploaded data.
+    InstancingStorage& GetInstancingStorage() { return instancingStorage_; }
+
+    /// Return the CPU-side copy of the instancing vertex buffer, which also counts the uploaded data.
+    const InstancingStorage& GetInstancingStorage() const { return instancingStorage_; }
+
     /// Return the frame update parameters.
     const FrameInfo& GetFrameInfo() const { return frame_; }
 
@@ -457,6 +485,8 @@ private:
     void HandleScreenMode(StringHash eventType, VariantMap& eventData);
     /// Handle render update event.
     void HandleRenderUpdate(StringHash eventType, VariantMap& eventData);
+    /// Handle frame end event. Resets the frame arenas.
+    void HandleEndFrame(StringHash eventType, VariantMap& eventData);
     /// Blur the shadow map.
     void BlurShadowMap(View* view, Texture2D* shadowMap, float blurScale);
 
@@ -474,6 +504,10 @@ private:
     SharedPtr<Geometry> pointLightGeometry_;
     /// Instance stream vertex buffer.
     SharedPtr<VertexBuffer> instancingBuffer_;
+    /// CPU-side copy of the instance stream, in which instanced draw calls keep their slices across frames.
+    InstancingStorage instancingStorage_;
+    /// Per-thread arenas for render-time temporaries.
+    Vector<FrameArena> frameArenas_;
     /// Default material.
     SharedPtr<Material> defaultMaterial_;
     /// Default range attenuation texture.
@@ -550,6 +584,8 @@ private:
     int maxOccluderTriangles_{5000};
     /// Occlusion buffer width.
     int occlusionBufferSize_{256};
+    /// Occlusion buffer rasterization mode.
+    OcclusionMode occlusionMode_{OCCLUSION_SCANLINE};
     /// Occluder screen size threshold.
     float occluderSizeThreshold_{0.025f};
     /// Mobile platform shadow depth bias multiplier.
@@ -566,6 +602,12 @@ private:
     i32 numPrimitives_{};
     /// Number of batches (3D geometry only).
     i32 numBatches_{};
+    /// Number of container heap allocations during the last frame.
+    i32 numFrameAllocations_{};
+    /// Number of container heap allocations at the end of the last frame.
+    i64 lastNumAllocations_{};
+    /// Number of bytes allocated from the frame arenas during the last frame.
+    i32 frameArenaUsedSize_{};
     /// Frame number on which shaders last changed.
     i32 shadersChangedFrameNumber_{NINDEX};
     /// Current stencil value for light optimization.
@@ -19,6 +19,7 @@ enum TrailType
 
 class IndexBuffer;
 class VertexBuffer;
+struct ScenePostUpdateEventData;
 
 /// Trail is consisting of series of tails. Two connected points make a tail.
 struct DV_API TrailPoint
@@ -173,7 +174,7 @@ protected:
 
 private:
     /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const ScenePostUpdateEventData& eventData);
 
     /// Resize RibbonTrail vertex and index buffers.
     void UpdateBufferSize();
@@ -106,6 +106,9 @@ void Skeleton::ClearBones()
 {
     bones_.Clear();
     rootBoneIndex_ = NINDEX;
+    pose_ = SkeletonPose();
+    poseOrder_.Clear();
+    poseParents_.Clear();
 }
 
 void Skeleton::Reset()
@@ -126,6 +129,110 @@ void Skeleton::ResetSilent()
     }
 }
 
+void Skeleton::ResetPose()
+{
+    const i32 numBones = bones_.Size();
+
+    if (poseOrder_.Size() != numBones)
+    {
+        pose_.positions_.Resize(numBones);
+        pose_.rotations_.Resize(numBones);
+        pose_.scales_.Resize(numBones);
+        pose_.modelTransforms_.Clear();
+
+        // Order the bones so that the parent transform is always calculated first. Bones that are their own parents
+        // (or have an invalid parent) are roots
+        poseParents_.Resize(numBones);
+        for (i32 i = 0; i < numBones; ++i)
+        {
+            i32 parentIndex = bones_[i].parentIndex_;
+            poseParents_[i] = (parentIndex == i || parentIndex < 0 || parentIndex >= numBones) ? NINDEX : parentIndex;
+        }
+
+        Vector<bool> ordered(numBones, false);
+        poseOrder_.Clear();
+        poseOrder_.Reserve(numBones);
+
+        while (poseOrder_.Size() < numBones)
+        {
+            i32 numOrdered = poseOrder_.Size();
+
+            for (i32 i = 0; i < numBones; ++i)
+            {
+                if (!ordered[i] && (poseParents_[i] == NINDEX || ordered[poseParents_[i]]))
+                {
+                    ordered[i] = true;
+                    poseOrder_.Push(i);
+                }
+            }
+
+            // Broken hierarchy with a cycle: treat the remaining bones as roots
+            if (poseOrder_.Size() == numOrdered)
+            {
+                for (i32 i = 0; i < numBones; ++i)
+                {
+                    if (!ordered[i])
+                    {
+                        ordered[i] = true;
+                        poseParents_[i] = NINDEX;
+                        poseOrder_.Push(i);
+                    }
+                }
+            }
+        }
+    }
+
+    for (i32 i = 0; i < numBones; ++i)
+    {
+        const Bone& bone = bones_[i];
+
+        if (bone.animated_ || !bone.node_)
+        {
+            pose_.positions_[i] = bone.initialPosition_;
+            pose_.rotations_[i] = bone.initialRotation_;
+            pose_.scales_[i] = bone.initialScale_;
+        }
+        else
+        {
+            pose_.positions_[i] = bone.node_->GetPosition();
+            pose_.rotations_[i] = bone.node_->GetRotation();
+            pose_.scales_[i] = bone.node_->GetScale();
+        }
+    }
+}
+
+void Skeleton::UpdatePoseTransforms()
+{
+    const i32 numBones = bones_.Size();
+    assert(poseOrder_.Size() == numBones);
+
+    pose_.modelTransforms_.Resize(numBones);
+    Matrix3x4* transforms = pose_.modelTransforms_.Buffer();
+
+    for (i32 i : poseOrder_)
+    {
+        Matrix3x4 localTransform(pose_.positions_[i], pose_.rotations_[i], pose_.scales_[i]);
+        i32 parentIndex = poseParents_[i];
+
+        if (parentIndex == NINDEX)
+            transforms[i] = localTransform;
+        else
+            transforms[i] = transforms[parentIndex] * localTransform;
+    }
+}
+
+void Skeleton::ApplyPoseSilent()
+{
+    if (pose_.positions_.Size() != bones_.Size())
+        return;
+
+    for (i32 i = 0; i < bones_.Size(); ++i)
+    {
+        const Bone& bone = bones_[i];
+        if (bone.animated_ && bone.node_)
+            bone.node_->SetTransformSilent(pose_.positions_[i], pose_.rotations_[i], pose_.scales_[i]);
+    }
+}
 
 Bone* Skeleton::GetRootBone()
 {
@@ -64,6 +64,19 @@ struct Bone
     WeakPtr<Node> node_;
 };
 
+/// Bone transforms of a skeleton kept in contiguous arrays, indexed like the bones. Used by node-free animation.
+struct SkeletonPose
+{
+    /// Local positions.
+    Vector<Vector3> positions_;
+    /// Local rotations.
+    Vector<Quaternion> rotations_;
+    /// Local scales.
+    Vector<Vector3> scales_;
+    /// Transforms relative to the skeleton's scene node.
+    Vector<Matrix3x4> modelTransforms_;
+};
+
 /// Hierarchical collection of bones.
 class DV_API Skeleton
 {
@@ -116,10 +129,31 @@ public:
 
     /// Reset all animating bones to initial positions without marking the nodes dirty. Requires the node dirtying to be performed later.
     void ResetSilent();
+    /// Reset the pose of all animating bones to initial positions. The pose of the other bones is read from their scene nodes.
+    void ResetPose();
+    /// Recalculate the model-space transforms of the pose from the local transforms.
+    void UpdatePoseTransforms();
+    /// Copy the pose of all animating bones to their scene nodes without marking the nodes dirty. Requires the node dirtying to be performed later.
+    void ApplyPoseSilent();
+
+    /// Return the pose.
+    SkeletonPose& GetPose() { return pose_; }
+
+    /// Return the pose.
+    const SkeletonPose& GetPose() const { return pose_; }
+
+    /// Return whether the pose has been calculated for all bones.
+    bool HasPose() const { return !bones_.Empty() && pose_.modelTransforms_.Size() == bones_.Size(); }
 
 private:
     /// Bones.
     Vector<Bone> bones_;
+    /// Pose of the bones.
+    SkeletonPose pose_;
+    /// Bone indices ordered so that parents come before their children.
+    Vector<i32> poseOrder_;
+    /// Parent bone indices used for the pose, NINDEX for root bones.
+    Vector<i32> poseParents_;
     /// Root bone index.
     i32 rootBoneIndex_;
 };
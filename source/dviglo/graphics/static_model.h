@@ -24,6 +24,7 @@ struct StaticModelGeometryData
 class DV_API StaticModel : public Drawable
 {
     DV_OBJECT(StaticModel, Drawable);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
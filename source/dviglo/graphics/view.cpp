@@ -10,6 +10,7 @@
 #include "graphics.h"
 #include "graphics_events.h"
 #include "../graphics_api/graphics_defs.h"
+#include "instancing_storage.h"
 #include "material.h"
 #include "occlusion_buffer.h"
 #include "octree.h"
@@ -54,8 +55,7 @@ public:
         {
             Drawable* drawable = *start++;
 
-            if (drawable->GetCastShadows() && !!(drawable->GetDrawableType() & drawableTypes_) &&
-                (drawable->GetViewMask() & viewMask_))
+            if (drawable->GetCastShadows())
             {
                 if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
                     result_.Push(drawable);
@@ -83,8 +83,7 @@ public:
             Drawable* drawable = *start++;
             DrawableTypes type = drawable->GetDrawableType();
 
-            if ((type == DrawableTypes::Zone || (type == DrawableTypes::Geometry && drawable->IsOccluder())) &&
-                (drawable->GetViewMask() & viewMask_))
+            if (type == DrawableTypes::Zone || (type == DrawableTypes::Geometry && drawable->IsOccluder()))
             {
                 if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
                     result_.Push(drawable);
@@ -126,11 +125,8 @@ public:
         {
             Drawable* drawable = *start++;
 
-            if (!!(drawable->GetDrawableType() & drawableTypes_) && (drawable->GetViewMask() & viewMask_))
-            {
-                if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
-                    result_.Push(drawable);
-            }
+            if (inside || frustum_.IsInsideFast(drawable->GetWorldBoundingBox()))
+                result_.Push(drawable);
         }
     }
 
@@ -138,11 +134,8 @@ public:
     OcclusionBuffer* buffer_;
 };
 
-void CheckVisibilityWork(const WorkItem* item, i32 threadIndex)
+void CheckVisibility(View* view, Drawable** start, Drawable** end, i32 threadIndex)
 {
-    auto* view = reinterpret_cast<View*>(item->aux_);
-    auto** start = reinterpret_cast<Drawable**>(item->start_);
-    auto** end = reinterpret_cast<Drawable**>(item->end_);
     OcclusionBuffer* buffer = view->occlusionBuffer_;
     const Matrix3x4& viewMatrix = view->cullCamera_->GetView();
     Vector3 viewZ = Vector3(viewMatrix.m20_, viewMatrix.m21_, viewMatrix.m22_);
@@ -215,6 +208,22 @@ void ProcessLightWork(const WorkItem* item, i32 threadIndex)
     view->ProcessLight(*query, threadIndex);
 }
 
+void GetLightBatchesWork(const WorkItem* item, i32 threadIndex)
+{
+    auto* view = reinterpret_cast<View*>(item->aux_);
+    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
+
+    view->GetLightBatches(*query);
+}
+
+void GetShadowBatchesWork(const WorkItem* item, i32 threadIndex)
+{
+    auto* view = reinterpret_cast<View*>(item->aux_);
+    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
+
+    view->GetShadowBatches(*query);
+}
+
 void UpdateDrawableGeometriesWork(const WorkItem* item, i32 threadIndex)
 {
     const FrameInfo& frame = *(reinterpret_cast<FrameInfo*>(item->aux_));
@@ -253,8 +262,14 @@ void SortLightQueueWork(const WorkItem* item, i32 threadIndex)
 
 void SortShadowQueueWork(const WorkItem* item, i32 threadIndex)
 {
-    LightBatchQueue* start = reinterpret_cast<LightBatchQueue*>(item->start_);
-    for (ShadowBatchQueue& shadowSplit : start->shadowSplits_)
+    auto* query = reinterpret_cast<LightQueryResult*>(item->start_);
+    LightBatchQueue* lightQueue = query->light_->GetLightQueue();
+
+    // Per-vertex lights and lights without lit geometries have no light queue
+    if (!lightQueue)
+        return;
+
+    for (ShadowBatchQueue& shadowSplit : lightQueue->shadowSplits_)
         shadowSplit.shadowBatches_.SortFrontToBack();
 }
 
@@ -876,30 +891,10 @@ void View::GetDrawables()
             result.maxZ_ = 0.0f;
         }
 
-        int numWorkItems = queue.GetNumThreads() + 1; // Worker threads + main thread
-        int drawablesPerItem = tempDrawables.Size() / numWorkItems;
-
-        Vector<Drawable*>::Iterator start = tempDrawables.Begin();
-        // Create a work item for each thread
-        for (int i = 0; i < numWorkItems; ++i)
+        queue.ParallelFor(0, tempDrawables.Size(), 64, [this, &tempDrawables](i32 begin, i32 end, i32 threadIndex)
         {
-            SharedPtr<WorkItem> item = queue.GetFreeItem();
-            item->priority_ = WI_MAX_PRIORITY;
-            item->workFunction_ = CheckVisibilityWork;
-            item->aux_ = this;
-
-            Vector<Drawable*>::Iterator end = tempDrawables.End();
-            if (i < numWorkItems - 1 && end - start > drawablesPerItem)
-                end = start + drawablesPerItem;
-
-            item->start_ = &(*start);
-            item->end_ = &(*end);
-            queue.AddWorkItem(item);
-
-            start = end;
-        }
-
-        queue.Complete(WI_MAX_PRIORITY);
+            CheckVisibility(this, tempDrawables.Buffer() + begin, tempDrawables.Buffer() + end, threadIndex);
+        });
     }
 
     // Combine lights, geometries & scene Z range from the threads
@@ -950,7 +945,7 @@ void View::GetBatches()
     threadedGeometries_.Clear();
 
     ProcessLights();
-    GetLightBatches();
+    GetMaxLightsBatches();
     GetBaseBatches();
 }
 
@@ -962,189 +957,251 @@ void View::ProcessLights()
     WorkQueue& queue = DV_WORK_QUEUE;
     lightQueryResults_.Resize(lights_.Size());
 
+    // Light queues must not be reallocated while the lights are processed. Unused queues are removed afterwards
+    lightQueues_.Resize(lights_.Size());
+    usedLightQueues_ = 0;
+    maxLightsDrawables_.Clear();
+
+    // The work is a task graph: the main thread collects the lit batches of a light as soon as its query has finished,
+    // while worker threads keep querying the shadow casters of the remaining lights. Collecting the lit batches writes only
+    // to the drawables in view, which the queries do not modify. The shadow casters of each light stay in the query result
+    // until all queries have finished: only then the main thread marks them in view and collects their shadow batches,
+    // while worker threads sort the shadow batches of the lights collected so far. Both collections are chained to keep
+    // the light queues in the light order
+    Vector<SharedPtr<WorkItem>> queryItems;
+    Vector<SharedPtr<WorkItem>> batchItems;
+    Vector<SharedPtr<WorkItem>> shadowItems;
+    Vector<SharedPtr<WorkItem>> sortItems;
+
     for (i32 i = 0; i < lightQueryResults_.Size(); ++i)
     {
-        SharedPtr<WorkItem> item = queue.GetFreeItem();
-        item->priority_ = WI_MAX_PRIORITY;
-        item->workFunction_ = ProcessLightWork;
-        item->aux_ = this;
-
         LightQueryResult& query = lightQueryResults_[i];
         query.light_ = lights_[i];
 
-        item->start_ = &query;
+        SharedPtr<WorkItem> queryItem = queue.GetFreeItem();
+        queryItem->priority_ = WI_MAX_PRIORITY;
+        queryItem->workFunction_ = ProcessLightWork;
+        queryItem->aux_ = this;
+        queryItem->start_ = &query;
+
+        SharedPtr<WorkItem> batchItem = queue.GetFreeItem();
+        batchItem->priority_ = WI_MAX_PRIORITY;
+        batchItem->workFunction_ = GetLightBatchesWork;
+        batchItem->aux_ = this;
+        batchItem->start_ = &query;
+        batchItem->mainThread_ = true;
+        queue.AddDependency(batchItem, queryItem);
+        if (batchItems.Size())
+            queue.AddDependency(batchItem, batchItems.Back());
+
+        SharedPtr<WorkItem> shadowItem = queue.GetFreeItem();
+        shadowItem->priority_ = WI_MAX_PRIORITY;
+        shadowItem->workFunction_ = GetShadowBatchesWork;
+        shadowItem->aux_ = this;
+        shadowItem->start_ = &query;
+        shadowItem->mainThread_ = true;
+        queue.AddDependency(shadowItem, batchItem);
+        if (shadowItems.Size())
+            queue.AddDependency(shadowItem, shadowItems.Back());
+
+        SharedPtr<WorkItem> sortItem = queue.GetFreeItem();
+        sortItem->priority_ = WI_MAX_PRIORITY;
+        sortItem->workFunction_ = SortShadowQueueWork;
+        sortItem->start_ = &query;
+        queue.AddDependency(sortItem, shadowItem);
+
+        queryItems.Push(queryItem);
+        batchItems.Push(batchItem);
+        shadowItems.Push(shadowItem);
+        sortItems.Push(sortItem);
+    }
+
+    // Marking the shadow casters in view changes what the queries read, so it waits for all of them
+    if (shadowItems.Size())
+    {
+        for (const SharedPtr<WorkItem>& item : queryItems)
+            queue.AddDependency(shadowItems.Front(), item);
+    }
+
+    for (const SharedPtr<WorkItem>& item : queryItems)
+        queue.AddWorkItem(item);
+    for (const SharedPtr<WorkItem>& item : batchItems)
+        queue.AddWorkItem(item);
+    for (const SharedPtr<WorkItem>& item : shadowItems)
+        queue.AddWorkItem(item);
+    for (const SharedPtr<WorkItem>& item : sortItems)
         queue.AddWorkItem(item);
-    }
 
     // Ensure all lights have been processed before proceeding
     queue.Complete(WI_MAX_PRIORITY);
+
+    lightQueues_.Resize(usedLightQueues_);
 }
 
-void View::GetLightBatches()
+void View::GetLightBatches(LightQueryResult& query)
 {
+    // If light has no affected geometries, no need to process further
+    if (query.litGeometries_.Empty())
+        return;
+
+    DV_PROFILE(GetLightBatches);
+
     BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassIndex_) ? &batchQueues_[alphaPassIndex_] : nullptr;
+    Renderer& renderer = DV_RENDERER;
+    i32 maxSortedInstances = renderer.GetMaxSortedInstances();
+
+    Light* light = query.light_;
 
-    // Build light queues and lit batches
+    // Per-pixel light
+    if (!light->GetPerVertex())
     {
-        DV_PROFILE(GetLightBatches);
+        i32 shadowSplits = query.numSplits_;
 
-        // Preallocate light queues: per-pixel lights which have lit geometries
-        i32 numLightQueues = 0;
-        i32 usedLightQueues = 0;
-        for (Vector<LightQueryResult>::ConstIterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+        // Initialize light queue and store it to the light so that it can be found later
+        LightBatchQueue& lightQueue = lightQueues_[usedLightQueues_++];
+        light->SetLightQueue(&lightQueue);
+        lightQueue.light_ = light;
+        lightQueue.negative_ = light->IsNegative();
+        lightQueue.shadowMap_ = nullptr;
+        lightQueue.litBaseBatches_.Clear(maxSortedInstances);
+        lightQueue.litBatches_.Clear(maxSortedInstances);
+        if (forwardLightsCommand_)
         {
-            if (!i->light_->GetPerVertex() && i->litGeometries_.Size())
-                ++numLightQueues;
+            SetQueueShaderDefines(lightQueue.litBaseBatches_, *forwardLightsCommand_);
+            SetQueueShaderDefines(lightQueue.litBatches_, *forwardLightsCommand_);
         }
+        else
+        {
+            lightQueue.litBaseBatches_.hasExtraDefines_ = false;
+            lightQueue.litBatches_.hasExtraDefines_ = false;
+        }
+        lightQueue.volumeBatches_.SetArena(&DV_RENDERER.GetFrameArena());
 
-        Renderer& renderer = DV_RENDERER;
-
-        lightQueues_.Resize(numLightQueues);
-        maxLightsDrawables_.Clear();
-        i32 maxSortedInstances = renderer.GetMaxSortedInstances();
-
-        for (Vector<LightQueryResult>::Iterator i = lightQueryResults_.Begin(); i != lightQueryResults_.End(); ++i)
+        // Allocate shadow map now
+        if (shadowSplits > 0)
         {
-            LightQueryResult& query = *i;
+            lightQueue.shadowMap_ = renderer.GetShadowMap(light, cullCamera_, viewSize_.x_, viewSize_.y_);
+            // If did not manage to get a shadow map, convert the light to unshadowed
+            if (!lightQueue.shadowMap_)
+                shadowSplits = 0;
+        }
 
-            // If light has no affected geometries, no need to process further
-            if (query.litGeometries_.Empty())
-                continue;
+        // Setup shadow batch queues
+        lightQueue.shadowSplits_.Resize(shadowSplits);
+        for (i32 j = 0; j < shadowSplits; ++j)
+        {
+            ShadowBatchQueue& shadowQueue = lightQueue.shadowSplits_[j];
+            Camera* shadowCamera = query.shadowCameras_[j];
+            shadowQueue.shadowCamera_ = shadowCamera;
+            shadowQueue.nearSplit_ = query.shadowNearSplits_[j];
+            shadowQueue.farSplit_ = query.shadowFarSplits_[j];
+            shadowQueue.shadowBatches_.Clear(maxSortedInstances);
 
-            Light* light = query.light_;
+            // Setup the shadow split viewport and finalize shadow camera parameters. The shadow casters are collected later
+            shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
+            FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
+        }
 
-            // Per-pixel light
-            if (!light->GetPerVertex())
-            {
-                i32 shadowSplits = query.numSplits_;
-
-                // Initialize light queue and store it to the light so that it can be found later
-                LightBatchQueue& lightQueue = lightQueues_[usedLightQueues++];
-                light->SetLightQueue(&lightQueue);
-                lightQueue.light_ = light;
-                lightQueue.negative_ = light->IsNegative();
-                lightQueue.shadowMap_ = nullptr;
-                lightQueue.litBaseBatches_.Clear(maxSortedInstances);
-                lightQueue.litBatches_.Clear(maxSortedInstances);
-                if (forwardLightsCommand_)
-                {
-                    SetQueueShaderDefines(lightQueue.litBaseBatches_, *forwardLightsCommand_);
-                    SetQueueShaderDefines(lightQueue.litBatches_, *forwardLightsCommand_);
-                }
-                else
-                {
-                    lightQueue.litBaseBatches_.hasExtraDefines_ = false;
-                    lightQueue.litBatches_.hasExtraDefines_ = false;
-                }
-                lightQueue.volumeBatches_.Clear();
+        // Process lit geometries
+        for (ArenaVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
+        {
+            Drawable* drawable = *j;
+            drawable->AddLight(light);
 
-                // Allocate shadow map now
-                if (shadowSplits > 0)
-                {
-                    lightQueue.shadowMap_ = renderer.GetShadowMap(light, cullCamera_, viewSize_.x_, viewSize_.y_);
-                    // If did not manage to get a shadow map, convert the light to unshadowed
-                    if (!lightQueue.shadowMap_)
-                        shadowSplits = 0;
-                }
+            // If drawable limits maximum lights, only record the light, and check maximum count / build batches later
+            if (!drawable->GetMaxLights())
+                GetLitBatches(drawable, lightQueue, alphaQueue);
+            else
+                maxLightsDrawables_.Insert(drawable);
+        }
+
+        // In deferred modes, store the light volume batch now. Since light mask 8 lowest bits are output to the stencil,
+        // lights that have all zeroes in the low 8 bits can be skipped; they would not affect geometry anyway
+        if (deferred_ && (light->GetLightMask() & 0xffu) != 0)
+        {
+            Batch volumeBatch;
+            volumeBatch.geometry_ = renderer.GetLightGeometry(light);
+            volumeBatch.geometryType_ = GEOM_STATIC;
+            volumeBatch.worldTransform_ = &light->GetVolumeTransform(cullCamera_);
+            volumeBatch.numWorldTransforms_ = 1;
+            volumeBatch.lightQueue_ = &lightQueue;
+            volumeBatch.distance_ = light->GetDistance();
+            volumeBatch.material_ = nullptr;
+            volumeBatch.pass_ = nullptr;
+            volumeBatch.zone_ = nullptr;
+            renderer.SetLightVolumeBatchShaders(volumeBatch, cullCamera_, lightVolumeCommand_->vertexShaderName_,
+                lightVolumeCommand_->pixelShaderName_, lightVolumeCommand_->vertexShaderDefines_,
+                lightVolumeCommand_->pixelShaderDefines_);
+            lightQueue.volumeBatches_.Push(volumeBatch);
+        }
+    }
+    // Per-vertex light
+    else
+    {
+        // Add the vertex light to lit drawables. It will be processed later during base pass batch generation
+        for (ArenaVector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
+        {
+            Drawable* drawable = *j;
+            drawable->AddVertexLight(light);
+        }
+    }
+}
 
-                // Setup shadow batch queues
-                lightQueue.shadowSplits_.Resize(shadowSplits);
-                for (i32 j = 0; j < shadowSplits; ++j)
-                {
-                    ShadowBatchQueue& shadowQueue = lightQueue.shadowSplits_[j];
-                    Camera* shadowCamera = query.shadowCameras_[j];
-                    shadowQueue.shadowCamera_ = shadowCamera;
-                    shadowQueue.nearSplit_ = query.shadowNearSplits_[j];
-                    shadowQueue.farSplit_ = query.shadowFarSplits_[j];
-                    shadowQueue.shadowBatches_.Clear(maxSortedInstances);
-
-                    // Setup the shadow split viewport and finalize shadow camera parameters
-                    shadowQueue.shadowViewport_ = GetShadowMapViewport(light, j, lightQueue.shadowMap_);
-                    FinalizeShadowCamera(shadowCamera, light, shadowQueue.shadowViewport_, query.shadowCasterBox_[j]);
-
-                    // Loop through shadow casters
-                    for (Vector<Drawable*>::ConstIterator k = query.shadowCasters_.Begin() + query.shadowCasterBegin_[j];
-                         k < query.shadowCasters_.Begin() + query.shadowCasterEnd_[j]; ++k)
-                    {
-                        Drawable* drawable = *k;
-                        // If drawable is not in actual view frustum, mark it in view here and check its geometry update type
-                        if (!drawable->IsInView(frame_, true))
-                        {
-                            drawable->MarkInView(frame_.frameNumber_);
-                            UpdateGeometryType type = drawable->GetUpdateGeometryType();
-                            if (type == UPDATE_MAIN_THREAD)
-                                nonThreadedGeometries_.Push(drawable);
-                            else if (type == UPDATE_WORKER_THREAD)
-                                threadedGeometries_.Push(drawable);
-                        }
+void View::GetShadowBatches(LightQueryResult& query)
+{
+    // Per-vertex lights and lights without lit geometries have no light queue
+    LightBatchQueue* lightQueue = query.light_->GetLightQueue();
+    if (!lightQueue)
+        return;
 
-                        const Vector<SourceBatch>& batches = drawable->GetBatches();
+    DV_PROFILE(GetShadowBatches);
 
-                        for (const SourceBatch& srcBatch : batches)
-                        {
-                            Technique* tech = GetTechnique(drawable, srcBatch.material_);
-                            if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
-                                continue;
+    for (i32 i = 0; i < lightQueue->shadowSplits_.Size(); ++i)
+    {
+        ShadowBatchQueue& shadowQueue = lightQueue->shadowSplits_[i];
 
-                            Pass* pass = tech->GetSupportedPass(Technique::shadowPassIndex);
-                            // Skip if material has no shadow pass
-                            if (!pass)
-                                continue;
+        // Loop through shadow casters
+        for (ArenaVector<Drawable*>::ConstIterator j = query.shadowCasters_.Begin() + query.shadowCasterBegin_[i];
+             j < query.shadowCasters_.Begin() + query.shadowCasterEnd_[i]; ++j)
+        {
+            Drawable* drawable = *j;
+            // If drawable is not in actual view frustum, mark it in view here and check its geometry update type
+            if (!drawable->IsInView(frame_, true))
+            {
+                drawable->MarkInView(frame_.frameNumber_);
+                UpdateGeometryType type = drawable->GetUpdateGeometryType();
+                if (type == UPDATE_MAIN_THREAD)
+                    nonThreadedGeometries_.Push(drawable);
+                else if (type == UPDATE_WORKER_THREAD)
+                    threadedGeometries_.Push(drawable);
+            }
 
-                            Batch destBatch(srcBatch);
-                            destBatch.pass_ = pass;
-                            destBatch.zone_ = nullptr;
+            const Vector<SourceBatch>& batches = drawable->GetBatches();
 
-                            AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
-                        }
-                    }
-                }
+            for (const SourceBatch& srcBatch : batches)
+            {
+                Technique* tech = GetTechnique(drawable, srcBatch.material_);
+                if (!srcBatch.geometry_ || !srcBatch.numWorldTransforms_ || !tech)
+                    continue;
 
-                // Process lit geometries
-                for (Vector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
-                {
-                    Drawable* drawable = *j;
-                    drawable->AddLight(light);
+                Pass* pass = tech->GetSupportedPass(Technique::shadowPassIndex);
+                // Skip if material has no shadow pass
+                if (!pass)
+                    continue;
 
-                    // If drawable limits maximum lights, only record the light, and check maximum count / build batches later
-                    if (!drawable->GetMaxLights())
-                        GetLitBatches(drawable, lightQueue, alphaQueue);
-                    else
-                        maxLightsDrawables_.Insert(drawable);
-                }
+                Batch destBatch(srcBatch);
+                destBatch.pass_ = pass;
+                destBatch.zone_ = nullptr;
 
-                // In deferred modes, store the light volume batch now. Since light mask 8 lowest bits are output to the stencil,
-                // lights that have all zeroes in the low 8 bits can be skipped; they would not affect geometry anyway
-                if (deferred_ && (light->GetLightMask() & 0xffu) != 0)
-                {
-                    Batch volumeBatch;
-                    volumeBatch.geometry_ = renderer.GetLightGeometry(light);
-                    volumeBatch.geometryType_ = GEOM_STATIC;
-                    volumeBatch.worldTransform_ = &light->GetVolumeTransform(cullCamera_);
-                    volumeBatch.numWorldTransforms_ = 1;
-                    volumeBatch.lightQueue_ = &lightQueue;
-                    volumeBatch.distance_ = light->GetDistance();
-                    volumeBatch.material_ = nullptr;
-                    volumeBatch.pass_ = nullptr;
-                    volumeBatch.zone_ = nullptr;
-                    renderer.SetLightVolumeBatchShaders(volumeBatch, cullCamera_, lightVolumeCommand_->vertexShaderName_,
-                        lightVolumeCommand_->pixelShaderName_, lightVolumeCommand_->vertexShaderDefines_,
-                        lightVolumeCommand_->pixelShaderDefines_);
-                    lightQueue.volumeBatches_.Push(volumeBatch);
-                }
-            }
-            // Per-vertex light
-            else
-            {
-                // Add the vertex light to lit drawables. It will be processed later during base pass batch generation
-                for (Vector<Drawable*>::ConstIterator j = query.litGeometries_.Begin(); j != query.litGeometries_.End(); ++j)
-                {
-                    Drawable* drawable = *j;
-                    drawable->AddVertexLight(light);
-                }
+                AddBatchToQueue(shadowQueue.shadowBatches_, destBatch, tech);
             }
         }
     }
+}
+
+void View::GetMaxLightsBatches()
+{
+    BatchQueue* alphaQueue = batchQueues_.Contains(alphaPassIndex_) ? &batchQueues_[alphaPassIndex_] : nullptr;
 
     // Process drawables with limited per-pixel light count
     if (maxLightsDrawables_.Size())
@@ -1287,6 +1344,7 @@ void View::UpdateGeometries()
             }
         }
 
+        // Shadow batches have already been sorted in ProcessLights()
         for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
         {
             SharedPtr<WorkItem> lightItem = queue.GetFreeItem();
@@ -1294,15 +1352,6 @@ void View::UpdateGeometries()
             lightItem->workFunction_ = SortLightQueueWork;
             lightItem->start_ = &(*i);
             queue.AddWorkItem(lightItem);
-
-            if (i->shadowSplits_.Size())
-            {
-                SharedPtr<WorkItem> shadowItem = queue.GetFreeItem();
-                shadowItem->priority_ = WI_MAX_PRIORITY;
-                shadowItem->workFunction_ = SortShadowQueueWork;
-                shadowItem->start_ = &(*i);
-                queue.AddWorkItem(shadowItem);
-            }
         }
     }
 
@@ -1322,6 +1371,7 @@ void View::UpdateGeometries()
                 }
             }
 
+            // Not ParallelFor(), as it would wait for the threaded updates before the non-threaded ones could start
             int numWorkItems = queue.GetNumThreads() + 1; // Worker threads + main thread
             int drawablesPerItem = threadedGeometries_.Size() / numWorkItems;
 
@@ -2281,7 +2331,9 @@ void View::ProcessLight(LightQueryResult& query, i32 threadIndex)
 #endif
     // Get lit geometries. They must match the light mask and be inside the main camera frustum to be considered
     Vector<Drawable*>& tempDrawables = tempDrawables_[threadIndex];
-    query.litGeometries_.Clear();
+    FrameArena& arena = DV_RENDERER.GetFrameArena(threadIndex);
+    query.litGeometries_.SetArena(&arena);
+    query.shadowCasters_.SetArena(&arena);
 
     switch (type)
     {
@@ -2333,7 +2385,6 @@ void View::ProcessLight(LightQueryResult& query, i32 threadIndex)
     SetupShadowCameras(query);
 
     // Process each split for shadow casters
-    query.shadowCasters_.Clear();
     for (i32 i = 0; i < query.numSplits_; ++i)
     {
         Camera* shadowCamera = query.shadowCameras_[i];
@@ -2904,7 +2955,9 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
         {
             // Create a new group based on the batch
             // In case the group remains below the instancing limit, do not enable instancing shaders yet
+            // Batches are collected on the main thread, so the instances can use its frame arena
             BatchGroup newGroup(batch);
+            newGroup.instances_.SetArena(&renderer.GetFrameArena());
             newGroup.geometryType_ = GEOM_STATIC;
             renderer.SetBatchShaders(newGroup, tech, allowShadows, queue);
             newGroup.CalculateSortKey();
@@ -2945,8 +2998,7 @@ void View::AddBatchToQueue(BatchQueue& queue, Batch& batch, Technique* tech, boo
 
 void View::PrepareInstancingBuffer()
 {
-    // Prepare instancing buffer from the source view
-    /// \todo If rendering the same view several times back-to-back, would not need to refill the buffer
+    // Prepare instancing buffer from the source view. Its draw calls keep their slices, so nothing needs to be uploaded
     if (sourceView_)
     {
         sourceView_->PrepareInstancingBuffer();
@@ -2955,43 +3007,55 @@ void View::PrepareInstancingBuffer()
 
     DV_PROFILE(PrepareInstancingBuffer);
 
-    i32 totalInstances = 0;
+    Renderer& renderer = DV_RENDERER;
+    InstancingStorage& storage = renderer.GetInstancingStorage();
+    storage.BeginFrame(frame_.frameNumber_);
 
     for (HashMap<i32, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        totalInstances += i->second_.GetNumInstances();
+        i->second_.SetInstancingData(storage);
 
     for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
     {
-        for (const ShadowBatchQueue& shadowSplit : i->shadowSplits_)
-            totalInstances += shadowSplit.shadowBatches_.GetNumInstances();
+        for (ShadowBatchQueue& shadowSplit : i->shadowSplits_)
+            shadowSplit.shadowBatches_.SetInstancingData(storage);
 
-        totalInstances += i->litBaseBatches_.GetNumInstances();
-        totalInstances += i->litBatches_.GetNumInstances();
+        i->litBaseBatches_.SetInstancingData(storage);
+        i->litBatches_.SetInstancingData(storage);
     }
 
-    if (!totalInstances || !DV_RENDERER.ResizeInstancingBuffer(totalInstances))
+    if (!storage.GetSize())
         return;
 
-    VertexBuffer* instancingBuffer = DV_RENDERER.GetInstancingBuffer();
-    i32 freeIndex = 0;
-    void* dest = instancingBuffer->Lock(0, totalInstances, true);
-    if (!dest)
-        return;
+    // Draw without instancing if the buffer can not hold all the slices
+    if (!renderer.ResizeInstancingBuffer(storage.GetSize()))
+    {
+        for (HashMap<i32, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
+            i->second_.ResetInstancingData();
 
-    const i32 stride = instancingBuffer->GetVertexSize();
-    for (HashMap<i32, BatchQueue>::Iterator i = batchQueues_.Begin(); i != batchQueues_.End(); ++i)
-        i->second_.SetInstancingData(dest, stride, freeIndex);
+        for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
+        {
+            for (ShadowBatchQueue& shadowSplit : i->shadowSplits_)
+                shadowSplit.shadowBatches_.ResetInstancingData();
 
-    for (Vector<LightBatchQueue>::Iterator i = lightQueues_.Begin(); i != lightQueues_.End(); ++i)
-    {
-        for (ShadowBatchQueue& shadowSplit : i->shadowSplits_)
-            shadowSplit.shadowBatches_.SetInstancingData(dest, stride, freeIndex);
+            i->litBaseBatches_.ResetInstancingData();
+            i->litBatches_.ResetInstancingData();
+        }
 
-        i->litBaseBatches_.SetInstancingData(dest, stride, freeIndex);
-        i->litBatches_.SetInstancingData(dest, stride, freeIndex);
+        return;
+    }
+
+    VertexBuffer* instancingBuffer = renderer.GetInstancingBuffer();
+    if (instancingBuffer->IsDataLost())
+    {
+        storage.Invalidate();
+        instancingBuffer->ClearDataLost();
     }
 
-    instancingBuffer->Unlock();
+    // Upload only the changed instances
+    storage.Flush();
+    const i32 stride = storage.GetStride();
+    for (const IntVector2& range : storage.GetUploadRanges())
+        instancingBuffer->SetDataRange(storage.GetData() + (intptr_t)range.x_ * stride, range.x_, range.y_);
 }
 
 void View::SetupLightVolumeBatch(Batch& batch)
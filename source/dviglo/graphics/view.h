@@ -4,6 +4,7 @@
 
 #pragma once
 
+#include "../containers/arena_vector.h"
 #include "../containers/hash_set.h"
 #include "../core/object.h"
 #include "batch.h"
@@ -35,10 +36,10 @@ struct LightQueryResult
 {
     /// Light.
     Light* light_;
-    /// Lit geometries.
-    Vector<Drawable*> litGeometries_;
-    /// Shadow casters.
-    Vector<Drawable*> shadowCasters_;
+    /// Lit geometries. Allocated from the frame arena of the thread that processed the light.
+    ArenaVector<Drawable*> litGeometries_;
+    /// Shadow casters. Allocated from the frame arena of the thread that processed the light.
+    ArenaVector<Drawable*> shadowCasters_;
     /// Shadow cameras.
     Camera* shadowCameras_[MAX_LIGHT_SPLITS];
     /// Shadow caster start indices.
@@ -88,8 +89,10 @@ inline constexpr i32 MAX_VIEWPORT_TEXTURES = 2;
 /// Internal structure for 3D rendering work. Created for each backbuffer and texture viewport, but not for shadow cameras.
 class DV_API View : public Object
 {
-    friend void CheckVisibilityWork(const WorkItem* item, i32 threadIndex);
+    friend void CheckVisibility(View* view, Drawable** start, Drawable** end, i32 threadIndex);
     friend void ProcessLightWork(const WorkItem* item, i32 threadIndex);
+    friend void GetLightBatchesWork(const WorkItem* item, i32 threadIndex);
+    friend void GetShadowBatchesWork(const WorkItem* item, i32 threadIndex);
 
     DV_OBJECT(View, Object);
 
@@ -174,10 +177,14 @@ private:
     void GetDrawables();
     /// Construct batches from the drawable objects.
     void GetBatches();
-    /// Get lit geometries and shadowcasters for visible lights.
+    /// Get lit geometries and shadowcasters for visible lights and build the light batches.
     void ProcessLights();
-    /// Get batches from lit geometries and shadowcasters.
-    void GetLightBatches();
+    /// Set up the light queue and shadow splits of a light and get the batches of its lit geometries.
+    void GetLightBatches(LightQueryResult& query);
+    /// Mark the shadow casters of a light in view and get their shadow batches. Must be called after all lights have been queried.
+    void GetShadowBatches(LightQueryResult& query);
+    /// Get lit batches for drawables that limit their maximum light count.
+    void GetMaxLightsBatches();
     /// Get unlit batches.
     void GetBaseBatches();
     /// Update geometries and sort batches.
@@ -381,6 +388,8 @@ private:
     Vector<ScenePassInfo> scenePasses_;
     /// Per-pixel light queues.
     Vector<LightBatchQueue> lightQueues_;
+    /// Number of light queues in use while the lights are processed.
+    i32 usedLightQueues_{};
     /// Per-vertex light queues.
     HashMap<hash64, LightBatchQueue> vertexLightQueues_;
     /// Batch queues by pass index.
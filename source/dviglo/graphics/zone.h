@@ -15,6 +15,7 @@ namespace dviglo
 class DV_API Zone : public Drawable
 {
     DV_OBJECT(Zone, Drawable);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
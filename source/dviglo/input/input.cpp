@@ -537,17 +537,12 @@ void Input::Update()
         {
             if (!suppressNextMouseMove_)
             {
-                using namespace MouseMove;
-
-                VariantMap& eventData = GetEventDataMap();
-
-                eventData[P_X] = mousePosition.x_;
-                eventData[P_Y] = mousePosition.y_;
-                eventData[P_DX] = mouseMove_.x_;
-                eventData[P_DY] = mouseMove_.y_;
-                eventData[P_BUTTONS] = (unsigned)mouseButtonDown_;
-                eventData[P_QUALIFIERS] = (unsigned)GetQualifiers();
-                SendEvent(E_MOUSEMOVE, eventData);
+                MouseMoveEventData eventData;
+                eventData.position_ = mousePosition;
+                eventData.delta_ = mouseMove_;
+                eventData.buttons_ = mouseButtonDown_;
+                eventData.qualifiers_ = GetQualifiers();
+                SendEvent(eventData);
             }
         }
     }
@@ -2017,17 +2012,13 @@ void Input::HandleSDLEvent(void* sdlEvent)
 
             if (!suppressNextMouseMove_)
             {
-                using namespace MouseMove;
-
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_X] = (int)(evt.motion.x * inputScale_.x_);
-                eventData[P_Y] = (int)(evt.motion.y * inputScale_.y_);
+                MouseMoveEventData eventData;
+                eventData.position_ = IntVector2((int)(evt.motion.x * inputScale_.x_), (int)(evt.motion.y * inputScale_.y_));
                 // The "on-the-fly" motion data needs to be scaled now, though this may reduce accuracy
-                eventData[P_DX] = (int)(evt.motion.xrel * inputScale_.x_);
-                eventData[P_DY] = (int)(evt.motion.yrel * inputScale_.y_);
-                eventData[P_BUTTONS] = (unsigned)mouseButtonDown_;
-                eventData[P_QUALIFIERS] = (unsigned)GetQualifiers();
-                SendEvent(E_MOUSEMOVE, eventData);
+                eventData.delta_ = IntVector2((int)(evt.motion.xrel * inputScale_.x_), (int)(evt.motion.yrel * inputScale_.y_));
+                eventData.buttons_ = mouseButtonDown_;
+                eventData.qualifiers_ = GetQualifiers();
+                SendEvent(eventData);
             }
         }
         // Only the left mouse button "finger" moves along with the mouse movement
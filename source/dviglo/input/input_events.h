@@ -39,6 +39,44 @@ DV_EVENT(E_MOUSEMOVE, MouseMove)
     DV_PARAM(P_QUALIFIERS, Qualifiers);        // int
 }
 
+/// Typed payload of E_MOUSEMOVE.
+struct MouseMoveEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_MOUSEMOVE; }
+
+    /// Mouse position. Only valid when the mouse is visible.
+    IntVector2 position_;
+    /// Mouse movement since the previous event.
+    IntVector2 delta_;
+    /// Mouse buttons held down.
+    MouseButtonFlags buttons_;
+    /// Qualifier keys held down.
+    QualifierFlags qualifiers_;
+
+    /// Write to event parameters.
+    void ToVariantMap(VariantMap& eventData) const
+    {
+        using namespace MouseMove;
+        eventData[P_X] = position_.x_;
+        eventData[P_Y] = position_.y_;
+        eventData[P_DX] = delta_.x_;
+        eventData[P_DY] = delta_.y_;
+        eventData[P_BUTTONS] = (unsigned)buttons_;
+        eventData[P_QUALIFIERS] = (unsigned)qualifiers_;
+    }
+
+    /// Read from event parameters.
+    void FromVariantMap(VariantMap& eventData)
+    {
+        using namespace MouseMove;
+        position_ = IntVector2(eventData[P_X].GetI32(), eventData[P_Y].GetI32());
+        delta_ = IntVector2(eventData[P_DX].GetI32(), eventData[P_DY].GetI32());
+        buttons_ = MouseButtonFlags(eventData[P_BUTTONS].GetU32());
+        qualifiers_ = QualifierFlags(eventData[P_QUALIFIERS].GetU32());
+    }
+};
+
 /// Mouse wheel moved.
 DV_EVENT(E_MOUSEWHEEL, MouseWheel)
 {
@@ -0,0 +1,69 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "bit_reader.h"
+#include "bit_writer.h"
+#include "deserializer.h"
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+BitReader::BitReader(Deserializer& source) :
+    source_(source),
+    scratch_(0),
+    scratchBits_(0),
+    numBits_(0)
+{
+}
+
+u32 BitReader::ReadBits(i32 numBits)
+{
+    assert(numBits >= 0 && numBits <= 32);
+
+    while (scratchBits_ < numBits)
+    {
+        scratch_ |= (u64)source_.ReadU8() << scratchBits_;
+        scratchBits_ += 8;
+    }
+
+    u32 value = (u32)(scratch_ & ((1ull << numBits) - 1));
+    scratch_ >>= numBits;
+    scratchBits_ -= numBits;
+    numBits_ += numBits;
+    return value;
+}
+
+bool BitReader::ReadBool()
+{
+    return ReadBits(1) != 0;
+}
+
+float BitReader::ReadQuantizedFloat(float min, float max, i32 numBits)
+{
+    double maxStep = (double)((1ull << numBits) - 1);
+    double normalized = maxStep > 0.0 ? ReadBits(numBits) / maxStep : 0.0;
+    return (float)(min + normalized * ((double)max - min));
+}
+
+Quaternion BitReader::ReadSmallestThreeQuaternion(i32 numBits)
+{
+    u32 largest = ReadBits(2);
+    float components[4];
+    float sumSquares = 0.0f;
+
+    for (u32 i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+        {
+            components[i] = ReadQuantizedFloat(-SMALLEST_THREE_MAX, SMALLEST_THREE_MAX, numBits);
+            sumSquares += components[i] * components[i];
+        }
+    }
+
+    components[largest] = sqrtf(Max(1.0f - sumSquares, 0.0f));
+    return Quaternion(components[0], components[1], components[2], components[3]).Normalized();
+}
+
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "../math/quaternion.h"
+
+namespace dviglo
+{
+
+class Deserializer;
+
+/// Reads values written by BitWriter from a stream. Reads only the bytes which contain the requested bits, so the rest of the stream can be read normally.
+class DV_API BitReader
+{
+public:
+    /// Construct with the source stream.
+    explicit BitReader(Deserializer& source);
+
+    /// Prevent copy construction.
+    BitReader(const BitReader& rhs) = delete;
+    /// Prevent assignment.
+    BitReader& operator =(const BitReader& rhs) = delete;
+
+    /// Read a value of the given bit width. Bit count must be 0-32.
+    u32 ReadBits(i32 numBits);
+    /// Read a bool from a single bit.
+    bool ReadBool();
+    /// Read a float written by BitWriter::WriteQuantizedFloat().
+    float ReadQuantizedFloat(float min, float max, i32 numBits);
+    /// Read a quaternion written by BitWriter::WriteSmallestThreeQuaternion().
+    Quaternion ReadSmallestThreeQuaternion(i32 numBits);
+
+    /// Return number of bits read.
+    i32 GetNumBits() const { return numBits_; }
+
+private:
+    /// Source stream.
+    Deserializer& source_;
+    /// Bits read from the stream but not yet returned.
+    u64 scratch_;
+    /// Number of bits in the scratch.
+    i32 scratchBits_;
+    /// Total number of bits read.
+    i32 numBits_;
+};
+
+}
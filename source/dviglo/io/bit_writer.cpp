@@ -0,0 +1,90 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "bit_writer.h"
+#include "serializer.h"
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+BitWriter::BitWriter(Serializer& dest) :
+    dest_(dest),
+    scratch_(0),
+    scratchBits_(0),
+    numBits_(0)
+{
+}
+
+BitWriter::~BitWriter()
+{
+    Flush();
+}
+
+void BitWriter::WriteBits(u32 value, i32 numBits)
+{
+    assert(numBits >= 0 && numBits <= 32);
+
+    if (numBits < 32)
+        value &= (1u << numBits) - 1;
+
+    scratch_ |= (u64)value << scratchBits_;
+    scratchBits_ += numBits;
+    numBits_ += numBits;
+
+    while (scratchBits_ >= 8)
+    {
+        dest_.WriteU8((u8)scratch_);
+        scratch_ >>= 8;
+        scratchBits_ -= 8;
+    }
+}
+
+void BitWriter::WriteBool(bool value)
+{
+    WriteBits(value ? 1u : 0u, 1);
+}
+
+void BitWriter::WriteQuantizedFloat(float value, float min, float max, i32 numBits)
+{
+    double maxStep = (double)((1ull << numBits) - 1);
+    double normalized = max > min ? (Clamp(value, min, max) - min) / ((double)max - min) : 0.0;
+    WriteBits((u32)Round(normalized * maxStep), numBits);
+}
+
+void BitWriter::WriteSmallestThreeQuaternion(const Quaternion& value, i32 numBits)
+{
+    Quaternion norm = value.Normalized();
+    const float components[4] = {norm.w_, norm.x_, norm.y_, norm.z_};
+
+    u32 largest = 0;
+    for (u32 i = 1; i < 4; ++i)
+    {
+        if (Abs(components[i]) > Abs(components[largest]))
+            largest = i;
+    }
+
+    // q and -q are the same rotation, so the sign of the largest component is not needed
+    float sign = components[largest] < 0.0f ? -1.0f : 1.0f;
+
+    WriteBits(largest, 2);
+    for (u32 i = 0; i < 4; ++i)
+    {
+        if (i != largest)
+            WriteQuantizedFloat(components[i] * sign, -SMALLEST_THREE_MAX, SMALLEST_THREE_MAX, numBits);
+    }
+}
+
+void BitWriter::Flush()
+{
+    if (scratchBits_ > 0)
+    {
+        dest_.WriteU8((u8)scratch_);
+        numBits_ += 8 - scratchBits_;
+        scratch_ = 0;
+        scratchBits_ = 0;
+    }
+}
+
+}
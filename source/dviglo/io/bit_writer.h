@@ -0,0 +1,55 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "../math/quaternion.h"
+
+namespace dviglo
+{
+
+class Serializer;
+
+/// Largest possible absolute value of the three smallest components of a unit quaternion.
+static const float SMALLEST_THREE_MAX = 0.70710678f;
+
+/// Writes values of arbitrary bit width to a stream. Bits are packed starting from the least significant bit of each byte.
+class DV_API BitWriter
+{
+public:
+    /// Construct with the destination stream.
+    explicit BitWriter(Serializer& dest);
+    /// Destruct. Writes the remaining bits.
+    ~BitWriter();
+
+    /// Prevent copy construction.
+    BitWriter(const BitWriter& rhs) = delete;
+    /// Prevent assignment.
+    BitWriter& operator =(const BitWriter& rhs) = delete;
+
+    /// Write the lowest bits of a value. Bit count must be 0-32.
+    void WriteBits(u32 value, i32 numBits);
+    /// Write a bool as a single bit.
+    void WriteBool(bool value);
+    /// Write a float clamped to a range and quantized to the given number of bits.
+    void WriteQuantizedFloat(float value, float min, float max, i32 numBits);
+    /// Write a unit quaternion as the index of its largest component and its three smallest components quantized to the given number of bits each.
+    void WriteSmallestThreeQuaternion(const Quaternion& value, i32 numBits);
+    /// Write the remaining bits padded to a whole byte.
+    void Flush();
+
+    /// Return number of bits written, including bits not yet flushed.
+    i32 GetNumBits() const { return numBits_; }
+
+private:
+    /// Destination stream.
+    Serializer& dest_;
+    /// Bits not yet written to the stream.
+    u64 scratch_;
+    /// Number of bits in the scratch.
+    i32 scratchBits_;
+    /// Total number of bits written.
+    i32 numBits_;
+};
+
+}
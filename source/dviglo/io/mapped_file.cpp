@@ -0,0 +1,129 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "log.h"
+#include "mapped_file.h"
+#include "path.h"
+
+#ifdef _WIN32
+#include "../common/win_wrapped.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+MappedFile::MappedFile(const String& fileName)
+{
+    Open(fileName);
+}
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+bool MappedFile::Open(const String& fileName)
+{
+    Close();
+
+    if (fileName.Empty())
+    {
+        DV_LOGERROR("Could not map file with empty name");
+        return false;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileW(to_win_native(fileName).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        DV_LOGERROR("Could not open file " + fileName);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        DV_LOGERROR("Could not map empty file " + fileName);
+        return false;
+    }
+
+    // The mapping keeps the file open, so the file handle is not needed after this
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping)
+    {
+        DV_LOGERROR("Could not map file " + fileName);
+        return false;
+    }
+
+    void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        DV_LOGERROR("Could not map file " + fileName);
+        return false;
+    }
+
+    mapping_ = mapping;
+    size_ = size.QuadPart;
+#else
+    int file = open(fileName.c_str(), O_RDONLY);
+    if (file == -1)
+    {
+        DV_LOGERROR("Could not open file " + fileName);
+        return false;
+    }
+
+    struct stat st{};
+    if (fstat(file, &st) == -1 || st.st_size == 0)
+    {
+        close(file);
+        DV_LOGERROR("Could not map empty file " + fileName);
+        return false;
+    }
+
+    // The mapping keeps the file open, so the descriptor is not needed after this
+    void* data = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (data == MAP_FAILED)
+    {
+        DV_LOGERROR("Could not map file " + fileName);
+        return false;
+    }
+
+    size_ = st.st_size;
+#endif
+
+    data_ = static_cast<const byte*>(data);
+    name_ = fileName;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (!data_)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(data_);
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+#else
+    munmap(const_cast<byte*>(data_), (size_t)size_);
+#endif
+
+    data_ = nullptr;
+    size_ = 0;
+    name_.Clear();
+}
+
+}
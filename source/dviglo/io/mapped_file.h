@@ -0,0 +1,55 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "../containers/ref_counted.h"
+#include "../containers/str.h"
+
+namespace dviglo
+{
+
+/// Read-only filesystem file mapped into memory. The contents are paged in by the OS on access and are not copied.
+class DV_API MappedFile : public RefCounted
+{
+public:
+    /// Construct.
+    MappedFile() = default;
+    /// Construct and map a filesystem file.
+    explicit MappedFile(const String& fileName);
+    /// Destruct. Unmap the file if mapped.
+    ~MappedFile() override;
+
+    /// Prevent copy construction.
+    MappedFile(const MappedFile& rhs) = delete;
+    /// Prevent assignment.
+    MappedFile& operator =(const MappedFile& rhs) = delete;
+
+    /// Map a filesystem file. Return true if successful. Files inside packages can not be mapped.
+    bool Open(const String& fileName);
+    /// Unmap the file.
+    void Close();
+
+    /// Return whether is mapped.
+    bool IsOpen() const { return data_ != nullptr; }
+    /// Return the mapped contents.
+    const byte* GetData() const { return data_; }
+    /// Return size in bytes.
+    i64 GetSize() const { return size_; }
+    /// Return the file name.
+    const String& GetName() const { return name_; }
+
+private:
+    /// Mapped contents.
+    const byte* data_ = nullptr;
+    /// Size in bytes.
+    i64 size_ = 0;
+    /// File name.
+    String name_;
+#ifdef _WIN32
+    /// File mapping handle.
+    void* mapping_ = nullptr;
+#endif
+};
+
+}
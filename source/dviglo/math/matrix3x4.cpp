@@ -32,31 +32,49 @@ void Matrix3x4::Decompose(Vector3& translation, Quaternion& rotation, Vector3& s
     rotation = Quaternion(ToMatrix3().Scaled(invScale));
 }
 
+// Cross product of the xyz components. The w component of the result is zero
+static inline __m128 Cross(__m128 a, __m128 b)
+{
+    __m128 c = _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)), b));
+    return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
 Matrix3x4 Matrix3x4::Inverse() const
 {
-    float det = m00_ * m11_ * m22_ +
-                m10_ * m21_ * m02_ +
-                m20_ * m01_ * m12_ -
-                m20_ * m11_ * m02_ -
-                m10_ * m01_ * m22_ -
-                m00_ * m21_ * m12_;
-
-    float invDet = 1.0f / det;
-    Matrix3x4 ret;
+    // Columns of the inverse of the rotation-scale part are the cross products of its rows divided by the determinant
+    const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+    __m128 r0 = _mm_and_ps(_mm_loadu_ps(&m00_), mask);
+    __m128 r1 = _mm_and_ps(_mm_loadu_ps(&m10_), mask);
+    __m128 r2 = _mm_and_ps(_mm_loadu_ps(&m20_), mask);
+    __m128 c0 = Cross(r1, r2);
+    __m128 c1 = Cross(r2, r0);
+    __m128 c2 = Cross(r0, r1);
 
-    ret.m00_ = (m11_ * m22_ - m21_ * m12_) * invDet;
-    ret.m01_ = -(m01_ * m22_ - m21_ * m02_) * invDet;
-    ret.m02_ = (m01_ * m12_ - m11_ * m02_) * invDet;
-    ret.m03_ = -(m03_ * ret.m00_ + m13_ * ret.m01_ + m23_ * ret.m02_);
-    ret.m10_ = -(m10_ * m22_ - m20_ * m12_) * invDet;
-    ret.m11_ = (m00_ * m22_ - m20_ * m02_) * invDet;
-    ret.m12_ = -(m00_ * m12_ - m10_ * m02_) * invDet;
-    ret.m13_ = -(m03_ * ret.m10_ + m13_ * ret.m11_ + m23_ * ret.m12_);
-    ret.m20_ = (m10_ * m21_ - m20_ * m11_) * invDet;
-    ret.m21_ = -(m00_ * m21_ - m20_ * m01_) * invDet;
-    ret.m22_ = (m00_ * m11_ - m10_ * m01_) * invDet;
-    ret.m23_ = -(m03_ * ret.m20_ + m13_ * ret.m21_ + m23_ * ret.m22_);
+#ifdef DV_AVX2
+    __m128 det = _mm_dp_ps(r0, c0, 0x7F);
+#else
+    __m128 det = _mm_mul_ps(r0, c0);
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+    det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+#endif
 
+    __m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), det);
+    c0 = _mm_mul_ps(c0, invDet);
+    c1 = _mm_mul_ps(c1, invDet);
+    c2 = _mm_mul_ps(c2, invDet);
+
+    // Translation column: -(inverse rotation-scale * translation)
+    __m128 c3 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, _mm_set1_ps(m03_)), _mm_mul_ps(c1, _mm_set1_ps(m13_))),
+        _mm_mul_ps(c2, _mm_set1_ps(m23_)));
+    c3 = _mm_sub_ps(_mm_setzero_ps(), c3);
+
+    _MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+    Matrix3x4 ret;
+    _mm_storeu_ps(&ret.m00_, c0);
+    _mm_storeu_ps(&ret.m10_, c1);
+    _mm_storeu_ps(&ret.m20_, c2);
     return ret;
 }
 
@@ -7,6 +7,9 @@
 #include "matrix4.h"
 
 #include <emmintrin.h>
+#ifdef DV_AVX2
+#include <immintrin.h>
+#endif
 
 namespace dviglo
 {
@@ -397,6 +400,17 @@ public:
         __m128 r2 = _mm_loadu_ps(&rhs.m20_);
         __m128 r3 = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
 
+#ifdef DV_AVX2
+        for (i32 i = 0; i < 3; ++i)
+        {
+            __m128 l = _mm_loadu_ps(&m00_ + i * 4);
+            __m128 t = _mm_mul_ps(l, r3);
+            t = _mm_fmadd_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0, t);
+            t = _mm_fmadd_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1, t);
+            t = _mm_fmadd_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2, t);
+            _mm_storeu_ps(&out.m00_ + i * 4, t);
+        }
+#else
         __m128 l = _mm_loadu_ps(&m00_);
         __m128 t0 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
         __m128 t1 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1);
@@ -417,6 +431,7 @@ public:
         t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
         t3 = _mm_mul_ps(l, r3);
         _mm_storeu_ps(&out.m20_, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+#endif
 
         return out;
     }
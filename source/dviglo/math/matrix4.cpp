@@ -56,61 +56,75 @@ void Matrix4::Decompose(Vector3& translation, Quaternion& rotation, Vector3& sca
     rotation = Quaternion(ToMatrix3().Scaled(invScale));
 }
 
-Matrix4 Matrix4::Inverse() const
+// Multiply 2x2 matrices stored in rows: a * b
+static inline __m128 Mat2Mul(__m128 a, __m128 b)
 {
-    float v0 = m20_ * m31_ - m21_ * m30_;
-    float v1 = m20_ * m32_ - m22_ * m30_;
-    float v2 = m20_ * m33_ - m23_ * m30_;
-    float v3 = m21_ * m32_ - m22_ * m31_;
-    float v4 = m21_ * m33_ - m23_ * m31_;
-    float v5 = m22_ * m33_ - m23_ * m32_;
-
-    float i00 = (v5 * m11_ - v4 * m12_ + v3 * m13_);
-    float i10 = -(v5 * m10_ - v2 * m12_ + v1 * m13_);
-    float i20 = (v4 * m10_ - v2 * m11_ + v0 * m13_);
-    float i30 = -(v3 * m10_ - v1 * m11_ + v0 * m12_);
-
-    float invDet = 1.0f / (i00 * m00_ + i10 * m01_ + i20 * m02_ + i30 * m03_);
-
-    i00 *= invDet;
-    i10 *= invDet;
-    i20 *= invDet;
-    i30 *= invDet;
-
-    float i01 = -(v5 * m01_ - v4 * m02_ + v3 * m03_) * invDet;
-    float i11 = (v5 * m00_ - v2 * m02_ + v1 * m03_) * invDet;
-    float i21 = -(v4 * m00_ - v2 * m01_ + v0 * m03_) * invDet;
-    float i31 = (v3 * m00_ - v1 * m01_ + v0 * m02_) * invDet;
-
-    v0 = m10_ * m31_ - m11_ * m30_;
-    v1 = m10_ * m32_ - m12_ * m30_;
-    v2 = m10_ * m33_ - m13_ * m30_;
-    v3 = m11_ * m32_ - m12_ * m31_;
-    v4 = m11_ * m33_ - m13_ * m31_;
-    v5 = m12_ * m33_ - m13_ * m32_;
-
-    float i02 = (v5 * m01_ - v4 * m02_ + v3 * m03_) * invDet;
-    float i12 = -(v5 * m00_ - v2 * m02_ + v1 * m03_) * invDet;
-    float i22 = (v4 * m00_ - v2 * m01_ + v0 * m03_) * invDet;
-    float i32 = -(v3 * m00_ - v1 * m01_ + v0 * m02_) * invDet;
-
-    v0 = m21_ * m10_ - m20_ * m11_;
-    v1 = m22_ * m10_ - m20_ * m12_;
-    v2 = m23_ * m10_ - m20_ * m13_;
-    v3 = m22_ * m11_ - m21_ * m12_;
-    v4 = m23_ * m11_ - m21_ * m13_;
-    v5 = m23_ * m12_ - m22_ * m13_;
-
-    float i03 = -(v5 * m01_ - v4 * m02_ + v3 * m03_) * invDet;
-    float i13 = (v5 * m00_ - v2 * m02_ + v1 * m03_) * invDet;
-    float i23 = -(v4 * m00_ - v2 * m01_ + v0 * m03_) * invDet;
-    float i33 = (v3 * m00_ - v1 * m01_ + v0 * m02_) * invDet;
+    return _mm_add_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
 
-    return Matrix4(
-        i00, i01, i02, i03,
-        i10, i11, i12, i13,
-        i20, i21, i22, i23,
-        i30, i31, i32, i33);
+// Multiply 2x2 matrices stored in rows: adjugate(a) * b
+static inline __m128 Mat2AdjMul(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// Multiply 2x2 matrices stored in rows: a * adjugate(b)
+static inline __m128 Mat2MulAdj(__m128 a, __m128 b)
+{
+    return _mm_sub_ps(_mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+        _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+Matrix4 Matrix4::Inverse() const
+{
+    // Blockwise inversion: the matrix is split into 2x2 blocks [A B; C D]
+    __m128 row0 = _mm_loadu_ps(&m00_);
+    __m128 row1 = _mm_loadu_ps(&m10_);
+    __m128 row2 = _mm_loadu_ps(&m20_);
+    __m128 row3 = _mm_loadu_ps(&m30_);
+
+    __m128 a = _mm_movelh_ps(row0, row1);
+    __m128 b = _mm_movehl_ps(row1, row0);
+    __m128 c = _mm_movelh_ps(row2, row3);
+    __m128 d = _mm_movehl_ps(row3, row2);
+
+    // Determinants of the blocks: |A|, |B|, |C|, |D|
+    __m128 detSub = _mm_sub_ps(
+        _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+        _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)), _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+    __m128 detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+    __m128 detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+    __m128 detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+    __m128 detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+    __m128 dc = Mat2AdjMul(d, c);
+    __m128 ab = Mat2AdjMul(a, b);
+    __m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+    __m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+    __m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+    __m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+    // |M| = |A| * |D| + |B| * |C| - tr((A# * B) * (D# * C))
+    __m128 tr = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 1, 2, 0)));
+    tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(2, 3, 0, 1)));
+    tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(1, 0, 3, 2)));
+    __m128 detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+
+    // Signs of the adjugate elements are folded into the reciprocal of the determinant
+    __m128 invDetM = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), detM);
+    x = _mm_mul_ps(x, invDetM);
+    y = _mm_mul_ps(y, invDetM);
+    z = _mm_mul_ps(z, invDetM);
+    w = _mm_mul_ps(w, invDetM);
+
+    Matrix4 ret;
+    _mm_storeu_ps(&ret.m00_, _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(&ret.m10_, _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+    _mm_storeu_ps(&ret.m20_, _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+    _mm_storeu_ps(&ret.m30_, _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    return ret;
 }
 
 String Matrix4::ToString() const
@@ -8,6 +8,9 @@
 #include "vector4.h"
 
 #include <emmintrin.h>
+#ifdef DV_AVX2
+#include <immintrin.h>
+#endif
 
 namespace dviglo
 {
@@ -421,6 +424,26 @@ public:
 
         Matrix4 out;
 
+#ifdef DV_AVX2
+        // Two rows of the result at once
+        __m256 r0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&rhs.m00_));
+        __m256 r1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&rhs.m10_));
+        __m256 r2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&rhs.m20_));
+        __m256 r3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(&rhs.m30_));
+
+        // Rows are loaded and stored by 128 bits: matrices are usually written by 128-bit stores just before,
+        // and a wider access would not be forwarded from them
+        for (i32 i = 0; i < 2; ++i)
+        {
+            __m256 l = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&m00_ + i * 8)), _mm_loadu_ps(&m10_ + i * 8), 1);
+            __m256 t = _mm256_mul_ps(_mm256_shuffle_ps(l, l, _MM_SHUFFLE(0, 0, 0, 0)), r0);
+            t = _mm256_fmadd_ps(_mm256_shuffle_ps(l, l, _MM_SHUFFLE(1, 1, 1, 1)), r1, t);
+            t = _mm256_fmadd_ps(_mm256_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2, t);
+            t = _mm256_fmadd_ps(_mm256_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3, t);
+            _mm_storeu_ps(&out.m00_ + i * 8, _mm256_castps256_ps128(t));
+            _mm_storeu_ps(&out.m10_ + i * 8, _mm256_extractf128_ps(t, 1));
+        }
+#else
         __m128 r0 = _mm_loadu_ps(&rhs.m00_);
         __m128 r1 = _mm_loadu_ps(&rhs.m10_);
         __m128 r2 = _mm_loadu_ps(&rhs.m20_);
@@ -453,6 +476,7 @@ public:
         t2 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(2, 2, 2, 2)), r2);
         t3 = _mm_mul_ps(_mm_shuffle_ps(l, l, _MM_SHUFFLE(3, 3, 3, 3)), r3);
         _mm_storeu_ps(&out.m30_, _mm_add_ps(_mm_add_ps(t0, t1), _mm_add_ps(t2, t3)));
+#endif
 
         return out;
     }
@@ -271,7 +271,8 @@ Quaternion Quaternion::Slerp(const Quaternion& rhs, float t) const
     }
 
     float angle = acosf(cosAngle);
-    float sinAngle = sinf(angle);
+    // sin(acos(x)) = sqrt(1 - x * x). (1 - x) is exact when x is close to 1
+    float sinAngle = sqrtf((1.0f - cosAngle) * (1.0f + cosAngle));
     float t1, t2;
 
     if (sinAngle > 0.001f)
@@ -286,7 +287,10 @@ Quaternion Quaternion::Slerp(const Quaternion& rhs, float t) const
         t2 = t;
     }
 
-    return *this * t1 + (rhs * sign) * t2;
+    // The angle and the sines are scalar, as SSE has no trigonometric instructions. Only the blend of the components is vectorized
+    __m128 q1 = _mm_mul_ps(_mm_loadu_ps(&w_), _mm_set1_ps(t1));
+    __m128 q2 = _mm_mul_ps(_mm_loadu_ps(&rhs.w_), _mm_set1_ps(t2 * sign));
+    return Quaternion(_mm_add_ps(q1, q2));
 #endif
 }
 
@@ -628,7 +628,7 @@ void CrowdManager::OnSceneSet(Scene* scene)
             return;
         }
 
-        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, DV_HANDLER(CrowdManager, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene, &CrowdManager::HandleSceneSubsystemUpdate);
 
         // Attempt to auto discover a NavigationMesh component (or its derivative) under the scene node
         if (navigationMeshId_ == 0)
@@ -671,15 +671,13 @@ const dtQueryFilter* CrowdManager::GetDetourQueryFilter(unsigned queryFilterType
     return crowd_ ? crowd_->getFilter(queryFilterType) : nullptr;
 }
 
-void CrowdManager::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void CrowdManager::HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData)
 {
     // Perform update tick as long as the crowd is initialized and the associated navmesh has not been removed
     if (crowd_ && navigationMesh_)
     {
-        using namespace SceneSubsystemUpdate;
-
         if (IsEnabledEffective())
-            Update(eventData[P_TIMESTEP].GetFloat());
+            Update(eventData.timeStep_);
     }
 }
 
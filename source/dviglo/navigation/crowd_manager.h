@@ -21,6 +21,7 @@ namespace dviglo
 
 class CrowdAgent;
 class NavigationMesh;
+struct SceneSubsystemUpdateEventData;
 
 /// Parameter structure for obstacle avoidance params (copied from DetourObstacleAvoidance.h in order to hide Detour header from Urho3D library users).
 struct CrowdObstacleAvoidanceParams
@@ -155,7 +156,7 @@ protected:
 
 private:
     /// Handle the scene subsystem update event.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData);
     /// Handle navigation mesh changed event. It can be navmesh being rebuilt or being removed from its node.
     void HandleNavMeshChanged(StringHash eventType, VariantMap& eventData);
     /// Handle component added in the scene to check for late addition of the navmesh.
@@ -1050,7 +1050,7 @@ void DynamicNavigationMesh::OnSceneSet(Scene* scene)
 {
     // Subscribe to the scene subsystem update, which will trigger the tile cache to update the nav mesh
     if (scene)
-        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, DV_HANDLER(DynamicNavigationMesh, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene, &DynamicNavigationMesh::HandleSceneSubsystemUpdate);
     else
         UnsubscribeFromEvent(E_SCENESUBSYSTEMUPDATE);
 }
@@ -1130,12 +1130,10 @@ void DynamicNavigationMesh::RemoveObstacle(Obstacle* obstacle, bool silent)
     }
 }
 
-void DynamicNavigationMesh::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void DynamicNavigationMesh::HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData)
 {
-    using namespace SceneSubsystemUpdate;
-
     if (tileCache_ && navMesh_ && IsEnabledEffective())
-        tileCache_->update(eventData[P_TIMESTEP].GetFloat(), navMesh_);
+        tileCache_->update(eventData.timeStep_, navMesh_);
 }
 
 }
@@ -21,6 +21,7 @@ namespace dviglo
 
 class OffMeshConnection;
 class Obstacle;
+struct SceneSubsystemUpdateEventData;
 
 class DV_API DynamicNavigationMesh : public NavigationMesh
 {
@@ -88,7 +89,7 @@ protected:
     /// Subscribe to events when assigned to a scene.
     void OnSceneSet(Scene* scene) override;
     /// Trigger the tile cache to make updates to the nav mesh if necessary.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData);
 
     /// Used by Obstacle class to add itself to the tile cache, if 'silent' an event will not be raised.
     void AddObstacle(Obstacle* obstacle, bool silent = false);
@@ -9,6 +9,7 @@
 #include "../io/memory_buffer.h"
 #include "../io/package_file.h"
 #include "connection.h"
+#include "interest_grid.h"
 #include "network.h"
 #include "network_events.h"
 #include "network_priority.h"
@@ -31,12 +32,28 @@
 #include "../common/debug_new.h"
 
 #include <cstdio>
+#include <mutex>
 
 namespace dviglo
 {
 
 static const int STATS_INTERVAL_MSEC = 2000;
 
+/// Guards adding replication states to nodes and components, which are shared by connections updated in worker threads.
+static std::mutex replicationStateMutex;
+
+/// Return the attributes changed after a scene network update tick.
+static DirtyBits GetChangedAttributes(const NetworkState& networkState, unsigned tick)
+{
+    DirtyBits bits;
+    for (unsigned i = 0; i < networkState.changeTicks_.Size(); ++i)
+    {
+        if (networkState.changeTicks_[i] > tick)
+            bits.Set(i);
+    }
+    return bits;
+}
+
 PackageDownload::PackageDownload() :
     totalFragments_(0),
     checksum_(0),
@@ -52,13 +69,19 @@ PackageUpload::PackageUpload() :
 
 Connection::Connection(bool isClient, const SLNet::AddressOrGUID& address, SLNet::RakPeerInterface* peer) :
     timeStamp_(0),
-    peer_(peer),
+    numSnapshotNodes_(0),
+    numSnapshotComponents_(0),
+    snapshotSequence_(0),
+    ackedSnapshot_(0),
     sendMode_(OPSM_NONE),
+    interestManaged_(false),
+    snapshotReplication_(false),
     isClient_(isClient),
     connectPending_(false),
     sceneLoaded_(false),
     logStatistics_(false),
     address_(nullptr),
+    peer_(peer),
     packedMessageLimit_(1024)
 {
     sceneState_.connection_ = this;
@@ -103,6 +126,12 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const byte*
         return;
     }
 
+    VectorBuffer& buffer = BeginMessage(msgID, reliable, inOrder, numBytes);
+    buffer.Write(data, numBytes);
+}
+
+VectorBuffer& Connection::BeginMessage(int msgID, bool reliable, bool inOrder, unsigned numBytes)
+{
     PacketType type = GetPacketType(reliable, inOrder);
     VectorBuffer& buffer = outgoingBuffer_[type];
 
@@ -117,7 +146,16 @@ void Connection::SendMessage(int msgID, bool reliable, bool inOrder, const byte*
 
     buffer.WriteU32((unsigned int) msgID);
     buffer.WriteU32(numBytes);
-    buffer.Write(data, numBytes);
+    return buffer;
+}
+
+void Connection::SendSharedUpdate(int msgID, bool reliable, bool inOrder, unsigned objectID, const VectorBuffer& update)
+{
+    // Net ID (3 bytes) and timestamp precede the shared data, which is copied directly into the outgoing buffer
+    VectorBuffer& buffer = BeginMessage(msgID, reliable, inOrder, 4 + update.GetSize());
+    buffer.WriteNetID(objectID);
+    buffer.WriteU8(timeStamp_);
+    buffer.Write(update.GetData(), update.GetSize());
 }
 
 void Connection::SendRemoteEvent(StringHash eventType, bool inOrder, const VariantMap& eventData)
@@ -167,6 +205,7 @@ void Connection::SetScene(Scene* newScene)
     scene_ = newScene;
     sceneLoaded_ = false;
     UnsubscribeFromEvent(E_ASYNCLOADFINISHED);
+    ClearSnapshotHistory();
 
     if (!scene_)
         return;
@@ -222,6 +261,22 @@ void Connection::SetRotation(const Quaternion& rotation)
         sendMode_ = OPSM_POSITION_ROTATION;
 }
 
+void Connection::SetSnapshotReplication(bool enable)
+{
+    if (enable == snapshotReplication_)
+        return;
+
+    snapshotReplication_ = enable;
+
+    // The replication states of the two modes are not interchangeable, so send the whole scene again
+    if (isClient_ && scene_)
+    {
+        scene_->CleanupConnection(this);
+        sceneState_.Clear();
+        ClearSnapshotHistory();
+    }
+}
+
 void Connection::SetConnectPending(bool connectPending)
 {
     connectPending_ = connectPending;
@@ -242,14 +297,38 @@ void Connection::SendServerUpdate()
     if (!scene_ || !sceneLoaded_)
         return;
 
+    snapshotNodes_.Clear();
+    snapshotComponents_.Clear();
+    numSnapshotNodes_ = 0;
+    numSnapshotComponents_ = 0;
+    snapshotNodeIDs_.Clear();
+
     // Always check the root node (scene) first so that the scene-wide components get sent first,
     // and all other replicated nodes get added to the dirty set for sending the initial state
     unsigned sceneID = scene_->GetID();
     nodesToProcess_.Insert(sceneID);
     ProcessNode(sceneID);
 
-    // Then go through all dirtied nodes
-    nodesToProcess_.Insert(sceneState_.dirtyNodes_);
+    // Then go through all dirtied nodes. With interest management, the nodes outside the area of interest are set aside
+    UpdateInterest();
+    if (interestManaged_)
+    {
+        for (HashSet<unsigned>::Iterator i = sceneState_.dirtyNodes_.Begin(); i != sceneState_.dirtyNodes_.End();)
+        {
+            if (IsNodeRelevant(*i))
+            {
+                nodesToProcess_.Insert(*i);
+                ++i;
+            }
+            else
+            {
+                sceneState_.irrelevantNodes_.Insert(*i);
+                i = sceneState_.dirtyNodes_.Erase(i);
+            }
+        }
+    }
+    else
+        nodesToProcess_.Insert(sceneState_.dirtyNodes_);
     nodesToProcess_.Erase(sceneID); // Do not process the root node twice
 
     while (nodesToProcess_.Size())
@@ -257,6 +336,9 @@ void Connection::SendServerUpdate()
         unsigned nodeID = nodesToProcess_.Front();
         ProcessNode(nodeID);
     }
+
+    if (snapshotReplication_)
+        SendSnapshot();
 }
 
 void Connection::SendClientUpdate()
@@ -276,6 +358,14 @@ void Connection::SendClientUpdate()
         msg_.WritePackedQuaternion(rotation_);
     SendMessage(MSG_CONTROLS, false, false, msg_, CONTROLS_CONTENT_ID);
 
+    // Acknowledge the latest snapshot applied in full. Repeated on every update, as the acknowledgements are unreliable too
+    if (ackedSnapshot_)
+    {
+        msg_.Clear();
+        msg_.WriteU32(ackedSnapshot_);
+        SendMessage(MSG_SNAPSHOTACK, false, false, msg_);
+    }
+
     ++timeStamp_;
 }
 
@@ -490,6 +580,14 @@ bool Connection::ProcessMessage(int msgID, MemoryBuffer& buffer)
             case MSG_PACKAGEINFO:
                 ProcessPackageInfo(msgID, msg);
                 break;
+
+            case MSG_SNAPSHOT:
+                ProcessSnapshot(msgID, msg);
+                break;
+
+            case MSG_SNAPSHOTACK:
+                ProcessSnapshotAck(msgID, msg);
+                break;
             default:
                 ProcessUnknownMessage(msgID, msg);
                 break;
@@ -1040,6 +1138,115 @@ void Connection::ProcessRemoteEvent(int msgID, MemoryBuffer& msg)
     }
 }
 
+void Connection::ProcessSnapshot(int msgID, MemoryBuffer& msg)
+{
+    if (IsClient())
+    {
+        DV_LOGWARNING("Received unexpected Snapshot message from client " + ToString());
+        return;
+    }
+
+    if (!scene_)
+        return;
+
+    // Snapshots are sent unreliably. An older snapshot arriving late must not overwrite newer state
+    unsigned sequence = msg.ReadU32();
+    if (sequence <= snapshotSequence_)
+        return;
+    snapshotSequence_ = sequence;
+
+    // Entries of nodes and components whose creation has not arrived yet are skipped
+    bool complete = true;
+
+    unsigned numNodes = msg.ReadVLE();
+    while (numNodes--)
+    {
+        unsigned nodeID = msg.ReadNetID();
+        unsigned size = msg.ReadVLE();
+        if (size > msg.GetSize() - msg.GetPosition())
+        {
+            DV_LOGWARNING("Truncated Snapshot message received from server");
+            return;
+        }
+
+        MemoryBuffer data(msg.GetData() + msg.GetPosition(), size);
+        msg.Seek(msg.GetPosition() + size);
+
+        Node* node = scene_->GetNode(nodeID);
+        if (node)
+        {
+            node->ReadDeltaUpdate(data);
+            // ApplyAttributes() is deliberately skipped, as Node has no attributes that require late applying.
+            // Furthermore it would propagate to components and child nodes, which is not desired in this case
+        }
+        else
+            complete = false;
+    }
+
+    unsigned numComponents = msg.ReadVLE();
+    while (numComponents--)
+    {
+        unsigned componentID = msg.ReadNetID();
+        unsigned size = msg.ReadVLE();
+        if (size > msg.GetSize() - msg.GetPosition())
+        {
+            DV_LOGWARNING("Truncated Snapshot message received from server");
+            return;
+        }
+
+        MemoryBuffer data(msg.GetData() + msg.GetPosition(), size);
+        msg.Seek(msg.GetPosition() + size);
+
+        Component* component = scene_->GetComponent(componentID);
+        if (component)
+        {
+            if (component->ReadDeltaUpdate(data))
+                component->ApplyAttributes();
+        }
+        else
+            complete = false;
+    }
+
+    // The server does not send again what has been acknowledged, so only acknowledge snapshots applied in full
+    if (complete)
+        ackedSnapshot_ = sequence;
+}
+
+void Connection::ProcessSnapshotAck(int msgID, MemoryBuffer& msg)
+{
+    if (!IsClient())
+    {
+        DV_LOGWARNING("Received unexpected SnapshotAck message from server");
+        return;
+    }
+
+    // The same acknowledgement is repeated until a newer snapshot arrives, and acknowledgements may arrive out of order.
+    // Each snapshot in the history is processed once
+    unsigned sequence = msg.ReadU32();
+    SnapshotRecord& record = snapshotHistory_[sequence % SNAPSHOT_HISTORY_SIZE];
+    if (!sequence || record.sequence_ != sequence)
+        return;
+
+    ackedSnapshot_ = Max(ackedSnapshot_, sequence);
+
+    // The client now has the attributes of the nodes in the snapshot and their components as of the snapshot's tick
+    for (unsigned nodeID : record.nodes_)
+    {
+        HashMap<unsigned, NodeReplicationState>::Iterator i = sceneState_.nodeStates_.Find(nodeID);
+        if (i == sceneState_.nodeStates_.End())
+            continue;
+
+        NodeReplicationState& nodeState = i->second_;
+        nodeState.ackedTick_ = Max(nodeState.ackedTick_, record.tick_);
+        for (HashMap<unsigned, ComponentReplicationState>::Iterator j = nodeState.componentStates_.Begin();
+             j != nodeState.componentStates_.End(); ++j)
+            j->second_.ackedTick_ = Max(j->second_.ackedTick_, record.tick_);
+    }
+
+    record.sequence_ = 0;
+    record.nodes_.Clear();
+}
+
 Scene* Connection::GetScene() const
 {
     return scene_;
@@ -1176,6 +1383,42 @@ void Connection::HandleAsyncLoadFinished(StringHash eventType, VariantMap& event
     SendMessage(MSG_SCENELOADED, true, true, msg_);
 }
 
+void Connection::UpdateInterest()
+{
+    auto* interestGrid = scene_->GetComponent<InterestGrid>();
+    bool managed = interestGrid && interestGrid->IsEnabledEffective();
+
+    if (managed)
+    {
+        IntRect cells = interestGrid->GetInterestCells(position_);
+        if (interestManaged_ && cells == interestCells_)
+            return;
+        interestCells_ = cells;
+    }
+    else if (!interestManaged_)
+        return;
+
+    interestManaged_ = managed;
+
+    // The area of interest has moved or interest management was turned off: check the skipped nodes again
+    sceneState_.dirtyNodes_.Insert(sceneState_.irrelevantNodes_);
+    sceneState_.irrelevantNodes_.Clear();
+}
+
+bool Connection::IsNodeRelevant(unsigned nodeID) const
+{
+    HashMap<unsigned, NodeReplicationState>::ConstIterator i = sceneState_.nodeStates_.Find(nodeID);
+    if (i == sceneState_.nodeStates_.End())
+        return true;
+
+    Node* node = i->second_.node_;
+    if (!node || node->GetOwner() == this)
+        return true;
+
+    const NetworkState* networkState = node->GetNetworkState();
+    return !networkState || !networkState->hasInterestCell_ || interestCells_.IsInside(networkState->interestCell_) != OUTSIDE;
+}
+
 void Connection::ProcessNode(unsigned nodeID)
 {
     // Check that we have not already processed this due to dependency recursion
@@ -1234,7 +1477,11 @@ void Connection::ProcessNewNode(Node* node)
     nodeState.connection_ = this;
     nodeState.sceneState_ = &sceneState_;
     nodeState.node_ = node;
-    node->AddReplicationState(&nodeState);
+    nodeState.ackedTick_ = scene_->GetNetworkUpdateTick();
+    {
+        std::scoped_lock lock(replicationStateMutex);
+        node->AddReplicationState(&nodeState);
+    }
 
     // Write node's attributes
     node->WriteInitialDeltaUpdate(msg_, timeStamp_);
@@ -1262,7 +1509,11 @@ void Connection::ProcessNewNode(Node* node)
         componentState.connection_ = this;
         componentState.nodeState_ = &nodeState;
         componentState.component_ = component;
-        component->AddReplicationState(&componentState);
+        componentState.ackedTick_ = scene_->GetNetworkUpdateTick();
+        {
+            std::scoped_lock lock(replicationStateMutex);
+            component->AddReplicationState(&componentState);
+        }
 
         msg_.WriteStringHash(component->GetType());
         msg_.WriteNetID(component->GetID());
@@ -1286,18 +1537,24 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             ProcessNode(nodeID);
     }
 
-    // Check from the interest management component, if exists, whether should update
+    // Check from the interest management component, if exists, whether should update. An InterestGrid replaces the per-node components
     /// \todo Searching for the component is a potential CPU hotspot. It should be cached
-    auto* priority = node->GetComponent<NetworkPriority>();
-    if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
+    if (!interestManaged_)
     {
-        float distance = (node->GetWorldPosition() - position_).Length();
-        if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
-            return;
+        auto* priority = node->GetComponent<NetworkPriority>();
+        if (priority && (!priority->GetAlwaysUpdateOwner() || node->GetOwner() != this))
+        {
+            float distance = (node->GetWorldPosition() - position_).Length();
+            if (!priority->CheckUpdate(distance, nodeState.priorityAcc_))
+                return;
+        }
     }
 
-    // Check if attributes have changed
-    if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.Size())
+    // Check if attributes have changed. In snapshot replication, the node stays in the dirty set until the client acknowledges them
+    bool unacknowledged = false;
+    if (snapshotReplication_)
+        unacknowledged = WriteSnapshotNode(node, nodeState);
+    else if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.Size())
     {
         const Vector<AttributeInfo>* attributes = node->GetNetworkAttributes();
         unsigned numAttributes = attributes->Size();
@@ -1312,44 +1569,38 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             }
         }
 
+        // Use the updates serialized by Node::PrepareNetworkUpdate() when they match what this connection needs
+        const NetworkState* networkState = node->GetNetworkState();
+
         // Send latestdata message if necessary
         if (hasLatestData)
         {
-            msg_.Clear();
-            msg_.WriteNetID(node->GetID());
-            node->WriteLatestDataUpdate(msg_, timeStamp_);
+            if (networkState->latestDataUpdate_.GetSize())
+                SendSharedUpdate(MSG_NODELATESTDATA, true, false, node->GetID(), networkState->latestDataUpdate_);
+            else
+            {
+                msg_.Clear();
+                msg_.WriteNetID(node->GetID());
+                node->WriteLatestDataUpdate(msg_, timeStamp_);
 
-            SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
+                SendMessage(MSG_NODELATESTDATA, true, false, msg_, node->GetID());
+            }
         }
 
         // Send deltaupdate if remaining dirty bits, or vars have changed
         if (nodeState.dirtyAttributes_.Count() || nodeState.dirtyVars_.Size())
         {
-            msg_.Clear();
-            msg_.WriteNetID(node->GetID());
-            node->WriteDeltaUpdate(msg_, nodeState.dirtyAttributes_, timeStamp_);
-
-            // Write changed variables
-            msg_.WriteVLE(nodeState.dirtyVars_.Size());
-            const VariantMap& vars = node->GetVars();
-            for (HashSet<StringHash>::ConstIterator i = nodeState.dirtyVars_.Begin(); i != nodeState.dirtyVars_.End(); ++i)
+            if (nodeState.dirtyAttributes_ == networkState->deltaBits_ && nodeState.dirtyVars_ == networkState->deltaVars_)
+                SendSharedUpdate(MSG_NODEDELTAUPDATE, true, true, node->GetID(), networkState->deltaUpdate_);
+            else
             {
-                VariantMap::ConstIterator j = vars.Find(*i);
-                if (j != vars.End())
-                {
-                    msg_.WriteStringHash(j->first_);
-                    msg_.WriteVariant(j->second_);
-                }
-                else
-                {
-                    // Variable has been marked dirty, but is removed (which is unsupported): send a dummy variable in place
-                    DV_LOGWARNING("Sending dummy user variable as original value was removed");
-                    msg_.WriteStringHash(StringHash());
-                    msg_.WriteVariant(Variant::EMPTY);
-                }
-            }
+                msg_.Clear();
+                msg_.WriteNetID(node->GetID());
+                node->WriteDeltaUpdate(msg_, nodeState.dirtyAttributes_, timeStamp_);
+                WriteChangedVars(node, nodeState.dirtyVars_);
 
-            SendMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
+                SendMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
+            }
 
             nodeState.dirtyAttributes_.ClearAll();
             nodeState.dirtyVars_.Clear();
@@ -1372,7 +1623,7 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
             SendMessage(MSG_REMOVECOMPONENT, true, true, msg_);
             nodeState.componentStates_.Erase(current);
         }
-        else
+        else if (!snapshotReplication_)
         {
             // Existing component. Check if attributes have changed
             if (componentState.dirtyAttributes_.Count())
@@ -1390,24 +1641,37 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                     }
                 }
 
+                // Use the updates serialized by Component::PrepareNetworkUpdate() when they match what this connection needs
+                const NetworkState* networkState = component->GetNetworkState();
+
                 // Send latestdata message if necessary
                 if (hasLatestData)
                 {
-                    msg_.Clear();
-                    msg_.WriteNetID(component->GetID());
-                    component->WriteLatestDataUpdate(msg_, timeStamp_);
+                    if (networkState->latestDataUpdate_.GetSize())
+                        SendSharedUpdate(MSG_COMPONENTLATESTDATA, true, false, component->GetID(), networkState->latestDataUpdate_);
+                    else
+                    {
+                        msg_.Clear();
+                        msg_.WriteNetID(component->GetID());
+                        component->WriteLatestDataUpdate(msg_, timeStamp_);
 
-                    SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
+                        SendMessage(MSG_COMPONENTLATESTDATA, true, false, msg_, component->GetID());
+                    }
                 }
 
                 // Send deltaupdate if remaining dirty bits
                 if (componentState.dirtyAttributes_.Count())
                 {
-                    msg_.Clear();
-                    msg_.WriteNetID(component->GetID());
-                    component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
+                    if (componentState.dirtyAttributes_ == networkState->deltaBits_)
+                        SendSharedUpdate(MSG_COMPONENTDELTAUPDATE, true, true, component->GetID(), networkState->deltaUpdate_);
+                    else
+                    {
+                        msg_.Clear();
+                        msg_.WriteNetID(component->GetID());
+                        component->WriteDeltaUpdate(msg_, componentState.dirtyAttributes_, timeStamp_);
 
-                    SendMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
+                        SendMessage(MSG_COMPONENTDELTAUPDATE, true, true, msg_);
+                    }
 
                     componentState.dirtyAttributes_.ClearAll();
                 }
@@ -1434,7 +1698,11 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
                 componentState.connection_ = this;
                 componentState.nodeState_ = &nodeState;
                 componentState.component_ = component;
-                component->AddReplicationState(&componentState);
+                componentState.ackedTick_ = scene_->GetNetworkUpdateTick();
+                {
+                    std::scoped_lock lock(replicationStateMutex);
+                    component->AddReplicationState(&componentState);
+                }
 
                 msg_.Clear();
                 msg_.WriteNetID(node->GetID());
@@ -1447,10 +1715,129 @@ void Connection::ProcessExistingNode(Node* node, NodeReplicationState& nodeState
         }
     }
 
+    if (unacknowledged)
+        return;
+
     nodeState.markedDirty_ = false;
     sceneState_.dirtyNodes_.Erase(node->GetID());
 }
 
+bool Connection::WriteSnapshotNode(Node* node, NodeReplicationState& nodeState)
+{
+    // User variables are not delta compressed against the acknowledged snapshot, so send them reliably
+    if (nodeState.dirtyVars_.Size())
+    {
+        msg_.Clear();
+        msg_.WriteNetID(node->GetID());
+        node->WriteDeltaUpdate(msg_, DirtyBits(), timeStamp_);
+        WriteChangedVars(node, nodeState.dirtyVars_);
+
+        SendMessage(MSG_NODEDELTAUPDATE, true, true, msg_);
+        nodeState.dirtyVars_.Clear();
+    }
+
+    // Which attributes to send is decided by the change ticks, so the dirty bits are not needed
+    bool written = false;
+    nodeState.dirtyAttributes_.ClearAll();
+
+    const NetworkState* networkState = node->GetNetworkState();
+    if (networkState->lastChangeTick_ > nodeState.ackedTick_)
+    {
+        msg_.Clear();
+        node->WriteDeltaUpdate(msg_, GetChangedAttributes(*networkState, nodeState.ackedTick_), timeStamp_);
+
+        snapshotNodes_.WriteNetID(node->GetID());
+        snapshotNodes_.WriteVLE(msg_.GetSize());
+        snapshotNodes_.Write(msg_.GetData(), msg_.GetSize());
+        ++numSnapshotNodes_;
+        written = true;
+    }
+
+    for (HashMap<unsigned, ComponentReplicationState>::Iterator i = nodeState.componentStates_.Begin();
+         i != nodeState.componentStates_.End(); ++i)
+    {
+        ComponentReplicationState& componentState = i->second_;
+        Component* component = componentState.component_;
+        if (!component)
+            continue;
+
+        componentState.dirtyAttributes_.ClearAll();
+
+        const NetworkState* componentNetworkState = component->GetNetworkState();
+        if (componentNetworkState->lastChangeTick_ > componentState.ackedTick_)
+        {
+            msg_.Clear();
+            component->WriteDeltaUpdate(msg_, GetChangedAttributes(*componentNetworkState, componentState.ackedTick_), timeStamp_);
+
+            snapshotComponents_.WriteNetID(component->GetID());
+            snapshotComponents_.WriteVLE(msg_.GetSize());
+            snapshotComponents_.Write(msg_.GetData(), msg_.GetSize());
+            ++numSnapshotComponents_;
+            written = true;
+        }
+    }
+
+    // Acknowledging the snapshot acknowledges the components along with the node
+    if (written)
+        snapshotNodeIDs_.Push(node->GetID());
+
+    return written;
+}
+
+void Connection::WriteChangedVars(Node* node, const HashSet<StringHash>& vars)
+{
+    msg_.WriteVLE(vars.Size());
+    const VariantMap& nodeVars = node->GetVars();
+    for (HashSet<StringHash>::ConstIterator i = vars.Begin(); i != vars.End(); ++i)
+    {
+        VariantMap::ConstIterator j = nodeVars.Find(*i);
+        if (j != nodeVars.End())
+        {
+            msg_.WriteStringHash(j->first_);
+            msg_.WriteVariant(j->second_);
+        }
+        else
+        {
+            // Variable has been marked dirty, but is removed (which is unsupported): send a dummy variable in place
+            DV_LOGWARNING("Sending dummy user variable as original value was removed");
+            msg_.WriteStringHash(StringHash());
+            msg_.WriteVariant(Variant::EMPTY);
+        }
+    }
+}
+
+void Connection::SendSnapshot()
+{
+    if (snapshotNodeIDs_.Empty())
+        return;
+
+    // Remember which nodes the snapshot updates, until the client acknowledges it or the record is reused
+    ++snapshotSequence_;
+    SnapshotRecord& record = snapshotHistory_[snapshotSequence_ % SNAPSHOT_HISTORY_SIZE];
+    record.sequence_ = snapshotSequence_;
+    record.tick_ = scene_->GetNetworkUpdateTick();
+    record.nodes_.Swap(snapshotNodeIDs_);
+
+    msg_.Clear();
+    msg_.WriteU32(snapshotSequence_);
+    msg_.WriteVLE(numSnapshotNodes_);
+    msg_.Write(snapshotNodes_.GetData(), snapshotNodes_.GetSize());
+    msg_.WriteVLE(numSnapshotComponents_);
+    msg_.Write(snapshotComponents_.GetData(), snapshotComponents_.GetSize());
+
+    // Unreliable sequenced: a lost snapshot is not resent, the next one carries the same changes against the acknowledged baseline
+    SendMessage(MSG_SNAPSHOT, false, true, msg_);
+}
+
+void Connection::ClearSnapshotHistory()
+{
+    for (SnapshotRecord& record : snapshotHistory_)
+    {
+        record.sequence_ = 0;
+        record.nodes_.Clear();
+    }
+}
+
 bool Connection::RequestNeededPackages(unsigned numPackages, MemoryBuffer& msg)
 {
     ResourceCache& cache = DV_RES_CACHE;
@@ -11,7 +11,9 @@
 #include "../core/timer.h"
 #include "../input/controls.h"
 #include "../io/vector_buffer.h"
+#include "../math/rect.h"
 #include "../scene/replication_state.h"
+#include "protocol.h"
 
 namespace SLNet
 {
@@ -80,6 +82,17 @@ struct PackageUpload
     unsigned totalFragments_;
 };
 
+/// Snapshot sent to the client, remembered until acknowledged.
+struct SnapshotRecord
+{
+    /// Sequence number, or 0 if the record is not in use.
+    unsigned sequence_{};
+    /// Scene network update tick of the snapshot.
+    unsigned tick_{};
+    /// Nodes with changes in the snapshot.
+    Vector<unsigned> nodes_;
+};
+
 /// Send modes for observer position/rotation. Activated by the client setting either position or rotation.
 enum ObserverPositionSendMode
 {
@@ -126,6 +139,8 @@ public:
     void SetPosition(const Vector3& position);
     /// Set the observer rotation for interest management, to be sent to the server. Note: not used by the NetworkPriority component.
     void SetRotation(const Quaternion& rotation);
+    /// Set whether attribute changes of already sent nodes and components are replicated as unreliable snapshots, delta compressed against the last snapshot acknowledged by the client. Changing resends the scene. Called by Network.
+    void SetSnapshotReplication(bool enable);
     /// Set the connection pending status. Called by Network.
     void SetConnectPending(bool connectPending);
     /// Set whether to log data in/out statistics.
@@ -187,6 +202,15 @@ public:
     /// Return whether to log data in/out statistics.
     bool GetLogStatistics() const { return logStatistics_; }
 
+    /// Return whether attribute changes are replicated as unreliable snapshots.
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+
+    /// Return the sequence number of the last snapshot sent on the server, or received on the client. 0 if none.
+    unsigned GetSnapshotSequence() const { return snapshotSequence_; }
+
+    /// Return the sequence number of the last snapshot applied in full by the client. 0 if none.
+    unsigned GetAckedSnapshot() const { return ackedSnapshot_; }
+
     /// Return remote address.
     String GetAddress() const;
 
@@ -253,12 +277,32 @@ private:
     void ProcessSceneLoaded(int msgID, MemoryBuffer& msg);
     /// Process a remote event message from the client or server. Called by Network.
     void ProcessRemoteEvent(int msgID, MemoryBuffer& msg);
+    /// Process a Snapshot message from the server. Called by Network.
+    void ProcessSnapshot(int msgID, MemoryBuffer& msg);
+    /// Process a SnapshotAck message from the client. Called by Network.
+    void ProcessSnapshotAck(int msgID, MemoryBuffer& msg);
+    /// Update the area of interest from the scene's InterestGrid. When it changes, the skipped nodes are checked again.
+    void UpdateInterest();
+    /// Return whether updates of a node should be sent now. New and removed nodes, and nodes owned by this connection are always relevant.
+    bool IsNodeRelevant(unsigned nodeID) const;
     /// Process a node for sending a network update. Recurses to process depended on node(s) first.
     void ProcessNode(unsigned nodeID);
     /// Process a node that the client has not yet received.
     void ProcessNewNode(Node* node);
     /// Process a node that the client has already received.
     void ProcessExistingNode(Node* node, NodeReplicationState& nodeState);
+    /// Write the attribute changes of a node and its components, which the client has not acknowledged, into the snapshot. Return true if any were written.
+    bool WriteSnapshotNode(Node* node, NodeReplicationState& nodeState);
+    /// Write changed node user variables into the message buffer.
+    void WriteChangedVars(Node* node, const HashSet<StringHash>& vars);
+    /// Send the snapshot written during the server update and add it to the history.
+    void SendSnapshot();
+    /// Forget the sent snapshots, so that their acknowledgements are ignored.
+    void ClearSnapshotHistory();
+    /// Start a packed message in the outgoing buffer and return the buffer, into which the numBytes of message data should be written.
+    VectorBuffer& BeginMessage(int msgID, bool reliable, bool inOrder, unsigned numBytes);
+    /// Send a node or component update that was serialized once for all connections. Writes the ID and the timestamp in front of the shared data.
+    void SendSharedUpdate(int msgID, bool reliable, bool inOrder, unsigned objectID, const VectorBuffer& update);
     /// Process a SyncPackagesInfo message from server.
     void ProcessPackageInfo(int msgID, MemoryBuffer& msg);
     /// Process unknown message. All unknown messages are forwarded as an events
@@ -292,6 +336,22 @@ private:
     HashSet<unsigned> nodesToProcess_;
     /// Reusable message buffer.
     VectorBuffer msg_;
+    /// Node entries of the snapshot being written.
+    VectorBuffer snapshotNodes_;
+    /// Component entries of the snapshot being written.
+    VectorBuffer snapshotComponents_;
+    /// Number of node entries in the snapshot being written.
+    unsigned numSnapshotNodes_;
+    /// Number of component entries in the snapshot being written.
+    unsigned numSnapshotComponents_;
+    /// Nodes with changes in the snapshot being written.
+    Vector<unsigned> snapshotNodeIDs_;
+    /// Sent snapshots by sequence number modulo the history size.
+    SnapshotRecord snapshotHistory_[SNAPSHOT_HISTORY_SIZE];
+    /// Sequence number of the last snapshot sent on the server, or received on the client.
+    unsigned snapshotSequence_;
+    /// Sequence number of the last snapshot applied in full by the client.
+    unsigned ackedSnapshot_;
     /// Queued remote events.
     Vector<RemoteEvent> remoteEvents_;
     /// Scene file to load once all packages (if any) have been downloaded.
@@ -306,6 +366,12 @@ private:
     Quaternion rotation_;
     /// Send mode for the observer position & rotation.
     ObserverPositionSendMode sendMode_;
+    /// Interest management grid cells around the observer position.
+    IntRect interestCells_;
+    /// Whether the scene's InterestGrid decides which node updates are sent.
+    bool interestManaged_;
+    /// Snapshot replication flag.
+    bool snapshotReplication_;
     /// Client connection flag.
     bool isClient_;
     /// Connection pending flag.
@@ -0,0 +1,129 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../core/context.h"
+#include "../core/profiler.h"
+#include "../scene/replication_state.h"
+#include "../scene/scene.h"
+#include "interest_grid.h"
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+extern const char* NETWORK_CATEGORY;
+
+static const float DEFAULT_CELL_SIZE = 50.0f;
+static const float DEFAULT_INTEREST_DISTANCE = 100.0f;
+
+InterestGrid::InterestGrid() :
+    cellSize_(DEFAULT_CELL_SIZE),
+    interestDistance_(DEFAULT_INTEREST_DISTANCE),
+    cellsDirty_(true)
+{
+}
+
+InterestGrid::~InterestGrid() = default;
+
+void InterestGrid::RegisterObject()
+{
+    DV_CONTEXT.RegisterFactory<InterestGrid>(NETWORK_CATEGORY);
+
+    DV_ACCESSOR_ATTRIBUTE("Is Enabled", IsEnabled, SetEnabled, true, AM_DEFAULT);
+    DV_ACCESSOR_ATTRIBUTE("Cell Size", GetCellSize, SetCellSize, DEFAULT_CELL_SIZE, AM_DEFAULT);
+    DV_ACCESSOR_ATTRIBUTE("Interest Distance", GetInterestDistance, SetInterestDistance, DEFAULT_INTEREST_DISTANCE, AM_DEFAULT);
+}
+
+void InterestGrid::SetCellSize(float size)
+{
+    cellSize_ = Max(size, M_EPSILON);
+    cellsDirty_ = true;
+    MarkNetworkUpdate();
+}
+
+void InterestGrid::SetInterestDistance(float distance)
+{
+    interestDistance_ = Max(distance, 0.0f);
+    MarkNetworkUpdate();
+}
+
+IntVector2 InterestGrid::GetCell(const Vector3& position) const
+{
+    return IntVector2(FloorToInt(position.x_ / cellSize_), FloorToInt(position.z_ / cellSize_));
+}
+
+IntRect InterestGrid::GetInterestCells(const Vector3& position) const
+{
+    IntVector2 cell = GetCell(position);
+    int radius = CeilToInt(interestDistance_ / cellSize_);
+    return IntRect(cell.x_ - radius, cell.y_ - radius, cell.x_ + radius + 1, cell.y_ + radius + 1);
+}
+
+void InterestGrid::Update()
+{
+    Scene* scene = GetScene();
+    if (!scene || !IsEnabledEffective())
+        return;
+
+    DV_PROFILE(UpdateInterestGrid);
+
+    // World transforms have been updated by Scene::PrepareNetworkUpdate(), so reading the positions is cheap.
+    // Nodes that were not changed or moved keep their cells
+    if (cellsDirty_)
+    {
+        const FlatHashMap<NodeId, Node*>& nodes = scene->GetReplicatedNodes();
+        for (FlatHashMap<NodeId, Node*>::ConstIterator i = nodes.Begin(); i != nodes.End(); ++i)
+            UpdateNode(i->first_, i->second_);
+        cellsDirty_ = false;
+    }
+    else
+    {
+        const Vector<NodeId>& changedNodes = scene->GetNetworkChangedNodes();
+        for (NodeId id : changedNodes)
+        {
+            Node* node = scene->GetNode(id);
+            if (node)
+                UpdateNode(id, node);
+        }
+    }
+}
+
+void InterestGrid::OnSceneSet(Scene* scene)
+{
+    cellsDirty_ = true;
+}
+
+void InterestGrid::OnSetEnabled()
+{
+    cellsDirty_ = true;
+}
+
+void InterestGrid::UpdateNode(NodeId id, Node* node)
+{
+    // Nodes get their network state in their first network update, until then they are not assigned
+    NetworkState* networkState = node->GetNetworkState();
+    if (!networkState)
+        return;
+
+    IntVector2 cell = GetCell(node->GetWorldPosition());
+    if (networkState->hasInterestCell_ && networkState->interestCell_ == cell)
+        return;
+
+    networkState->interestCell_ = cell;
+    networkState->hasInterestCell_ = true;
+
+    // The node may have entered the area of interest of connections which have skipped its changes
+    for (Vector<ReplicationState*>::Iterator i = networkState->replicationStates_.Begin();
+         i != networkState->replicationStates_.End(); ++i)
+    {
+        auto* nodeState = static_cast<NodeReplicationState*>(*i);
+        if (nodeState->markedDirty_)
+        {
+            nodeState->sceneState_->dirtyNodes_.Insert(id);
+            nodeState->sceneState_->irrelevantNodes_.Erase(id);
+        }
+    }
+}
+
+}
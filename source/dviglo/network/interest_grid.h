@@ -0,0 +1,64 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include "../math/rect.h"
+#include "../scene/component.h"
+#include "../scene/node.h"
+
+namespace dviglo
+{
+
+/// %Network interest management by a uniform grid on the XZ plane. Create into the scene on the server.
+/// Connections receive updates only for replicated nodes in the cells near their \ref Connection::SetPosition "position".
+class DV_API InterestGrid : public Component
+{
+    DV_OBJECT(InterestGrid, Component);
+
+public:
+    /// Construct.
+    explicit InterestGrid();
+    /// Destruct.
+    ~InterestGrid() override;
+    /// Register object factory.
+    static void RegisterObject();
+
+    /// Set cell size in world units. Default 50.
+    void SetCellSize(float size);
+    /// Set distance around a connection's position, within which node updates are sent. Rounded up to whole cells. Default 100.
+    void SetInterestDistance(float distance);
+
+    /// Return cell size.
+    float GetCellSize() const { return cellSize_; }
+
+    /// Return interest distance.
+    float GetInterestDistance() const { return interestDistance_; }
+
+    /// Return the cell of a world position.
+    IntVector2 GetCell(const Vector3& position) const;
+    /// Return the cells within the interest distance of a world position. Right and bottom edges are exclusive.
+    IntRect GetInterestCells(const Vector3& position) const;
+
+    /// Assign the replicated nodes changed in the last network update to cells. Nodes that moved to another cell are given back to the connections which skipped their updates. Called by Network after Scene::PrepareNetworkUpdate().
+    void Update();
+
+protected:
+    /// Handle scene being assigned.
+    void OnSceneSet(Scene* scene) override;
+    /// Handle enabled/disabled state change.
+    void OnSetEnabled() override;
+
+private:
+    /// Assign a node to a cell.
+    void UpdateNode(NodeId id, Node* node);
+
+    /// Cell size.
+    float cellSize_;
+    /// Interest distance.
+    float interestDistance_;
+    /// Whether all nodes must be assigned again, because the grid is new, was disabled or the cell size changed.
+    bool cellsDirty_;
+};
+
+}
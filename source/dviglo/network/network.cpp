@@ -5,6 +5,7 @@
 #include "../core/context.h"
 #include "../core/core_events.h"
 #include "../core/profiler.h"
+#include "../core/work_queue.h"
 #include "../engine/engine_events.h"
 #include "../io/file_system.h"
 #include "../input/input_events.h"
@@ -12,6 +13,7 @@
 #include "../io/log.h"
 #include "../io/memory_buffer.h"
 #include "http_request.h"
+#include "interest_grid.h"
 #include "network.h"
 #include "network_events.h"
 #include "network_priority.h"
@@ -194,6 +196,7 @@ Network::Network() :
     updateFps_(DEFAULT_UPDATE_FPS),
     simulatedLatency_(0),
     simulatedPacketLoss_(0.0f),
+    snapshotReplication_(false),
     updateInterval_(1.0f / (float)DEFAULT_UPDATE_FPS),
     updateAcc_(0.0f),
     isServer_(false),
@@ -314,6 +317,7 @@ void Network::NewConnectionEstablished(const SLNet::AddressOrGUID& connection)
     // Create a new client connection corresponding to this MessageConnection
     SharedPtr<Connection> newConnection(new Connection(true, connection, rakPeer_));
     newConnection->ConfigureNetworkSimulator(simulatedLatency_, simulatedPacketLoss_);
+    newConnection->SetSnapshotReplication(snapshotReplication_);
     clientConnections_[connection] = newConnection;
     DV_LOGINFO("Client " + newConnection->ToString() + " connected");
 
@@ -593,6 +597,15 @@ void Network::SetSimulatedPacketLoss(float probability)
     ConfigureNetworkSimulator();
 }
 
+void Network::SetSnapshotReplication(bool enable)
+{
+    snapshotReplication_ = enable;
+
+    for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
+         i != clientConnections_.End(); ++i)
+        i->second_->SetSnapshotReplication(enable);
+}
+
 void Network::RegisterRemoteEvent(StringHash eventType)
 {
     if (blacklistedRemoteEvents_.Find(eventType) != blacklistedRemoteEvents_.End())
@@ -684,6 +697,11 @@ Vector<SharedPtr<Connection>> Network::GetClientConnections() const
     return ret;
 }
 
+bool Network::IsNetworkSimulatorActive() const
+{
+    return (rakPeer_ && rakPeer_->IsNetworkSimulatorActive()) || (rakPeerClient_ && rakPeerClient_->IsNetworkSimulatorActive());
+}
+
 bool Network::IsServerRunning() const
 {
     if (!rakPeer_)
@@ -929,38 +947,7 @@ void Network::PostUpdate(float timeStep)
         updateAcc_ = fmodf(updateAcc_, updateInterval_);
 
         if (IsServerRunning())
-        {
-            // Collect and prepare all networked scenes
-            {
-                DV_PROFILE(PrepareServerUpdate);
-
-                networkScenes_.Clear();
-                for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
-                     i != clientConnections_.End(); ++i)
-                {
-                    Scene* scene = i->second_->GetScene();
-                    if (scene)
-                        networkScenes_.Insert(scene);
-                }
-
-                for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
-                    (*i)->PrepareNetworkUpdate();
-            }
-
-            {
-                DV_PROFILE(SendServerUpdate);
-
-                // Then send server updates for each client connection
-                for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
-                     i != clientConnections_.End(); ++i)
-                {
-                    i->second_->SendServerUpdate();
-                    i->second_->SendRemoteEvents();
-                    i->second_->SendPackages();
-                    i->second_->SendAllBuffers();
-                }
-            }
-        }
+            SendServerUpdates();
 
         if (serverConnection_)
         {
@@ -975,6 +962,57 @@ void Network::PostUpdate(float timeStep)
     }
 }
 
+void Network::SendServerUpdates()
+{
+    // Collect and prepare all networked scenes
+    {
+        DV_PROFILE(PrepareServerUpdate);
+
+        networkScenes_.Clear();
+        for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
+             i != clientConnections_.End(); ++i)
+        {
+            Scene* scene = i->second_->GetScene();
+            if (scene)
+                networkScenes_.Insert(scene);
+        }
+
+        for (HashSet<Scene*>::ConstIterator i = networkScenes_.Begin(); i != networkScenes_.End(); ++i)
+        {
+            (*i)->PrepareNetworkUpdate();
+
+            auto* interestGrid = (*i)->GetComponent<InterestGrid>();
+            if (interestGrid)
+                interestGrid->Update();
+        }
+    }
+
+    {
+        DV_PROFILE(SendServerUpdate);
+
+        updateConnections_.Clear();
+        for (HashMap<SLNet::AddressOrGUID, SharedPtr<Connection>>::Iterator i = clientConnections_.Begin();
+             i != clientConnections_.End(); ++i)
+            updateConnections_.Push(i->second_);
+
+        // Then generate server updates for each client connection. The scenes are only read during this,
+        // and a connection writes only to its own replication states and message buffers
+        DV_WORK_QUEUE.ParallelFor(0, updateConnections_.Size(), 1, [this](i32 begin, i32 end, i32 /*threadIndex*/)
+        {
+            for (i32 i = begin; i < end; ++i)
+                updateConnections_[i]->SendServerUpdate();
+        });
+
+        // Remote events and packages may send events or use resources, so they are handled in the main thread
+        for (Connection* connection : updateConnections_)
+        {
+            connection->SendRemoteEvents();
+            connection->SendPackages();
+            connection->SendAllBuffers();
+        }
+    }
+}
+
 void Network::HandleBeginFrame(StringHash eventType, VariantMap& eventData)
 {
     using namespace BeginFrame;
@@ -1038,6 +1076,7 @@ void Network::ConfigureNetworkSimulator()
 
 void RegisterNetworkLibrary()
 {
+    InterestGrid::RegisterObject();
     NetworkPriority::RegisterObject();
 }
 
@@ -80,6 +80,8 @@ public:
     void SetSimulatedLatency(int ms);
     /// Set simulated packet loss probability between 0.0 - 1.0.
     void SetSimulatedPacketLoss(float probability);
+    /// Set whether attribute changes are replicated to clients as unreliable snapshots, delta compressed against the last snapshot each client acknowledged, instead of reliable delta updates. Creation and removal of nodes and components stay reliable. Default false.
+    void SetSnapshotReplication(bool enable);
     /// Register a remote event as allowed to be received. There is also a fixed blacklist of events that can not be allowed in any case, such as ConsoleCommand.
     void RegisterRemoteEvent(StringHash eventType);
     /// Unregister a remote event as allowed to received.
@@ -103,6 +105,12 @@ public:
     /// Return simulated packet loss probability.
     float GetSimulatedPacketLoss() const { return simulatedPacketLoss_; }
 
+    /// Return whether the simulated latency and packet loss are in effect. SLikeNet applies them only in debug builds.
+    bool IsNetworkSimulatorActive() const;
+
+    /// Return whether attribute changes are replicated to clients as unreliable snapshots.
+    bool GetSnapshotReplication() const { return snapshotReplication_; }
+
     /// Return a client or server connection by RakNet connection address, or null if none exist.
     Connection* GetConnection(const SLNet::AddressOrGUID& connection) const;
     /// Return the connection to the server. Null if not connected.
@@ -121,6 +129,8 @@ public:
     void Update(float timeStep);
     /// Send outgoing messages after frame logic. Called by HandleRenderUpdate.
     void PostUpdate(float timeStep);
+    /// Prepare networked scenes and send server updates to all client connections. The updates are generated in worker threads. Called by PostUpdate.
+    void SendServerUpdates();
 
 private:
     /// Handle begin frame event.
@@ -150,12 +160,16 @@ private:
     HashSet<StringHash> blacklistedRemoteEvents_;
     /// Networked scenes.
     HashSet<Scene*> networkScenes_;
+    /// Client connections being updated by SendServerUpdates.
+    Vector<Connection*> updateConnections_;
     /// Update FPS.
     int updateFps_;
     /// Simulated latency (send delay) in milliseconds.
     int simulatedLatency_;
     /// Simulated packet loss probability between 0.0 - 1.0.
     float simulatedPacketLoss_;
+    /// Snapshot replication flag.
+    bool snapshotReplication_;
     /// Update time interval.
     float updateInterval_;
     /// Update time accumulator.
@@ -49,6 +49,11 @@ static const int MSG_PACKAGEINFO = 0x98;
 /// Packet that includes all the above messages
 static const int MSG_PACKED_MESSAGE = 0x99;
 
+/// Server->client: attribute changes of existing nodes and components since the last snapshot acknowledged by the client. Sent unreliably.
+static const int MSG_SNAPSHOT = 0x9A;
+/// Client->server: acknowledge the latest snapshot applied in full.
+static const int MSG_SNAPSHOTACK = 0x9B;
+
 /// Used to define custom messages, usually of the form MSG_USER + x, where x is an integer value.
 static const int MSG_USER = 0x200;
 
@@ -56,5 +61,7 @@ static const int MSG_USER = 0x200;
 static const unsigned CONTROLS_CONTENT_ID = 1;
 /// Package file fragment size.
 static const unsigned PACKAGE_FRAGMENT_SIZE = 1024;
+/// Number of sent snapshots remembered per connection. Acknowledgements of older snapshots are ignored.
+static const unsigned SNAPSHOT_HISTORY_SIZE = 64;
 
 }
@@ -129,6 +129,7 @@ struct HeightfieldData : public CollisionGeometryData
 class DV_API CollisionShape : public Component
 {
     DV_OBJECT(CollisionShape, Component);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
@@ -763,19 +763,18 @@ void PhysicsWorld::OnSceneSet(Scene* scene)
     if (scene)
     {
         scene_ = GetScene();
-        SubscribeToEvent(scene_, E_SCENESUBSYSTEMUPDATE, DV_HANDLER(PhysicsWorld, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene_, &PhysicsWorld::HandleSceneSubsystemUpdate);
     }
     else
         UnsubscribeFromEvent(E_SCENESUBSYSTEMUPDATE);
 }
 
-void PhysicsWorld::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void PhysicsWorld::HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace SceneSubsystemUpdate;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 #ifdef DV_TRACY_PROFILING
@@ -785,6 +784,11 @@ static const char* STR_STEP_SIMULATION = "StepSimulation";
 
 void PhysicsWorld::PreStep(float timeStep)
 {
+    // Call fixed update of the logic components, unless another physics world is the fixed update source of the scene
+    Scene* scene = GetScene();
+    if (scene && GetFixedUpdateSource() == this)
+        scene->UpdateLogicComponents(LogicComponentEvents::FixedUpdate, timeStep);
+
     // Send pre-step event
     using namespace PhysicsPreStep;
 
@@ -807,6 +811,10 @@ void PhysicsWorld::PostStep(float timeStep)
 
     SendCollisionEvents();
 
+    Scene* scene = GetScene();
+    if (scene && GetFixedUpdateSource() == this)
+        scene->UpdateLogicComponents(LogicComponentEvents::FixedPostUpdate, timeStep);
+
     // Send post-step event
     using namespace PhysicsPostStep;
 
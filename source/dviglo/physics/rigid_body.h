@@ -36,6 +36,7 @@ enum CollisionEventMode
 class DV_API RigidBody : public Component, public btMotionState
 {
     DV_OBJECT(RigidBody, Component);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
@@ -263,6 +263,12 @@ void PhysicsWorld2D::Update(float timeStep)
 {
     DV_PROFILE(UpdatePhysics2D);
 
+    // Call fixed update of the logic components, unless a 3D physics world is the fixed update source of the scene
+    Scene* scene = GetScene();
+    bool fixedUpdateSource = scene && GetFixedUpdateSource() == this;
+    if (fixedUpdateSource)
+        scene->UpdateLogicComponents(LogicComponentEvents::FixedUpdate, timeStep);
+
     using namespace PhysicsPreStep;
 
     VariantMap& eventData = GetEventDataMap();
@@ -311,8 +317,14 @@ void PhysicsWorld2D::Update(float timeStep)
     SendBeginContactEvents();
     SendEndContactEvents();
 
-    using namespace PhysicsPostStep;
-    SendEvent(E_PHYSICSPOSTSTEP, eventData);
+    if (fixedUpdateSource)
+        scene->UpdateLogicComponents(LogicComponentEvents::FixedPostUpdate, timeStep);
+
+    // Contact events and logic components may have reused the event data map
+    VariantMap& postStepData = GetEventDataMap();
+    postStepData[PhysicsPostStep::P_WORLD] = this;
+    postStepData[PhysicsPostStep::P_TIMESTEP] = timeStep;
+    SendEvent(E_PHYSICSPOSTSTEP, postStepData);
 }
 
 void PhysicsWorld2D::DrawDebugGeometry()
@@ -690,18 +702,17 @@ void PhysicsWorld2D::OnSceneSet(Scene* scene)
 {
     // Subscribe to the scene subsystem update, which will trigger the physics simulation step
     if (scene)
-        SubscribeToEvent(scene, E_SCENESUBSYSTEMUPDATE, DV_HANDLER(PhysicsWorld2D, HandleSceneSubsystemUpdate));
+        SubscribeToEvent(scene, &PhysicsWorld2D::HandleSceneSubsystemUpdate);
     else
         UnsubscribeFromEvent(E_SCENESUBSYSTEMUPDATE);
 }
 
-void PhysicsWorld2D::HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData)
+void PhysicsWorld2D::HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace SceneSubsystemUpdate;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void PhysicsWorld2D::SendBeginContactEvents()
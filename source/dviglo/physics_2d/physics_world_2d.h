@@ -17,6 +17,7 @@ namespace dviglo
 class Camera;
 class CollisionShape2D;
 class RigidBody2D;
+struct SceneSubsystemUpdateEventData;
 
 /// 2D Physics raycast hit.
 struct DV_API PhysicsRaycastResult2D
@@ -194,7 +195,7 @@ protected:
     void OnSceneSet(Scene* scene) override;
 
     /// Handle the scene subsystem update event, step simulation here.
-    void HandleSceneSubsystemUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleSceneSubsystemUpdate(const SceneSubsystemUpdateEventData& eventData);
     /// Send begin contact events.
     void SendBeginContactEvents();
     /// Send end contact events.
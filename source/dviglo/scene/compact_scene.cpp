@@ -0,0 +1,725 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../core/context.h"
+#include "../core/profiler.h"
+#include "../io/log.h"
+#include "../io/mapped_file.h"
+#include "../io/memory_buffer.h"
+#include "../io/vector_buffer.h"
+#include "component.h"
+#include "scene.h"
+
+#include <cstring>
+
+#include "../common/debug_new.h"
+
+namespace dviglo
+{
+
+// Compact scene layout. All integers are u32 and all tables are 4-byte aligned, so the tables are used in place.
+// - Header: file ID "USCC", format version, table sizes and offsets.
+// - Types: each node or component class with its row count and attribute columns.
+// - Columns: attribute name, variant type, row size and data offset. Fixed-size values are stored in the column
+//   in Serializer::WriteVariantData() format, other values as offsets into the data block.
+// - Nodes: in depth-first order, so that a parent always precedes its children. The first node is the scene.
+// - Components: grouped by owner node.
+// - Data block: type and attribute names and variable-size values. Equal strings are stored once.
+
+/// Compact scene format version. Increase when the layout changes.
+static constexpr u32 COMPACT_SCENE_VERSION = 1;
+
+/// Null index in the compact scene tables.
+static constexpr u32 COMPACT_NONE = 0xffffffff;
+
+struct CompactSceneHeader
+{
+    char id_[4];
+    u32 version_;
+    u32 numTypes_;
+    u32 numColumns_;
+    u32 numNodes_;
+    u32 numComponents_;
+    u32 typesOffset_;
+    u32 columnsOffset_;
+    u32 nodesOffset_;
+    u32 componentsOffset_;
+    u32 dataOffset_;
+    u32 dataSize_;
+};
+
+struct CompactType
+{
+    u32 name_;
+    u32 numRows_;
+    u32 firstColumn_;
+    u32 numColumns_;
+};
+
+struct CompactColumn
+{
+    u32 name_;
+    u32 type_;
+    u32 rowSize_;
+    u32 offset_;
+};
+
+struct CompactNode
+{
+    u32 id_;
+    u32 parent_;
+    u32 type_;
+    u32 row_;
+    u32 firstComponent_;
+    u32 numComponents_;
+};
+
+struct CompactComponent
+{
+    u32 id_;
+    u32 type_;
+    u32 row_;
+};
+
+/// Return size of a value in Serializer::WriteVariantData() format if it does not depend on the value, otherwise 0.
+static u32 GetFixedValueSize(VariantType type)
+{
+    switch (type)
+    {
+    case VAR_BOOL: return 1;
+    case VAR_INT: return 4;
+    case VAR_FLOAT: return 4;
+    case VAR_INT64: return 8;
+    case VAR_DOUBLE: return 8;
+    case VAR_VECTOR2: return 8;
+    case VAR_INTVECTOR2: return 8;
+    case VAR_VECTOR3: return 12;
+    case VAR_INTVECTOR3: return 12;
+    case VAR_VECTOR4: return 16;
+    case VAR_QUATERNION: return 16;
+    case VAR_COLOR: return 16;
+    case VAR_INTRECT: return 16;
+    case VAR_MATRIX3: return 36;
+    case VAR_MATRIX3X4: return 48;
+    case VAR_MATRIX4: return 64;
+    default: return 0;
+    }
+}
+
+static u32 AlignCompactOffset(u32 offset)
+{
+    return (offset + 3u) & ~3u;
+}
+
+/// Collects scene content into per-class attribute columns.
+class CompactSceneWriter
+{
+public:
+    /// Add a node with its components and children.
+    void AddNode(const Node* node, u32 parent)
+    {
+        u32 index = nodes_.Size();
+        nodes_.Push(CompactNode{node->GetID(), parent, 0, 0, (u32)components_.Size(), 0});
+        AddRow(node, nodes_[index].type_, nodes_[index].row_);
+
+        for (const SharedPtr<Component>& component : node->GetComponents())
+        {
+            if (component->IsTemporary())
+                continue;
+
+            CompactComponent& dest = components_.EmplaceBack(CompactComponent{component->GetID(), 0, 0});
+            AddRow(component, dest.type_, dest.row_);
+            ++nodes_[index].numComponents_;
+        }
+
+        for (const SharedPtr<Node>& child : node->GetChildren())
+        {
+            if (!child->IsTemporary())
+                AddNode(child, index);
+        }
+    }
+
+    /// Write the collected content.
+    bool Write(Serializer& dest) const
+    {
+        u32 numColumns = 0;
+        for (const Type& type : types_)
+            numColumns += type.attributes_.Size();
+
+        CompactSceneHeader header;
+        memcpy(header.id_, "USCC", 4);
+        header.version_ = COMPACT_SCENE_VERSION;
+        header.numTypes_ = types_.Size();
+        header.numColumns_ = numColumns;
+        header.numNodes_ = nodes_.Size();
+        header.numComponents_ = components_.Size();
+        header.typesOffset_ = sizeof(CompactSceneHeader);
+        header.columnsOffset_ = header.typesOffset_ + header.numTypes_ * sizeof(CompactType);
+        header.nodesOffset_ = header.columnsOffset_ + numColumns * sizeof(CompactColumn);
+        header.componentsOffset_ = header.nodesOffset_ + header.numNodes_ * sizeof(CompactNode);
+
+        Vector<CompactType> types;
+        Vector<CompactColumn> columns;
+        u32 offset = header.componentsOffset_ + header.numComponents_ * sizeof(CompactComponent);
+
+        for (const Type& type : types_)
+        {
+            types.Push(CompactType{type.name_, type.numRows_, (u32)columns.Size(), (u32)type.attributes_.Size()});
+
+            for (i32 i = 0; i < type.attributes_.Size(); ++i)
+            {
+                const AttributeInfo* attr = type.attributes_[i];
+                u32 fixedSize = GetFixedValueSize(attr->type_);
+                columns.Push(CompactColumn{type.attributeNames_[i], (u32)attr->type_, fixedSize ? fixedSize : 4u, offset});
+                offset = AlignCompactOffset(offset + type.columns_[i].GetSize());
+            }
+        }
+
+        header.dataOffset_ = offset;
+        header.dataSize_ = data_.GetSize();
+
+        bool success = dest.Write(&header, sizeof header) == sizeof header;
+        success &= WriteTable(dest, types);
+        success &= WriteTable(dest, columns);
+        success &= WriteTable(dest, nodes_);
+        success &= WriteTable(dest, components_);
+
+        static const byte padding[4]{};
+        for (const Type& type : types_)
+        {
+            for (const VectorBuffer& column : type.columns_)
+            {
+                success &= dest.Write(column.GetData(), column.GetSize()) == column.GetSize();
+                i32 paddingSize = AlignCompactOffset(column.GetSize()) - column.GetSize();
+                success &= dest.Write(padding, paddingSize) == paddingSize;
+            }
+        }
+
+        success &= dest.Write(data_.GetData(), data_.GetSize()) == data_.GetSize();
+        return success;
+    }
+
+private:
+    /// Node or component class.
+    struct Type
+    {
+        /// Name offset in the data block.
+        u32 name_;
+        /// Number of objects.
+        u32 numRows_;
+        /// Saved attributes.
+        Vector<const AttributeInfo*> attributes_;
+        /// Attribute name offsets in the data block.
+        Vector<u32> attributeNames_;
+        /// Attribute values.
+        Vector<VectorBuffer> columns_;
+    };
+
+    template <class T>
+    static bool WriteTable(Serializer& dest, const Vector<T>& table)
+    {
+        i32 size = table.Size() * (i32)sizeof(T);
+        return dest.Write(table.Buffer(), size) == size;
+    }
+
+    /// Append the attributes of an object to its class columns.
+    void AddRow(const Serializable* object, u32& typeIndex, u32& row)
+    {
+        typeIndex = GetType(object);
+        Type& type = types_[typeIndex];
+        row = type.numRows_++;
+
+        Variant value;
+        for (i32 i = 0; i < type.attributes_.Size(); ++i)
+        {
+            const AttributeInfo& attr = *type.attributes_[i];
+            object->OnGetAttribute(attr, value);
+            if (value.GetType() != attr.type_)
+                value = Variant(attr.type_, String::EMPTY);
+
+            if (GetFixedValueSize(attr.type_))
+                type.columns_[i].WriteVariantData(value);
+            else
+                type.columns_[i].WriteU32(AddValue(value));
+        }
+    }
+
+    /// Return class index of an object. Attribute lists are compared too, as they can be per-instance.
+    u32 GetType(const Serializable* object)
+    {
+        const Vector<AttributeInfo>* attributes = object->GetAttributes();
+        Pair<StringHash, const void*> key(object->GetType(), attributes);
+        auto it = typeIndices_.Find(key);
+        if (it != typeIndices_.End())
+            return it->second_;
+
+        u32 index = types_.Size();
+        Type& type = types_.EmplaceBack();
+        type.name_ = AddString(object->GetTypeName());
+        type.numRows_ = 0;
+        if (attributes)
+        {
+            for (const AttributeInfo& attr : *attributes)
+            {
+                if (!(attr.mode_ & AM_FILE) || (attr.mode_ & AM_FILEREADONLY) == AM_FILEREADONLY)
+                    continue;
+
+                type.attributes_.Push(&attr);
+                type.attributeNames_.Push(AddString(attr.name_));
+                type.columns_.EmplaceBack();
+            }
+        }
+
+        typeIndices_[key] = index;
+        return index;
+    }
+
+    /// Add a variable-size value to the data block. Return its offset.
+    u32 AddValue(const Variant& value)
+    {
+        if (value.GetType() == VAR_STRING)
+            return AddString(value.GetString());
+
+        u32 offset = data_.GetSize();
+        data_.WriteVariantData(value);
+        return offset;
+    }
+
+    /// Add a string to the data block unless already added. Return its offset.
+    u32 AddString(const String& str)
+    {
+        auto it = strings_.Find(str);
+        if (it != strings_.End())
+            return it->second_;
+
+        u32 offset = data_.GetSize();
+        data_.WriteString(str);
+        strings_[str] = offset;
+        return offset;
+    }
+
+    /// Classes.
+    Vector<Type> types_;
+    /// Class indices by type and attribute list.
+    HashMap<Pair<StringHash, const void*>, u32> typeIndices_;
+    /// Nodes.
+    Vector<CompactNode> nodes_;
+    /// Components.
+    Vector<CompactComponent> components_;
+    /// Offsets of the strings in the data block.
+    HashMap<String, u32> strings_;
+    /// Data block.
+    VectorBuffer data_;
+};
+
+/// Attribute column of a class bound to a runtime attribute.
+struct CompactAttributeBinding
+{
+    /// Runtime attribute.
+    const AttributeInfo* attr_;
+    /// Column values.
+    const byte* values_;
+    /// Size of a value in the column.
+    u32 rowSize_;
+    /// Whether the column contains offsets into the data block.
+    bool indirect_;
+};
+
+/// Class of the compact scene bound to a runtime class.
+struct CompactTypeBinding
+{
+    /// Runtime type.
+    StringHash type_;
+    /// Number of rows.
+    u32 numRows_;
+    /// Columns that have a matching runtime attribute.
+    Vector<CompactAttributeBinding> attributes_;
+    /// Created objects by row. Null if the row is unused or the object could not be created.
+    Vector<Serializable*> objects_;
+    /// Whether the objects allow typed attribute access.
+    bool typedAccess_ = false;
+};
+
+/// Return whether a table of the compact scene lies inside the data.
+static bool IsCompactTableValid(i64 size, u32 offset, u32 count, u32 elementSize)
+{
+    return (offset & 3u) == 0 && (i64)offset + (i64)count * elementSize <= size;
+}
+
+bool Scene::LoadCompact(const String& fileName)
+{
+    DV_PROFILE(LoadSceneCompact);
+
+    StopAsyncLoading();
+
+    MappedFile file;
+    if (!file.Open(fileName))
+        return false;
+
+    DV_LOGINFO("Loading scene from " + fileName);
+
+    if (!LoadCompactInternal(file.GetData(), file.GetSize()))
+        return false;
+
+    hash32 checksum = 0;
+    for (i64 i = 0; i < file.GetSize(); ++i)
+        checksum = SDBMHash(checksum, file.GetData()[i]);
+
+    fileName_ = fileName;
+    checksum_ = checksum;
+    return true;
+}
+
+bool Scene::LoadCompact(const void* data, i64 size)
+{
+    DV_PROFILE(LoadSceneCompact);
+
+    StopAsyncLoading();
+
+    return LoadCompactInternal(static_cast<const byte*>(data), size);
+}
+
+bool Scene::SaveCompact(Serializer& dest) const
+{
+    DV_PROFILE(SaveSceneCompact);
+
+    CompactSceneWriter writer;
+    writer.AddNode(this, COMPACT_NONE);
+    if (!writer.Write(dest))
+    {
+        DV_LOGERROR("Could not save scene, writing to stream failed");
+        return false;
+    }
+
+    FinishSaving(&dest);
+    return true;
+}
+
+bool Scene::LoadCompactInternal(const byte* data, i64 size)
+{
+    // The tables are read in place, so the data must be aligned like the mapped file
+    if (!data || ((uintptr_t)data & 3u) || size < (i64)sizeof(CompactSceneHeader) || size > M_MAX_UNSIGNED)
+    {
+        DV_LOGERROR("Compact scene data is empty or not aligned");
+        return false;
+    }
+
+    const auto* header = reinterpret_cast<const CompactSceneHeader*>(data);
+    if (memcmp(header->id_, "USCC", 4) != 0)
+    {
+        DV_LOGERROR("Not a compact scene file");
+        return false;
+    }
+
+    if (header->version_ != COMPACT_SCENE_VERSION)
+    {
+        DV_LOGERROR("Unsupported compact scene version " + String(header->version_));
+        return false;
+    }
+
+    if (!IsCompactTableValid(size, header->typesOffset_, header->numTypes_, sizeof(CompactType))
+        || !IsCompactTableValid(size, header->columnsOffset_, header->numColumns_, sizeof(CompactColumn))
+        || !IsCompactTableValid(size, header->nodesOffset_, header->numNodes_, sizeof(CompactNode))
+        || !IsCompactTableValid(size, header->componentsOffset_, header->numComponents_, sizeof(CompactComponent))
+        || (i64)header->dataOffset_ + header->dataSize_ > size || !header->numNodes_)
+    {
+        DV_LOGERROR("Compact scene tables are out of range");
+        return false;
+    }
+
+    const auto* types = reinterpret_cast<const CompactType*>(data + header->typesOffset_);
+    const auto* columns = reinterpret_cast<const CompactColumn*>(data + header->columnsOffset_);
+    const auto* nodes = reinterpret_cast<const CompactNode*>(data + header->nodesOffset_);
+    const auto* components = reinterpret_cast<const CompactComponent*>(data + header->componentsOffset_);
+    const byte* dataBlock = data + header->dataOffset_;
+    u32 dataSize = header->dataSize_;
+
+    auto getString = [dataBlock, dataSize](u32 offset) -> String
+    {
+        if (offset >= dataSize)
+            return String::EMPTY;
+        const char* str = reinterpret_cast<const char*>(dataBlock + offset);
+        return String(str, (i32)strnlen(str, dataSize - offset));
+    };
+
+    // Bind the columns to the runtime attributes once per class instead of once per object
+    Vector<CompactTypeBinding> bindings(header->numTypes_);
+    for (u32 i = 0; i < header->numTypes_; ++i)
+    {
+        const CompactType& type = types[i];
+        CompactTypeBinding& binding = bindings[i];
+        binding.type_ = StringHash(getString(type.name_));
+        binding.numRows_ = type.numRows_;
+
+        if ((u64)type.firstColumn_ + type.numColumns_ > header->numColumns_)
+        {
+            DV_LOGERROR("Compact scene columns are out of range");
+            return false;
+        }
+
+        const Vector<AttributeInfo>* attributes = DV_CONTEXT.GetAttributes(binding.type_);
+        if (!attributes)
+            continue;
+
+        for (u32 j = type.firstColumn_; j < type.firstColumn_ + type.numColumns_; ++j)
+        {
+            const CompactColumn& column = columns[j];
+            u32 fixedSize = GetFixedValueSize((VariantType)column.type_);
+            if (column.rowSize_ != (fixedSize ? fixedSize : 4u)
+                || (i64)column.offset_ + (i64)column.rowSize_ * type.numRows_ > size)
+            {
+                DV_LOGERROR("Compact scene column is out of range");
+                return false;
+            }
+
+            // Columns of removed or retyped attributes are skipped
+            String name = getString(column.name_);
+            for (const AttributeInfo& attr : *attributes)
+            {
+                if (attr.type_ == (VariantType)column.type_ && (attr.mode_ & AM_FILE) && attr.name_ == name)
+                {
+                    if (!fixedSize)
+                    {
+                        for (u32 row = 0; row < type.numRows_; ++row)
+                        {
+                            u32 offset;
+                            memcpy(&offset, data + column.offset_ + (size_t)row * column.rowSize_, sizeof offset);
+                            if (offset >= dataSize)
+                            {
+                                DV_LOGERROR("Compact scene column data is out of range");
+                                return false;
+                            }
+                        }
+                    }
+
+                    binding.attributes_.Push(CompactAttributeBinding{&attr, data + column.offset_, column.rowSize_, fixedSize == 0});
+                    break;
+                }
+            }
+        }
+    }
+
+    // Validate the hierarchy and the rows before clearing the scene, so that a corrupt file
+    // leaves the scene as it was instead of half loaded
+    // Every object has one row, so more rows than objects can only come from a corrupt file
+    Vector<u32> firstRows(header->numTypes_);
+    u64 numRows = 0;
+    for (u32 i = 0; i < header->numTypes_; ++i)
+    {
+        firstRows[i] = (u32)numRows;
+        numRows += types[i].numRows_;
+        if (numRows > (u64)header->numNodes_ + header->numComponents_)
+        {
+            DV_LOGERROR("Compact scene rows are out of range");
+            return false;
+        }
+    }
+
+    Vector<bool> usedRows((i32)numRows, false);
+    auto useRow = [&](u32 typeIndex, u32 row) -> bool
+    {
+        if (typeIndex >= header->numTypes_ || row >= types[typeIndex].numRows_)
+            return false;
+
+        bool& used = usedRows[firstRows[typeIndex] + row];
+        if (used)
+            return false;
+
+        used = true;
+        return true;
+    };
+
+    Vector<bool> nodeTypes(header->numTypes_, false);
+    for (u32 i = 0; i < header->numNodes_; ++i)
+    {
+        const CompactNode& node = nodes[i];
+        if (i == 0 && node.parent_ != COMPACT_NONE)
+        {
+            DV_LOGERROR("Compact scene does not start with the scene node");
+            return false;
+        }
+
+        if (i > 0 && node.parent_ >= i)
+        {
+            DV_LOGERROR("Compact scene node order is invalid");
+            return false;
+        }
+
+        if (!useRow(node.type_, node.row_) || bindings[node.type_].type_ != (i == 0 ? GetType() : Node::GetTypeStatic()))
+        {
+            DV_LOGERROR("Compact scene node data is out of range");
+            return false;
+        }
+
+        if ((u64)node.firstComponent_ + node.numComponents_ > header->numComponents_)
+        {
+            DV_LOGERROR("Compact scene components are out of range");
+            return false;
+        }
+
+        nodeTypes[node.type_] = true;
+    }
+
+    // Each component must belong to one node only, which the unique rows also check
+    for (u32 i = 0; i < header->numNodes_; ++i)
+    {
+        const CompactNode& node = nodes[i];
+        for (u32 j = node.firstComponent_; j < node.firstComponent_ + node.numComponents_; ++j)
+        {
+            const CompactComponent& component = components[j];
+            if (component.type_ >= header->numTypes_ || nodeTypes[component.type_] || !useRow(component.type_, component.row_))
+            {
+                DV_LOGERROR("Compact scene component data is out of range");
+                return false;
+            }
+        }
+    }
+
+    // Remember the object of a row, so that the columns can be applied one class at a time
+    auto addRow = [&](Serializable* object, u32 typeIndex, u32 row)
+    {
+        CompactTypeBinding& binding = bindings[typeIndex];
+        if (binding.objects_.Empty())
+        {
+            binding.objects_.Resize(binding.numRows_, nullptr);
+            binding.typedAccess_ = object->HasTypedAttributeAccess();
+        }
+
+        binding.objects_[row] = object;
+    };
+
+    // Apply the columns of a class to all its objects, column by column
+    auto applyColumns = [&](const CompactTypeBinding& binding)
+    {
+        if (binding.objects_.Empty())
+            return;
+
+        for (const CompactAttributeBinding& column : binding.attributes_)
+        {
+            const AttributeInfo& attr = *column.attr_;
+            bool typedAccess = binding.typedAccess_ && attr.accessor_ && attr.accessor_->IsTyped();
+
+            for (u32 row = 0; row < binding.numRows_; ++row)
+            {
+                Serializable* object = binding.objects_[row];
+                if (!object)
+                    continue;
+
+                const byte* value = column.values_ + (size_t)row * column.rowSize_;
+                u32 valueSize = column.rowSize_;
+                if (column.indirect_)
+                {
+                    u32 offset;
+                    memcpy(&offset, value, sizeof offset);
+                    value = dataBlock + offset;
+                    valueSize = dataSize - offset;
+                }
+
+                MemoryBuffer source(value, (i32)valueSize);
+                if (typedAccess)
+                    attr.accessor_->Read(object, source);
+                else
+                    object->OnSetAttribute(attr, source.ReadVariant(attr.type_));
+            }
+        }
+    };
+
+    Clear();
+
+    // Reserve the scene and node containers up front, as the final counts are known
+    i32 numReplicatedNodes = 0;
+    Vector<i32> numChildren(header->numNodes_, 0);
+    for (u32 i = 0; i < header->numNodes_; ++i)
+    {
+        const CompactNode& node = nodes[i];
+        if (IsReplicatedID(node.id_))
+            ++numReplicatedNodes;
+        if (i > 0)
+            ++numChildren[node.parent_];
+    }
+
+    i32 numReplicatedComponents = 0;
+    for (u32 i = 0; i < header->numComponents_; ++i)
+    {
+        if (IsReplicatedID(components[i].id_))
+            ++numReplicatedComponents;
+    }
+
+    replicatedNodes_.Reserve(numReplicatedNodes);
+    localNodes_.Reserve(header->numNodes_ - numReplicatedNodes);
+    replicatedComponents_.Reserve(numReplicatedComponents);
+    localComponents_.Reserve(header->numComponents_ - numReplicatedComponents);
+
+    // Create the whole hierarchy first, then apply the node columns before the components are created,
+    // like the binary format applies the node attributes before loading the components
+    Vector<Node*> createdNodes(header->numNodes_);
+    Vector<Component*> createdComponents(header->numComponents_, nullptr);
+    // The scene is empty, so the objects normally keep their saved IDs and there is nothing to resolve
+    bool idsChanged = false;
+
+    for (u32 i = 0; i < header->numNodes_; ++i)
+    {
+        const CompactNode& compactNode = nodes[i];
+        Node* node;
+
+        if (i == 0)
+            node = this;
+        else
+            node = createdNodes[compactNode.parent_]->CreateChild(compactNode.id_, IsReplicatedID(compactNode.id_) ? REPLICATED : LOCAL);
+
+        createdNodes[i] = node;
+        idsChanged |= node->GetID() != compactNode.id_;
+        node->children_.Reserve(numChildren[i]);
+        addRow(node, compactNode.type_, compactNode.row_);
+    }
+
+    for (u32 i = 0; i < header->numTypes_; ++i)
+    {
+        if (nodeTypes[i])
+            applyColumns(bindings[i]);
+    }
+
+    for (u32 i = 0; i < header->numNodes_; ++i)
+    {
+        const CompactNode& compactNode = nodes[i];
+        Node* node = createdNodes[i];
+        node->components_.Reserve(compactNode.numComponents_);
+
+        for (u32 j = compactNode.firstComponent_; j < compactNode.firstComponent_ + compactNode.numComponents_; ++j)
+        {
+            const CompactComponent& compactComponent = components[j];
+
+            // Do not abort if the component type is unknown, like the binary format
+            Component* component = node->CreateComponent(bindings[compactComponent.type_].type_,
+                IsReplicatedID(compactComponent.id_) ? REPLICATED : LOCAL, compactComponent.id_);
+            if (!component)
+                continue;
+
+            createdComponents[j] = component;
+            idsChanged |= component->GetID() != compactComponent.id_;
+            addRow(component, compactComponent.type_, compactComponent.row_);
+        }
+    }
+
+    for (u32 i = 0; i < header->numTypes_; ++i)
+    {
+        if (!nodeTypes[i])
+            applyColumns(bindings[i]);
+    }
+
+    // Remap the node and component ID attributes only if some saved IDs were taken
+    if (idsChanged)
+    {
+        SceneResolver resolver;
+        for (u32 i = 0; i < header->numNodes_; ++i)
+            resolver.AddNode(nodes[i].id_, createdNodes[i]);
+        for (u32 i = 0; i < header->numComponents_; ++i)
+            resolver.AddComponent(components[i].id_, createdComponents[i]);
+        resolver.Resolve();
+    }
+
+    ApplyAttributes();
+    return true;
+}
+
+}
@@ -150,6 +150,10 @@ void Component::PrepareNetworkUpdate()
         return;
 
     unsigned numAttributes = attributes->Size();
+    DirtyBits changedAttributes;
+    unsigned tick = GetScene() ? GetScene()->GetNetworkUpdateTick() : 0;
+
+    bool typedAccess = HasTypedAttributeAccess();
 
     // Check for attribute changes
     for (unsigned i = 0; i < numAttributes; ++i)
@@ -159,11 +163,19 @@ void Component::PrepareNetworkUpdate()
         if (animationEnabled_ && IsAnimatedNetworkAttribute(attr))
             continue;
 
+        // Typed accessors compare without reading into a variant. Once the current value has been read, it is equal to the previous value until a change is detected
+        if (typedAccess && attr.accessor_ && attr.accessor_->IsTyped() && networkState_->currentValues_[i].GetType() != VAR_NONE
+            && attr.accessor_->Equals(this, networkState_->previousValues_[i]))
+            continue;
+
         OnGetAttribute(attr, networkState_->currentValues_[i]);
 
         if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            networkState_->changeTicks_[i] = tick;
+            networkState_->lastChangeTick_ = tick;
+            changedAttributes.Set(i);
 
             // Mark the attribute dirty in all replication states that are tracking this component
             for (Vector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
@@ -183,6 +195,10 @@ void Component::PrepareNetworkUpdate()
         }
     }
 
+    // Serialize the changes once for all connections that are tracking this component
+    if (changedAttributes.Count() && networkState_->replicationStates_.Size())
+        CacheNetworkUpdate(changedAttributes);
+
     networkUpdate_ = false;
 }
 
@@ -201,7 +217,7 @@ void Component::CleanupConnection(Connection* connection)
 void Component::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.Size() == 1)
-        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, DV_HANDLER(Component, HandleAttributeAnimationUpdate));
+        SubscribeToEvent(GetScene(), &Component::HandleAttributeAnimationUpdate);
 }
 
 void Component::OnAttributeAnimationRemoved()
@@ -255,11 +271,9 @@ void Component::GetComponents(Vector<Component*>& dest, StringHash type) const
         dest.Clear();
 }
 
-void Component::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData)
+void Component::HandleAttributeAnimationUpdate(const AttributeAnimationUpdateEventData& eventData)
 {
-    using namespace AttributeAnimationUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    UpdateAttributeAnimations(eventData.timeStep_);
 }
 
 Component* Component::GetFixedUpdateSource()
@@ -16,6 +16,7 @@ class Node;
 class Scene;
 
 struct ComponentReplicationState;
+struct AttributeAnimationUpdateEventData;
 
 /// Autoremove is used by some components for automatic removal from the scene hierarchy upon completion of an action, for example sound or particle effect.
 enum AutoRemoveMode
@@ -112,7 +113,7 @@ protected:
     /// Set scene node. Called by Node when creating the component.
     void SetNode(Node* node);
     /// Handle scene attribute animation update event.
-    void HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleAttributeAnimationUpdate(const AttributeAnimationUpdateEventData& eventData);
     /// Return a component from the scene root that sends out fixed update events (either PhysicsWorld or PhysicsWorld2D). Return null if neither exists.
     Component* GetFixedUpdateSource();
     /// Perform autoremove. Called by subclasses. Caller should keep a weak pointer to itself to check whether was actually removed, and return immediately without further member operations in that case.
@@ -2,13 +2,8 @@
 // Copyright (c) 2022-2023 the Dviglo project
 // License: MIT
 
-#include "../io/log.h"
-#if defined(DV_BULLET) || defined(DV_BOX2D)
-#include "../physics/physics_events.h"
-#endif
 #include "logic_component.h"
 #include "scene.h"
-#include "scene_events.h"
 
 namespace dviglo
 {
@@ -16,11 +11,19 @@ namespace dviglo
 LogicComponent::LogicComponent() :
     updateEventMask_(LogicComponentEvents::All),
     currentEventMask_(LogicComponentEvents::None),
+    threadSafeEventMask_(LogicComponentEvents::None),
+    updateScene_(nullptr),
+    threadSafeUpdate_(false),
     delayedStartCalled_(false)
 {
+    for (i32& index : updateIndices_)
+        index = NINDEX;
 }
 
-LogicComponent::~LogicComponent() = default;
+LogicComponent::~LogicComponent()
+{
+    RemoveEventSubscription();
+}
 
 void LogicComponent::OnSetEnabled()
 {
@@ -52,6 +55,15 @@ void LogicComponent::SetUpdateEventMask(LogicComponentEvents mask)
     }
 }
 
+void LogicComponent::SetThreadSafeUpdate(bool enable)
+{
+    if (threadSafeUpdate_ != enable)
+    {
+        threadSafeUpdate_ = enable;
+        UpdateEventSubscription();
+    }
+}
+
 void LogicComponent::OnNodeSet(Node* node)
 {
     if (node)
@@ -71,15 +83,7 @@ void LogicComponent::OnSceneSet(Scene* scene)
     if (scene)
         UpdateEventSubscription();
     else
-    {
-        UnsubscribeFromEvent(E_SCENEUPDATE);
-        UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
-#if defined(DV_BULLET) || defined(DV_BOX2D)
-        UnsubscribeFromEvent(E_PHYSICSPRESTEP);
-        UnsubscribeFromEvent(E_PHYSICSPOSTSTEP);
-#endif
-        currentEventMask_ = LogicComponentEvents::None;
-    }
+        RemoveEventSubscription();
 }
 
 void LogicComponent::UpdateEventSubscription()
@@ -88,119 +92,106 @@ void LogicComponent::UpdateEventSubscription()
     if (!scene)
         return;
 
+    // A component may move to another scene without being removed from the previous one first
+    if (updateScene_ && updateScene_ != scene)
+        RemoveEventSubscription();
+
+    updateScene_ = scene;
+
     bool enabled = IsEnabledEffective();
 
-    bool needUpdate = enabled && (!!(updateEventMask_ & LogicComponentEvents::Update) || !delayedStartCalled_);
-    if (needUpdate && !(currentEventMask_ & LogicComponentEvents::Update))
-    {
-        SubscribeToEvent(scene, E_SCENEUPDATE, DV_HANDLER(LogicComponent, HandleSceneUpdate));
-        currentEventMask_ |= LogicComponentEvents::Update;
-    }
-    else if (!needUpdate && !!(currentEventMask_ & LogicComponentEvents::Update))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEUPDATE);
-        currentEventMask_ &= ~LogicComponentEvents::Update;
-    }
+    // Delayed start must happen in the main thread, so the component uses the thread-safe lists only after it
+    bool threadSafe = threadSafeUpdate_ && delayedStartCalled_;
 
-    bool needPostUpdate = enabled && !!(updateEventMask_ & LogicComponentEvents::PostUpdate);
-    if (needPostUpdate && !(currentEventMask_ & LogicComponentEvents::PostUpdate))
+    for (i32 i = 0; i < NUM_LOGIC_COMPONENT_EVENTS; ++i)
     {
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, DV_HANDLER(LogicComponent, HandleScenePostUpdate));
-        currentEventMask_ |= LogicComponentEvents::PostUpdate;
-    }
-    else if (!needPostUpdate && !!(currentEventMask_ & LogicComponentEvents::PostUpdate))
-    {
-        UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
-        currentEventMask_ &= ~LogicComponentEvents::PostUpdate;
-    }
+        LogicComponentEvents event = LogicComponentEvents(1 << i);
 
-#if defined(DV_BULLET) || defined(DV_BOX2D)
-    Component* world = GetFixedUpdateSource();
-    if (!world)
-        return;
+        bool needEvent = enabled && !!(updateEventMask_ & event);
+        // Update event is needed for the delayed start even if the component does not use it
+        if (event == LogicComponentEvents::Update && !delayedStartCalled_)
+            needEvent = enabled;
 
-    bool needFixedUpdate = enabled && !!(updateEventMask_ & LogicComponentEvents::FixedUpdate);
-    if (needFixedUpdate && !(currentEventMask_ & LogicComponentEvents::FixedUpdate))
-    {
-        SubscribeToEvent(world, E_PHYSICSPRESTEP, DV_HANDLER(LogicComponent, HandlePhysicsPreStep));
-        currentEventMask_ |= LogicComponentEvents::FixedUpdate;
-    }
-    else if (!needFixedUpdate && !!(currentEventMask_ & LogicComponentEvents::FixedUpdate))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPRESTEP);
-        currentEventMask_ &= ~LogicComponentEvents::FixedUpdate;
-    }
+        bool hasEvent = !!(currentEventMask_ & event);
 
-    bool needFixedPostUpdate = enabled && !!(updateEventMask_ & LogicComponentEvents::FixedPostUpdate);
-    if (needFixedPostUpdate && !(currentEventMask_ & LogicComponentEvents::FixedPostUpdate))
-    {
-        SubscribeToEvent(world, E_PHYSICSPOSTSTEP, DV_HANDLER(LogicComponent, HandlePhysicsPostStep));
-        currentEventMask_ |= LogicComponentEvents::FixedPostUpdate;
-    }
-    else if (!needFixedPostUpdate && !!(currentEventMask_ & LogicComponentEvents::FixedPostUpdate))
-    {
-        UnsubscribeFromEvent(world, E_PHYSICSPOSTSTEP);
-        currentEventMask_ &= ~LogicComponentEvents::FixedPostUpdate;
+        // Change of the thread-safe flag moves the component to the other list
+        if (hasEvent && (!needEvent || threadSafe != !!(threadSafeEventMask_ & event)))
+        {
+            scene->RemoveLogicComponent(this, event);
+            hasEvent = false;
+        }
+
+        if (needEvent && !hasEvent)
+        {
+            if (threadSafe)
+                threadSafeEventMask_ |= event;
+            else
+                threadSafeEventMask_ &= ~event;
+
+            scene->AddLogicComponent(this, event);
+        }
     }
-#endif
 }
 
-void LogicComponent::HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::RemoveEventSubscription()
 {
-    using namespace SceneUpdate;
+    if (!updateScene_)
+        return;
 
-    // Execute user-defined delayed start function before first update
-    if (!delayedStartCalled_)
+    for (i32 i = 0; i < NUM_LOGIC_COMPONENT_EVENTS; ++i)
     {
-        DelayedStart();
-        delayedStartCalled_ = true;
-
-        // If did not need actual update events, unsubscribe now
-        if (!(updateEventMask_ & LogicComponentEvents::Update))
-        {
-            UnsubscribeFromEvent(GetScene(), E_SCENEUPDATE);
-            currentEventMask_ &= ~LogicComponentEvents::Update;
-            return;
-        }
+        LogicComponentEvents event = LogicComponentEvents(1 << i);
+        if (!!(currentEventMask_ & event))
+            updateScene_->RemoveLogicComponent(this, event);
     }
 
-    // Then execute user-defined update function
-    Update(eventData[P_TIMESTEP].GetFloat());
+    updateScene_ = nullptr;
 }
 
-void LogicComponent::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void LogicComponent::CallUpdate(LogicComponentEvents event, float timeStep)
 {
-    using namespace ScenePostUpdate;
+    switch (event)
+    {
+    case LogicComponentEvents::Update:
+        // Execute user-defined delayed start function before first update
+        if (!delayedStartCalled_)
+        {
+            DelayedStart();
+            delayedStartCalled_ = true;
 
-    // Execute user-defined post-update function
-    PostUpdate(eventData[P_TIMESTEP].GetFloat());
-}
+            // Unsubscribe now if did not need actual update events, or move to the thread-safe lists
+            UpdateEventSubscription();
+            if (!(updateEventMask_ & LogicComponentEvents::Update))
+                return;
+        }
 
-#if defined(DV_BULLET) || defined(DV_BOX2D)
+        // Then execute user-defined update function
+        Update(timeStep);
+        break;
 
-void LogicComponent::HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPreStep;
+    case LogicComponentEvents::PostUpdate:
+        PostUpdate(timeStep);
+        break;
 
-    // Execute user-defined delayed start function before first fixed update if not called yet
-    if (!delayedStartCalled_)
-    {
-        DelayedStart();
-        delayedStartCalled_ = true;
-    }
+    case LogicComponentEvents::FixedUpdate:
+        // Execute user-defined delayed start function before first fixed update if not called yet
+        if (!delayedStartCalled_)
+        {
+            DelayedStart();
+            delayedStartCalled_ = true;
+            UpdateEventSubscription();
+        }
 
-    // Execute user-defined fixed update function
-    FixedUpdate(eventData[P_TIMESTEP].GetFloat());
-}
+        FixedUpdate(timeStep);
+        break;
 
-void LogicComponent::HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData)
-{
-    using namespace PhysicsPostStep;
+    case LogicComponentEvents::FixedPostUpdate:
+        FixedPostUpdate(timeStep);
+        break;
 
-    // Execute user-defined fixed post-update function
-    FixedPostUpdate(eventData[P_TIMESTEP].GetFloat());
+    default:
+        break;
+    }
 }
 
-#endif
-
 }
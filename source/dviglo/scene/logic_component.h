@@ -34,11 +34,16 @@ enum class LogicComponentEvents
 };
 DV_FLAGS(LogicComponentEvents);
 
-/// Helper base class for user-defined game logic components that hooks up to update events and forwards them to virtual functions similar to ScriptInstance class.
+/// Number of update events a logic component can use.
+inline constexpr i32 NUM_LOGIC_COMPONENT_EVENTS = 4;
+
+/// Helper base class for user-defined game logic components. The scene keeps lists of logic components by update event and calls their virtual functions directly, without sending events to each component.
 class DV_API LogicComponent : public Component
 {
     DV_OBJECT(LogicComponent, Component);
 
+    friend class Scene;
+
 public:
     /// Construct.
     explicit LogicComponent();
@@ -69,9 +74,15 @@ public:
     /// Set what update events should be subscribed to. Use this for optimization: by default all are in use. Note that this is not an attribute and is not saved or network-serialized, therefore it should always be called eg. in the subclass constructor.
     void SetUpdateEventMask(LogicComponentEvents mask);
 
+    /// Set whether the update functions can be called in worker threads, in parallel with the other thread-safe logic components. The update functions of such a component may only modify the component itself and the transform of its own node. DelayedStart() is always called in the main thread. Like the update event mask, this is not an attribute.
+    void SetThreadSafeUpdate(bool enable);
+
     /// Return what update events are subscribed to.
     LogicComponentEvents GetUpdateEventMask() const { return updateEventMask_; }
 
+    /// Return whether the update functions can be called in worker threads.
+    bool IsThreadSafeUpdate() const { return threadSafeUpdate_; }
+
     /// Return whether the DelayedStart() function has been called.
     bool IsDelayedStartCalled() const { return delayedStartCalled_; }
 
@@ -82,22 +93,25 @@ protected:
     void OnSceneSet(Scene* scene) override;
 
 private:
-    /// Subscribe/unsubscribe to update events based on current enabled state and update event mask.
+    /// Add to/remove from the scene's update lists based on current enabled state and update event mask.
     void UpdateEventSubscription();
-    /// Handle scene update event.
-    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData);
-    /// Handle scene post-update event.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
-#if defined(DV_BULLET) || defined(DV_BOX2D)
-    /// Handle physics pre-step event.
-    void HandlePhysicsPreStep(StringHash eventType, VariantMap& eventData);
-    /// Handle physics post-step event.
-    void HandlePhysicsPostStep(StringHash eventType, VariantMap& eventData);
-#endif
+    /// Remove from all update lists of the scene.
+    void RemoveEventSubscription();
+    /// Call the update function for an event. Called by Scene.
+    void CallUpdate(LogicComponentEvents event, float timeStep);
+
     /// Requested event subscription mask.
     LogicComponentEvents updateEventMask_;
     /// Current event subscription mask.
     LogicComponentEvents currentEventMask_;
+    /// Events for which the component is in the thread-safe update lists.
+    LogicComponentEvents threadSafeEventMask_;
+    /// Indices in the scene's update lists by event.
+    i32 updateIndices_[NUM_LOGIC_COMPONENT_EVENTS];
+    /// Scene whose update lists the component is in.
+    Scene* updateScene_;
+    /// Thread-safe update flag.
+    bool threadSafeUpdate_;
     /// Flag for delayed start.
     bool delayedStartCalled_;
 };
@@ -35,7 +35,8 @@ Node::Node() :
     position_(Vector3::ZERO),
     rotation_(Quaternion::IDENTITY),
     scale_(Vector3::ONE),
-    worldRotation_(Quaternion::IDENTITY)
+    worldRotation_(Quaternion::IDENTITY),
+    transformIndex_(NINDEX)
 {
     impl_ = make_unique<NodeImpl>();
     impl_->owner_ = nullptr;
@@ -64,8 +65,8 @@ void Node::RegisterObject()
     DV_ATTRIBUTE("Variables", vars_, Variant::emptyVariantMap, AM_FILE); // Network replication of vars uses custom data
     DV_ACCESSOR_ATTRIBUTE("Network Position", GetNetPositionAttr, SetNetPositionAttr, Vector3::ZERO,
         AM_NET | AM_LATESTDATA | AM_NOEDIT);
-    DV_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, Variant::emptyBuffer,
-        AM_NET | AM_LATESTDATA | AM_NOEDIT);
+    DV_ACCESSOR_ATTRIBUTE("Network Rotation", GetNetRotationAttr, SetNetRotationAttr, Quaternion::IDENTITY,
+        AM_NET | AM_LATESTDATA | AM_NOEDIT).SetQuantization(AttributeQuantization::SmallestThree(15));
     DV_ACCESSOR_ATTRIBUTE("Network Parent Node", GetNetParentAttr, SetNetParentAttr, Variant::emptyBuffer,
         AM_NET | AM_NOEDIT);
 }
@@ -713,6 +714,10 @@ void Node::SetOwner(Connection* owner)
 
 void Node::MarkDirty()
 {
+    // With the scene-level transform update the subtree is a contiguous range, so it can be marked without recursion
+    if (scene_ && scene_->MarkTransformsDirty(this))
+        return;
+
     Node *cur = this;
     for (;;)
     {
@@ -728,21 +733,7 @@ void Node::MarkDirty()
         cur->dirty_ = true;
 
         // Notify listener components first, then mark child nodes
-        for (Vector<WeakPtr<Component>>::Iterator i = cur->listeners_.Begin(); i != cur->listeners_.End();)
-        {
-            Component *c = *i;
-            if (c)
-            {
-                c->OnMarkedDirty(cur);
-                ++i;
-            }
-            // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
-            else
-            {
-                *i = cur->listeners_.Back();
-                cur->listeners_.Pop();
-            }
-        }
+        cur->NotifyListenersDirty();
 
         // Tail call optimization: Don't recurse to mark the first child dirty, but
         // instead process it in the context of the current function. If there are more
@@ -760,6 +751,25 @@ void Node::MarkDirty()
     }
 }
 
+void Node::NotifyListenersDirty()
+{
+    for (Vector<WeakPtr<Component>>::Iterator i = listeners_.Begin(); i != listeners_.End();)
+    {
+        Component *c = *i;
+        if (c)
+        {
+            c->OnMarkedDirty(this);
+            ++i;
+        }
+        // If listener has expired, erase from list (swap with the last element to avoid O(n^2) behavior)
+        else
+        {
+            *i = listeners_.Back();
+            listeners_.Pop();
+        }
+    }
+}
+
 Node* Node::CreateChild(const String& name, CreateMode mode, NodeId id, bool temporary)
 {
     Node* newNode = CreateChild(id, mode, temporary);
@@ -810,10 +820,13 @@ void Node::AddChild(Node* node, i32 index)
         }
     }
 
-    // Add to the child vector, then add to the scene if not added yet
+    // Add to the child vector, then add to the scene if not added yet. Reparenting within the scene changes the node order
+    // of the scene-level transform update
     children_.Insert(index, nodeShared);
     if (scene_ && node->GetScene() != scene_)
         scene_->NodeAdded(node);
+    else if (scene_)
+        scene_->MarkTransformOrderDirty();
 
     node->parent_ = this;
     node->MarkDirty();
@@ -1445,14 +1458,13 @@ void Node::SetNetPositionAttr(const Vector3& value)
         SetPosition(value);
 }
 
-void Node::SetNetRotationAttr(const Vector<byte>& value)
+void Node::SetNetRotationAttr(const Quaternion& value)
 {
-    MemoryBuffer buf(value);
     auto* transform = GetComponent<SmoothedTransform>();
     if (transform)
-        transform->SetTargetRotation(buf.ReadPackedQuaternion());
+        transform->SetTargetRotation(value);
     else
-        SetRotation(buf.ReadPackedQuaternion());
+        SetRotation(value);
 }
 
 void Node::SetNetParentAttr(const Vector<byte>& value)
@@ -1497,11 +1509,9 @@ const Vector3& Node::GetNetPositionAttr() const
     return position_;
 }
 
-const Vector<byte>& Node::GetNetRotationAttr() const
+const Quaternion& Node::GetNetRotationAttr() const
 {
-    impl_->attrBuffer_.Clear();
-    impl_->attrBuffer_.WritePackedQuaternion(rotation_);
-    return impl_->attrBuffer_.GetBuffer();
+    return rotation_;
 }
 
 const Vector<byte>& Node::GetNetParentAttr() const
@@ -1694,6 +1704,10 @@ void Node::PrepareNetworkUpdate()
 
     const Vector<AttributeInfo>* attributes = networkState_->attributes_;
     i32 numAttributes = attributes->Size();
+    DirtyBits changedAttributes;
+    unsigned tick = scene_ ? scene_->GetNetworkUpdateTick() : 0;
+
+    bool typedAccess = HasTypedAttributeAccess();
 
     // Check for attribute changes
     for (i32 i = 0; i < numAttributes; ++i)
@@ -1703,11 +1717,19 @@ void Node::PrepareNetworkUpdate()
         if (animationEnabled_ && IsAnimatedNetworkAttribute(attr))
             continue;
 
+        // Typed accessors compare without reading into a variant. Once the current value has been read, it is equal to the previous value until a change is detected
+        if (typedAccess && attr.accessor_ && attr.accessor_->IsTyped() && networkState_->currentValues_[i].GetType() != VAR_NONE
+            && attr.accessor_->Equals(this, networkState_->previousValues_[i]))
+            continue;
+
         OnGetAttribute(attr, networkState_->currentValues_[i]);
 
         if (networkState_->currentValues_[i] != networkState_->previousValues_[i])
         {
             networkState_->previousValues_[i] = networkState_->currentValues_[i];
+            networkState_->changeTicks_[i] = tick;
+            networkState_->lastChangeTick_ = tick;
+            changedAttributes.Set(i);
 
             // Mark the attribute dirty in all replication states that are tracking this node
             for (Vector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
@@ -1727,6 +1749,7 @@ void Node::PrepareNetworkUpdate()
     }
 
     // Finally check for user var changes
+    bool varsChanged = false;
     for (VariantMap::ConstIterator i = vars_.Begin(); i != vars_.End(); ++i)
     {
         VariantMap::ConstIterator j = networkState_->previousVars_.Find(i->first_);
@@ -1734,6 +1757,13 @@ void Node::PrepareNetworkUpdate()
         {
             networkState_->previousVars_[i->first_] = i->second_;
 
+            if (!varsChanged)
+            {
+                networkState_->deltaVars_.Clear();
+                varsChanged = true;
+            }
+            networkState_->deltaVars_.Insert(i->first_);
+
             // Mark the var dirty in all replication states that are tracking this node
             for (Vector<ReplicationState*>::Iterator j = networkState_->replicationStates_.Begin();
                  j != networkState_->replicationStates_.End(); ++j)
@@ -1750,6 +1780,23 @@ void Node::PrepareNetworkUpdate()
         }
     }
 
+    // Serialize the changes once for all connections that are tracking this node
+    if ((changedAttributes.Count() || varsChanged) && networkState_->replicationStates_.Size())
+    {
+        if (!varsChanged)
+            networkState_->deltaVars_.Clear();
+
+        CacheNetworkUpdate(changedAttributes);
+
+        VectorBuffer& delta = networkState_->deltaUpdate_;
+        delta.WriteVLE(networkState_->deltaVars_.Size());
+        for (HashSet<StringHash>::ConstIterator i = networkState_->deltaVars_.Begin(); i != networkState_->deltaVars_.End(); ++i)
+        {
+            delta.WriteStringHash(*i);
+            delta.WriteVariant(vars_[*i]);
+        }
+    }
+
     networkUpdate_ = false;
 }
 
@@ -1884,7 +1931,7 @@ void Node::SetTransformSilent(const Vector3& position, const Quaternion& rotatio
 void Node::OnAttributeAnimationAdded()
 {
     if (attributeAnimationInfos_.Size() == 1)
-        SubscribeToEvent(GetScene(), E_ATTRIBUTEANIMATIONUPDATE, DV_HANDLER(Node, HandleAttributeAnimationUpdate));
+        SubscribeToEvent(GetScene(), &Node::HandleAttributeAnimationUpdate);
 }
 
 void Node::OnAttributeAnimationRemoved()
@@ -2241,11 +2288,9 @@ void Node::RemoveComponent(Vector<SharedPtr<Component>>::Iterator i)
     components_.Erase(i);
 }
 
-void Node::HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData)
+void Node::HandleAttributeAnimationUpdate(const AttributeAnimationUpdateEventData& eventData)
 {
-    using namespace AttributeAnimationUpdate;
-
-    UpdateAttributeAnimations(eventData[P_TIMESTEP].GetFloat());
+    UpdateAttributeAnimations(eventData.timeStep_);
 }
 
 }
@@ -22,6 +22,7 @@ class Scene;
 class SceneResolver;
 
 struct NodeReplicationState;
+struct AttributeAnimationUpdateEventData;
 
 /// Component and child node creation mode for networking.
 enum CreateMode
@@ -62,8 +63,10 @@ struct DV_API NodeImpl
 class DV_API Node : public Animatable
 {
     DV_OBJECT(Node, Animatable);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
     friend class Connection;
+    friend class Scene;
 
 public:
     /// Construct.
@@ -577,13 +580,13 @@ public:
     /// Set network position attribute.
     void SetNetPositionAttr(const Vector3& value);
     /// Set network rotation attribute.
-    void SetNetRotationAttr(const Vector<byte>& value);
+    void SetNetRotationAttr(const Quaternion& value);
     /// Set network parent attribute.
     void SetNetParentAttr(const Vector<byte>& value);
     /// Return network position attribute.
     const Vector3& GetNetPositionAttr() const;
     /// Return network rotation attribute.
-    const Vector<byte>& GetNetRotationAttr() const;
+    const Quaternion& GetNetRotationAttr() const;
     /// Return network parent attribute.
     const Vector<byte>& GetNetParentAttr() const;
     /// Load components and optionally load child nodes.
@@ -642,6 +645,8 @@ private:
     Component* SafeCreateComponent(const String& typeName, StringHash type, CreateMode mode, ComponentId id);
     /// Recalculate the world transform.
     void UpdateWorldTransform() const;
+    /// Notify listener components that the node has been marked dirty. Erase expired listeners.
+    void NotifyListenersDirty();
     /// Remove child node by iterator.
     void RemoveChild(Vector<SharedPtr<Node>>::Iterator i);
     /// Return child nodes recursively.
@@ -657,7 +662,7 @@ private:
     /// Remove a component from this node with the specified iterator.
     void RemoveComponent(Vector<SharedPtr<Component>>::Iterator i);
     /// Handle attribute animation update event.
-    void HandleAttributeAnimationUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleAttributeAnimationUpdate(const AttributeAnimationUpdateEventData& eventData);
 
     /// World-space transform matrix.
     mutable Matrix3x4 worldTransform_;
@@ -693,6 +698,8 @@ private:
     Vector<SharedPtr<Node>> children_;
     /// Node listeners.
     Vector<WeakPtr<Component>> listeners_;
+    /// Index in the node order of the scene-level transform update, or NINDEX if not assigned.
+    i32 transformIndex_;
 
     /// Pointer to implementation.
     std::unique_ptr<NodeImpl> impl_;
@@ -8,7 +8,9 @@
 #include "../containers/hash_map.h"
 #include "../containers/hash_set.h"
 #include "../containers/ptr.h"
+#include "../io/vector_buffer.h"
 #include "../math/string_hash.h"
+#include "../math/vector2.h"
 
 #include <cstring>
 
@@ -93,6 +95,15 @@ struct DV_API DirtyBits
     /// Return number of set bits.
     unsigned Count() const { return count_; }
 
+    /// Test for equality with another dirty bits structure.
+    bool operator ==(const DirtyBits& rhs) const
+    {
+        return count_ == rhs.count_ && !memcmp(data_, rhs.data_, MAX_NETWORK_ATTRIBUTES / 8);
+    }
+
+    /// Test for inequality with another dirty bits structure.
+    bool operator !=(const DirtyBits& rhs) const { return !(*this == rhs); }
+
     /// Bit data.
     unsigned char data_[MAX_NETWORK_ATTRIBUTES / 8]{};
     /// Number of set bits.
@@ -112,8 +123,24 @@ struct DV_API NetworkState
     Vector<ReplicationState*> replicationStates_;
     /// Previous user variables.
     VariantMap previousVars_;
+    /// Scene network update tick of the last change of each attribute. Used on the server only.
+    Vector<unsigned> changeTicks_;
+    /// Scene network update tick of the last attribute change. Used on the server only.
+    unsigned lastChangeTick_{};
     /// Bitmask for intercepting network messages. Used on the client only.
     unsigned long long interceptMask_{};
+    /// Attributes changed in the last network update, excluding latest data attributes.
+    DirtyBits deltaBits_;
+    /// User variables changed in the last network update. Used by nodes only.
+    HashSet<StringHash> deltaVars_;
+    /// Delta update of deltaBits_ and deltaVars_ without the timestamp. Serialized once and shared by all connections.
+    VectorBuffer deltaUpdate_;
+    /// Latest data update without the timestamp. Serialized once and shared by all connections.
+    VectorBuffer latestDataUpdate_;
+    /// Interest management grid cell of a node. Used on the server only.
+    IntVector2 interestCell_;
+    /// Whether the node has been assigned to an interest management grid cell.
+    bool hasInterestCell_{};
 };
 
 /// Base class for per-user network replication states.
@@ -132,6 +159,8 @@ struct DV_API ComponentReplicationState : public ReplicationState
     WeakPtr<Component> component_;
     /// Dirty attribute bits.
     DirtyBits dirtyAttributes_;
+    /// Scene network update tick, up to which the client is known to have the attributes. Used in snapshot replication.
+    unsigned ackedTick_{};
 };
 
 /// Per-user node network replication state.
@@ -147,6 +176,8 @@ struct DV_API NodeReplicationState : public ReplicationState
     HashSet<StringHash> dirtyVars_;
     /// Components by ID.
     HashMap<unsigned, ComponentReplicationState> componentStates_;
+    /// Scene network update tick, up to which the client is known to have the attributes. Used in snapshot replication.
+    unsigned ackedTick_{};
     /// Interest management priority accumulator.
     float priorityAcc_{};
     /// Whether exists in the SceneState's dirty set.
@@ -160,11 +191,14 @@ struct DV_API SceneReplicationState : public ReplicationState
     HashMap<unsigned, NodeReplicationState> nodeStates_;
     /// Dirty node IDs.
     HashSet<unsigned> dirtyNodes_;
+    /// Dirty node IDs outside the connection's area of interest. Their updates are skipped until they become interesting again.
+    HashSet<unsigned> irrelevantNodes_;
 
     void Clear()
     {
         nodeStates_.Clear();
         dirtyNodes_.Clear();
+        irrelevantNodes_.Clear();
     }
 };
 
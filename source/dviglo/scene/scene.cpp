@@ -8,6 +8,7 @@
 #include "../core/work_queue.h"
 #include "../io/file.h"
 #include "../io/log.h"
+#include "../io/memory_buffer.h"
 #include "../io/package_file.h"
 #include "../resource/resource_cache.h"
 #include "../resource/resource_events.h"
@@ -23,6 +24,9 @@
 #include "unknown_component.h"
 #include "value_animation.h"
 
+#include <cstring>
+#include <thread>
+
 #include "../common/debug_new.h"
 
 namespace dviglo
@@ -34,6 +38,10 @@ const char* SUBSYSTEM_CATEGORY = "Subsystem";
 
 static const float DEFAULT_SMOOTHING_CONSTANT = 50.0f;
 static const float DEFAULT_SNAP_THRESHOLD = 5.0f;
+/// Maximum number of nodes in a task of the scene-level transform update.
+static const i32 TRANSFORM_TASK_NODES = 256;
+/// Approximate size in bytes of the root-level nodes deserialized by one work item during asynchronous loading.
+static const i64 STAGED_BATCH_SIZE = 64 * 1024;
 
 Scene::Scene() :
     replicatedNodeID_(FIRST_REPLICATED_ID),
@@ -41,6 +49,7 @@ Scene::Scene() :
     localNodeID_(FIRST_LOCAL_ID),
     localComponentID_(FIRST_LOCAL_ID),
     checksum_(0),
+    networkUpdateTick_(0),
     asyncLoadingMs_(5),
     timeScale_(1.0f),
     elapsedTime_(0),
@@ -48,27 +57,31 @@ Scene::Scene() :
     snapThreshold_(DEFAULT_SNAP_THRESHOLD),
     updateEnabled_(true),
     asyncLoading_(false),
-    threadedUpdate_(false)
+    threadedUpdate_(false),
+    transformUpdateEnabled_(false)
 {
     // Assign an ID to self so that nodes can refer to this node as a parent
     SetID(GetFreeNodeID(REPLICATED));
     NodeAdded(this);
 
-    SubscribeToEvent(E_UPDATE, DV_HANDLER(Scene, HandleUpdate));
+    SubscribeToEvent(&Scene::HandleUpdate);
     SubscribeToEvent(E_RESOURCEBACKGROUNDLOADED, DV_HANDLER(Scene, HandleResourceBackgroundLoaded));
 }
 
 Scene::~Scene()
 {
+    // Worker threads may still be deserializing into the asynchronous loading progress
+    StopStagedLoading();
+
     // Remove root-level components first, so that scene subsystems such as the octree destroy themselves. This will speed up
     // the removal of child nodes' components
     RemoveAllComponents();
     RemoveAllChildren();
 
     // Remove scene reference and owner from all nodes that still exist
-    for (HashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->ResetScene();
-    for (HashMap<NodeId, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
+    for (FlatHashMap<NodeId, Node*>::Iterator i = localNodes_.Begin(); i != localNodes_.End(); ++i)
         i->second_->ResetScene();
 }
 
@@ -189,7 +202,7 @@ void Scene::AddReplicationState(NodeReplicationState* state)
     Node::AddReplicationState(state);
 
     // This is the first update for a new connection. Mark all replicated nodes dirty
-    for (HashMap<NodeId, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<NodeId, Node*>::ConstIterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         state->sceneState_->dirtyNodes_.Insert(i->first_);
 }
 
@@ -285,6 +298,249 @@ bool Scene::SaveJSON(Serializer& dest, const String& indentation) const
         return false;
 }
 
+/// Read the file attribute values of a node or component. Return false if the data ends prematurely.
+static bool ReadStagedValues(Deserializer& source, const Vector<AttributeInfo>* attributes, Vector<Variant>& values)
+{
+    if (!attributes)
+        return true;
+
+    for (const AttributeInfo& attr : *attributes)
+    {
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        if (source.IsEof())
+            return false;
+
+        values.Push(source.ReadVariant(attr.type_));
+    }
+
+    return true;
+}
+
+/// Skip a null-terminated string in binary scene data. Return false if the data ends prematurely.
+static bool SkipStagedString(MemoryBuffer& source)
+{
+    i64 position = source.GetPosition();
+    const void* end = memchr(source.GetData() + position, 0, (size_t)(source.GetSize() - position));
+    if (!end)
+        return false;
+
+    source.Seek(static_cast<const byte*>(end) - source.GetData() + 1);
+    return true;
+}
+
+/// Skip a value in Serializer::WriteVariantData() format without constructing it. Return false if the data ends prematurely.
+static bool SkipStagedValue(MemoryBuffer& source, VariantType type)
+{
+    i64 size = 0;
+
+    switch (type)
+    {
+    case VAR_BOOL: size = 1; break;
+    case VAR_INT: case VAR_FLOAT: case VAR_VOIDPTR: case VAR_PTR: case VAR_CUSTOM_HEAP: case VAR_CUSTOM_STACK: size = 4; break;
+    case VAR_INT64: case VAR_DOUBLE: case VAR_VECTOR2: case VAR_INTVECTOR2: size = 8; break;
+    case VAR_VECTOR3: case VAR_INTVECTOR3: size = 12; break;
+    case VAR_VECTOR4: case VAR_QUATERNION: case VAR_COLOR: case VAR_INTRECT: size = 16; break;
+    case VAR_MATRIX3: size = 36; break;
+    case VAR_MATRIX3X4: size = 48; break;
+    case VAR_MATRIX4: size = 64; break;
+
+    case VAR_STRING:
+        return SkipStagedString(source);
+
+    case VAR_BUFFER:
+        size = source.ReadVLE();
+        break;
+
+    case VAR_RESOURCEREF:
+        source.ReadStringHash();
+        return SkipStagedString(source);
+
+    case VAR_RESOURCEREFLIST:
+        source.ReadStringHash();
+        [[fallthrough]];
+
+    case VAR_STRINGVECTOR:
+        for (u32 i = source.ReadVLE(); i > 0; --i)
+        {
+            if (!SkipStagedString(source))
+                return false;
+        }
+        return true;
+
+    case VAR_VARIANTVECTOR:
+        for (u32 i = source.ReadVLE(); i > 0; --i)
+        {
+            if (source.IsEof() || !SkipStagedValue(source, (VariantType)source.ReadU8()))
+                return false;
+        }
+        return true;
+
+    case VAR_VARIANTMAP:
+        for (u32 i = source.ReadVLE(); i > 0; --i)
+        {
+            source.ReadStringHash();
+            if (source.IsEof() || !SkipStagedValue(source, (VariantType)source.ReadU8()))
+                return false;
+        }
+        return true;
+
+    default:
+        break;
+    }
+
+    if (source.GetPosition() + size > source.GetSize())
+        return false;
+
+    source.Seek(source.GetPosition() + size);
+    return true;
+}
+
+/// Skip a node with its components and children in binary scene data and count them. Return false if the data is invalid.
+static bool SkipStagedNode(MemoryBuffer& source, const Vector<AttributeInfo>* nodeAttributes, AsyncProgress& progress)
+{
+    // Node attributes have no size prefix, so they must be skipped one by one
+    NodeId nodeID = source.ReadU32();
+    if (nodeAttributes)
+    {
+        for (const AttributeInfo& attr : *nodeAttributes)
+        {
+            if ((attr.mode_ & AM_FILE) && (source.IsEof() || !SkipStagedValue(source, attr.type_)))
+                return false;
+        }
+    }
+
+    if (Scene::IsReplicatedID(nodeID))
+        ++progress.numReplicatedNodes_;
+    else
+        ++progress.numLocalNodes_;
+
+    i32 numComponents = source.ReadVLE();
+    for (i32 i = 0; i < numComponents; ++i)
+    {
+        i64 size = source.ReadVLE();
+        if (source.GetPosition() + size > source.GetSize())
+            return false;
+
+        // The component data starts with the type and the ID
+        MemoryBuffer compBuffer(source.GetData() + source.GetPosition(), (i32)size);
+        source.Seek(source.GetPosition() + size);
+        compBuffer.ReadStringHash();
+        if (Scene::IsReplicatedID(compBuffer.ReadU32()))
+            ++progress.numReplicatedComponents_;
+        else
+            ++progress.numLocalComponents_;
+    }
+
+    i32 numChildren = source.ReadVLE();
+    for (i32 i = 0; i < numChildren; ++i)
+    {
+        if (!SkipStagedNode(source, nodeAttributes, progress))
+            return false;
+    }
+
+    return true;
+}
+
+/// Deserialize a node with its components and children into a batch. Return false if the data is invalid.
+static bool StageNode(MemoryBuffer& source, const Vector<AttributeInfo>* nodeAttributes, i32 parent, StagedNodeBatch& batch)
+{
+    // Children are appended to the same vector, so refer to the node by index
+    i32 index = batch.nodes_.Size();
+    batch.nodes_.EmplaceBack();
+    batch.nodes_[index].id_ = source.ReadU32();
+    batch.nodes_[index].parent_ = parent;
+    if (!ReadStagedValues(source, nodeAttributes, batch.nodes_[index].values_))
+        return false;
+
+    i32 numComponents = source.ReadVLE();
+    batch.nodes_[index].firstComponent_ = batch.components_.Size();
+    batch.nodes_[index].numComponents_ = numComponents;
+    for (i32 i = 0; i < numComponents; ++i)
+    {
+        i64 size = source.ReadVLE();
+        i64 end = source.GetPosition() + size;
+        if (end > source.GetSize())
+            return false;
+
+        MemoryBuffer compBuffer(source.GetData() + source.GetPosition(), (i32)size);
+        source.Seek(end);
+
+        StagedComponent& component = batch.components_.EmplaceBack();
+        component.type_ = compBuffer.ReadStringHash();
+        component.id_ = compBuffer.ReadU32();
+
+        // Component types without attributes, such as unknown components, load themselves from the raw data.
+        // A component that fails to load is skipped, like in the synchronous loading
+        const Vector<AttributeInfo>* attributes = DV_CONTEXT.GetAttributes(component.type_);
+        component.hasValues_ = attributes != nullptr;
+        if (attributes)
+            ReadStagedValues(compBuffer, attributes, component.values_);
+        else
+        {
+            component.data_.Resize(compBuffer.GetSize() - compBuffer.GetPosition());
+            compBuffer.Read(component.data_.Buffer(), component.data_.Size());
+        }
+    }
+
+    i32 numChildren = source.ReadVLE();
+    for (i32 i = 0; i < numChildren; ++i)
+    {
+        if (!StageNode(source, nodeAttributes, index, batch))
+            return false;
+    }
+
+    return true;
+}
+
+/// Work function that reads the binary data of the root-level nodes and finds where each of them starts.
+static void SplitStagedDataWork(const WorkItem* item, i32 /*threadIndex*/)
+{
+    auto* progress = static_cast<AsyncProgress*>(item->aux_);
+    File* file = progress->file_;
+
+    // The file is not accessed by the main thread until the loading finishes
+    progress->data_.Resize((i32)(file->GetSize() - file->GetPosition()));
+    progress->data_.Resize(file->Read(progress->data_.Buffer(), progress->data_.Size()));
+
+    // Calculate the checksum here too, so that finishing the loading does not read the whole file in the main thread
+    file->GetChecksum();
+
+    MemoryBuffer source(progress->data_);
+    const Vector<AttributeInfo>* nodeAttributes = DV_CONTEXT.GetAttributes(Node::GetTypeStatic());
+    i64 end = 0;
+
+    for (i32 i = 0; i < progress->totalNodes_; ++i)
+    {
+        if (!SkipStagedNode(source, nodeAttributes, *progress))
+            break;
+
+        progress->nodeOffsets_.Push(end);
+        end = source.GetPosition();
+    }
+
+    progress->nodeOffsets_.Push(end);
+}
+
+/// Work function that deserializes a batch of root-level nodes.
+static void StageNodesWork(const WorkItem* item, i32 /*threadIndex*/)
+{
+    auto* progress = static_cast<AsyncProgress*>(item->aux_);
+    auto* batch = static_cast<StagedNodeBatch*>(item->start_);
+
+    MemoryBuffer source(progress->data_.Buffer() + batch->start_, (i32)(batch->end_ - batch->start_));
+    const Vector<AttributeInfo>* nodeAttributes = DV_CONTEXT.GetAttributes(Node::GetTypeStatic());
+
+    for (i32 i = 0; i < batch->numRootNodes_; ++i)
+    {
+        if (!StageNode(source, nodeAttributes, -1, *batch))
+            return;
+    }
+
+    batch->success_ = true;
+}
+
 bool Scene::LoadAsync(File* file, LoadMode mode)
 {
     if (!file)
@@ -336,6 +592,7 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
         // Store own old ID for resolving possible root node references
         NodeId nodeID = file->ReadU32();
         resolver_.AddNode(nodeID, this);
+        asyncProgress_.resolveIDs_ = nodeID != GetID();
 
         // Load root level components first
         if (!Node::Load(*file, resolver_, false))
@@ -346,6 +603,16 @@ bool Scene::LoadAsync(File* file, LoadMode mode)
 
         // Then prepare to load child nodes in the async updates
         asyncProgress_.totalNodes_ = file->ReadVLE();
+
+        // With worker threads, the child nodes are deserialized there and the async updates only attach them to the scene
+        if (DV_WORK_QUEUE.GetNumThreads() && asyncProgress_.totalNodes_)
+        {
+            asyncProgress_.staged_ = true;
+            asyncProgress_.splitItem_ = new WorkItem();
+            asyncProgress_.splitItem_->workFunction_ = SplitStagedDataWork;
+            asyncProgress_.splitItem_->aux_ = &asyncProgress_;
+            DV_WORK_QUEUE.AddWorkItem(asyncProgress_.splitItem_);
+        }
     }
     else
     {
@@ -494,6 +761,7 @@ bool Scene::LoadAsyncJSON(File* file, LoadMode mode)
 
 void Scene::StopAsyncLoading()
 {
+    StopStagedLoading();
     asyncLoading_ = false;
     asyncProgress_.file_.Reset();
     asyncProgress_.xmlFile_.Reset();
@@ -501,6 +769,8 @@ void Scene::StopAsyncLoading()
     asyncProgress_.xmlElement_ = XMLElement::EMPTY;
     asyncProgress_.jsonIndex_ = 0;
     asyncProgress_.resources_.Clear();
+    asyncProgress_.resolveIDs_ = false;
+    asyncProgress_.applyIndex_ = -1;
     resolver_.Reset();
 }
 
@@ -648,6 +918,17 @@ void Scene::SetAsyncLoadingMs(int ms)
     asyncLoadingMs_ = Max(ms, 1);
 }
 
+void Scene::SetTransformUpdateEnabled(bool enable)
+{
+    if (enable == transformUpdateEnabled_)
+        return;
+
+    transformUpdateEnabled_ = enable;
+
+    // Free the arrays when disabled. When enabled, the node order is built on the next update
+    transforms_ = TransformHierarchy();
+}
+
 void Scene::SetElapsedTime(float time)
 {
     elapsedTime_ = time;
@@ -686,12 +967,12 @@ Node* Scene::GetNode(NodeId id) const
 {
     if (IsReplicatedID(id))
     {
-        HashMap<NodeId, Node*>::ConstIterator i = replicatedNodes_.Find(id);
+        FlatHashMap<NodeId, Node*>::ConstIterator i = replicatedNodes_.Find(id);
         return i != replicatedNodes_.End() ? i->second_ : nullptr;
     }
     else
     {
-        HashMap<NodeId, Node*>::ConstIterator i = localNodes_.Find(id);
+        FlatHashMap<NodeId, Node*>::ConstIterator i = localNodes_.Find(id);
         return i != localNodes_.End() ? i->second_ : nullptr;
     }
 }
@@ -713,12 +994,12 @@ Component* Scene::GetComponent(ComponentId id) const
 {
     if (IsReplicatedID(id))
     {
-        HashMap<ComponentId, Component*>::ConstIterator i = replicatedComponents_.Find(id);
+        FlatHashMap<ComponentId, Component*>::ConstIterator i = replicatedComponents_.Find(id);
         return i != replicatedComponents_.End() ? i->second_ : nullptr;
     }
     else
     {
-        HashMap<ComponentId, Component*>::ConstIterator i = localComponents_.Find(id);
+        FlatHashMap<ComponentId, Component*>::ConstIterator i = localComponents_.Find(id);
         return i != localComponents_.End() ? i->second_ : nullptr;
     }
 }
@@ -750,20 +1031,25 @@ void Scene::Update(float timeStep)
 
     timeStep *= timeScale_;
 
-    using namespace SceneUpdate;
-
-    VariantMap& eventData = GetEventDataMap();
-    eventData[P_SCENE] = this;
-    eventData[P_TIMESTEP] = timeStep;
-
     // Update variable timestep logic
-    SendEvent(E_SCENEUPDATE, eventData);
+    UpdateLogicComponents(LogicComponentEvents::Update, timeStep);
+
+    SceneUpdateEventData updateData;
+    updateData.scene_ = this;
+    updateData.timeStep_ = timeStep;
+    SendEvent(updateData);
 
     // Update scene attribute animation.
-    SendEvent(E_ATTRIBUTEANIMATIONUPDATE, eventData);
+    AttributeAnimationUpdateEventData animationData;
+    animationData.scene_ = this;
+    animationData.timeStep_ = timeStep;
+    SendEvent(animationData);
 
     // Update scene subsystems. If a physics world is present, it will be updated, triggering fixed timestep logic updates
-    SendEvent(E_SCENESUBSYSTEMUPDATE, eventData);
+    SceneSubsystemUpdateEventData subsystemData;
+    subsystemData.scene_ = this;
+    subsystemData.timeStep_ = timeStep;
+    SendEvent(subsystemData);
 
     // Update transform smoothing
     {
@@ -780,7 +1066,12 @@ void Scene::Update(float timeStep)
     }
 
     // Post-update variable timestep logic
-    SendEvent(E_SCENEPOSTUPDATE, eventData);
+    UpdateLogicComponents(LogicComponentEvents::PostUpdate, timeStep);
+
+    ScenePostUpdateEventData postUpdateData;
+    postUpdateData.scene_ = this;
+    postUpdateData.timeStep_ = timeStep;
+    SendEvent(postUpdateData);
 
     // Note: using a float for elapsed time accumulation is inherently inaccurate. The purpose of this value is
     // primarily to update material animation effects, as it is available to shaders. It can be reset by calling
@@ -818,6 +1109,137 @@ void Scene::DelayedMarkedDirty(Component* component)
     delayedDirtyComponents_.Push(component);
 }
 
+void Scene::UpdateLogicComponents(LogicComponentEvents event, float timeStep)
+{
+    i32 eventIndex = LogBaseTwo((u32)event);
+    LogicComponentList& list = logicComponents_[eventIndex];
+    list.updating_ = true;
+
+    // Thread-safe components first. Components that finish their delayed start in the main thread move to the thread-safe
+    // list and must not be updated twice
+    if (!list.threadSafeComponents_.Empty())
+    {
+        BeginThreadedUpdate();
+
+        DV_WORK_QUEUE.ParallelFor(0, list.threadSafeComponents_.Size(), 64,
+            [&list, event, timeStep](i32 begin, i32 end, i32 /*threadIndex*/)
+        {
+            LogicComponent** components = list.threadSafeComponents_.Buffer();
+            for (i32 i = begin; i < end; ++i)
+            {
+                if (components[i])
+                    components[i]->CallUpdate(event, timeStep);
+            }
+        });
+
+        EndThreadedUpdate();
+    }
+
+    // Components can be added during the update, so the size is not cached
+    for (i32 i = 0; i < list.components_.Size(); ++i)
+    {
+        LogicComponent* component = list.components_[i];
+        if (component)
+            component->CallUpdate(event, timeStep);
+    }
+
+    list.updating_ = false;
+    if (list.numRemoved_)
+        CompactLogicComponents(eventIndex);
+}
+
+void Scene::AddLogicComponent(LogicComponent* component, LogicComponentEvents event)
+{
+    i32 eventIndex = LogBaseTwo((u32)event);
+    LogicComponentList& list = logicComponents_[eventIndex];
+
+    // Without updates the removed components would never be compacted
+    if (!list.updating_ && list.numRemoved_ > (list.components_.Size() + list.threadSafeComponents_.Size()) / 2)
+        CompactLogicComponents(eventIndex);
+
+    Vector<LogicComponent*>& components = !!(component->threadSafeEventMask_ & event) ? list.threadSafeComponents_ :
+        list.components_;
+
+    component->updateIndices_[eventIndex] = components.Size();
+    component->currentEventMask_ |= event;
+    components.Push(component);
+}
+
+void Scene::RemoveLogicComponent(LogicComponent* component, LogicComponentEvents event)
+{
+    i32 eventIndex = LogBaseTwo((u32)event);
+    LogicComponentList& list = logicComponents_[eventIndex];
+    Vector<LogicComponent*>& components = !!(component->threadSafeEventMask_ & event) ? list.threadSafeComponents_ :
+        list.components_;
+
+    i32 index = component->updateIndices_[eventIndex];
+    assert(index >= 0 && index < components.Size() && components[index] == component);
+
+    components[index] = nullptr;
+    component->updateIndices_[eventIndex] = NINDEX;
+    component->currentEventMask_ &= ~event;
+    ++list.numRemoved_;
+}
+
+i32 Scene::GetNumLogicComponents(LogicComponentEvents event) const
+{
+    const LogicComponentList& list = logicComponents_[LogBaseTwo((u32)event)];
+    return list.components_.Size() + list.threadSafeComponents_.Size() - list.numRemoved_;
+}
+
+void Scene::UpdateTransforms()
+{
+    if (!transformUpdateEnabled_)
+        return;
+
+    DV_PROFILE(UpdateTransforms);
+
+    if (transforms_.orderDirty_)
+        RebuildTransformOrder();
+
+    // Nodes above the task subtrees are few. Update them first, as the tasks read their world transforms
+    for (i32 index : transforms_.spine_)
+        UpdateTransformRange(index, index + 1);
+
+    DV_WORK_QUEUE.ParallelFor(0, transforms_.tasks_.Size(), 1, [this](i32 begin, i32 end, i32 /*threadIndex*/)
+    {
+        for (i32 i = begin; i < end; ++i)
+        {
+            i32 root = transforms_.tasks_[i];
+            UpdateTransformRange(root, transforms_.subtreeEnds_[root]);
+        }
+    });
+}
+
+bool Scene::MarkTransformsDirty(Node* node)
+{
+    TransformHierarchy& t = transforms_;
+    if (!transformUpdateEnabled_ || t.orderDirty_)
+        return false;
+
+    i32 index = node->transformIndex_;
+    if (index < 0 || index >= t.nodes_.Size() || t.nodes_[index] != node)
+        return false;
+
+    // A node that is already dirty has a dirty subtree, so the walk skips its subtree
+    for (i32 i = index, end = t.subtreeEnds_[index]; i < end;)
+    {
+        Node* current = t.nodes_[i];
+        if (current->dirty_)
+        {
+            i = t.subtreeEnds_[i];
+            continue;
+        }
+
+        current->dirty_ = true;
+        t.dirty_[i] = 1;
+        current->NotifyListenersDirty();
+        ++i;
+    }
+
+    return true;
+}
+
 NodeId Scene::GetFreeNodeID(CreateMode mode)
 {
     if (mode == REPLICATED)
@@ -893,6 +1315,7 @@ void Scene::NodeAdded(Node* node)
         oldScene->NodeRemoved(node);
 
     node->SetScene(this);
+    MarkTransformOrderDirty();
 
     // If the new node has an ID of zero (default), assign a replicated ID now
     NodeId id = node->GetID();
@@ -905,7 +1328,7 @@ void Scene::NodeAdded(Node* node)
     // If node with same ID exists, remove the scene reference from it and overwrite with the new node
     if (IsReplicatedID(id))
     {
-        HashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Find(id);
+        FlatHashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Find(id);
         if (i != replicatedNodes_.End() && i->second_ != node)
         {
             DV_LOGWARNING("Overwriting node with ID " + String(id));
@@ -919,7 +1342,7 @@ void Scene::NodeAdded(Node* node)
     }
     else
     {
-        HashMap<NodeId, Node*>::Iterator i = localNodes_.Find(id);
+        FlatHashMap<NodeId, Node*>::Iterator i = localNodes_.Find(id);
         if (i != localNodes_.End() && i->second_ != node)
         {
             DV_LOGWARNING("Overwriting node with ID " + String(id));
@@ -970,6 +1393,7 @@ void Scene::NodeRemoved(Node* node)
         localNodes_.Erase(id);
 
     node->ResetScene();
+    MarkTransformOrderDirty();
 
     // Remove node from tag cache
     if (!node->GetTags().Empty())
@@ -1004,7 +1428,7 @@ void Scene::ComponentAdded(Component* component)
 
     if (IsReplicatedID(id))
     {
-        HashMap<ComponentId, Component*>::Iterator i = replicatedComponents_.Find(id);
+        FlatHashMap<ComponentId, Component*>::Iterator i = replicatedComponents_.Find(id);
         if (i != replicatedComponents_.End() && i->second_ != component)
         {
             DV_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1015,7 +1439,7 @@ void Scene::ComponentAdded(Component* component)
     }
     else
     {
-        HashMap<ComponentId, Component*>::Iterator i = localComponents_.Find(id);
+        FlatHashMap<ComponentId, Component*>::Iterator i = localComponents_.Find(id);
         if (i != localComponents_.End() && i->second_ != component)
         {
             DV_LOGWARNING("Overwriting component with ID " + String(id));
@@ -1025,6 +1449,7 @@ void Scene::ComponentAdded(Component* component)
         localComponents_[id] = component;
     }
 
+    ++hierarchyVersion_;
     component->OnSceneSet(this);
 }
 
@@ -1033,6 +1458,8 @@ void Scene::ComponentRemoved(Component* component)
     if (!component)
         return;
 
+    ++hierarchyVersion_;
+
     ComponentId id = component->GetID();
     if (Scene::IsReplicatedID(id))
         replicatedComponents_.Erase(id);
@@ -1069,11 +1496,17 @@ String Scene::GetVarNamesAttr() const
 
 void Scene::PrepareNetworkUpdate()
 {
+    ++networkUpdateTick_;
+    networkChangedNodes_.Clear();
+
     for (HashSet<NodeId>::Iterator i = networkUpdateNodes_.Begin(); i != networkUpdateNodes_.End(); ++i)
     {
         Node* node = GetNode(*i);
         if (node)
+        {
             node->PrepareNetworkUpdate();
+            networkChangedNodes_.Push(*i);
+        }
     }
 
     for (HashSet<ComponentId>::Iterator i = networkUpdateComponents_.Begin(); i != networkUpdateComponents_.End(); ++i)
@@ -1085,16 +1518,26 @@ void Scene::PrepareNetworkUpdate()
 
     networkUpdateNodes_.Clear();
     networkUpdateComponents_.Clear();
+
+    // Connections read world positions in worker threads, so update the lazily cached transforms now
+    for (FlatHashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    {
+        if (i->second_->IsDirty())
+        {
+            i->second_->GetWorldTransform();
+            networkChangedNodes_.Push(i->first_);
+        }
+    }
 }
 
 void Scene::CleanupConnection(Connection* connection)
 {
     Node::CleanupConnection(connection);
 
-    for (HashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
+    for (FlatHashMap<NodeId, Node*>::Iterator i = replicatedNodes_.Begin(); i != replicatedNodes_.End(); ++i)
         i->second_->CleanupConnection(connection);
 
-    for (HashMap<ComponentId, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
+    for (FlatHashMap<ComponentId, Component*>::Iterator i = replicatedComponents_.Begin(); i != replicatedComponents_.End(); ++i)
         i->second_->CleanupConnection(connection);
 }
 
@@ -1140,13 +1583,12 @@ void Scene::MarkReplicationDirty(Node* node)
     }
 }
 
-void Scene::HandleUpdate(StringHash eventType, VariantMap& eventData)
+void Scene::HandleUpdate(const UpdateEventData& eventData)
 {
     if (!updateEnabled_)
         return;
 
-    using namespace Update;
-    Update(eventData[P_TIMESTEP].GetFloat());
+    Update(eventData.timeStep_);
 }
 
 void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData)
@@ -1164,58 +1606,200 @@ void Scene::HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eve
     }
 }
 
+void Scene::CompactLogicComponents(i32 eventIndex)
+{
+    LogicComponentList& list = logicComponents_[eventIndex];
+
+    // Keep the order of the components, so that the update order does not depend on removals
+    for (Vector<LogicComponent*>* components : {&list.components_, &list.threadSafeComponents_})
+    {
+        i32 size = 0;
+        for (i32 i = 0; i < components->Size(); ++i)
+        {
+            LogicComponent* component = (*components)[i];
+            if (component)
+            {
+                component->updateIndices_[eventIndex] = size;
+                (*components)[size++] = component;
+            }
+        }
+
+        components->Resize(size);
+    }
+
+    list.numRemoved_ = 0;
+}
+
+void Scene::RebuildTransformOrder()
+{
+    DV_PROFILE(RebuildTransformOrder);
+
+    TransformHierarchy& t = transforms_;
+    t.nodes_.Clear();
+    t.parents_.Clear();
+    t.worldTransforms_.Clear();
+    t.worldRotations_.Clear();
+    t.dirty_.Clear();
+    t.spine_.Clear();
+    t.tasks_.Clear();
+
+    // Depth-first traversal with an explicit stack, as hierarchies can be deep. Children are pushed in reverse order to keep
+    // the child order
+    Vector<Pair<Node*, i32>> stack;
+    const Vector<SharedPtr<Node>>& children = GetChildren();
+    for (i32 i = children.Size() - 1; i >= 0; --i)
+        stack.Push(MakePair(children[i].Get(), NINDEX));
+
+    while (!stack.Empty())
+    {
+        Pair<Node*, i32> entry = stack.Back();
+        stack.Pop();
+
+        Node* node = entry.first_;
+        i32 index = t.nodes_.Size();
+        node->transformIndex_ = index;
+        t.nodes_.Push(node);
+        t.parents_.Push(entry.second_);
+        t.worldTransforms_.Push(node->worldTransform_);
+        t.worldRotations_.Push(node->worldRotation_);
+        t.dirty_.Push(node->dirty_ ? 1 : 0);
+
+        for (i32 i = node->children_.Size() - 1; i >= 0; --i)
+            stack.Push(MakePair(node->children_[i].Get(), index));
+    }
+
+    // Children follow their parent, so the subtree ends can be accumulated backwards
+    i32 numNodes = t.nodes_.Size();
+    t.subtreeEnds_.Resize(numNodes);
+    for (i32 i = 0; i < numNodes; ++i)
+        t.subtreeEnds_[i] = i + 1;
+    for (i32 i = numNodes - 1; i >= 0; --i)
+    {
+        i32 parent = t.parents_[i];
+        if (parent >= 0)
+            t.subtreeEnds_[parent] = Max(t.subtreeEnds_[parent], t.subtreeEnds_[i]);
+    }
+
+    // Split into tasks of whole subtrees. The nodes with too large subtrees form the spine, whose parents are also on the spine
+    for (i32 i = 0; i < numNodes;)
+    {
+        if (t.subtreeEnds_[i] - i <= TRANSFORM_TASK_NODES)
+        {
+            t.tasks_.Push(i);
+            i = t.subtreeEnds_[i];
+        }
+        else
+            t.spine_.Push(i++);
+    }
+
+    t.orderDirty_ = false;
+}
+
+void Scene::UpdateTransformRange(i32 begin, i32 end)
+{
+    TransformHierarchy& t = transforms_;
+    u8* dirty = t.dirty_.Buffer();
+    Matrix3x4* worldTransforms = t.worldTransforms_.Buffer();
+    Quaternion* worldRotations = t.worldRotations_.Buffer();
+
+    for (i32 i = begin; i < end; ++i)
+    {
+        if (!dirty[i])
+            continue;
+
+        // Same as Node::UpdateWorldTransform(), but the parent's world transform is read from the array
+        Node* node = t.nodes_[i];
+        i32 parent = t.parents_[i];
+        if (parent < 0)
+        {
+            worldTransforms[i] = node->GetTransform();
+            worldRotations[i] = node->rotation_;
+        }
+        else
+        {
+            worldTransforms[i] = worldTransforms[parent] * node->GetTransform();
+            worldRotations[i] = worldRotations[parent] * node->rotation_;
+        }
+
+        node->worldTransform_ = worldTransforms[i];
+        node->worldRotation_ = worldRotations[i];
+        node->dirty_ = false;
+        dirty[i] = 0;
+    }
+}
+
 void Scene::UpdateAsyncLoading()
 {
     DV_PROFILE(UpdateAsyncLoading);
 
+    // Worker threads can deserialize the nodes while the resources are loading
+    if (asyncProgress_.splitItem_ && asyncProgress_.splitItem_->completed_)
+        StartStagedBatches();
+
     // If resources left to load, do not load nodes yet
     if (asyncProgress_.loadedResources_ < asyncProgress_.totalResources_)
         return;
 
     HiresTimer asyncLoadTimer;
 
-    for (;;)
+    // Nodes deserialized in worker threads only need to be attached to the scene
+    if (asyncProgress_.staged_)
     {
-        if (asyncProgress_.loadedNodes_ >= asyncProgress_.totalNodes_)
+        if (AttachStagedNodes(asyncLoadTimer) && ApplyAsyncAttributes(asyncLoadTimer))
         {
             FinishAsyncLoading();
             return;
         }
+    }
+    else
+    {
+        for (;;)
+        {
+            if (asyncProgress_.loadedNodes_ >= asyncProgress_.totalNodes_)
+            {
+                if (ApplyAsyncAttributes(asyncLoadTimer))
+                {
+                    FinishAsyncLoading();
+                    return;
+                }
+                break;
+            }
 
 
-        // Read one child node with its full sub-hierarchy either from binary, JSON, or XML
-        /// \todo Works poorly in scenes where one root-level child node contains all content
-        if (asyncProgress_.xmlFile_)
-        {
-            NodeId nodeID = asyncProgress_.xmlElement_.GetU32("id");
-            Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->LoadXML(asyncProgress_.xmlElement_, resolver_);
-            asyncProgress_.xmlElement_ = asyncProgress_.xmlElement_.GetNext("node");
-        }
-        else if (asyncProgress_.jsonFile_) // Load from JSON
-        {
-            const JSONValue& childValue = asyncProgress_.jsonFile_->GetRoot().Get("children").GetArray().At(asyncProgress_.jsonIndex_);
+            // Read one child node with its full sub-hierarchy either from binary, JSON, or XML
+            /// \todo Works poorly in scenes where one root-level child node contains all content
+            if (asyncProgress_.xmlFile_)
+            {
+                NodeId nodeID = asyncProgress_.xmlElement_.GetU32("id");
+                Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
+                resolver_.AddNode(nodeID, newNode);
+                newNode->LoadXML(asyncProgress_.xmlElement_, resolver_);
+                asyncProgress_.xmlElement_ = asyncProgress_.xmlElement_.GetNext("node");
+            }
+            else if (asyncProgress_.jsonFile_) // Load from JSON
+            {
+                const JSONValue& childValue = asyncProgress_.jsonFile_->GetRoot().Get("children").GetArray().At(asyncProgress_.jsonIndex_);
 
-            NodeId nodeID = childValue.Get("id").GetU32();
-            Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->LoadJSON(childValue, resolver_);
-            ++asyncProgress_.jsonIndex_;
-        }
-        else // Load from binary
-        {
-            NodeId nodeID = asyncProgress_.file_->ReadU32();
-            Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
-            resolver_.AddNode(nodeID, newNode);
-            newNode->Load(*asyncProgress_.file_, resolver_);
-        }
+                NodeId nodeID = childValue.Get("id").GetU32();
+                Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
+                resolver_.AddNode(nodeID, newNode);
+                newNode->LoadJSON(childValue, resolver_);
+                ++asyncProgress_.jsonIndex_;
+            }
+            else // Load from binary
+            {
+                NodeId nodeID = asyncProgress_.file_->ReadU32();
+                Node* newNode = CreateChild(nodeID, IsReplicatedID(nodeID) ? REPLICATED : LOCAL);
+                resolver_.AddNode(nodeID, newNode);
+                newNode->Load(*asyncProgress_.file_, resolver_);
+            }
 
-        ++asyncProgress_.loadedNodes_;
+            ++asyncProgress_.loadedNodes_;
 
-        // Break if time limit exceeded, so that we keep sufficient FPS
-        if (asyncLoadTimer.GetUSec(false) >= asyncLoadingMs_ * 1000LL)
-            break;
+            // Break if time limit exceeded, so that we keep sufficient FPS
+            if (asyncLoadTimer.GetUSec(false) >= asyncLoadingMs_ * 1000LL)
+                break;
+        }
     }
 
     using namespace AsyncLoadProgress;
@@ -1232,12 +1816,9 @@ void Scene::UpdateAsyncLoading()
 
 void Scene::FinishAsyncLoading()
 {
+    // The ID attributes were resolved and the attributes applied in the async updates
     if (asyncProgress_.mode_ > LOAD_RESOURCES_ONLY)
-    {
-        resolver_.Resolve();
-        ApplyAttributes();
         FinishLoading(asyncProgress_.file_);
-    }
 
     StopAsyncLoading();
 
@@ -1248,6 +1829,209 @@ void Scene::FinishAsyncLoading()
     SendEvent(E_ASYNCLOADFINISHED, eventData);
 }
 
+void Scene::StartStagedBatches()
+{
+    DV_PROFILE(StartStagedBatches);
+
+    AsyncProgress& progress = asyncProgress_;
+    progress.splitItem_.Reset();
+
+    // The last offset is the end of the valid data
+    i32 numNodes = progress.nodeOffsets_.Size() - 1;
+    if (numNodes < progress.totalNodes_)
+    {
+        DV_LOGERROR("Could not load all nodes from " + progress.file_->GetName() + ", data is invalid");
+        progress.totalNodes_ = numNodes;
+    }
+
+    // Reserve the scene containers for all nodes and components at once
+    replicatedNodes_.Reserve(replicatedNodes_.Size() + progress.numReplicatedNodes_);
+    localNodes_.Reserve(localNodes_.Size() + progress.numLocalNodes_);
+    replicatedComponents_.Reserve(replicatedComponents_.Size() + progress.numReplicatedComponents_);
+    localComponents_.Reserve(localComponents_.Size() + progress.numLocalComponents_);
+
+    // Group the root-level nodes so that the work items are large enough to outweigh the scheduling overhead
+    for (i32 first = 0; first < numNodes;)
+    {
+        i32 last = first + 1;
+        while (last < numNodes && progress.nodeOffsets_[last] - progress.nodeOffsets_[first] < STAGED_BATCH_SIZE)
+            ++last;
+
+        StagedNodeBatch& batch = progress.batches_.EmplaceBack();
+        batch.start_ = progress.nodeOffsets_[first];
+        batch.end_ = progress.nodeOffsets_[last];
+        batch.numRootNodes_ = last - first;
+        first = last;
+    }
+
+    // The batches vector is not resized anymore, so the work items can point to its elements
+    for (StagedNodeBatch& batch : progress.batches_)
+    {
+        batch.workItem_ = new WorkItem();
+        batch.workItem_->workFunction_ = StageNodesWork;
+        batch.workItem_->start_ = &batch;
+        batch.workItem_->aux_ = &progress;
+        DV_WORK_QUEUE.AddWorkItem(batch.workItem_);
+    }
+}
+
+bool Scene::AttachStagedNodes(HiresTimer& timer)
+{
+    AsyncProgress& progress = asyncProgress_;
+    if (progress.splitItem_)
+        return false;
+
+    while (progress.batchIndex_ < progress.batches_.Size())
+    {
+        StagedNodeBatch& batch = progress.batches_[progress.batchIndex_];
+        if (!batch.workItem_->completed_)
+            return false;
+
+        if (batch.createdNodes_.Empty())
+            batch.createdNodes_.Resize(batch.nodes_.Size());
+
+        while (progress.nodeIndex_ < batch.nodes_.Size())
+        {
+            const StagedNode& staged = batch.nodes_[progress.nodeIndex_];
+            Node* parent = staged.parent_ < 0 ? this : batch.createdNodes_[staged.parent_];
+            Node* newNode = parent->CreateChild(staged.id_, IsReplicatedID(staged.id_) ? REPLICATED : LOCAL);
+            batch.createdNodes_[progress.nodeIndex_] = newNode;
+
+            // The scene was cleared, so the nodes normally keep their saved IDs and there is nothing to resolve
+            if (!progress.resolveIDs_ && newNode->GetID() != staged.id_)
+                StartResolvingStagedIDs();
+            if (progress.resolveIDs_)
+                resolver_.AddNode(staged.id_, newNode);
+
+            newNode->LoadValues(staged.values_);
+
+            for (i32 i = staged.firstComponent_; i < staged.firstComponent_ + staged.numComponents_ && i < batch.components_.Size(); ++i)
+            {
+                const StagedComponent& component = batch.components_[i];
+                Component* newComponent = newNode->SafeCreateComponent(String::EMPTY, component.type_,
+                    IsReplicatedID(component.id_) ? REPLICATED : LOCAL, component.id_);
+                if (!newComponent)
+                    continue;
+
+                if (!progress.resolveIDs_ && newComponent->GetID() != component.id_)
+                    StartResolvingStagedIDs();
+                if (progress.resolveIDs_)
+                    resolver_.AddComponent(component.id_, newComponent);
+
+                if (component.hasValues_)
+                    newComponent->LoadValues(component.values_);
+                else
+                {
+                    MemoryBuffer buffer(component.data_);
+                    newComponent->Load(buffer);
+                }
+            }
+
+            if (staged.parent_ < 0)
+                ++progress.loadedNodes_;
+            ++progress.nodeIndex_;
+
+            // Break if time limit exceeded, so that we keep sufficient FPS
+            if (timer.GetUSec(false) >= asyncLoadingMs_ * 1000LL)
+                return false;
+        }
+
+        if (!batch.success_)
+        {
+            DV_LOGERROR("Could not load all nodes from " + progress.file_->GetName() + ", data is invalid");
+            return true;
+        }
+
+        // Free the staged data early, as it can take as much memory as the scene itself
+        batch.nodes_ = Vector<StagedNode>();
+        batch.components_ = Vector<StagedComponent>();
+        batch.createdNodes_ = Vector<Node*>();
+        ++progress.batchIndex_;
+        progress.nodeIndex_ = 0;
+    }
+
+    return true;
+}
+
+void Scene::StartResolvingStagedIDs()
+{
+    // The nodes and components attached so far kept their saved IDs
+    asyncProgress_.resolveIDs_ = true;
+
+    Vector<Node*> nodes;
+    GetChildren(nodes, true);
+    for (Node* node : nodes)
+    {
+        resolver_.AddNode(node->GetID(), node);
+        for (const SharedPtr<Component>& component : node->GetComponents())
+            resolver_.AddComponent(component->GetID(), component);
+    }
+}
+
+bool Scene::ApplyAsyncAttributes(HiresTimer& timer)
+{
+    if (asyncProgress_.mode_ == LOAD_RESOURCES_ONLY)
+        return true;
+
+    // Resolve the ID attributes before any attributes are applied. The scene components are applied first
+    if (asyncProgress_.applyIndex_ < 0)
+    {
+        if (!asyncProgress_.staged_ || asyncProgress_.resolveIDs_)
+            resolver_.Resolve();
+        else
+            resolver_.Reset();
+
+        for (const SharedPtr<Component>& component : components_)
+            component->ApplyAttributes();
+
+        asyncProgress_.applyIndex_ = 0;
+    }
+
+    // Apply one root-level node with its children at a time, to spread the work over frames
+    while (asyncProgress_.applyIndex_ < children_.Size())
+    {
+        if (timer.GetUSec(false) >= asyncLoadingMs_ * 1000LL)
+            return false;
+
+        children_[asyncProgress_.applyIndex_++]->ApplyAttributes();
+    }
+
+    return true;
+}
+
+void Scene::StopStagedLoading()
+{
+    AsyncProgress& progress = asyncProgress_;
+    if (!progress.staged_)
+        return;
+
+    // The work items refer to the progress structure, so the ones already started must be waited for
+    Vector<SharedPtr<WorkItem>> workItems;
+    if (progress.splitItem_)
+        workItems.Push(progress.splitItem_);
+    for (const StagedNodeBatch& batch : progress.batches_)
+        workItems.Push(batch.workItem_);
+
+    for (const SharedPtr<WorkItem>& workItem : workItems)
+    {
+        if (!DV_WORK_QUEUE.RemoveWorkItem(workItem))
+        {
+            while (!workItem->completed_)
+                std::this_thread::yield();
+        }
+    }
+
+    progress.staged_ = false;
+    progress.data_.Clear();
+    progress.nodeOffsets_.Clear();
+    progress.splitItem_.Reset();
+    progress.batches_.Clear();
+    progress.batchIndex_ = 0;
+    progress.nodeIndex_ = 0;
+    progress.numReplicatedNodes_ = progress.numLocalNodes_ = 0;
+    progress.numReplicatedComponents_ = progress.numLocalComponents_ = 0;
+}
+
 void Scene::FinishLoading(Deserializer* source)
 {
     if (source)
@@ -1515,4 +2299,18 @@ void RegisterSceneLibrary()
     SplinePath::RegisterObject();
 }
 
+void SceneTimeStepEventData::ToVariantMap(VariantMap& eventData) const
+{
+    using namespace SceneUpdate;
+    eventData[P_SCENE] = scene_;
+    eventData[P_TIMESTEP] = timeStep_;
+}
+
+void SceneTimeStepEventData::FromVariantMap(VariantMap& eventData)
+{
+    using namespace SceneUpdate;
+    scene_ = static_cast<Scene*>(eventData[P_SCENE].GetPtr());
+    timeStep_ = eventData[P_TIMESTEP].GetFloat();
+}
+
 }
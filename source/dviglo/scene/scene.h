@@ -6,9 +6,11 @@
 
 #pragma once
 
+#include "../containers/flat_hash_map.h"
 #include "../containers/hash_set.h"
 #include "../resource/xml_element.h"
 #include "../resource/json_file.h"
+#include "logic_component.h"
 #include "node.h"
 #include "scene_resolver.h"
 
@@ -18,7 +20,10 @@ namespace dviglo
 {
 
 class File;
+class HiresTimer;
 class PackageFile;
+struct UpdateEventData;
+struct WorkItem;
 
 inline constexpr id32 FIRST_REPLICATED_ID = 0x1;
 inline constexpr id32 LAST_REPLICATED_ID = 0xffffff;
@@ -36,6 +41,57 @@ enum LoadMode
     LOAD_SCENE_AND_RESOURCES
 };
 
+/// Component deserialized in a worker thread during asynchronous loading.
+struct StagedComponent
+{
+    /// Component type.
+    StringHash type_;
+    /// Component ID in the file.
+    ComponentId id_{};
+    /// Whether the type has registered attributes. If not, the component is loaded from the raw data.
+    bool hasValues_{};
+    /// File attribute values.
+    Vector<Variant> values_;
+    /// Raw attribute data.
+    Vector<byte> data_;
+};
+
+/// Node deserialized in a worker thread during asynchronous loading.
+struct StagedNode
+{
+    /// Node ID in the file.
+    NodeId id_{};
+    /// Index of the parent node in the batch, or -1 for a root-level node.
+    i32 parent_{};
+    /// File attribute values.
+    Vector<Variant> values_;
+    /// Index of the first component in the batch.
+    i32 firstComponent_{};
+    /// Number of components.
+    i32 numComponents_{};
+};
+
+/// Root-level nodes with their children deserialized by one work item during asynchronous loading.
+struct StagedNodeBatch
+{
+    /// Start offset in the binary data.
+    i64 start_{};
+    /// End offset in the binary data.
+    i64 end_{};
+    /// Number of root-level nodes.
+    i32 numRootNodes_{};
+    /// Nodes in depth-first order. Parents precede their children.
+    Vector<StagedNode> nodes_;
+    /// Components of all nodes.
+    Vector<StagedComponent> components_;
+    /// Whether all nodes were deserialized successfully.
+    bool success_{};
+    /// Created scene nodes by batch index. Filled in the main thread.
+    Vector<Node*> createdNodes_;
+    /// Work item.
+    SharedPtr<WorkItem> workItem_;
+};
+
 /// Asynchronous loading progress of a scene.
 struct AsyncProgress
 {
@@ -64,12 +120,77 @@ struct AsyncProgress
     i32 loadedNodes_;
     /// Total root-level nodes.
     i32 totalNodes_;
+
+    /// Whether binary data is deserialized in worker threads.
+    bool staged_{};
+    /// Binary data of the root-level nodes. Read in a worker thread.
+    Vector<byte> data_;
+    /// Start offsets of the root-level nodes in the binary data, followed by the end offset.
+    Vector<i64> nodeOffsets_;
+    /// Work item that reads the binary data and finds the root-level nodes. Null once the batches have been started.
+    SharedPtr<WorkItem> splitItem_;
+    /// Batches of deserialized nodes.
+    Vector<StagedNodeBatch> batches_;
+    /// Batch being attached to the scene.
+    i32 batchIndex_{};
+    /// Next node to attach in the current batch.
+    i32 nodeIndex_{};
+    /// Number of replicated nodes in the binary data. Counted in a worker thread to reserve the scene containers.
+    i32 numReplicatedNodes_{};
+    /// Number of local nodes in the binary data.
+    i32 numLocalNodes_{};
+    /// Number of replicated components in the binary data.
+    i32 numReplicatedComponents_{};
+    /// Number of local components in the binary data.
+    i32 numLocalComponents_{};
+    /// Whether an attached node or component did not keep its saved ID, so the ID attributes must be resolved.
+    bool resolveIDs_{};
+
+    /// Next root-level node to apply the attributes to after all nodes are loaded, or -1 if the ID attributes are not resolved yet.
+    i32 applyIndex_{-1};
+};
+
+/// Logic components that use an update event. Removed components are set to null and compacted after the update, so that components can be added and removed during the update.
+struct LogicComponentList
+{
+    /// Components updated in the main thread.
+    Vector<LogicComponent*> components_;
+    /// Components updated in worker threads.
+    Vector<LogicComponent*> threadSafeComponents_;
+    /// Number of removed components not yet compacted.
+    i32 numRemoved_{};
+    /// Update in progress flag.
+    bool updating_{};
+};
+
+/// Scene nodes in parent-before-child order for the scene-level world transform update. The subtree of each node is a contiguous range.
+struct TransformHierarchy
+{
+    /// Nodes, not including the scene itself.
+    Vector<Node*> nodes_;
+    /// Index of the parent node, or -1 for children of the scene.
+    Vector<i32> parents_;
+    /// One past the last index of each node's subtree.
+    Vector<i32> subtreeEnds_;
+    /// World transforms. Valid for nodes that are not dirty.
+    Vector<Matrix3x4> worldTransforms_;
+    /// World rotations. Valid for nodes that are not dirty.
+    Vector<Quaternion> worldRotations_;
+    /// Dirty flags. Set together with the node's dirty flag and cleared only by the transform update.
+    Vector<u8> dirty_;
+    /// Nodes whose subtree is too large for one task. Updated first in the main thread.
+    Vector<i32> spine_;
+    /// Subtree roots updated as independent tasks.
+    Vector<i32> tasks_;
+    /// Node order needs rebuild flag.
+    bool orderDirty_{true};
 };
 
 /// Root scene node, represents the whole scene.
 class DV_API Scene : public Node
 {
     DV_OBJECT(Scene, Node);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     using Node::GetComponent;
@@ -104,6 +225,12 @@ public:
     bool SaveXML(Serializer& dest, const String& indentation = "\t") const;
     /// Save to a JSON file. Return true if successful.
     bool SaveJSON(Serializer& dest, const String& indentation = "\t") const;
+    /// Load from a compact binary scene file, which is mapped into memory instead of read. Return true if successful.
+    bool LoadCompact(const String& fileName);
+    /// Load from compact binary scene data in memory. The data is read in place and must stay valid during the call. Return true if successful.
+    bool LoadCompact(const void* data, i64 size);
+    /// Save to compact binary scene format. Return true if successful.
+    bool SaveCompact(Serializer& dest) const;
     /// Load from a binary file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
     bool LoadAsync(File* file, LoadMode mode = LOAD_SCENE_AND_RESOURCES);
     /// Load from an XML file asynchronously. Return true if started successfully. The LOAD_RESOURCES_ONLY mode can also be used to preload resources from object prefab files.
@@ -139,6 +266,8 @@ public:
     void SetSnapThreshold(float threshold);
     /// Set maximum milliseconds per frame to spend on async scene loading.
     void SetAsyncLoadingMs(int ms);
+    /// Enable or disable the scene-level world transform update. When enabled, dirty world transforms are updated in one pass over contiguous arrays before culling, instead of lazily through the parent pointers.
+    void SetTransformUpdateEnabled(bool enable);
     /// Add a required package file for networking. To be called on the server.
     void AddRequiredPackageFile(PackageFile* package);
     /// Clear required package files.
@@ -152,6 +281,8 @@ public:
 
     /// Return node from the whole scene by ID, or null if not found.
     Node* GetNode(NodeId id) const;
+    /// Return all replicated nodes by ID.
+    const FlatHashMap<NodeId, Node*>& GetReplicatedNodes() const { return replicatedNodes_; }
     /// Return component from the whole scene by ID, or null if not found.
     Component* GetComponent(ComponentId id) const;
     /// Get nodes with specific tag from the whole scene, return false if empty.
@@ -160,6 +291,9 @@ public:
     /// Return whether updates are enabled.
     bool IsUpdateEnabled() const { return updateEnabled_; }
 
+    /// Return whether the scene-level world transform update is enabled.
+    bool IsTransformUpdateEnabled() const { return transformUpdateEnabled_; }
+
     /// Return whether an asynchronous loading operation is in progress.
     bool IsAsyncLoading() const { return asyncLoading_; }
 
@@ -178,6 +312,11 @@ public:
     /// Return update time scale.
     float GetTimeScale() const { return timeScale_; }
 
+    /// Return the number of network updates prepared on the server. Attribute changes are stamped with it.
+    unsigned GetNetworkUpdateTick() const { return networkUpdateTick_; }
+    /// Return IDs of the nodes that were checked for attribute changes or had their world transform updated in the last network update. May contain duplicates.
+    const Vector<NodeId>& GetNetworkChangedNodes() const { return networkChangedNodes_; }
+
     /// Return elapsed time in seconds.
     float GetElapsedTime() const { return elapsedTime_; }
 
@@ -204,10 +343,32 @@ public:
     void EndThreadedUpdate();
     /// Add a component to the delayed dirty notify queue. Is thread-safe.
     void DelayedMarkedDirty(Component* component);
+    /// Call the update function of all logic components that use an update event. Update and post-update are called by Update(), fixed updates by the physics world.
+    void UpdateLogicComponents(LogicComponentEvents event, float timeStep);
+    /// Add a logic component to the list of an update event. Called by LogicComponent.
+    void AddLogicComponent(LogicComponent* component, LogicComponentEvents event);
+    /// Remove a logic component from the list of an update event. Called by LogicComponent.
+    void RemoveLogicComponent(LogicComponent* component, LogicComponentEvents event);
+
+    /// Return number of logic components that use an update event.
+    i32 GetNumLogicComponents(LogicComponentEvents event) const;
 
     /// Return threaded update flag.
     bool IsThreadedUpdate() const { return threadedUpdate_; }
 
+    /// Update the dirty world transforms of all nodes. Called by the octree before culling. Does nothing if the scene-level transform update is disabled.
+    void UpdateTransforms();
+    /// Mark a node and its subtree dirty using the node order of the transform update. Return false if the node is not in a valid node order, in which case the caller marks the subtree itself. Called by Node::MarkDirty().
+    bool MarkTransformsDirty(Node* node);
+    /// Mark the node order of the transform update for rebuild. Called when the hierarchy changes.
+    void MarkTransformOrderDirty()
+    {
+        transforms_.orderDirty_ = true;
+        ++hierarchyVersion_;
+    }
+    /// Return a number that changes whenever a node or component is added to or removed from the scene, or a node is reparented.
+    u32 GetHierarchyVersion() const { return hierarchyVersion_; }
+
     /// Get free node ID, either non-local or local.
     NodeId GetFreeNodeID(CreateMode mode);
     /// Get free component ID, either non-local or local.
@@ -245,15 +406,27 @@ public:
 
 private:
     /// Handle the logic update event to update the scene, if active.
-    void HandleUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleUpdate(const UpdateEventData& eventData);
     /// Handle a background loaded resource completing.
     void HandleResourceBackgroundLoaded(StringHash eventType, VariantMap& eventData);
     /// Update asynchronous loading.
     void UpdateAsyncLoading();
     /// Finish asynchronous loading.
     void FinishAsyncLoading();
+    /// Start deserializing the root-level nodes in worker threads.
+    void StartStagedBatches();
+    /// Attach nodes deserialized in worker threads to the scene until the time limit. Return true when all have been attached.
+    bool AttachStagedNodes(HiresTimer& timer);
+    /// Remember all nodes and components in the scene resolver, as a staged node or component did not keep its saved ID.
+    void StartResolvingStagedIDs();
+    /// Resolve the ID attributes and apply the attributes of the loaded nodes until the time limit. Return true when all have been applied.
+    bool ApplyAsyncAttributes(HiresTimer& timer);
+    /// Wait for the work items of asynchronous loading and free the staged data.
+    void StopStagedLoading();
     /// Finish loading. Sets the scene filename and checksum.
     void FinishLoading(Deserializer* source);
+    /// Create nodes and components from compact binary scene data. Return true if successful.
+    bool LoadCompactInternal(const byte* data, i64 size);
     /// Finish saving. Sets the scene filename and checksum.
     void FinishSaving(Serializer* dest) const;
     /// Preload resources from a binary scene or object prefab file.
@@ -262,15 +435,21 @@ private:
     void PreloadResourcesXML(const XMLElement& element);
     /// Preload resources from a JSON scene or object prefab file.
     void PreloadResourcesJSON(const JSONValue& value);
+    /// Remove null pointers from a logic component list.
+    void CompactLogicComponents(i32 eventIndex);
+    /// Rebuild the node order of the transform update.
+    void RebuildTransformOrder();
+    /// Update the dirty world transforms in a range of the node order. Parents outside the range must already be up to date.
+    void UpdateTransformRange(i32 begin, i32 end);
 
     /// Replicated scene nodes by ID.
-    HashMap<NodeId, Node*> replicatedNodes_;
+    FlatHashMap<NodeId, Node*> replicatedNodes_;
     /// Local scene nodes by ID.
-    HashMap<NodeId, Node*> localNodes_;
+    FlatHashMap<NodeId, Node*> localNodes_;
     /// Replicated components by ID.
-    HashMap<ComponentId, Component*> replicatedComponents_;
+    FlatHashMap<ComponentId, Component*> replicatedComponents_;
     /// Local components by ID.
-    HashMap<ComponentId, Component*> localComponents_;
+    FlatHashMap<ComponentId, Component*> localComponents_;
     /// Cached tagged nodes by tag.
     HashMap<StringHash, Vector<Node*>> taggedNodes_;
     /// Asynchronous loading progress.
@@ -287,10 +466,18 @@ private:
     HashSet<NodeId> networkUpdateNodes_;
     /// Components to check for attribute changes on the next network update.
     HashSet<ComponentId> networkUpdateComponents_;
+    /// Nodes checked or moved in the last network update.
+    Vector<NodeId> networkChangedNodes_;
+    /// Logic components by update event.
+    LogicComponentList logicComponents_[NUM_LOGIC_COMPONENT_EVENTS];
+    /// Node order and world transforms for the scene-level transform update.
+    TransformHierarchy transforms_;
     /// Delayed dirty notification queue for components.
     Vector<Component*> delayedDirtyComponents_;
     /// Mutex for the delayed dirty notification queue.
     std::mutex sceneMutex_;
+    /// Hierarchy change counter.
+    u32 hierarchyVersion_{};
     /// Preallocated event data map for smoothing update events.
     VariantMap smoothingData_;
     /// Next free non-local node ID.
@@ -303,6 +490,8 @@ private:
     ComponentId localComponentID_;
     /// Scene source file checksum.
     mutable hash32 checksum_;
+    /// Network update counter.
+    unsigned networkUpdateTick_;
     /// Maximum milliseconds per frame to spend on async scene loading.
     int asyncLoadingMs_;
     /// Scene update time scale.
@@ -319,6 +508,8 @@ private:
     bool asyncLoading_;
     /// Threaded update flag.
     bool threadedUpdate_;
+    /// Scene-level world transform update flag.
+    bool transformUpdateEnabled_;
 };
 
 /// Register Scene library objects.
@@ -9,6 +9,22 @@
 namespace dviglo
 {
 
+class Scene;
+
+/// Typed payload of the scene update events, which carry the scene and the timestep.
+struct DV_API SceneTimeStepEventData
+{
+    /// Scene being updated.
+    Scene* scene_{};
+    /// Timestep in seconds.
+    float timeStep_{};
+
+    /// Write to event parameters.
+    void ToVariantMap(VariantMap& eventData) const;
+    /// Read from event parameters.
+    void FromVariantMap(VariantMap& eventData);
+};
+
 /// Variable timestep scene update.
 DV_EVENT(E_SCENEUPDATE, SceneUpdate)
 {
@@ -16,6 +32,13 @@ DV_EVENT(E_SCENEUPDATE, SceneUpdate)
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_SCENEUPDATE.
+struct SceneUpdateEventData : SceneTimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_SCENEUPDATE; }
+};
+
 /// Scene subsystem update.
 DV_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
 {
@@ -23,6 +46,13 @@ DV_EVENT(E_SCENESUBSYSTEMUPDATE, SceneSubsystemUpdate)
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_SCENESUBSYSTEMUPDATE.
+struct SceneSubsystemUpdateEventData : SceneTimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_SCENESUBSYSTEMUPDATE; }
+};
+
 /// Scene transform smoothing update.
 DV_EVENT(E_UPDATESMOOTHING, UpdateSmoothing)
 {
@@ -54,6 +84,13 @@ DV_EVENT(E_ATTRIBUTEANIMATIONUPDATE, AttributeAnimationUpdate)
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_ATTRIBUTEANIMATIONUPDATE.
+struct AttributeAnimationUpdateEventData : SceneTimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_ATTRIBUTEANIMATIONUPDATE; }
+};
+
 /// Attribute animation added to object animation.
 DV_EVENT(E_ATTRIBUTEANIMATIONADDED, AttributeAnimationAdded)
 {
@@ -75,6 +112,13 @@ DV_EVENT(E_SCENEPOSTUPDATE, ScenePostUpdate)
     DV_PARAM(P_TIMESTEP, TimeStep);            // float
 }
 
+/// Typed payload of E_SCENEPOSTUPDATE.
+struct ScenePostUpdateEventData : SceneTimeStepEventData
+{
+    /// Return event type.
+    static StringHash GetEventType() { return E_SCENEPOSTUPDATE; }
+};
+
 /// Asynchronous scene loading progress.
 DV_EVENT(E_ASYNCLOADPROGRESS, AsyncLoadProgress)
 {
@@ -3,6 +3,8 @@
 // License: MIT
 
 #include "../core/context.h"
+#include "../io/bit_reader.h"
+#include "../io/bit_writer.h"
 #include "../io/deserializer.h"
 #include "../io/log.h"
 #include "../io/serializer.h"
@@ -35,6 +37,135 @@ static unsigned RemapAttributeIndex(const Vector<AttributeInfo>* attributes, con
     return netAttrIndex; // Could not remap
 }
 
+static bool IsBitPacked(const AttributeInfo& attr)
+{
+    return attr.quantization_.IsSupported(attr.type_);
+}
+
+static void WriteQuantizedValue(BitWriter& dest, const AttributeQuantization& quantization, const Variant& value)
+{
+    float min = quantization.min_;
+    float max = quantization.max_;
+    i32 bits = quantization.bits_;
+
+    switch (value.GetType())
+    {
+    case VAR_FLOAT:
+        dest.WriteQuantizedFloat(value.GetFloat(), min, max, bits);
+        break;
+
+    case VAR_VECTOR2:
+        {
+            const Vector2& vector = value.GetVector2();
+            dest.WriteQuantizedFloat(vector.x_, min, max, bits);
+            dest.WriteQuantizedFloat(vector.y_, min, max, bits);
+        }
+        break;
+
+    case VAR_VECTOR3:
+        {
+            const Vector3& vector = value.GetVector3();
+            dest.WriteQuantizedFloat(vector.x_, min, max, bits);
+            dest.WriteQuantizedFloat(vector.y_, min, max, bits);
+            dest.WriteQuantizedFloat(vector.z_, min, max, bits);
+        }
+        break;
+
+    case VAR_VECTOR4:
+        {
+            const Vector4& vector = value.GetVector4();
+            dest.WriteQuantizedFloat(vector.x_, min, max, bits);
+            dest.WriteQuantizedFloat(vector.y_, min, max, bits);
+            dest.WriteQuantizedFloat(vector.z_, min, max, bits);
+            dest.WriteQuantizedFloat(vector.w_, min, max, bits);
+        }
+        break;
+
+    case VAR_QUATERNION:
+        dest.WriteSmallestThreeQuaternion(value.GetQuaternion(), bits);
+        break;
+
+    default:
+        break;
+    }
+}
+
+static Variant ReadQuantizedValue(BitReader& source, const AttributeQuantization& quantization, VariantType type)
+{
+    float min = quantization.min_;
+    float max = quantization.max_;
+    i32 bits = quantization.bits_;
+
+    switch (type)
+    {
+    case VAR_FLOAT:
+        return source.ReadQuantizedFloat(min, max, bits);
+
+    case VAR_VECTOR2:
+        {
+            float x = source.ReadQuantizedFloat(min, max, bits);
+            float y = source.ReadQuantizedFloat(min, max, bits);
+            return Vector2(x, y);
+        }
+
+    case VAR_VECTOR3:
+        {
+            float x = source.ReadQuantizedFloat(min, max, bits);
+            float y = source.ReadQuantizedFloat(min, max, bits);
+            float z = source.ReadQuantizedFloat(min, max, bits);
+            return Vector3(x, y, z);
+        }
+
+    case VAR_VECTOR4:
+        {
+            float x = source.ReadQuantizedFloat(min, max, bits);
+            float y = source.ReadQuantizedFloat(min, max, bits);
+            float z = source.ReadQuantizedFloat(min, max, bits);
+            float w = source.ReadQuantizedFloat(min, max, bits);
+            return Vector4(x, y, z, w);
+        }
+
+    case VAR_QUATERNION:
+        return source.ReadSmallestThreeQuaternion(bits);
+
+    default:
+        return Variant::EMPTY;
+    }
+}
+
+static void WriteNetworkValues(Serializer& dest, const Vector<AttributeInfo>& attributes, const Vector<Variant>& values,
+    const DirtyBits& attributeBits)
+{
+    unsigned numAttributes = attributes.Size();
+
+    // Quantized values are bit-packed in front of the other values
+    {
+        BitWriter packed(dest);
+        for (unsigned i = 0; i < numAttributes; ++i)
+        {
+            if (attributeBits.IsSet(i) && IsBitPacked(attributes[i]))
+                WriteQuantizedValue(packed, attributes[i].quantization_, values[i]);
+        }
+    }
+
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (attributeBits.IsSet(i) && !IsBitPacked(attributes[i]))
+            dest.WriteVariantData(values[i]);
+    }
+}
+
+static DirtyBits GetLatestDataBits(const Vector<AttributeInfo>& attributes)
+{
+    DirtyBits ret;
+    for (unsigned i = 0; i < attributes.Size(); ++i)
+    {
+        if (attributes[i].mode_ & AM_LATESTDATA)
+            ret.Set(i);
+    }
+    return ret;
+}
+
 Serializable::Serializable() :
     setInstanceDefault_(false),
     temporary_(false)
@@ -277,6 +408,9 @@ bool Serializable::Load(Deserializer& source)
     if (!attributes)
         return true;
 
+    // Instance defaults are stored as variants, so they use the generic path
+    bool typedAccess = HasTypedAttributeAccess() && !setInstanceDefault_;
+
     for (unsigned i = 0; i < attributes->Size(); ++i)
     {
         const AttributeInfo& attr = attributes->At(i);
@@ -289,6 +423,13 @@ bool Serializable::Load(Deserializer& source)
             return false;
         }
 
+        // Typed accessors read the value directly
+        if (typedAccess && attr.accessor_ && attr.accessor_->IsTyped())
+        {
+            attr.accessor_->Read(this, source);
+            continue;
+        }
+
         Variant varValue = source.ReadVariant(attr.type_);
         OnSetAttribute(attr, varValue);
     }
@@ -303,6 +444,7 @@ bool Serializable::Save(Serializer& dest) const
         return true;
 
     Variant value;
+    bool typedAccess = HasTypedAttributeAccess();
 
     for (unsigned i = 0; i < attributes->Size(); ++i)
     {
@@ -310,9 +452,18 @@ bool Serializable::Save(Serializer& dest) const
         if (!(attr.mode_ & AM_FILE) || (attr.mode_ & AM_FILEREADONLY) == AM_FILEREADONLY)
             continue;
 
-        OnGetAttribute(attr, value);
+        bool success;
+        if (typedAccess && attr.accessor_ && attr.accessor_->IsTyped())
+        {
+            success = attr.accessor_->Write(this, dest);
+        }
+        else
+        {
+            OnGetAttribute(attr, value);
+            success = dest.WriteVariantData(value);
+        }
 
-        if (!dest.WriteVariantData(value))
+        if (!success)
         {
             DV_LOGERROR("Could not save " + GetTypeName() + ", writing to stream failed");
             return false;
@@ -566,6 +717,31 @@ bool Serializable::SaveJSON(JSONValue& dest) const
     return true;
 }
 
+bool Serializable::LoadValues(const Vector<Variant>& values)
+{
+    const Vector<AttributeInfo>* attributes = GetAttributes();
+    if (!attributes)
+        return true;
+
+    // Values are in the order of the file attributes, same as in the binary format
+    i32 index = 0;
+    for (const AttributeInfo& attr : *attributes)
+    {
+        if (!(attr.mode_ & AM_FILE))
+            continue;
+
+        if (index >= values.Size())
+        {
+            DV_LOGERROR("Could not load " + GetTypeName() + ", not enough attribute values");
+            return false;
+        }
+
+        OnSetAttribute(attr, values[index++]);
+    }
+
+    return true;
+}
+
 bool Serializable::SetAttribute(unsigned index, const Variant& value)
 {
     const Vector<AttributeInfo>* attributes = GetAttributes();
@@ -708,6 +884,7 @@ void Serializable::AllocateNetworkState()
     {
         networkState_->currentValues_.Resize(numAttributes);
         networkState_->previousValues_.Resize(numAttributes);
+        networkState_->changeTicks_.Resize(numAttributes, 0);
 
         // Copy the default attribute values to the previous state as a starting point
         for (unsigned i = 0; i < numAttributes; ++i)
@@ -741,12 +918,7 @@ void Serializable::WriteInitialDeltaUpdate(Serializer& dest, unsigned char timeS
     // First write the change bitfield, then attribute data for non-default attributes
     dest.WriteU8(timeStamp);
     dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
-
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
-    }
+    WriteNetworkValues(dest, *attributes, networkState_->currentValues_, attributeBits);
 }
 
 void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp)
@@ -764,15 +936,10 @@ void Serializable::WriteDeltaUpdate(Serializer& dest, const DirtyBits& attribute
     unsigned numAttributes = attributes->Size();
 
     // First write the change bitfield, then attribute data for changed attributes
-    // Note: the attribute bits should not contain LATESTDATA attributes
+    // Note: in reliable replication the attribute bits do not contain LATESTDATA attributes, snapshots send them together
     dest.WriteU8(timeStamp);
     dest.Write(attributeBits.data_, (numAttributes + 7) >> 3u);
-
-    for (unsigned i = 0; i < numAttributes; ++i)
-    {
-        if (attributeBits.IsSet(i))
-            dest.WriteVariantData(networkState_->currentValues_[i]);
-    }
+    WriteNetworkValues(dest, *attributes, networkState_->currentValues_, attributeBits);
 }
 
 void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp)
@@ -787,15 +954,40 @@ void Serializable::WriteLatestDataUpdate(Serializer& dest, unsigned char timeSta
     if (!attributes)
         return;
 
+    dest.WriteU8(timeStamp);
+    WriteNetworkValues(dest, *attributes, networkState_->currentValues_, GetLatestDataBits(*attributes));
+}
+
+void Serializable::CacheNetworkUpdate(const DirtyBits& changedAttributes)
+{
+    const Vector<AttributeInfo>* attributes = networkState_->attributes_;
     unsigned numAttributes = attributes->Size();
 
-    dest.WriteU8(timeStamp);
+    // Latest data attributes are always sent together, so they are cached separately from the delta
+    DirtyBits& deltaBits = networkState_->deltaBits_;
+    deltaBits = changedAttributes;
+    bool hasLatestData = false;
 
     for (unsigned i = 0; i < numAttributes; ++i)
     {
-        if (attributes->At(i).mode_ & AM_LATESTDATA)
-            dest.WriteVariantData(networkState_->currentValues_[i]);
+        if (deltaBits.IsSet(i) && (attributes->At(i).mode_ & AM_LATESTDATA))
+        {
+            hasLatestData = true;
+            deltaBits.Clear(i);
+        }
+    }
+
+    if (hasLatestData)
+    {
+        VectorBuffer& latestData = networkState_->latestDataUpdate_;
+        latestData.Clear();
+        WriteNetworkValues(latestData, *attributes, networkState_->currentValues_, GetLatestDataBits(*attributes));
     }
+
+    VectorBuffer& delta = networkState_->deltaUpdate_;
+    delta.Clear();
+    delta.Write(deltaBits.data_, (numAttributes + 7) >> 3u);
+    WriteNetworkValues(delta, *attributes, networkState_->currentValues_, deltaBits);
 }
 
 bool Serializable::ReadDeltaUpdate(Deserializer& source)
@@ -806,38 +998,11 @@ bool Serializable::ReadDeltaUpdate(Deserializer& source)
 
     unsigned numAttributes = attributes->Size();
     DirtyBits attributeBits;
-    bool changed = false;
 
-    unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
     unsigned char timeStamp = source.ReadU8();
     source.Read(attributeBits.data_, (numAttributes + 7) >> 3u);
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
-    {
-        if (attributeBits.IsSet(i))
-        {
-            const AttributeInfo& attr = attributes->At(i);
-            if (!(interceptMask & (1ULL << i)))
-            {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
-                changed = true;
-            }
-            else
-            {
-                using namespace InterceptNetworkUpdate;
-
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_SERIALIZABLE] = this;
-                eventData[P_TIMESTAMP] = (unsigned)timeStamp;
-                eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
-                eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
-                SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
-            }
-        }
-    }
-
-    return changed;
+    return ReadNetworkValues(source, attributeBits, timeStamp);
 }
 
 bool Serializable::ReadLatestDataUpdate(Deserializer& source)
@@ -846,34 +1011,57 @@ bool Serializable::ReadLatestDataUpdate(Deserializer& source)
     if (!attributes)
         return false;
 
+    unsigned char timeStamp = source.ReadU8();
+
+    return ReadNetworkValues(source, GetLatestDataBits(*attributes), timeStamp);
+}
+
+bool Serializable::ReadNetworkValues(Deserializer& source, const DirtyBits& attributeBits, unsigned char timeStamp)
+{
+    const Vector<AttributeInfo>* attributes = GetNetworkAttributes();
     unsigned numAttributes = attributes->Size();
     bool changed = false;
 
     unsigned long long interceptMask = networkState_ ? networkState_->interceptMask_ : 0;
-    unsigned char timeStamp = source.ReadU8();
 
-    for (unsigned i = 0; i < numAttributes && !source.IsEof(); ++i)
+    // Quantized values are bit-packed in front of the other values, but are applied in attribute order like the rest
+    Variant packedValues[MAX_NETWORK_ATTRIBUTES];
     {
+        BitReader packed(source);
+        for (unsigned i = 0; i < numAttributes; ++i)
+        {
+            const AttributeInfo& attr = attributes->At(i);
+            if (attributeBits.IsSet(i) && IsBitPacked(attr))
+                packedValues[i] = ReadQuantizedValue(packed, attr.quantization_, attr.type_);
+        }
+    }
+
+    for (unsigned i = 0; i < numAttributes; ++i)
+    {
+        if (!attributeBits.IsSet(i))
+            continue;
+
         const AttributeInfo& attr = attributes->At(i);
-        if (attr.mode_ & AM_LATESTDATA)
+        bool isPacked = IsBitPacked(attr);
+        if (!isPacked && source.IsEof())
+            break;
+
+        if (!(interceptMask & (1ULL << i)))
         {
-            if (!(interceptMask & (1ULL << i)))
-            {
-                OnSetAttribute(attr, source.ReadVariant(attr.type_));
-                changed = true;
-            }
-            else
-            {
-                using namespace InterceptNetworkUpdate;
-
-                VariantMap& eventData = GetEventDataMap();
-                eventData[P_SERIALIZABLE] = this;
-                eventData[P_TIMESTAMP] = (unsigned)timeStamp;
-                eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
-                eventData[P_NAME] = attr.name_;
-                eventData[P_VALUE] = source.ReadVariant(attr.type_);
-                SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
-            }
+            OnSetAttribute(attr, isPacked ? packedValues[i] : source.ReadVariant(attr.type_));
+            changed = true;
+        }
+        else
+        {
+            using namespace InterceptNetworkUpdate;
+
+            VariantMap& eventData = GetEventDataMap();
+            eventData[P_SERIALIZABLE] = this;
+            eventData[P_TIMESTAMP] = (unsigned)timeStamp;
+            eventData[P_INDEX] = RemapAttributeIndex(GetAttributes(), attr, i);
+            eventData[P_NAME] = attr.name_;
+            eventData[P_VALUE] = isPacked ? packedValues[i] : source.ReadVariant(attr.type_);
+            SendEvent(E_INTERCEPTNETWORKUPDATE, eventData);
         }
     }
 
@@ -6,6 +6,8 @@
 
 #include "../core/attribute.h"
 #include "../core/object.h"
+#include "../io/deserializer.h"
+#include "../io/serializer.h"
 
 #include <cstddef>
 #include <memory>
@@ -15,8 +17,6 @@ namespace dviglo
 {
 
 class Connection;
-class Deserializer;
-class Serializer;
 class XMLElement;
 class JSONValue;
 
@@ -55,6 +55,8 @@ public:
     virtual bool LoadJSON(const JSONValue& source);
     /// Save as JSON data. Return true if successful.
     virtual bool SaveJSON(JSONValue& dest) const;
+    /// Load from file attribute values deserialized in advance, for example in a worker thread. Return true if successful.
+    virtual bool LoadValues(const Vector<Variant>& values);
 
     /// Apply attribute changes that can not be applied immediately. Called after scene load or a network update.
     virtual void ApplyAttributes() { }
@@ -62,6 +64,9 @@ public:
     /// Return whether should save default-valued attributes into XML. Default false.
     virtual bool SaveDefaultAttributes() const { return false; }
 
+    /// Return whether typed attribute accessors may read and write the attributes directly, bypassing OnSetAttribute() and OnGetAttribute(). Default false, classes opt in with DV_TYPED_ATTRIBUTE_ACCESS().
+    virtual bool HasTypedAttributeAccess() const { return false; }
+
     /// Mark for attribute check on the next network update.
     virtual void MarkNetworkUpdate() { }
 
@@ -87,6 +92,8 @@ public:
     void WriteDeltaUpdate(Serializer& dest, const DirtyBits& attributeBits, unsigned char timeStamp);
     /// Write a latest data network update.
     void WriteLatestDataUpdate(Serializer& dest, unsigned char timeStamp);
+    /// Serialize the delta and latest data updates of changed attributes into the network state, so that connections can share them. Called when a network update has detected changes.
+    void CacheNetworkUpdate(const DirtyBits& changedAttributes);
     /// Read and apply a network delta update. Return true if attributes were changed.
     bool ReadDeltaUpdate(Deserializer& source);
     /// Read and apply a network latest data update. Return true if attributes were changed.
@@ -119,6 +126,8 @@ protected:
     std::unique_ptr<NetworkState> networkState_;
 
 private:
+    /// Read and apply the network attribute values selected by the bits. Return true if attributes were changed.
+    bool ReadNetworkValues(Deserializer& source, const DirtyBits& attributeBits, unsigned char timeStamp);
     /// Set instance-level default value. Allocate the internal data structure as necessary.
     void SetInstanceDefault(const String& name, const Variant& defaultValue);
     /// Get instance-level default value.
@@ -175,6 +184,223 @@ SharedPtr<AttributeAccessor> MakeVariantAttributeAccessor(TGetFunction getFuncti
     return SharedPtr<AttributeAccessor>(new VariantAttributeAccessorImpl<TClassType, TGetFunction, TSetFunction>(getFunction, setFunction));
 }
 
+/// Return whether the class uses the OnSetAttribute() and OnGetAttribute() implementations of Serializable.
+template <class T>
+constexpr bool HasDefaultAttributeHooks()
+{
+    return std::is_same_v<decltype(&T::OnSetAttribute), void (Serializable::*)(const AttributeInfo&, const Variant&)>
+        && std::is_same_v<decltype(&T::OnGetAttribute), void (Serializable::*)(const AttributeInfo&, Variant&) const>;
+}
+
+/// Return whether attributes of the type can be saved, loaded and compared without a Variant. The binary format is the same as with Serializer::WriteVariantData().
+template <class T>
+constexpr bool IsTypedAttributeType()
+{
+    return std::is_same_v<T, bool> || std::is_same_v<T, int> || std::is_same_v<T, unsigned> || std::is_same_v<T, long long>
+        || std::is_same_v<T, float> || std::is_same_v<T, double> || std::is_same_v<T, Vector2> || std::is_same_v<T, Vector3>
+        || std::is_same_v<T, Vector4> || std::is_same_v<T, Quaternion> || std::is_same_v<T, Color> || std::is_same_v<T, String>
+        || std::is_same_v<T, Vector<byte>> || std::is_same_v<T, ResourceRef> || std::is_same_v<T, ResourceRefList>
+        || std::is_same_v<T, StringVector> || std::is_same_v<T, IntRect> || std::is_same_v<T, IntVector2>
+        || std::is_same_v<T, IntVector3> || std::is_same_v<T, Matrix3> || std::is_same_v<T, Matrix3x4> || std::is_same_v<T, Matrix4>;
+}
+
+/// Write attribute value of a type accepted by IsTypedAttributeType().
+template <class T>
+bool WriteTypedAttribute(Serializer& dest, const T& value)
+{
+    if constexpr (std::is_same_v<T, bool>)
+        return dest.WriteBool(value);
+    else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, unsigned>)
+        return dest.WriteI32(static_cast<i32>(value));
+    else if constexpr (std::is_same_v<T, long long>)
+        return dest.WriteI64(value);
+    else if constexpr (std::is_same_v<T, float>)
+        return dest.WriteFloat(value);
+    else if constexpr (std::is_same_v<T, double>)
+        return dest.WriteDouble(value);
+    else if constexpr (std::is_same_v<T, Vector2>)
+        return dest.WriteVector2(value);
+    else if constexpr (std::is_same_v<T, Vector3>)
+        return dest.WriteVector3(value);
+    else if constexpr (std::is_same_v<T, Vector4>)
+        return dest.WriteVector4(value);
+    else if constexpr (std::is_same_v<T, Quaternion>)
+        return dest.WriteQuaternion(value);
+    else if constexpr (std::is_same_v<T, Color>)
+        return dest.WriteColor(value);
+    else if constexpr (std::is_same_v<T, String>)
+        return dest.WriteString(value);
+    else if constexpr (std::is_same_v<T, Vector<byte>>)
+        return dest.WriteBuffer(value);
+    else if constexpr (std::is_same_v<T, ResourceRef>)
+        return dest.WriteResourceRef(value);
+    else if constexpr (std::is_same_v<T, ResourceRefList>)
+        return dest.WriteResourceRefList(value);
+    else if constexpr (std::is_same_v<T, StringVector>)
+        return dest.WriteStringVector(value);
+    else if constexpr (std::is_same_v<T, IntRect>)
+        return dest.WriteIntRect(value);
+    else if constexpr (std::is_same_v<T, IntVector2>)
+        return dest.WriteIntVector2(value);
+    else if constexpr (std::is_same_v<T, IntVector3>)
+        return dest.WriteIntVector3(value);
+    else if constexpr (std::is_same_v<T, Matrix3>)
+        return dest.WriteMatrix3(value);
+    else if constexpr (std::is_same_v<T, Matrix3x4>)
+        return dest.WriteMatrix3x4(value);
+    else
+        return dest.WriteMatrix4(value);
+}
+
+/// Read attribute value of a type accepted by IsTypedAttributeType().
+template <class T>
+T ReadTypedAttribute(Deserializer& source)
+{
+    if constexpr (std::is_same_v<T, bool>)
+        return source.ReadBool();
+    else if constexpr (std::is_same_v<T, int> || std::is_same_v<T, unsigned>)
+        return static_cast<T>(source.ReadI32());
+    else if constexpr (std::is_same_v<T, long long>)
+        return source.ReadI64();
+    else if constexpr (std::is_same_v<T, float>)
+        return source.ReadFloat();
+    else if constexpr (std::is_same_v<T, double>)
+        return source.ReadDouble();
+    else if constexpr (std::is_same_v<T, Vector2>)
+        return source.ReadVector2();
+    else if constexpr (std::is_same_v<T, Vector3>)
+        return source.ReadVector3();
+    else if constexpr (std::is_same_v<T, Vector4>)
+        return source.ReadVector4();
+    else if constexpr (std::is_same_v<T, Quaternion>)
+        return source.ReadQuaternion();
+    else if constexpr (std::is_same_v<T, Color>)
+        return source.ReadColor();
+    else if constexpr (std::is_same_v<T, String>)
+        return source.ReadString();
+    else if constexpr (std::is_same_v<T, Vector<byte>>)
+        return source.ReadBuffer();
+    else if constexpr (std::is_same_v<T, ResourceRef>)
+        return source.ReadResourceRef();
+    else if constexpr (std::is_same_v<T, ResourceRefList>)
+        return source.ReadResourceRefList();
+    else if constexpr (std::is_same_v<T, StringVector>)
+        return source.ReadStringVector();
+    else if constexpr (std::is_same_v<T, IntRect>)
+        return source.ReadIntRect();
+    else if constexpr (std::is_same_v<T, IntVector2>)
+        return source.ReadIntVector2();
+    else if constexpr (std::is_same_v<T, IntVector3>)
+        return source.ReadIntVector3();
+    else if constexpr (std::is_same_v<T, Matrix3>)
+        return source.ReadMatrix3();
+    else if constexpr (std::is_same_v<T, Matrix3x4>)
+        return source.ReadMatrix3x4();
+    else
+        return source.ReadMatrix4();
+}
+
+/// Compare attribute value of a type accepted by IsTypedAttributeType() with a variant without copying the variant's value.
+template <class T>
+bool EqualsTypedAttribute(const Variant& variant, const T& value)
+{
+    if (variant.GetType() != GetVariantType<T>())
+        return false;
+
+    if constexpr (std::is_arithmetic_v<T>)
+        return variant.Get<T>() == value;
+    else if constexpr (std::is_same_v<T, ResourceRef>)
+        return variant.GetResourceRef() == value;
+    else if constexpr (std::is_same_v<T, ResourceRefList>)
+        return variant.GetResourceRefList() == value;
+    else if constexpr (std::is_same_v<T, StringVector>)
+        return variant.GetStringVector() == value;
+    else
+        return variant.Get<const T&>() == value;
+}
+
+/// Template implementation of the attribute accessor with a compile-time value type. Saving, loading and network change detection of the types accepted by IsTypedAttributeType() bypass the Variant.
+template <class TClassType, class T, class TGetFunction, class TSetFunction>
+class TypedAttributeAccessorImpl : public AttributeAccessor
+{
+public:
+    /// Construct.
+    TypedAttributeAccessorImpl(TGetFunction getFunction, TSetFunction setFunction) : getFunction_(getFunction), setFunction_(setFunction) { }
+
+    /// Invoke getter function.
+    void Get(const Serializable* ptr, Variant& value) const override
+    {
+        assert(ptr);
+        const auto classPtr = static_cast<const TClassType*>(ptr);
+        value = getFunction_(*classPtr);
+    }
+
+    /// Invoke setter function.
+    void Set(Serializable* ptr, const Variant& value) override
+    {
+        assert(ptr);
+        auto classPtr = static_cast<TClassType*>(ptr);
+        setFunction_(*classPtr, value.Get<T>());
+    }
+
+    /// Return whether the value type has a typed fast path.
+    bool IsTyped() const override { return IsTypedAttributeType<T>(); }
+
+    /// Write the value returned by the getter function.
+    bool Write(const Serializable* ptr, Serializer& dest) const override
+    {
+        if constexpr (IsTypedAttributeType<T>())
+        {
+            assert(ptr);
+            const auto classPtr = static_cast<const TClassType*>(ptr);
+            return WriteTypedAttribute<T>(dest, getFunction_(*classPtr));
+        }
+        else
+            return false;
+    }
+
+    /// Read the value and pass it to the setter function.
+    void Read(Serializable* ptr, Deserializer& source) override
+    {
+        if constexpr (IsTypedAttributeType<T>())
+        {
+            assert(ptr);
+            auto classPtr = static_cast<TClassType*>(ptr);
+            setFunction_(*classPtr, ReadTypedAttribute<T>(source));
+        }
+    }
+
+    /// Compare the value returned by the getter function.
+    bool Equals(const Serializable* ptr, const Variant& value) const override
+    {
+        if constexpr (IsTypedAttributeType<T>())
+        {
+            assert(ptr);
+            const auto classPtr = static_cast<const TClassType*>(ptr);
+            return EqualsTypedAttribute<T>(value, getFunction_(*classPtr));
+        }
+        else
+            return false;
+    }
+
+private:
+    /// Get functor.
+    TGetFunction getFunction_;
+    /// Set functor.
+    TSetFunction setFunction_;
+};
+
+/// Make typed attribute accessor implementation.
+/// \tparam TClassType Serializable class type.
+/// \tparam T Attribute value type.
+/// \tparam TGetFunction Functional object with call signature `T getFunction(const TClassType& self)` (may return a const reference)
+/// \tparam TSetFunction Functional object with call signature `void setFunction(TClassType& self, const T& value)`
+template <class TClassType, class T, class TGetFunction, class TSetFunction>
+SharedPtr<AttributeAccessor> MakeTypedAttributeAccessor(TGetFunction getFunction, TSetFunction setFunction)
+{
+    return SharedPtr<AttributeAccessor>(new TypedAttributeAccessorImpl<TClassType, T, TGetFunction, TSetFunction>(getFunction, setFunction));
+}
+
 /// Make member attribute accessor.
 #define DV_MAKE_MEMBER_ATTRIBUTE_ACCESSOR(typeName, variable) dviglo::MakeVariantAttributeAccessor<ClassName>( \
     [](const ClassName& self, dviglo::Variant& value) { value = self.variable; }, \
@@ -190,6 +416,31 @@ SharedPtr<AttributeAccessor> MakeVariantAttributeAccessor(TGetFunction getFuncti
     [](const ClassName& self, dviglo::Variant& value) { value = self.getFunction(); }, \
     [](ClassName& self, const dviglo::Variant& value) { self.setFunction(value.Get<typeName>()); })
 
+/// Let typed attribute accessors bypass OnSetAttribute() and OnGetAttribute() for objects of exactly this class. Place in the class declaration.
+/// Subclasses do not inherit the opt-in. Fails to compile if the class overrides OnSetAttribute() or OnGetAttribute().
+#define DV_TYPED_ATTRIBUTE_ACCESS() \
+    public: \
+        bool HasTypedAttributeAccess() const override \
+        { \
+            static_assert(dviglo::HasDefaultAttributeHooks<ClassName>(), "Typed attribute access bypasses the overridden OnSetAttribute() or OnGetAttribute()"); \
+            return GetType() == GetTypeStatic(); \
+        }
+
+/// Make typed member attribute accessor.
+#define DV_MAKE_TYPED_MEMBER_ATTRIBUTE_ACCESSOR(typeName, variable) dviglo::MakeTypedAttributeAccessor<ClassName, typeName>( \
+    [](const ClassName& self) -> decltype(auto) { return (self.variable); }, \
+    [](ClassName& self, const typeName& value) { self.variable = value; })
+
+/// Make typed member attribute accessor with custom post-set callback.
+#define DV_MAKE_TYPED_MEMBER_ATTRIBUTE_ACCESSOR_EX(typeName, variable, postSetCallback) dviglo::MakeTypedAttributeAccessor<ClassName, typeName>( \
+    [](const ClassName& self) -> decltype(auto) { return (self.variable); }, \
+    [](ClassName& self, const typeName& value) { self.variable = value; self.postSetCallback(); })
+
+/// Make typed get/set attribute accessor.
+#define DV_MAKE_TYPED_GET_SET_ATTRIBUTE_ACCESSOR(getFunction, setFunction, typeName) dviglo::MakeTypedAttributeAccessor<ClassName, typeName>( \
+    [](const ClassName& self) -> decltype(auto) { return self.getFunction(); }, \
+    [](ClassName& self, const typeName& value) { self.setFunction(value); })
+
 /// Make member enum attribute accessor.
 #define DV_MAKE_MEMBER_ENUM_ATTRIBUTE_ACCESSOR(variable) dviglo::MakeVariantAttributeAccessor<ClassName>( \
     [](const ClassName& self, dviglo::Variant& value) { value = static_cast<int>(self.variable); }, \
@@ -227,7 +478,7 @@ namespace AttributeMetadata
 
 /// Define an object member attribute.
 #define DV_ATTRIBUTE(name, variable, defaultValue, mode) DV_CONTEXT.RegisterAttribute<ClassName>(dviglo::AttributeInfo( \
-    dviglo::GetVariantType<std::remove_reference_t<decltype(variable)>>(), name, DV_MAKE_MEMBER_ATTRIBUTE_ACCESSOR(std::remove_reference_t<decltype(variable)>, variable), nullptr, defaultValue, mode))
+    dviglo::GetVariantType<std::remove_reference_t<decltype(variable)>>(), name, DV_MAKE_TYPED_MEMBER_ATTRIBUTE_ACCESSOR(std::remove_reference_t<decltype(variable)>, variable), nullptr, defaultValue, mode))
 
 /// Define an object member attribute with forced type. Allows use custom type convertible to variant type (e.g. serialize u8 as int).
 #define DV_ATTRIBUTE_FORCE_TYPE(name, typeName, variable, defaultValue, mode) DV_CONTEXT.RegisterAttribute<ClassName>(dviglo::AttributeInfo( \
@@ -235,7 +486,7 @@ namespace AttributeMetadata
 
 /// Define an object member attribute. Post-set member function callback is called when attribute set.
 #define DV_ATTRIBUTE_EX(name, variable, postSetCallback, defaultValue, mode) DV_CONTEXT.RegisterAttribute<ClassName>(dviglo::AttributeInfo( \
-    dviglo::GetVariantType<std::remove_reference_t<decltype(variable)>>(), name, DV_MAKE_MEMBER_ATTRIBUTE_ACCESSOR_EX(std::remove_reference_t<decltype(variable)>, variable, postSetCallback), nullptr, defaultValue, mode))
+    dviglo::GetVariantType<std::remove_reference_t<decltype(variable)>>(), name, DV_MAKE_TYPED_MEMBER_ATTRIBUTE_ACCESSOR_EX(std::remove_reference_t<decltype(variable)>, variable, postSetCallback), nullptr, defaultValue, mode))
 
 /// Define an object member attribute with forced type. Allows use custom type convertible to variant type (e.g. serialize u8 as int). Post-set member function callback is called when attribute set.
 #define DV_ATTRIBUTE_FORCE_TYPE_EX(name, typeName, variable, postSetCallback, defaultValue, mode) DV_CONTEXT.RegisterAttribute<ClassName>(dviglo::AttributeInfo( \
@@ -243,7 +494,7 @@ namespace AttributeMetadata
 
 /// Define an attribute that uses get and set functions.
 #define DV_ACCESSOR_ATTRIBUTE(name, getFunction, setFunction, defaultValue, mode) DV_CONTEXT.RegisterAttribute<ClassName>(dviglo::AttributeInfo( \
-    dviglo::GetVariantType<DV_GETTER_RETURN_TYPE(getFunction)>(), name, DV_MAKE_GET_SET_ATTRIBUTE_ACCESSOR(getFunction, setFunction, DV_GETTER_RETURN_TYPE(getFunction)), nullptr, defaultValue, mode))
+    dviglo::GetVariantType<DV_GETTER_RETURN_TYPE(getFunction)>(), name, DV_MAKE_TYPED_GET_SET_ATTRIBUTE_ACCESSOR(getFunction, setFunction, DV_GETTER_RETURN_TYPE(getFunction)), nullptr, defaultValue, mode))
 
 /// Define an attribute that uses get and set functions with forced type.
 #define DV_ACCESSOR_ATTRIBUTE_FORCE_TYPE(name, getFunction, setFunction, typeName, defaultValue, mode) DV_CONTEXT.RegisterAttribute<ClassName>(dviglo::AttributeInfo( \
@@ -26,6 +26,7 @@ DV_FLAGSET(SmoothingType, SmoothingTypeFlags);
 class DV_API SmoothedTransform : public Component
 {
     DV_OBJECT(SmoothedTransform, Component);
+    DV_TYPED_ATTRIBUTE_ACCESS();
 
 public:
     /// Construct.
@@ -130,7 +130,7 @@ UI::UI() :
     SubscribeToEvent(E_SCREENMODE, DV_HANDLER(UI, HandleScreenMode));
     SubscribeToEvent(E_MOUSEBUTTONDOWN, DV_HANDLER(UI, HandleMouseButtonDown));
     SubscribeToEvent(E_MOUSEBUTTONUP, DV_HANDLER(UI, HandleMouseButtonUp));
-    SubscribeToEvent(E_MOUSEMOVE, DV_HANDLER(UI, HandleMouseMove));
+    SubscribeToEvent(&UI::HandleMouseMove);
     SubscribeToEvent(E_MOUSEWHEEL, DV_HANDLER(UI, HandleMouseWheel));
     SubscribeToEvent(E_TOUCHBEGIN, DV_HANDLER(UI, HandleTouchBegin));
     SubscribeToEvent(E_TOUCHEND, DV_HANDLER(UI, HandleTouchEnd));
@@ -1790,19 +1790,17 @@ void UI::HandleMouseButtonUp(StringHash eventType, VariantMap& eventData)
     ProcessClickEnd(cursorPos, (MouseButton)eventData[P_BUTTON].GetU32(), mouseButtons_, qualifiers_, cursor_, cursorVisible);
 }
 
-void UI::HandleMouseMove(StringHash eventType, VariantMap& eventData)
+void UI::HandleMouseMove(const MouseMoveEventData& eventData)
 {
-    using namespace MouseMove;
-
-    mouseButtons_ = MouseButtonFlags(eventData[P_BUTTONS].GetU32());
-    qualifiers_ = QualifierFlags(eventData[P_QUALIFIERS].GetU32());
+    mouseButtons_ = eventData.buttons_;
+    qualifiers_ = eventData.qualifiers_;
     usingTouchInput_ = false;
 
     const IntVector2& rootSize = rootElement_->GetSize();
     const IntVector2& rootPos = rootElement_->GetPosition();
 
-    const IntVector2 mouseDeltaPos{ eventData[P_DX].GetI32(), eventData[P_DY].GetI32() };
-    const IntVector2 mousePos{ eventData[P_X].GetI32(), eventData[P_Y].GetI32() };
+    const IntVector2& mouseDeltaPos = eventData.delta_;
+    const IntVector2& mousePos = eventData.position_;
 
     if (cursor_)
     {
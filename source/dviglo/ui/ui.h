@@ -36,6 +36,7 @@ class XMLElement;
 class XMLFile;
 class RenderSurface;
 class UIComponent;
+struct MouseMoveEventData;
 
 /// %UI subsystem. Manages the graphical user interface.
 class DV_API UI : public Object
@@ -304,7 +305,7 @@ private:
     /// Handle mouse button up event.
     void HandleMouseButtonUp(StringHash eventType, VariantMap& eventData);
     /// Handle mouse move event.
-    void HandleMouseMove(StringHash eventType, VariantMap& eventData);
+    void HandleMouseMove(const MouseMoveEventData& eventData);
     /// Handle mouse wheel event.
     void HandleMouseWheel(StringHash eventType, VariantMap& eventData);
     /// Handle touch begin event.
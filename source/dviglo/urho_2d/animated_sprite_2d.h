@@ -36,6 +36,7 @@ namespace Spriter
 }
 
 class AnimationSet2D;
+struct ScenePostUpdateEventData;
 
 /// Animated sprite component, it uses to play animation created by Spine (http://www.esotericsoftware.com) and Spriter (http://www.brashmonkey.com/).
 class DV_API AnimatedSprite2D : public StaticSprite2D
@@ -88,7 +89,7 @@ protected:
     /// Handle update vertices.
     void UpdateSourceBatches() override;
     /// Handle scene post update.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const ScenePostUpdateEventData& eventData);
     /// Update animation.
     void UpdateAnimation(float timeStep);
 #ifdef DV_SPINE
@@ -59,7 +59,7 @@ void ParticleEmitter2D::OnSetEnabled()
     if (scene)
     {
         if (IsEnabledEffective())
-            SubscribeToEvent(scene, E_SCENEPOSTUPDATE, DV_HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
+            SubscribeToEvent(scene, &ParticleEmitter2D::HandleScenePostUpdate);
         else
             UnsubscribeFromEvent(scene, E_SCENEPOSTUPDATE);
     }
@@ -164,7 +164,7 @@ void ParticleEmitter2D::OnSceneSet(Scene* scene)
     Drawable2D::OnSceneSet(scene);
 
     if (scene && IsEnabledEffective())
-        SubscribeToEvent(scene, E_SCENEPOSTUPDATE, DV_HANDLER(ParticleEmitter2D, HandleScenePostUpdate));
+        SubscribeToEvent(scene, &ParticleEmitter2D::HandleScenePostUpdate);
     else if (!scene)
         UnsubscribeFromEvent(E_SCENEPOSTUPDATE);
 }
@@ -252,12 +252,11 @@ void ParticleEmitter2D::UpdateMaterial()
         sourceBatches_[0].material_ = nullptr;
 }
 
-void ParticleEmitter2D::HandleScenePostUpdate(StringHash eventType, VariantMap& eventData)
+void ParticleEmitter2D::HandleScenePostUpdate(const ScenePostUpdateEventData& eventData)
 {
-    using namespace ScenePostUpdate;
     bool hasParticles = numParticles_ > 0;
     bool emitting = emissionTime_ > 0.0f;
-    float timeStep = eventData[P_TIMESTEP].GetFloat();
+    float timeStep = eventData.timeStep_;
     Update(timeStep);
 
     if (emitting && emissionTime_ == 0.0f)
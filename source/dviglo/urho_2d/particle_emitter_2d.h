@@ -11,6 +11,7 @@ namespace dviglo
 
 class ParticleEffect2D;
 class Sprite2D;
+struct ScenePostUpdateEventData;
 
 /// 2D particle.
 struct Particle2D
@@ -115,7 +116,7 @@ private:
     /// Update material.
     void UpdateMaterial();
     /// Handle scene post update.
-    void HandleScenePostUpdate(StringHash eventType, VariantMap& eventData);
+    void HandleScenePostUpdate(const ScenePostUpdateEventData& eventData);
     /// Update.
     void Update(float timeStep);
     /// Emit particle.
@@ -28,7 +28,8 @@ DV_DEFINE_APPLICATION_MAIN(HugeObjectCount)
 
 HugeObjectCount::HugeObjectCount() :
     animate_(false),
-    useGroups_(false)
+    useGroups_(false),
+    looseOctree_(false)
 {
 }
 
@@ -67,7 +68,8 @@ void HugeObjectCount::CreateScene()
 
     // Create the Octree component to the scene so that drawable objects can be rendered. Use default volume
     // (-1000, -1000, -1000) to (1000, 1000, 1000)
-    scene_->CreateComponent<Octree>();
+    auto* octree = scene_->CreateComponent<Octree>();
+    octree->SetLooseness(looseOctree_ ? 3.0f : DEFAULT_OCTREE_LOOSENESS);
 
     // Create a Zone for ambient light & fog control
     Node* zoneNode = scene_->CreateChild("Zone");
@@ -149,7 +151,8 @@ void HugeObjectCount::CreateInstructions()
     instructionText->SetText(
         "Use WASD keys and mouse/touch to move\n"
         "Space to toggle animation\n"
-        "G to toggle object group optimization"
+        "G to toggle object group optimization\n"
+        "L to toggle loose octree"
     );
     instructionText->SetFont(DV_RES_CACHE.GetResource<Font>("Fonts/Anonymous Pro.ttf"), 15);
     // The text has multiple rows. Center them in relation to each other
@@ -237,6 +240,13 @@ void HugeObjectCount::HandleUpdate(StringHash eventType, VariantMap& eventData)
         CreateScene();
     }
 
+    // Toggle octree looseness. Animated objects need to be reinserted less often with larger culling boxes
+    if (DV_INPUT.GetKeyPress(KEY_L))
+    {
+        looseOctree_ = !looseOctree_;
+        scene_->GetComponent<Octree>()->SetLooseness(looseOctree_ ? 3.0f : DEFAULT_OCTREE_LOOSENESS);
+    }
+
     // Move the camera, scale movement with time step
     MoveCamera(timeStep);
 
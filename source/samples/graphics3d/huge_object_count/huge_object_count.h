@@ -21,6 +21,7 @@ class Scene;
 ///     - Allowing examination of performance hotspots in the rendering code
 ///     - Using the profiler to measure the time taken to animate the scene
 ///     - Optionally speeding up rendering by grouping objects with the StaticModelGroup component
+///     - Optionally reducing octree reinsertions of animated objects with a loose octree
 class HugeObjectCount : public Sample
 {
     DV_OBJECT(HugeObjectCount, Sample);
@@ -77,4 +78,6 @@ private:
     bool animate_;
     /// Group optimization flag.
     bool useGroups_;
+    /// Loose octree flag.
+    bool looseOctree_;
 };
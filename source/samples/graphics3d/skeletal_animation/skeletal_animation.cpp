@@ -112,6 +112,8 @@ void SkeletalAnimation::CreateScene()
         modelObject->SetModel(cache.GetResource<Model>("Models/Kachujin/Kachujin.mdl"));
         modelObject->SetMaterial(cache.GetResource<Material>("Models/Kachujin/Materials/Kachujin.xml"));
         modelObject->SetCastShadows(true);
+        // Nothing is attached to the bones, so they do not need to be updated each frame
+        modelObject->SetNodeFreeAnimation(true);
 
         // Create an AnimationState for a walk animation. Its time position will need to be manually updated to advance the
         // animation, The alternative would be to use an AnimationController component which updates the animation automatically,
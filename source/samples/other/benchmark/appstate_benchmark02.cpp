@@ -44,6 +44,8 @@ void AppState_Benchmark02::OnEnter()
         mover->SetParameters(2.f, 100.f, castleTop);
 
         AnimatedModel* modelObject = woman->GetComponent<AnimatedModel>();
+        // Animation and skinning of node-free models are calculated entirely in the worker threads
+        modelObject->SetNodeFreeAnimation(true);
         Animation* walkAnimation = DV_RES_CACHE.GetResource<Animation>("Models/Kachujin/Kachujin_Walk.ani");
         AnimationState* state = modelObject->AddAnimationState(walkAnimation);
         if (state)
@@ -58,6 +60,7 @@ void AppState_Benchmark02::OnEnter()
     scene_->GetChildrenWithTag(mutants, "mutant");
     for (Node* mutant : mutants)
     {
+        mutant->GetComponent<AnimatedModel>()->SetNodeFreeAnimation(true);
         AnimationController* animCtrl = mutant->CreateComponent<AnimationController>();
         animCtrl->PlayExclusive("Models/Mutant/Mutant_Idle0.ani", 0, true, 0.f);
         animCtrl->SetTime("Models/Mutant/Mutant_Idle0.ani", Random(animCtrl->GetLength("Models/Mutant/Mutant_Idle0.ani")));
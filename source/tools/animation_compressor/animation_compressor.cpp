@@ -0,0 +1,98 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include <dviglo/core/process_utils.h>
+#include <dviglo/core/string_utils.h>
+#include <dviglo/graphics/animation.h>
+#include <dviglo/io/file.h>
+
+#include <dviglo/common/win_wrapped.h>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+static i32 CountKeyFrames(Animation* animation)
+{
+    i32 count = 0;
+    for (i32 i = 0; i < animation->GetNumTracks(); ++i)
+        count += animation->GetTrack(i)->GetNumKeyFrames();
+    return count;
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+    {
+        ErrorExit("Usage: animation_compressor <input ani file> <output ani file> [options]\n\n"
+                  "Options:\n"
+                  "-p <tolerance> Position tolerance, default 0.001\n"
+                  "-r <degrees>   Rotation tolerance in degrees, default 0.1\n"
+                  "-s <tolerance> Scale tolerance, default 0.001\n"
+                  "-d             Decompress instead of compressing");
+    }
+
+    String inputFile = arguments[0];
+    String outputFile = arguments[1];
+    AnimationCompressionSettings settings;
+    bool decompress = false;
+
+    for (i32 i = 2; i < arguments.Size(); ++i)
+    {
+        String arg = arguments[i].ToLower();
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-p" && hasValue)
+            settings.positionTolerance_ = ToFloat(arguments[++i]);
+        else if (arg == "-r" && hasValue)
+            settings.rotationTolerance_ = ToFloat(arguments[++i]);
+        else if (arg == "-s" && hasValue)
+            settings.scaleTolerance_ = ToFloat(arguments[++i]);
+        else if (arg == "-d")
+            decompress = true;
+        else
+            ErrorExit("Unrecognized option " + arguments[i]);
+    }
+
+    File source(inputFile);
+    if (!source.IsOpen())
+        ErrorExit("Could not open input file " + inputFile);
+
+    SharedPtr<Animation> animation(new Animation());
+    if (!animation->Load(source))
+        ErrorExit("Could not load animation " + inputFile);
+    source.Close();
+
+    i32 keyFrames = CountKeyFrames(animation);
+    i32 memoryUse = animation->GetMemoryUse();
+
+    if (decompress)
+        animation->Decompress();
+    else
+        animation->Compress(settings);
+
+    File dest(outputFile, FILE_WRITE);
+    if (!dest.IsOpen() || !animation->Save(dest))
+        ErrorExit("Could not write output file " + outputFile);
+
+    PrintLine("Tracks: " + String(animation->GetNumTracks()));
+    PrintLine("Keyframes: " + String(keyFrames) + " -> " + String(CountKeyFrames(animation)));
+    PrintLine("Memory use: " + String(memoryUse) + " -> " + String(animation->GetMemoryUse()) + " bytes");
+}
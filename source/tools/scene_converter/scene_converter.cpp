@@ -0,0 +1,124 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include <dviglo/core/process_utils.h>
+#include <dviglo/core/string_utils.h>
+#include <dviglo/engine/engine.h>
+#include <dviglo/engine/engine_defs.h>
+#include <dviglo/io/file.h>
+#include <dviglo/io/file_system.h>
+#include <dviglo/io/path.h>
+#include <dviglo/scene/scene.h>
+
+#include <dviglo/common/win_wrapped.h>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+int main(int argc, char** argv);
+void Run(const Vector<String>& arguments);
+
+int main(int argc, char** argv)
+{
+    Vector<String> arguments;
+
+    #ifdef WIN32
+    arguments = ParseArguments(GetCommandLineW());
+    #else
+    arguments = ParseArguments(argc, argv);
+    #endif
+
+    Run(arguments);
+    return 0;
+}
+
+static bool LoadScene(Scene* scene, const String& fileName)
+{
+    String extension = GetExtension(fileName);
+    if (extension == ".cscn")
+        return scene->LoadCompact(fileName);
+
+    File source(fileName);
+    if (!source.IsOpen())
+        return false;
+
+    if (extension == ".xml")
+        return scene->LoadXML(source);
+    else if (extension == ".json")
+        return scene->LoadJSON(source);
+    else
+        return scene->Load(source);
+}
+
+static bool SaveScene(Scene* scene, const String& fileName)
+{
+    String extension = GetExtension(fileName);
+    File dest(fileName, FILE_WRITE);
+    if (!dest.IsOpen())
+        return false;
+
+    if (extension == ".cscn")
+        return scene->SaveCompact(dest);
+    else if (extension == ".xml")
+        return scene->SaveXML(dest);
+    else if (extension == ".json")
+        return scene->SaveJSON(dest);
+    else
+        return scene->Save(dest);
+}
+
+void Run(const Vector<String>& arguments)
+{
+    if (arguments.Size() < 2)
+    {
+        ErrorExit("Usage: scene_converter <input scene> <output scene> [options]\n\n"
+                  "The format is chosen by the file extension: .cscn for the compact binary format,\n"
+                  ".xml, .json, and the binary format for any other extension.\n\n"
+                  "Options:\n"
+                  "-p <path> Resource directory. Components keep resource references only if\n"
+                  "          the resources can be loaded, so pass the directories the scene uses");
+    }
+
+    String inputFile = arguments[0];
+    String outputFile = arguments[1];
+    String resourcePaths;
+
+    for (i32 i = 2; i < arguments.Size(); ++i)
+    {
+        String arg = arguments[i].ToLower();
+        bool hasValue = i + 1 < arguments.Size();
+
+        if (arg == "-p" && hasValue)
+        {
+            if (!resourcePaths.Empty())
+                resourcePaths += ";";
+            String path = to_internal(arguments[++i]);
+            resourcePaths += IsAbsolutePath(path) ? path : DV_FILE_SYSTEM.GetCurrentDir() + path;
+        }
+        else
+        {
+            ErrorExit("Unrecognized option " + arguments[i]);
+        }
+    }
+
+    // Headless engine registers all component types without creating a window
+    VariantMap engineParameters;
+    engineParameters[EP_HEADLESS] = true;
+    engineParameters[EP_LOG_NAME] = String::EMPTY;
+    engineParameters[EP_LOG_QUIET] = true;
+    engineParameters[EP_RESOURCE_PATHS] = resourcePaths;
+    engineParameters[EP_AUTOLOAD_PATHS] = String::EMPTY;
+    engineParameters[EP_WORKER_THREADS] = false;
+    if (!DV_ENGINE.Initialize(engineParameters))
+        ErrorExit("Could not initialize engine");
+
+    SharedPtr<Scene> scene(new Scene());
+    if (!LoadScene(scene, inputFile))
+        ErrorExit("Could not load scene " + inputFile);
+
+    if (!SaveScene(scene, outputFile))
+        ErrorExit("Could not write output file " + outputFile);
+
+    PrintLine("Nodes: " + String(scene->GetNumChildren(true) + 1));
+}
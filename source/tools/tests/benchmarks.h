@@ -0,0 +1,9 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+// Замеры производительности долгие, а их результаты зависят от машины, поэтому по умолчанию они выключены.
+// Включаются аргументом командной строки -benchmarks или переменной окружения DV_TEST_BENCHMARKS=1.
+// Без замеров тесты выполняют те же проверки на меньших объёмах данных и ничего не печатают
+bool benchmarks_enabled();
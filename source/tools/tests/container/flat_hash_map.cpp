@@ -0,0 +1,212 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/containers/allocator.h>
+#include <dviglo/containers/flat_hash_map.h>
+#include <dviglo/containers/flat_hash_set.h>
+#include <dviglo/containers/hash_map.h>
+#include <dviglo/containers/hash_set.h>
+#include <dviglo/containers/str.h>
+#include <dviglo/math/string_hash.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Сравнивает содержимое с эталонным HashMap
+template <class T, class U>
+static bool equal_maps(const FlatHashMap<T, U>& flat, const HashMap<T, U>& reference)
+{
+    if (flat.Size() != reference.Size())
+        return false;
+
+    for (auto it = reference.Begin(); it != reference.End(); ++it)
+    {
+        auto flat_it = flat.Find(it->first_);
+        if (flat_it == flat.End() || flat_it->second_ != it->second_)
+            return false;
+    }
+
+    return true;
+}
+
+template <class Map, class Key>
+static i64 benchmark(const Vector<Key>& keys, const Vector<Key>& missing_keys, i64& checksum)
+{
+    auto start_time = std::chrono::steady_clock::now();
+
+    Map map;
+    for (i32 i = 0; i < keys.Size(); ++i)
+        map[keys[i]] = i;
+
+    for (i32 repeat = 0; repeat < 10; ++repeat)
+    {
+        for (const Key& key : keys)
+            checksum += map.Contains(key);
+
+        for (const Key& key : missing_keys)
+            checksum += map.Contains(key);
+
+        for (auto it = map.Begin(); it != map.End(); ++it)
+            checksum += it->second_;
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+template <class Key>
+static void print_benchmark(const char* key_name, const Vector<Key>& keys, const Vector<Key>& missing_keys)
+{
+    i64 checksum = 0;
+    i64 hash_map_usec = benchmark<HashMap<Key, i32>>(keys, missing_keys, checksum);
+    i64 flat_usec = benchmark<FlatHashMap<Key, i32>>(keys, missing_keys, checksum);
+    assert(checksum != 0);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Map with " << key_name << " keys (" << keys.Size() << " elements, insert + 10 x find hit/miss + iterate): HashMap "
+                  << hash_map_usec << " us, FlatHashMap " << flat_usec << " us" << std::endl;
+    }
+}
+
+void test_container_flat_hash_map()
+{
+    // Конструктор по умолчанию не выделяет память
+    {
+        i32 num_allocations = GetNumContainerAllocations();
+        FlatHashMap<i32, i32> map;
+        FlatHashSet<i32> set;
+        assert(map.Find(1) == map.End() && !set.Contains(1));
+        assert(!map.Erase(1) && !set.Erase(1));
+        assert(GetNumContainerAllocations() == num_allocations);
+    }
+
+    // Случайные вставки и удаления дают тот же результат, что и HashMap
+    {
+        std::mt19937 random(123);
+        FlatHashMap<i32, i32> flat;
+        HashMap<i32, i32> reference;
+
+        for (i32 i = 0; i < 20000; ++i)
+        {
+            i32 key = (i32)(random() % 2000);
+            switch (random() % 3)
+            {
+            case 0:
+                flat[key] = i;
+                reference[key] = i;
+                break;
+
+            case 1:
+                assert(flat.Erase(key) == reference.Erase(key));
+                break;
+
+            default:
+                assert(flat.Contains(key) == reference.Contains(key));
+                break;
+            }
+        }
+
+        assert(equal_maps(flat, reference));
+
+        // Копирование и перемещение
+        FlatHashMap<i32, i32> copy(flat);
+        assert(equal_maps(copy, reference));
+        FlatHashMap<i32, i32> moved(std::move(copy));
+        assert(equal_maps(moved, reference) && copy.Empty());
+
+        // Сортировка
+        flat.Sort();
+        for (auto it = flat.Begin(), prev = it++; it != flat.End(); prev = it++)
+            assert(prev->first_ < it->first_);
+        assert(equal_maps(flat, reference));
+
+        // Удаление во время обхода
+        for (auto it = flat.Begin(); it != flat.End();)
+        {
+            if (it->first_ % 2)
+                it = flat.Erase(it);
+            else
+                ++it;
+        }
+
+        for (auto& pair : flat)
+            assert(pair.first_ % 2 == 0 && reference[pair.first_] == pair.second_);
+
+        // Очистка сохраняет память
+        i32 capacity = flat.Capacity();
+        flat.Clear();
+        assert(flat.Empty() && flat.Capacity() == capacity && flat.Find(0) == flat.End());
+    }
+
+    // Множество и строковые ключи
+    {
+        FlatHashSet<String> set{"a", "b", "c"};
+        HashSet<String> reference{"a", "b", "c"};
+        for (i32 i = 0; i < 1000; ++i)
+        {
+            set.Insert(String(i));
+            reference.Insert(String(i));
+        }
+
+        for (i32 i = 0; i < 1000; i += 3)
+        {
+            set.Erase(String(i));
+            reference.Erase(String(i));
+        }
+
+        assert(set.Size() == reference.Size());
+        for (const String& key : reference)
+            assert(set.Contains(key));
+
+        bool exists;
+        set.Insert("a", exists);
+        assert(exists);
+
+        set.Sort();
+        for (auto it = set.Begin(), prev = it++; it != set.End(); prev = it++)
+            assert(*prev < *it);
+
+        FlatHashSet<String> copy = set;
+        assert(copy == set);
+        copy.Erase("a");
+        assert(copy != set);
+    }
+
+    // Замер производительности для разных типов ключей
+    std::mt19937 random(456);
+
+    Vector<i32> int_keys;
+    Vector<i32> missing_int_keys;
+    for (i32 i = 0; i < 10000; ++i)
+    {
+        int_keys.Push(i * 2);
+        missing_int_keys.Push(i * 2 + 1);
+    }
+    print_benchmark("i32", int_keys, missing_int_keys);
+
+    Vector<void*> pointer_keys;
+    Vector<void*> missing_pointer_keys;
+    for (i32 i = 0; i < 10000; ++i)
+    {
+        pointer_keys.Push(reinterpret_cast<void*>((intptr_t)(i * 32 + 64)));
+        missing_pointer_keys.Push(reinterpret_cast<void*>((intptr_t)(i * 32 + 48)));
+    }
+    print_benchmark("pointer", pointer_keys, missing_pointer_keys);
+
+    Vector<StringHash> string_hash_keys;
+    Vector<StringHash> missing_string_hash_keys;
+    for (i32 i = 0; i < 10000; ++i)
+    {
+        string_hash_keys.Push(StringHash((u32)random()));
+        missing_string_hash_keys.Push(StringHash((u32)random()));
+    }
+    print_benchmark("StringHash", string_hash_keys, missing_string_hash_keys);
+}
@@ -0,0 +1,153 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/containers/allocator.h>
+#include <dviglo/containers/arena_vector.h>
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Временные массивы как при подготовке кадра: много небольших массивов указателей
+static constexpr i32 num_vectors = 200;
+static constexpr i32 num_elements = 300;
+
+static i64 fill_vectors(FrameArena* arena)
+{
+    i64 sum = 0;
+
+    for (i32 i = 0; i < num_vectors; ++i)
+    {
+        if (arena)
+        {
+            ArenaVector<void*> temp(arena);
+            for (i32 j = 0; j < num_elements; ++j)
+                temp.Push(reinterpret_cast<void*>((intptr_t)j));
+            sum += (intptr_t)temp.Back();
+        }
+        else
+        {
+            Vector<void*> temp;
+            for (i32 j = 0; j < num_elements; ++j)
+                temp.Push(reinterpret_cast<void*>((intptr_t)j));
+            sum += (intptr_t)temp.Back();
+        }
+    }
+
+    return sum;
+}
+
+void test_container_frame_arena()
+{
+    {
+        FrameArena arena(256);
+
+        // Выравнивание
+        u8* a = static_cast<u8*>(arena.Allocate(1, 1));
+        u8* b = static_cast<u8*>(arena.Allocate(8, 8));
+        double* c = arena.Allocate<double>(3);
+        u8* d = static_cast<u8*>(arena.Allocate(16, 64));
+        assert(b > a && (intptr_t)b % 8 == 0);
+        assert((intptr_t)c % alignof(double) == 0);
+        assert((intptr_t)d % 64 == 0);
+        assert(arena.GetNumBlocks() == 1);
+
+        // Выделения, которые не помещаются в блок, добавляют новые блоки
+        for (i32 i = 0; i < 100; ++i)
+            memset(arena.Allocate(100), i, 100);
+        assert(arena.GetNumBlocks() > 1);
+        assert(arena.GetUsedSize() >= 100 * 100);
+
+        // После сброса всё помещается в один блок
+        i32 capacity = arena.GetCapacity();
+        arena.Reset();
+        assert(arena.GetNumBlocks() == 1);
+        assert(arena.GetUsedSize() == 0);
+        assert(arena.GetCapacity() >= capacity);
+
+        i64 num_allocations = GetNumContainerAllocations();
+        for (i32 i = 0; i < 100; ++i)
+            arena.Allocate(100);
+        assert(arena.GetNumBlocks() == 1);
+        assert(GetNumContainerAllocations() == num_allocations);
+    }
+
+    {
+        FrameArena arena;
+        ArenaVector<i32> vec(&arena);
+        for (i32 i = 0; i < 1000; ++i)
+            vec.Push(i);
+        assert(vec.Size() == 1000);
+
+        i32 sum = 0;
+        for (i32 value : vec)
+            sum += value;
+        assert(sum == 999 * 1000 / 2);
+
+        // Копия берёт память из той же арены
+        ArenaVector<i32> copy(vec);
+        assert(copy.GetArena() == &arena);
+        assert(copy.Size() == 1000 && copy[999] == 999);
+
+        // Без арены память берётся из кучи
+        ArenaVector<i32> heap_vec;
+        heap_vec = vec;
+        assert(!heap_vec.GetArena());
+        assert(heap_vec.Size() == 1000 && heap_vec[500] == 500);
+
+        heap_vec.SetArena(&arena);
+        assert(heap_vec.Empty() && heap_vec.GetArena() == &arena);
+    }
+
+    // Выделения в других потоках тоже учитываются, в том числе после завершения потока
+    {
+        i64 num_allocations = GetNumContainerAllocations();
+        std::thread thread([]
+        {
+            ArenaVector<i32> vec;
+            vec.Push(1);
+        });
+        thread.join();
+        assert(GetNumContainerAllocations() > num_allocations);
+    }
+
+    // Замер производительности. Арена сбрасывается каждый кадр, как в Renderer
+    const i32 num_frames = 100;
+    FrameArena arena;
+    i64 sum = 0;
+
+    i64 num_allocations = GetNumContainerAllocations();
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < num_frames; ++i)
+        sum += fill_vectors(nullptr);
+    i64 heap_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    i64 heap_allocations = GetNumContainerAllocations() - num_allocations;
+
+    num_allocations = GetNumContainerAllocations();
+    start_time = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < num_frames; ++i)
+    {
+        sum += fill_vectors(&arena);
+        arena.Reset();
+    }
+    i64 arena_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    i64 arena_allocations = GetNumContainerAllocations() - num_allocations;
+
+    assert(sum == 2 * num_frames * num_vectors * (i64)(num_elements - 1));
+    assert(heap_allocations >= num_frames * num_vectors);
+    assert(arena_allocations < num_frames);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Frame arena (" << num_vectors << " temporary vectors per frame): Vector " << heap_usec / num_frames << " us, "
+                  << heap_allocations / num_frames << " allocations per frame; ArenaVector " << arena_usec / num_frames << " us, "
+                  << arena_allocations << " allocations in " << num_frames << " frames" << std::endl;
+    }
+}
@@ -0,0 +1,40 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+
+#include <dviglo/core/context.h>
+#include <dviglo/scene/node.h>
+#include <dviglo/scene/replication_state.h>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+void test_core_context()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+
+    // Состояние репликации хранит указатель на вектор сетевых атрибутов класса
+    SharedPtr<Node> node(new Node());
+    node->AllocateNetworkState();
+    const Vector<AttributeInfo>* attributes = node->GetNetworkState()->attributes_;
+    assert(attributes && attributes == DV_CONTEXT.GetNetworkAttributes(Node::GetTypeStatic()));
+    String first_name = attributes->Front().name_;
+    i32 num_attributes = attributes->Size();
+
+    // Регистрация новых классов увеличивает таблицы атрибутов, но указатель должен остаться действительным
+    constexpr i32 num_types = 1000;
+    for (i32 i = 0; i < num_types; ++i)
+        DV_CONTEXT.RegisterAttribute(StringHash("ContextTestType" + String(i)), AttributeInfo(VAR_INT, "Value", nullptr, nullptr, 0, AM_DEFAULT));
+
+    assert(DV_CONTEXT.GetNetworkAttributes(Node::GetTypeStatic()) == attributes);
+    assert(attributes->Size() == num_attributes);
+    assert(attributes->Front().name_ == first_name);
+
+    for (i32 i = 0; i < num_types; ++i)
+        DV_CONTEXT.RemoveAllAttributes(StringHash("ContextTestType" + String(i)));
+
+    assert(DV_CONTEXT.GetNetworkAttributes(Node::GetTypeStatic()) == attributes);
+}
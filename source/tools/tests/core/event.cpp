@@ -0,0 +1,210 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/core_events.h>
+#include <dviglo/core/object.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+DV_EVENT(E_TESTEVENT, TestEvent)
+{
+    DV_PARAM(P_VALUE, Value);                  // i32
+    DV_PARAM(P_SCALE, Scale);                  // float
+}
+
+struct TestEventData
+{
+    static StringHash GetEventType() { return E_TESTEVENT; }
+
+    i32 value_{};
+    float scale_{};
+
+    void ToVariantMap(VariantMap& eventData) const
+    {
+        using namespace TestEvent;
+        eventData[P_VALUE] = value_;
+        eventData[P_SCALE] = scale_;
+    }
+
+    void FromVariantMap(VariantMap& eventData)
+    {
+        using namespace TestEvent;
+        value_ = eventData[P_VALUE].GetI32();
+        scale_ = eventData[P_SCALE].GetFloat();
+    }
+};
+
+class Sender : public Object
+{
+    DV_OBJECT(Sender, Object);
+};
+
+// Обработчик с типизированными параметрами
+class TypedReceiver : public Object
+{
+    DV_OBJECT(TypedReceiver, Object);
+
+public:
+    void Subscribe(Object* sender)
+    {
+        if (sender)
+            SubscribeToEvent(sender, &TypedReceiver::HandleTestEvent);
+        else
+            SubscribeToEvent(&TypedReceiver::HandleTestEvent);
+    }
+
+    void HandleTestEvent(const TestEventData& eventData)
+    {
+        sum += eventData.value_ * eventData.scale_;
+        ++num_events;
+    }
+
+    float sum = 0.f;
+    i32 num_events = 0;
+};
+
+// Обработчик с VariantMap, как у старого кода
+class LegacyReceiver : public Object
+{
+    DV_OBJECT(LegacyReceiver, Object);
+
+public:
+    void Subscribe(Object* sender)
+    {
+        if (sender)
+            SubscribeToEvent(sender, E_TESTEVENT, DV_HANDLER(LegacyReceiver, HandleTestEvent));
+        else
+            SubscribeToEvent(E_TESTEVENT, DV_HANDLER(LegacyReceiver, HandleTestEvent));
+    }
+
+    void HandleTestEvent(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace TestEvent;
+        sum += eventData[P_VALUE].GetI32() * eventData[P_SCALE].GetFloat();
+        ++num_events;
+
+        // Вложенное событие не должно портить параметры для следующих обработчиков
+        if (send_nested)
+            SendEvent(E_UPDATE, Update::P_TIMESTEP, 1.f);
+    }
+
+    float sum = 0.f;
+    i32 num_events = 0;
+    bool send_nested = false;
+};
+
+} // namespace
+
+template <class Receiver>
+static i64 benchmark(i32 num_receivers, i32 num_sends, bool typed_send, float& checksum)
+{
+    SharedPtr<Sender> sender(new Sender());
+    Vector<SharedPtr<Receiver>> receivers;
+    for (i32 i = 0; i < num_receivers; ++i)
+    {
+        SharedPtr<Receiver> receiver(new Receiver());
+        receiver->Subscribe(nullptr);
+        receivers.Push(receiver);
+    }
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < num_sends; ++i)
+    {
+        if (typed_send)
+        {
+            TestEventData eventData;
+            eventData.value_ = i;
+            eventData.scale_ = 0.5f;
+            sender->SendEvent(eventData);
+        }
+        else
+        {
+            using namespace TestEvent;
+            VariantMap& eventData = sender->GetEventDataMap();
+            eventData[P_VALUE] = i;
+            eventData[P_SCALE] = 0.5f;
+            sender->SendEvent(E_TESTEVENT, eventData);
+        }
+    }
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    for (Receiver* receiver : receivers)
+        checksum += receiver->sum;
+
+    return usec;
+}
+
+void test_core_event()
+{
+    {
+        SharedPtr<Sender> sender(new Sender());
+        SharedPtr<TypedReceiver> typed(new TypedReceiver());
+        SharedPtr<LegacyReceiver> legacy(new LegacyReceiver());
+        SharedPtr<LegacyReceiver> legacy2(new LegacyReceiver());
+        typed->Subscribe(nullptr);
+        legacy->Subscribe(nullptr);
+        legacy2->Subscribe(nullptr);
+        legacy->send_nested = true;
+
+        // Типизированное событие доходит до обоих видов обработчиков
+        TestEventData eventData;
+        eventData.value_ = 3;
+        eventData.scale_ = 2.f;
+        sender->SendEvent(eventData);
+        assert(typed->num_events == 1 && typed->sum == 6.f);
+        assert(legacy->num_events == 1 && legacy->sum == 6.f);
+        assert(legacy2->num_events == 1 && legacy2->sum == 6.f);
+
+        // Событие с VariantMap доходит до типизированного обработчика
+        {
+            using namespace TestEvent;
+            sender->SendEvent(E_TESTEVENT, P_VALUE, 5, P_SCALE, 1.f);
+        }
+        assert(typed->num_events == 2 && typed->sum == 11.f);
+        assert(legacy2->num_events == 2 && legacy2->sum == 11.f);
+
+        // Подписка на событие конкретного отправителя
+        SharedPtr<Sender> other_sender(new Sender());
+        typed->UnsubscribeFromEvent(E_TESTEVENT);
+        typed->Subscribe(other_sender);
+        assert(typed->HasSubscribedToEvent(other_sender, E_TESTEVENT));
+        sender->SendEvent(eventData);
+        assert(typed->num_events == 2);
+        other_sender->SendEvent(eventData);
+        assert(typed->num_events == 3 && typed->sum == 17.f);
+
+        typed->SetBlockEvents(true);
+        other_sender->SendEvent(eventData);
+        assert(typed->num_events == 3);
+    }
+
+    // Замер производительности: много отправок одному получателю и мало отправок многим получателям
+    float checksum = 0.f;
+    for (i32 num_receivers : {1, 100})
+    {
+        i32 num_sends = 200000 / num_receivers;
+        i64 legacy_usec = benchmark<LegacyReceiver>(num_receivers, num_sends, false, checksum);
+        i64 typed_usec = benchmark<TypedReceiver>(num_receivers, num_sends, true, checksum);
+        i64 bridged_usec = benchmark<LegacyReceiver>(num_receivers, num_sends, true, checksum);
+
+        if (benchmarks_enabled())
+        {
+            std::cout << "Event dispatch (" << num_receivers << " receivers, " << num_sends << " sends): VariantMap "
+                      << legacy_usec << " us, typed " << typed_usec << " us, typed to VariantMap handlers " << bridged_usec
+                      << " us" << std::endl;
+        }
+    }
+
+    assert(checksum > 0.f);
+}
@@ -0,0 +1,213 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/work_queue.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+static std::atomic<i32> num_executed{0};
+
+static void tiny_work(const WorkItem* item, i32 thread_index)
+{
+    ++num_executed;
+}
+
+static void large_work(const WorkItem* item, i32 thread_index)
+{
+    u32 hash = 0;
+
+    for (u32 i = 0; i < 200000; ++i)
+        hash = hash * 31 + i;
+
+    *reinterpret_cast<std::atomic<u32>*>(item->aux_) = hash;
+    ++num_executed;
+}
+
+static std::atomic<i32> order_counter{0};
+
+// Запоминает, каким по счёту был выполнен элемент
+static void ordered_work(const WorkItem* item, i32 thread_index)
+{
+    *reinterpret_cast<i32*>(item->start_) = order_counter++;
+}
+
+static void main_thread_work(const WorkItem* item, i32 thread_index)
+{
+    assert(thread_index == 0);
+    ordered_work(item, thread_index);
+}
+
+// Возвращает время выполнения в микросекундах
+static i64 run_items(void (*work_function)(const WorkItem*, i32), i32 num_items, i32 priority)
+{
+    WorkQueue& queue = DV_WORK_QUEUE;
+    std::atomic<u32> result{0};
+    num_executed = 0;
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (i32 i = 0; i < num_items; ++i)
+    {
+        SharedPtr<WorkItem> item = queue.GetFreeItem();
+        item->workFunction_ = work_function;
+        item->aux_ = &result;
+        item->priority_ = priority;
+        queue.AddWorkItem(item);
+    }
+
+    queue.Complete(priority);
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    assert(num_executed == num_items);
+    assert(queue.IsCompleted(0));
+
+    return usec;
+}
+
+static void benchmark(const char* mode_name)
+{
+    const i32 num_tiny = 2000;
+    const i32 num_large = 64;
+
+    i64 tiny_usec = run_items(tiny_work, num_tiny, WI_MAX_PRIORITY);
+    i64 large_usec = run_items(large_work, num_large, WI_MAX_PRIORITY);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "WorkQueue (" << mode_name << "): "
+                  << num_tiny << " tiny items " << tiny_usec << " us, "
+                  << num_large << " large items " << large_usec << " us" << std::endl;
+    }
+}
+
+void test_core_work_queue()
+{
+    WorkQueue& queue = DV_WORK_QUEUE;
+    queue.CreateThreads(2, WQM_SHARED_QUEUE);
+    assert(queue.GetNumThreads() == 2);
+    assert(queue.GetMode() == WQM_SHARED_QUEUE);
+
+    benchmark("shared queue");
+
+    queue.SetMode(WQM_WORK_STEALING);
+    benchmark("work stealing");
+
+    // Complete() должен дождаться высокоприоритетных элементов, а низкоприоритетные доделают рабочие потоки
+    {
+        num_executed = 0;
+
+        for (i32 i = 0; i < 100; ++i)
+        {
+            SharedPtr<WorkItem> item = queue.GetFreeItem();
+            item->workFunction_ = tiny_work;
+            item->priority_ = (i % 2) ? WI_MAX_PRIORITY : 0;
+            queue.AddWorkItem(item);
+        }
+
+        queue.Complete(WI_MAX_PRIORITY);
+        assert(queue.IsCompleted(WI_MAX_PRIORITY));
+        assert(num_executed >= 50);
+
+        queue.Complete(0);
+        assert(queue.IsCompleted(0));
+        assert(num_executed == 100);
+    }
+
+    // Граф задач: a -> (b, c) -> d, где c выполняется только в главном потоке
+    for (WorkQueueMode mode : {WQM_SHARED_QUEUE, WQM_WORK_STEALING})
+    {
+        queue.SetMode(mode);
+        order_counter = 0;
+        i32 order[4]{-1, -1, -1, -1};
+        SharedPtr<WorkItem> items[4];
+
+        for (i32 i = 0; i < 4; ++i)
+        {
+            items[i] = queue.GetFreeItem();
+            items[i]->workFunction_ = ordered_work;
+            items[i]->start_ = &order[i];
+            items[i]->priority_ = WI_MAX_PRIORITY;
+        }
+
+        items[2]->workFunction_ = main_thread_work;
+        items[2]->mainThread_ = true;
+
+        queue.AddDependency(items[1], items[0]);
+        queue.AddDependency(items[2], items[0]);
+        queue.AddDependency(items[3], items[1]);
+        queue.AddDependency(items[3], items[2]);
+
+        // Порядок добавления не важен
+        for (i32 i = 3; i >= 0; --i)
+            queue.AddWorkItem(items[i]);
+
+        queue.Complete(WI_MAX_PRIORITY);
+        assert(order[0] == 0);
+        assert(order[1] > order[0] && order[2] > order[0]);
+        assert(order[3] == 3);
+    }
+
+    // Цепочка продолжений: каждое продолжение попадает в деку потока, выполнившего предыдущий элемент
+    for (WorkQueueMode mode : {WQM_SHARED_QUEUE, WQM_WORK_STEALING})
+    {
+        queue.SetMode(mode);
+        order_counter = 0;
+        constexpr i32 num_items = 200;
+        i32 order[num_items];
+        Vector<SharedPtr<WorkItem>> items;
+
+        for (i32 i = 0; i < num_items; ++i)
+        {
+            SharedPtr<WorkItem> item = queue.GetFreeItem();
+            item->workFunction_ = ordered_work;
+            item->start_ = &order[i];
+            item->priority_ = WI_MAX_PRIORITY;
+            if (i > 0)
+                queue.AddDependency(item, items.Back());
+            items.Push(item);
+        }
+
+        for (const SharedPtr<WorkItem>& item : items)
+            queue.AddWorkItem(item);
+
+        queue.Complete(WI_MAX_PRIORITY);
+        for (i32 i = 0; i < num_items; ++i)
+            assert(order[i] == i);
+    }
+
+    // ParallelFor() должен обойти каждый индекс диапазона ровно один раз
+    for (WorkQueueMode mode : {WQM_SHARED_QUEUE, WQM_WORK_STEALING})
+    {
+        queue.SetMode(mode);
+        Vector<i32> values(100000);
+
+        // Несколько прогонов, чтобы оценка стоимости успела разрешить разбиение
+        for (i32 run = 0; run < 3; ++run)
+        {
+            for (i32 i = 0; i < values.Size(); ++i)
+                values[i] = 0;
+
+            queue.ParallelFor(0, values.Size(), 16, [&values](i32 begin, i32 end, i32 thread_index)
+            {
+                for (i32 i = begin; i < end; ++i)
+                    values[i] += i % 7 + 1;
+            });
+
+            for (i32 i = 0; i < values.Size(); ++i)
+                assert(values[i] == i % 7 + 1);
+        }
+
+        // Пустой диапазон
+        queue.ParallelFor(5, 5, 1, [](i32 begin, i32 end, i32 thread_index) { assert(false); });
+    }
+
+    queue.SetMode(WQM_SHARED_QUEUE);
+}
@@ -0,0 +1,337 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/context.h>
+#include <dviglo/core/work_queue.h>
+#include <dviglo/graphics/animated_model.h>
+#include <dviglo/graphics/animation.h>
+#include <dviglo/graphics/animation_state.h>
+#include <dviglo/graphics/camera.h>
+#include <dviglo/graphics/octree.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Скелет персонажа: позвоночник и четыре конечности
+static constexpr i32 num_chains = 5;
+static constexpr i32 chain_length = 8;
+static constexpr i32 num_bones = num_chains * chain_length;
+
+static String bone_name(i32 index)
+{
+    return "Bone" + String(index);
+}
+
+static SharedPtr<Model> create_model()
+{
+    Skeleton skeleton;
+    Vector<Bone>& bones = skeleton.GetModifiableBones();
+
+    for (i32 chain = 0; chain < num_chains; ++chain)
+    {
+        for (i32 i = 0; i < chain_length; ++i)
+        {
+            Bone bone;
+            i32 index = chain * chain_length + i;
+            bone.name_ = bone_name(index);
+            bone.nameHash_ = bone.name_;
+            // Конечности крепятся к середине позвоночника
+            if (i > 0)
+                bone.parentIndex_ = index - 1;
+            else
+                bone.parentIndex_ = chain == 0 ? 0 : chain_length / 2;
+            bone.initialPosition_ = i == 0 && chain > 0 ? Vector3((float)chain - 2.5f, 0.f, 0.f) : Vector3(0.f, 0.25f, 0.f);
+            bone.initialRotation_ = Quaternion(10.f * chain, Vector3::FORWARD);
+            bone.offsetMatrix_ = Matrix3x4(Vector3(0.f, -0.25f * i, 0.f), Quaternion::IDENTITY, Vector3::ONE);
+            bone.collisionMask_ = BONECOLLISION_SPHERE;
+            bone.radius_ = 0.1f;
+            bones.Push(bone);
+        }
+    }
+
+    skeleton.SetRootBoneIndex(0);
+
+    SharedPtr<Model> model(new Model());
+    model->SetBoundingBox(BoundingBox(-2.f, 2.f));
+    model->SetSkeleton(skeleton);
+    return model;
+}
+
+static SharedPtr<Animation> create_animation(const String& name, float phase)
+{
+    SharedPtr<Animation> animation(new Animation());
+    animation->SetName(name);
+    animation->SetAnimationName(name);
+    animation->SetLength(1.f);
+
+    const i32 num_key_frames = 30;
+
+    for (i32 bone = 0; bone < num_bones; ++bone)
+    {
+        AnimationTrack* track = animation->CreateTrack(bone_name(bone));
+        track->channelMask_ = AnimationChannels::Position | AnimationChannels::Rotation;
+
+        for (i32 i = 0; i < num_key_frames; ++i)
+        {
+            AnimationKeyFrame key_frame;
+            key_frame.time_ = (float)i / num_key_frames;
+            float angle = 360.f * (key_frame.time_ + phase) + bone;
+            key_frame.position_ = Vector3(0.f, 0.25f, 0.05f * Sin(angle));
+            key_frame.rotation_ = Quaternion(30.f * Sin(angle), 20.f * Cos(angle), 0.f);
+            track->AddKeyFrame(key_frame);
+        }
+    }
+
+    return animation;
+}
+
+static AnimatedModel* create_character(Scene* scene, Model* model, Animation* walk, Animation* wave, bool node_free)
+{
+    Node* node = scene->CreateChild("Jack");
+    AnimatedModel* animated_model = node->CreateComponent<AnimatedModel>();
+    animated_model->SetNodeFreeAnimation(node_free);
+    animated_model->SetModel(model);
+
+    AnimationState* walk_state = animated_model->AddAnimationState(walk);
+    walk_state->SetWeight(1.f);
+    walk_state->SetLooped(true);
+
+    AnimationState* wave_state = animated_model->AddAnimationState(wave);
+    wave_state->SetWeight(0.5f);
+    wave_state->SetLooped(true);
+    wave_state->SetBlendMode(ABM_ADDITIVE);
+    wave_state->SetLayer(1);
+
+    return animated_model;
+}
+
+// Кадр как в Octree::Update и View: анимация, перемещение персонажа, скиннинг
+static void update_character(AnimatedModel* animated_model, float time_step, const FrameInfo& frame)
+{
+    for (AnimationState* state : animated_model->GetAnimationStates())
+        state->AddTime(time_step);
+
+    animated_model->GetNode()->Translate(Vector3(0.f, 0.f, time_step));
+    animated_model->ApplyAnimation();
+    animated_model->UpdateGeometry(frame);
+}
+
+static i64 benchmark(Scene* scene, Model* model, Animation* walk, Animation* wave, bool node_free)
+{
+    const i32 num_characters = 1000;
+    const i32 num_frames = 20;
+    const float time_step = 1.f / 60.f;
+
+    Vector<AnimatedModel*> characters;
+    for (i32 i = 0; i < num_characters; ++i)
+    {
+        AnimatedModel* character = create_character(scene, model, walk, wave, node_free);
+        character->GetNode()->SetPosition(Vector3((float)(i % 32), 0.f, (float)(i / 32)));
+        characters.Push(character);
+    }
+
+    FrameInfo frame;
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < num_frames; ++i)
+    {
+        for (AnimatedModel* character : characters)
+            update_character(character, time_step, frame);
+    }
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    for (AnimatedModel* character : characters)
+        character->GetNode()->Remove();
+
+    return usec / num_frames;
+}
+
+// Кадр как в движке: LogicComponent'ы двигают персонажей, затем Octree::Update обновляет анимацию в рабочих потоках
+static i64 parallel_benchmark(Model* model, Animation* walk, Animation* wave, bool use_octree)
+{
+    const i32 num_characters = benchmarks_enabled() ? 1000 : 50;
+    const i32 num_frames = benchmarks_enabled() ? 20 : 2;
+
+    SharedPtr<Scene> scene(new Scene());
+    Octree* octree = scene->CreateComponent<Octree>();
+    Camera* camera = scene->CreateChild("Camera")->CreateComponent<Camera>();
+
+    Vector<AnimatedModel*> characters;
+    for (i32 i = 0; i < num_characters; ++i)
+    {
+        AnimatedModel* character = create_character(scene, model, walk, wave, true);
+        character->GetNode()->SetPosition(Vector3((float)(i % 32), 0.f, (float)(i / 32)));
+        characters.Push(character);
+    }
+
+    // Узел, прикреплённый к кости, записывается после параллельного прохода в главном потоке
+    Node* hand = characters[0]->GetNode()->GetChild(bone_name(num_bones - 1), true);
+    Node* sword = hand->CreateChild("Sword");
+    Vector3 initial_sword_position = sword->GetWorldPosition() - characters[0]->GetNode()->GetWorldPosition();
+
+    FrameInfo frame;
+    frame.camera_ = camera;
+    frame.timeStep_ = 1.f / 60.f;
+
+    i64 usec = 0;
+    for (i32 i = 1; i <= num_frames; ++i)
+    {
+        frame.frameNumber_ = i;
+
+        for (AnimatedModel* character : characters)
+        {
+            for (AnimationState* state : character->GetAnimationStates())
+                state->AddTime(frame.timeStep_);
+
+            character->GetNode()->Translate(Vector3(0.f, 0.f, frame.timeStep_));
+            character->MarkInView(i);
+        }
+
+        auto start_time = std::chrono::steady_clock::now();
+        if (use_octree)
+            octree->Update(frame);
+        else
+        {
+            for (AnimatedModel* character : characters)
+            {
+                character->Update(frame);
+                character->UpdateGeometry(frame);
+            }
+        }
+        usec += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    // Скиннинг уже посчитан, View нечего обновлять
+    for (i32 i = 1; i < characters.Size(); ++i)
+        assert(characters[i]->GetUpdateGeometryType() == UPDATE_NONE);
+
+    Vector3 sword_position = sword->GetWorldPosition() - characters[0]->GetNode()->GetWorldPosition();
+    assert(!sword_position.Equals(initial_sword_position));
+
+    return usec / num_frames;
+}
+
+static bool nearly_equal(const float* a, const float* b, i32 count, float epsilon)
+{
+    for (i32 i = 0; i < count; ++i)
+    {
+        if (Abs(a[i] - b[i]) > epsilon)
+            return false;
+    }
+
+    return true;
+}
+
+static void check_same_pose(AnimatedModel* node_model, AnimatedModel* node_free_model)
+{
+    Node* node = node_model->GetNode();
+    Node* node_free = node_free_model->GetNode();
+
+    for (i32 i = 0; i < num_bones; ++i)
+    {
+        Node* bone = node->GetChild(bone_name(i), true);
+        Node* node_free_bone = node_free->GetChild(bone_name(i), true);
+        Matrix3x4 transform = node->GetWorldTransform().Inverse() * bone->GetWorldTransform();
+        Matrix3x4 node_free_transform = node_free->GetWorldTransform().Inverse() * node_free_bone->GetWorldTransform();
+        assert(nearly_equal(transform.Data(), node_free_transform.Data(), 12, 1e-4f));
+    }
+
+    BoundingBox box = node_model->GetWorldBoundingBox().Transformed(node->GetWorldTransform().Inverse());
+    BoundingBox node_free_box = node_free_model->GetWorldBoundingBox().Transformed(node_free->GetWorldTransform().Inverse());
+    assert(nearly_equal(box.min_.Data(), node_free_box.min_.Data(), 3, 1e-3f));
+    assert(nearly_equal(box.max_.Data(), node_free_box.max_.Data(), 3, 1e-3f));
+}
+
+void test_graphics_animated_model()
+{
+    AnimatedModel::RegisterObject();
+    Camera::RegisterObject();
+    Octree::RegisterObject();
+
+    SharedPtr<Model> model = create_model();
+    SharedPtr<Animation> walk = create_animation("Walk", 0.f);
+    SharedPtr<Animation> wave = create_animation("Wave", 0.3f);
+    SharedPtr<Scene> scene(new Scene());
+    FrameInfo frame;
+
+    {
+        AnimatedModel* node_model = create_character(scene, model, walk, wave, false);
+        AnimatedModel* node_free_model = create_character(scene, model, walk, wave, true);
+        Node* node_free_bone = node_free_model->GetNode()->GetChild(bone_name(num_bones - 1), true);
+        Vector3 initial_position = node_free_bone->GetPosition();
+
+        for (i32 i = 0; i < 10; ++i)
+        {
+            update_character(node_model, 0.037f, frame);
+            update_character(node_free_model, 0.037f, frame);
+        }
+
+        // Узлы костей не обновляются, пока не понадобятся
+        assert(node_free_bone->GetPosition() == initial_position);
+        node_free_model->SyncBoneNodes();
+        assert(node_free_bone->GetPosition() != initial_position);
+        check_same_pose(node_model, node_free_model);
+
+        // Скиннинг уже посчитан по позе, синхронизация узлов костей не требует его повторно
+        assert(node_free_model->GetUpdateGeometryType() == UPDATE_NONE);
+
+        // Узел, прикреплённый к кости, включает синхронизацию каждый кадр
+        Node* sword = node_free_bone->CreateChild("Sword");
+        for (i32 i = 0; i < 5; ++i)
+        {
+            update_character(node_model, 0.037f, frame);
+            update_character(node_free_model, 0.037f, frame);
+        }
+        check_same_pose(node_model, node_free_model);
+
+        // После удаления узла синхронизация снова выключается
+        sword->Remove();
+        Vector3 synced_position = node_free_bone->GetPosition();
+        update_character(node_free_model, 0.037f, frame);
+        assert(node_free_bone->GetPosition() == synced_position);
+        update_character(node_model, 0.037f, frame);
+        node_free_model->SyncBoneNodes();
+        check_same_pose(node_model, node_free_model);
+
+        // Кость, управляемая пользователем, читается из узла
+        Node* node_bone = node_model->GetNode()->GetChild(bone_name(chain_length), true);
+        node_free_bone = node_free_model->GetNode()->GetChild(bone_name(chain_length), true);
+        node_model->GetSkeleton().GetBone(chain_length)->animated_ = false;
+        node_free_model->GetSkeleton().GetBone(chain_length)->animated_ = false;
+        node_bone->SetRotation(Quaternion(45.f, Vector3::UP));
+        node_free_bone->SetRotation(Quaternion(45.f, Vector3::UP));
+        update_character(node_model, 0.037f, frame);
+        update_character(node_free_model, 0.037f, frame);
+        node_free_model->SyncBoneNodes();
+        check_same_pose(node_model, node_free_model);
+
+        node_model->GetNode()->Remove();
+        node_free_model->GetNode()->Remove();
+    }
+
+    // Без замеров проверяется только многопоточное обновление
+    if (!benchmarks_enabled())
+    {
+        parallel_benchmark(model, walk, wave, true);
+        return;
+    }
+
+    i64 node_usec = benchmark(scene, model, walk, wave, false);
+    i64 node_free_usec = benchmark(scene, model, walk, wave, true);
+
+    i64 serial_usec = parallel_benchmark(model, walk, wave, false);
+    i64 parallel_usec = parallel_benchmark(model, walk, wave, true);
+
+    std::cout << "AnimatedModel (1000 characters, " << num_bones << " bones, 2 blended animations): bone nodes "
+              << node_usec << " us, node-free " << node_free_usec << " us per frame; animation and skinning "
+              << serial_usec << " us serial, " << parallel_usec << " us in " << DV_WORK_QUEUE.GetNumThreads() + 1
+              << " threads" << std::endl;
+}
@@ -0,0 +1,271 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/graphics/animation.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/math/random.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+static constexpr i32 num_tracks = 40;
+static constexpr i32 num_key_frames = 300;
+static constexpr float length = 10.f;
+
+// Виды дорожек: поворот, линейное перемещение, колебания всех каналов, неподвижная кость
+static SharedPtr<Animation> create_animation()
+{
+    SharedPtr<Animation> animation(new Animation());
+    animation->SetAnimationName("Test");
+    animation->SetLength(length);
+
+    for (i32 i = 0; i < num_tracks; ++i)
+    {
+        AnimationTrack* track = animation->CreateTrack("Bone" + String(i));
+        track->channelMask_ = AnimationChannels::Position | AnimationChannels::Rotation;
+        if (i % 4 == 2)
+            track->channelMask_ |= AnimationChannels::Scale;
+
+        for (i32 j = 0; j < num_key_frames; ++j)
+        {
+            AnimationKeyFrame key_frame;
+            key_frame.time_ = j * length / (num_key_frames - 1);
+            float phase = key_frame.time_ * (1.f + i * 0.1f);
+
+            switch (i % 4)
+            {
+            case 0:
+                key_frame.position_ = Vector3(0.f, 1.f, 0.f);
+                key_frame.rotation_ = Quaternion(Sin(phase * 36.f) * 60.f, Vector3(1.f, 0.5f, 0.f).Normalized());
+                break;
+
+            case 1:
+                key_frame.position_ = Vector3(key_frame.time_, 0.f, -key_frame.time_ * 0.5f);
+                key_frame.rotation_ = Quaternion(45.f, Vector3::UP);
+                break;
+
+            case 2:
+                key_frame.position_ = Vector3(Sin(phase * 40.f), Cos(phase * 25.f), 0.2f) * 3.f;
+                key_frame.rotation_ = Quaternion(phase * 10.f, phase * 25.f, Sin(phase * 50.f) * 90.f);
+                key_frame.scale_ = Vector3::ONE * (1.f + Sin(phase * 30.f) * 0.5f);
+                break;
+
+            default:
+                key_frame.position_ = Vector3(0.f, 0.f, 0.5f);
+                key_frame.rotation_ = Quaternion::IDENTITY;
+                break;
+            }
+
+            track->AddKeyFrame(key_frame);
+        }
+    }
+
+    return animation;
+}
+
+// Угол между поворотами в градусах. Вычисляется через расстояние между кватернионами, так как арккосинус
+// скалярного произведения неточен для малых углов
+static float rotation_error(const Quaternion& lhs, const Quaternion& rhs)
+{
+    Quaternion nearest = lhs.DotProduct(rhs) < 0.f ? -rhs : rhs;
+    Quaternion delta = lhs - nearest;
+    return 4.f * Asin(Sqrt(delta.DotProduct(delta)) * 0.5f);
+}
+
+// Максимальные отклонения сжатой анимации от исходной в случайные моменты времени
+static void measure_error(Animation* original, Animation* compressed, float& position_error, float& rotation_error_degrees,
+    float& scale_error)
+{
+    position_error = rotation_error_degrees = scale_error = 0.f;
+    SetRandomSeed(1);
+
+    for (i32 i = 0; i < num_tracks; ++i)
+    {
+        const AnimationTrack* original_track = original->GetTrack(i);
+        const AnimationTrack* compressed_track = compressed->GetTrack(original_track->nameHash_);
+        assert(compressed_track && compressed_track->IsCompressed());
+        i32 original_index = 0;
+        i32 compressed_index = 0;
+
+        for (i32 j = 0; j < 200; ++j)
+        {
+            float time = Random(length);
+            Vector3 position1, position2, scale1 = Vector3::ONE, scale2 = Vector3::ONE;
+            Quaternion rotation1, rotation2;
+
+            assert(original_track->Sample(time, length, true, original_index, position1, rotation1, scale1));
+            assert(compressed_track->Sample(time, length, true, compressed_index, position2, rotation2, scale2));
+
+            position_error = Max(position_error, (position1 - position2).Length());
+            rotation_error_degrees = Max(rotation_error_degrees, rotation_error(rotation1, rotation2));
+            scale_error = Max(scale_error, (scale1 - scale2).Length());
+        }
+    }
+}
+
+static i64 sample_benchmark(Animation* animation, i32 num_iterations, float& checksum)
+{
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (i32 i = 0; i < num_iterations; ++i)
+    {
+        float time = (i % 1000) * length / 1000.f;
+
+        for (i32 j = 0; j < animation->GetNumTracks(); ++j)
+        {
+            const AnimationTrack* track = animation->GetTrack(j);
+            i32 index = 0;
+            Vector3 position, scale;
+            Quaternion rotation;
+            track->Sample(time, length, true, index, position, rotation, scale);
+            checksum += position.x_ + rotation.w_;
+        }
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void test_graphics_animation_compression()
+{
+    // Кодирование поворотов в 48 бит
+    SetRandomSeed(42);
+    for (i32 i = 0; i < 1000; ++i)
+    {
+        Quaternion rotation(Random(-180.f, 180.f), Random(-180.f, 180.f), Random(-180.f, 180.f));
+        u16 encoded[3];
+        CompressedKeyFrames::EncodeRotation(rotation, encoded);
+        assert(rotation_error(rotation, CompressedKeyFrames::DecodeRotation(encoded)) < 0.02f);
+    }
+
+    SharedPtr<Animation> original = create_animation();
+    SharedPtr<Animation> compressed = original->Clone();
+    i32 original_memory = 0;
+    for (i32 i = 0; i < num_tracks; ++i)
+        original_memory += original->GetTrack(i)->GetKeyFrameMemoryUse();
+
+    AnimationCompressionSettings settings;
+    compressed->Compress(settings);
+    assert(compressed->IsCompressed());
+    assert(!original->IsCompressed());
+
+    i32 compressed_memory = 0;
+    for (i32 i = 0; i < num_tracks; ++i)
+        compressed_memory += compressed->GetTrack(i)->GetKeyFrameMemoryUse();
+    assert(compressed_memory * 4 < original_memory);
+    assert(compressed->GetMemoryUse() * 4 < original_memory);
+
+    // Линейная дорожка сводится к двум ключам, неподвижная - к одному
+    assert(compressed->GetTrack(String("Bone1"))->GetNumKeyFrames() == 2);
+    assert(compressed->GetTrack(String("Bone3"))->GetNumKeyFrames() == 1);
+    assert(compressed->GetTrack(String("Bone3"))->compressedKeyFrames_.positions_.Empty());
+    assert(compressed->GetTrack(String("Bone0"))->compressedKeyFrames_.positions_.Empty());
+    assert(!compressed->GetTrack(String("Bone0"))->compressedKeyFrames_.rotations_.Empty());
+
+    // Ошибка в любой момент времени не больше допуска с учётом квантования
+    float position_error, rotation_error_degrees, scale_error;
+    measure_error(original, compressed, position_error, rotation_error_degrees, scale_error);
+    assert(position_error < settings.positionTolerance_ + 0.001f);
+    assert(rotation_error_degrees < settings.rotationTolerance_ + 0.02f);
+    assert(scale_error < settings.scaleTolerance_ + 0.001f);
+
+    // Изменение ключей сжатой дорожки сначала распаковывает её
+    {
+        SharedPtr<Animation> edited = compressed->Clone();
+        AnimationTrack* track = edited->GetTrack(String("Bone1"));
+        assert(track->IsCompressed());
+
+        AnimationKeyFrame key_frame = *track->GetKeyFrame(1);
+        assert(!track->IsCompressed() && track->GetNumKeyFrames() == 2);
+        key_frame.time_ = length * 0.5f;
+        key_frame.position_ = Vector3::ZERO;
+        track->AddKeyFrame(key_frame);
+        assert(track->GetNumKeyFrames() == 3 && track->GetKeyFrame(1)->position_ == Vector3::ZERO);
+
+        track = edited->GetTrack(String("Bone0"));
+        i32 num_key_frames = track->GetNumKeyFrames();
+        track->SetKeyFrame(0, *track->GetKeyFrame(0));
+        assert(!track->IsCompressed() && track->GetNumKeyFrames() == num_key_frames);
+
+        track = edited->GetTrack(String("Bone2"));
+        track->RemoveAllKeyFrames();
+        assert(!track->IsCompressed() && track->GetNumKeyFrames() == 0);
+    }
+
+    // Сохранение и загрузка в сжатом формате без потерь
+    {
+        VectorBuffer buffer;
+        assert(compressed->Save(buffer));
+        assert(buffer.GetSize() * 4 < original_memory);
+        buffer.Seek(0);
+
+        SharedPtr<Animation> loaded(new Animation());
+        assert(loaded->Load(buffer));
+        assert(loaded->IsCompressed());
+        assert(loaded->GetNumTracks() == num_tracks);
+        assert(loaded->GetMemoryUse() == compressed->GetMemoryUse());
+
+        for (i32 i = 0; i < num_tracks; ++i)
+        {
+            const AnimationTrack* track = compressed->GetTrack(i);
+            const AnimationTrack* loaded_track = loaded->GetTrack(track->nameHash_);
+            assert(loaded_track->channelMask_ == track->channelMask_);
+            assert(loaded_track->GetNumKeyFrames() == track->GetNumKeyFrames());
+
+            for (i32 j = 0; j < track->GetNumKeyFrames(); ++j)
+            {
+                assert(loaded_track->compressedKeyFrames_.GetTime(j) == track->compressedKeyFrames_.GetTime(j));
+                assert(loaded_track->compressedKeyFrames_.GetPosition(j) == track->compressedKeyFrames_.GetPosition(j));
+                assert(loaded_track->compressedKeyFrames_.GetRotation(j) == track->compressedKeyFrames_.GetRotation(j));
+                assert(loaded_track->compressedKeyFrames_.GetScale(j) == track->compressedKeyFrames_.GetScale(j));
+            }
+        }
+    }
+
+    // Частично сжатая анимация сохраняется в обычном формате
+    {
+        SharedPtr<Animation> partial = original->Clone();
+        partial->GetTrack(String("Bone2"))->Compress(length);
+        assert(!partial->IsCompressed());
+
+        VectorBuffer buffer;
+        assert(partial->Save(buffer));
+        buffer.Seek(0);
+
+        SharedPtr<Animation> loaded(new Animation());
+        assert(loaded->Load(buffer));
+        assert(!loaded->IsCompressed());
+        assert(loaded->GetTrack(String("Bone2"))->GetNumKeyFrames() == partial->GetTrack(String("Bone2"))->GetNumKeyFrames());
+        assert(loaded->GetTrack(String("Bone0"))->GetNumKeyFrames() == num_key_frames);
+    }
+
+    // После распаковки ключи снова можно редактировать
+    {
+        SharedPtr<Animation> decompressed = compressed->Clone();
+        decompressed->Decompress();
+        assert(!decompressed->IsCompressed());
+        assert(decompressed->GetTrack(String("Bone1"))->keyFrames_.Size() == 2);
+        assert(decompressed->GetTrack(String("Bone1"))->GetKeyFrame(1)->position_.Equals(Vector3(length, 0.f, -length * 0.5f)));
+    }
+
+    // Замер производительности выборки
+    const i32 num_iterations = benchmarks_enabled() ? 2000 : 100;
+    float checksum = 0.f;
+    i64 original_usec = sample_benchmark(original, num_iterations, checksum);
+    i64 compressed_usec = sample_benchmark(compressed, num_iterations, checksum);
+    assert(checksum == checksum);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Animation compression (" << num_tracks << " tracks, " << num_key_frames << " keyframes): memory "
+                  << original_memory << " -> " << compressed_memory << " bytes, max error " << position_error << " / "
+                  << rotation_error_degrees << " deg / " << scale_error << ", sampling " << original_usec << " us -> "
+                  << compressed_usec << " us" << std::endl;
+    }
+}
@@ -0,0 +1,224 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/graphics/batch.h>
+#include <dviglo/math/random.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Параметры Batch, от которых зависит сортировка
+struct CapturedBatch
+{
+    hash64 sort_key;
+    float distance;
+    i8 render_order;
+};
+
+// Очередь как в большой сцене: немного шейдеров и источников света, больше материалов и моделей.
+// Все расстояния разные, чтобы порядок сортировки был однозначным
+static Vector<CapturedBatch> capture_queue(i32 num_batches)
+{
+    Vector<CapturedBatch> capture;
+
+    for (i32 i = 0; i < num_batches; ++i)
+    {
+        hash64 shader = Random(20) | (Random(1.f) < 0.2f ? 0x8000u : 0u);
+        hash64 light_queue = Random(1.f) < 0.5f ? 0u : Random(8) + 1;
+        hash64 material = Random(300) + 1;
+        hash64 geometry = Random(150) + 1;
+
+        CapturedBatch batch;
+        batch.sort_key = (shader << 48u) | (light_queue << 32u) | (material << 16u) | geometry;
+        batch.distance = i * 0.01f + 1.f;
+        batch.render_order = Random(1.f) < 0.05f ? (i8)-10 : (i8)DEFAULT_RENDER_ORDER;
+        capture.Push(batch);
+    }
+
+    // Порядок добавления в очередь не связан с расстоянием
+    for (i32 i = capture.Size() - 1; i > 0; --i)
+        std::swap(capture[i], capture[Random(i + 1)]);
+
+    return capture;
+}
+
+static void replay(BatchQueue& queue, const Vector<CapturedBatch>& capture)
+{
+    queue.Clear(0);
+    queue.batches_.Resize(capture.Size());
+
+    for (i32 i = 0; i < capture.Size(); ++i)
+    {
+        queue.batches_[i].sortKey_ = capture[i].sort_key;
+        queue.batches_[i].distance_ = capture[i].distance;
+        queue.batches_[i].renderOrder_ = capture[i].render_order;
+    }
+}
+
+// Прежняя реализация сортировки на сравнениях
+
+static bool compare_state(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    else if (lhs->sortKey_ != rhs->sortKey_)
+        return lhs->sortKey_ < rhs->sortKey_;
+    else
+        return lhs->distance_ < rhs->distance_;
+}
+
+static bool compare_front_to_back(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    else if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ < rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+static bool compare_back_to_front(Batch* lhs, Batch* rhs)
+{
+    if (lhs->renderOrder_ != rhs->renderOrder_)
+        return lhs->renderOrder_ < rhs->renderOrder_;
+    else if (lhs->distance_ != rhs->distance_)
+        return lhs->distance_ > rhs->distance_;
+    else
+        return lhs->sortKey_ < rhs->sortKey_;
+}
+
+static void reference_sort_back_to_front(BatchQueue& queue)
+{
+    queue.sortedBatches_.Clear();
+    for (Batch& batch : queue.batches_)
+        queue.sortedBatches_.Push(&batch);
+
+    std::sort(queue.sortedBatches_.Begin(), queue.sortedBatches_.End(), compare_back_to_front);
+}
+
+static void reference_sort_front_to_back(BatchQueue& queue)
+{
+    queue.sortedBatches_.Clear();
+    for (Batch& batch : queue.batches_)
+        queue.sortedBatches_.Push(&batch);
+
+    Vector<Batch*>& batches = queue.sortedBatches_;
+    std::sort(batches.Begin(), batches.End(), compare_front_to_back);
+
+    HashMap<hash32, hash32> shader_remapping;
+    HashMap<hash16, hash16> material_remapping;
+    HashMap<hash16, hash16> geometry_remapping;
+
+    for (Batch* batch : batches)
+    {
+        hash32 shader_id = (hash32)(batch->sortKey_ >> 32u);
+        if (!shader_remapping.Contains(shader_id))
+            shader_remapping[shader_id] = (hash32)shader_remapping.Size() | (shader_id & 0x80000000);
+
+        hash16 material_id = (hash16)((batch->sortKey_ & 0xffff0000) >> 16u);
+        if (!material_remapping.Contains(material_id))
+            material_remapping[material_id] = (hash16)material_remapping.Size();
+
+        hash16 geometry_id = (hash16)(batch->sortKey_ & 0xffffu);
+        if (!geometry_remapping.Contains(geometry_id))
+            geometry_remapping[geometry_id] = (hash16)geometry_remapping.Size();
+
+        batch->sortKey_ = (((hash64)shader_remapping[shader_id]) << 32u) | (((hash64)material_remapping[material_id]) << 16u) |
+                          geometry_remapping[geometry_id];
+    }
+
+    std::sort(batches.Begin(), batches.End(), compare_state);
+}
+
+// Очереди должны быть отсортированы одинаково
+static void check_equal(BatchQueue& expected, BatchQueue& actual)
+{
+    assert(expected.sortedBatches_.Size() == actual.sortedBatches_.Size());
+
+    for (i32 i = 0; i < expected.sortedBatches_.Size(); ++i)
+    {
+        assert(expected.sortedBatches_[i] - &expected.batches_[0] == actual.sortedBatches_[i] - &actual.batches_[0]);
+        assert(expected.sortedBatches_[i]->sortKey_ == actual.sortedBatches_[i]->sortKey_);
+    }
+}
+
+template <class SortFunction>
+static i64 benchmark(BatchQueue& queue, const Vector<CapturedBatch>& capture, i32 num_iterations, SortFunction sort)
+{
+    i64 usec = 0;
+
+    for (i32 i = 0; i < num_iterations; ++i)
+    {
+        replay(queue, capture);
+
+        auto start_time = std::chrono::steady_clock::now();
+        sort(queue);
+        usec += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    return usec / num_iterations;
+}
+
+void test_graphics_batch_queue()
+{
+    SetRandomSeed(1);
+    Vector<CapturedBatch> capture = capture_queue(20000);
+
+    BatchQueue expected;
+    BatchQueue actual;
+
+    replay(expected, capture);
+    reference_sort_front_to_back(expected);
+    replay(actual, capture);
+    actual.SortFrontToBack();
+    check_equal(expected, actual);
+
+    replay(expected, capture);
+    reference_sort_back_to_front(expected);
+    replay(actual, capture);
+    actual.SortBackToFront();
+    check_equal(expected, actual);
+
+    // Группы инстансинга при сортировке от дальних к ближним упорядочиваются только по render order
+    {
+        BatchQueue queue;
+        queue.Clear(0);
+
+        for (i32 i = 0; i < 1000; ++i)
+        {
+            Batch batch;
+            batch.geometry_ = reinterpret_cast<Geometry*>((uintptr_t)(i + 1) * 16);
+            batch.renderOrder_ = (i8)(Random(256) - 128);
+            queue.batchGroups_[BatchGroupKey(batch)] = BatchGroup(batch);
+        }
+
+        queue.SortBackToFront();
+        assert(queue.sortedBatchGroups_.Size() == 1000);
+
+        for (i32 i = 1; i < queue.sortedBatchGroups_.Size(); ++i)
+            assert(queue.sortedBatchGroups_[i - 1]->renderOrder_ <= queue.sortedBatchGroups_[i]->renderOrder_);
+    }
+
+    if (!benchmarks_enabled())
+        return;
+
+    // Замер производительности
+    const i32 num_iterations = 20;
+
+    i64 reference_front_to_back_usec = benchmark(expected, capture, num_iterations, reference_sort_front_to_back);
+    i64 front_to_back_usec = benchmark(actual, capture, num_iterations, [](BatchQueue& queue) { queue.SortFrontToBack(); });
+    i64 reference_back_to_front_usec = benchmark(expected, capture, num_iterations, reference_sort_back_to_front);
+    i64 back_to_front_usec = benchmark(actual, capture, num_iterations, [](BatchQueue& queue) { queue.SortBackToFront(); });
+
+    std::cout << "Batch queue (" << capture.Size() << " batches): front to back " << reference_front_to_back_usec
+              << " us std::sort, " << front_to_back_usec << " us radix; back to front " << reference_back_to_front_usec
+              << " us std::sort, " << back_to_front_usec << " us radix" << std::endl;
+}
@@ -0,0 +1,188 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/graphics/instancing_storage.h>
+
+#include <cstring>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Размер экземпляра с одним дополнительным элементом
+static constexpr i32 stride = sizeof(Matrix3x4) + sizeof(Vector4);
+
+// Группа экземпляров в своей очереди
+struct TestGroup
+{
+    BatchQueue queue;
+    Vector<Matrix3x4> transforms;
+    Vector<Vector4> extra_data;
+};
+
+static void init_group(TestGroup& group, i32 num_instances, bool with_extra_data)
+{
+    group.transforms.Clear();
+    group.extra_data.Clear();
+    for (i32 i = 0; i < num_instances; ++i)
+    {
+        group.transforms.Push(Matrix3x4(Vector3(i * 2.f, 0.f, (float)num_instances), Quaternion::IDENTITY, 1.f));
+        group.extra_data.Push(Vector4((float)i, 1.f, 2.f, 3.f));
+    }
+
+    Batch batch;
+    batch.geometryType_ = GEOM_INSTANCED;
+    batch.worldTransform_ = &group.transforms[0];
+    batch.numWorldTransforms_ = num_instances;
+    batch.instancingData_ = with_extra_data ? &group.extra_data[0] : nullptr;
+
+    group.queue.Clear(0);
+    BatchGroup batch_group(batch);
+    for (i32 i = 0; i < num_instances; ++i)
+    {
+        // Дополнительные данные у каждого экземпляра свои
+        Batch instance = batch;
+        instance.worldTransform_ = &group.transforms[i];
+        instance.numWorldTransforms_ = 1;
+        instance.instancingData_ = with_extra_data ? &group.extra_data[i] : nullptr;
+        batch_group.AddTransforms(instance);
+    }
+    group.queue.batchGroups_[BatchGroupKey(batch)] = batch_group;
+}
+
+// Заполняет хранилище как View::PrepareInstancingBuffer() и переносит изменения в копию буфера на GPU
+static void render_frame(InstancingStorage& storage, Vector<u8>& gpu_buffer, Vector<TestGroup*>& groups, i32 frame_number)
+{
+    storage.BeginFrame(frame_number);
+    for (TestGroup* group : groups)
+        group->queue.SetInstancingData(storage);
+
+    if (gpu_buffer.Size() < storage.GetSize() * stride)
+    {
+        gpu_buffer.Resize(storage.GetSize() * stride);
+        storage.Invalidate();
+    }
+
+    storage.Flush();
+    for (const IntVector2& range : storage.GetUploadRanges())
+        memcpy(&gpu_buffer[range.x_ * stride], storage.GetData() + range.x_ * stride, range.y_ * stride);
+}
+
+// Данные в буфере на GPU должны совпадать с данными экземпляров
+static void check_gpu_buffer(const Vector<u8>& gpu_buffer, const Vector<TestGroup*>& groups)
+{
+    for (const TestGroup* group : groups)
+    {
+        const BatchGroup& batch_group = group->queue.batchGroups_.Begin()->second_;
+        assert(batch_group.startIndex_ != NINDEX);
+
+        for (i32 i = 0; i < group->transforms.Size(); ++i)
+        {
+            const u8* instance = &gpu_buffer[(batch_group.startIndex_ + i) * stride];
+            assert(memcmp(instance, &group->transforms[i], sizeof(Matrix3x4)) == 0);
+            if (batch_group.instances_[i].instancingData_)
+                assert(memcmp(instance + sizeof(Matrix3x4), &group->extra_data[i], sizeof(Vector4)) == 0);
+        }
+    }
+}
+
+void test_graphics_instancing_storage()
+{
+    InstancingStorage storage;
+    storage.SetStride(stride);
+    Vector<u8> gpu_buffer;
+
+    TestGroup static_groups[4];
+    for (i32 i = 0; i < 4; ++i)
+        init_group(static_groups[i], 250, i % 2 == 0);
+
+    TestGroup moving_group;
+    init_group(moving_group, 100, true);
+
+    Vector<TestGroup*> groups;
+    for (TestGroup& group : static_groups)
+        groups.Push(&group);
+    groups.Push(&moving_group);
+
+    i32 frame_number = 1;
+
+    // В первом кадре загружается всё
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    check_gpu_buffer(gpu_buffer, groups);
+    assert(storage.GetNumInstances() == 1100);
+    assert(storage.GetNumChangedInstances() == 1100);
+    assert(storage.GetUploadedBytes() >= 1100 * stride);
+
+    // Ничего не изменилось - ничего не загружается
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    check_gpu_buffer(gpu_buffer, groups);
+    assert(storage.GetNumChangedInstances() == 0);
+    assert(storage.GetUploadedBytes() == 0);
+
+    // Представление, использующее результаты другого представления в том же кадре, тоже ничего не загружает
+    render_frame(storage, gpu_buffer, groups, frame_number - 1);
+    assert(storage.GetUploadedBytes() == 0);
+
+    // Загружаются только сдвинутые экземпляры
+    i64 uploaded_bytes = 0;
+    const i32 num_frames = 60;
+    for (i32 i = 0; i < num_frames; ++i)
+    {
+        for (i32 j = 0; j < moving_group.transforms.Size(); j += 10)
+            moving_group.transforms[j].SetTranslation(Vector3((float)i, (float)j, 0.f));
+
+        render_frame(storage, gpu_buffer, groups, frame_number++);
+        check_gpu_buffer(gpu_buffer, groups);
+        assert(storage.GetNumChangedInstances() == 10);
+        assert(storage.GetUploadedBytes() <= 100 * stride);
+        uploaded_bytes += storage.GetUploadedBytes();
+    }
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Instancing storage (1100 instances, 10 moving): " << uploaded_bytes / num_frames << " bytes uploaded per frame, "
+                  << 1100 * stride << " bytes with full rewrite" << std::endl;
+    }
+
+    // Слайс пропавшей группы освобождается и достаётся новой группе подходящего размера
+    i32 size = storage.GetSize();
+    groups.Erase(2);
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    assert(storage.GetNumSlices() == 5);
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    assert(storage.GetNumSlices() == 4);
+
+    TestGroup new_group;
+    init_group(new_group, 200, false);
+    groups.Push(&new_group);
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    check_gpu_buffer(gpu_buffer, groups);
+    assert(storage.GetSize() == size);
+    assert(storage.GetNumChangedInstances() == 200);
+
+    // Выросшая группа переезжает в новый слайс
+    init_group(moving_group, 300, true);
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    check_gpu_buffer(gpu_buffer, groups);
+    assert(storage.GetSize() > size);
+
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    assert(storage.GetUploadedBytes() == 0);
+
+    // Когда почти всё хранилище свободно, оставшиеся слайсы сдвигаются к началу и хранилище уменьшается
+    size = storage.GetSize();
+    groups.Resize(1);
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    assert(storage.GetNumSlices() == 1);
+    assert(storage.GetSize() == 256);
+    assert(storage.GetUploadedBytes() >= 256 * stride);
+    check_gpu_buffer(gpu_buffer, groups);
+
+    render_frame(storage, gpu_buffer, groups, frame_number++);
+    assert(storage.GetUploadedBytes() == 0);
+}
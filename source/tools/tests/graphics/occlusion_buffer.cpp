@@ -0,0 +1,159 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/context.h>
+#include <dviglo/graphics/camera.h>
+#include <dviglo/graphics/occlusion_buffer.h>
+#include <dviglo/math/random.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Куб единичного размера
+static const Vector3 box_vertices[] =
+{
+    Vector3(-0.5f, -0.5f, -0.5f), Vector3(0.5f, -0.5f, -0.5f), Vector3(0.5f, 0.5f, -0.5f), Vector3(-0.5f, 0.5f, -0.5f),
+    Vector3(-0.5f, -0.5f, 0.5f), Vector3(0.5f, -0.5f, 0.5f), Vector3(0.5f, 0.5f, 0.5f), Vector3(-0.5f, 0.5f, 0.5f)
+};
+
+static const u16 box_indices[] =
+{
+    0, 2, 1, 0, 3, 2, // -Z
+    4, 5, 6, 4, 6, 7, // +Z
+    0, 4, 7, 0, 7, 3, // -X
+    1, 2, 6, 1, 6, 5, // +X
+    3, 7, 6, 3, 6, 2, // +Y
+    0, 1, 5, 0, 5, 4  // -Y
+};
+
+static constexpr i32 num_box_triangles = 12;
+
+static SharedPtr<OcclusionBuffer> create_buffer(Camera* camera, OcclusionMode mode, bool threaded)
+{
+    SharedPtr<OcclusionBuffer> buffer(new OcclusionBuffer());
+    buffer->SetSize(256, RoundToInt(256 / camera->GetAspectRatio()), threaded);
+    buffer->SetView(camera);
+    buffer->SetMode(mode);
+    buffer->SetMaxTriangles(M_MAX_UNSIGNED);
+    buffer->SetCullMode(CULL_NONE);
+    return buffer;
+}
+
+static void draw(OcclusionBuffer* buffer, const Vector<Matrix3x4>& occluders)
+{
+    buffer->Clear();
+    for (const Matrix3x4& transform : occluders)
+        buffer->AddTriangles(transform, box_vertices, sizeof(Vector3), box_indices, sizeof(u16), 0, num_box_triangles * 3);
+    buffer->DrawTriangles();
+    buffer->BuildDepthHierarchy();
+}
+
+// Возвращает скорость растеризации в треугольниках за миллисекунду
+static float benchmark(OcclusionBuffer* buffer, const Vector<Matrix3x4>& occluders, i32 num_frames)
+{
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (i32 i = 0; i < num_frames; ++i)
+        draw(buffer, occluders);
+
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    return 1000.f * occluders.Size() * num_box_triangles * num_frames / Max(usec, (i64)1);
+}
+
+void test_graphics_occlusion_buffer()
+{
+    Camera::RegisterObject();
+
+    SharedPtr<Scene> scene(new Scene());
+    Node* camera_node = scene->CreateChild("Camera");
+    camera_node->SetPosition(Vector3(0.f, 15.f, -110.f));
+    camera_node->SetRotation(Quaternion(10.f, 0.f, 0.f));
+    Camera* camera = camera_node->CreateComponent<Camera>();
+    camera->SetFov(45.f);
+    camera->SetAspectRatio(16.f / 9.f);
+    camera->SetFarClip(300.f);
+
+    // Город из коробок разной высоты
+    SetRandomSeed(1);
+    Vector<Matrix3x4> occluders;
+    for (i32 z = -32; z < 32; ++z)
+    {
+        for (i32 x = -32; x < 32; ++x)
+        {
+            Vector3 size(Random(1.f, 2.5f), Random(2.f, 20.f), Random(1.f, 2.5f));
+            Vector3 position(x * 3.f, size.y_ * 0.5f, z * 3.f);
+            occluders.Push(Matrix3x4(position, Quaternion(Random(90.f), Vector3::UP), size));
+        }
+    }
+
+    SharedPtr<OcclusionBuffer> scanline = create_buffer(camera, OCCLUSION_SCANLINE, false);
+    SharedPtr<OcclusionBuffer> tiled = create_buffer(camera, OCCLUSION_TILED, false);
+    SharedPtr<OcclusionBuffer> threaded_tiled = create_buffer(camera, OCCLUSION_TILED, true);
+    assert(tiled->GetMode() == OCCLUSION_TILED);
+
+    draw(scanline, occluders);
+    draw(tiled, occluders);
+    draw(threaded_tiled, occluders);
+
+    // Точки выборки совпадают, но глубина интерполируется по-разному, поэтому сравнение с допуском
+    i32 num_pixels = tiled->GetWidth() * tiled->GetHeight();
+    i32 num_mismatches = 0;
+    for (i32 i = 0; i < num_pixels; ++i)
+    {
+        int a = scanline->GetBuffer()[i];
+        int b = tiled->GetBuffer()[i];
+        if (Abs(a - b) > Max(a, b) / 100)
+            ++num_mismatches;
+    }
+    assert(num_mismatches < num_pixels / 100);
+
+    // Порядок треугольников в потоках не влияет на результат
+    assert(memcmp(tiled->GetBuffer(), threaded_tiled->GetBuffer(), num_pixels * sizeof(int)) == 0);
+
+    // Уровни иерархии, построенные по ходу растеризации тайлов, должны совпадать с построенными обычным способом
+    SharedPtr<OcclusionBuffer> copy = create_buffer(camera, OCCLUSION_SCANLINE, false);
+    copy->Clear();
+    memcpy(copy->GetBuffer(), tiled->GetBuffer(), num_pixels * sizeof(int));
+    copy->BuildDepthHierarchy();
+
+    i32 num_occluded = 0;
+    i32 num_disagreements = 0;
+    for (i32 i = 0; i < 2000; ++i)
+    {
+        Vector3 center(Random(-96.f, 96.f), Random(0.f, 10.f), Random(-96.f, 96.f));
+        BoundingBox box(center - Vector3::ONE * 0.5f, center + Vector3::ONE * 0.5f);
+
+        bool visible = tiled->IsVisible(box);
+        assert(visible == copy->IsVisible(box));
+        assert(visible == threaded_tiled->IsVisible(box));
+
+        if (!visible)
+            ++num_occluded;
+        if (visible != scanline->IsVisible(box))
+            ++num_disagreements;
+    }
+    assert(num_occluded > 100);
+    assert(num_disagreements < 2000 / 100);
+
+    if (!benchmarks_enabled())
+        return;
+
+    // Замер производительности
+    SharedPtr<OcclusionBuffer> threaded_scanline = create_buffer(camera, OCCLUSION_SCANLINE, true);
+    const i32 num_frames = 20;
+
+    std::cout << "Occlusion buffer (" << occluders.Size() * num_box_triangles << " triangles): scanline "
+              << benchmark(scanline, occluders, num_frames) << " tri/ms, tiled "
+              << benchmark(tiled, occluders, num_frames) << " tri/ms, threaded scanline "
+              << benchmark(threaded_scanline, occluders, num_frames) << " tri/ms, threaded tiled "
+              << benchmark(threaded_tiled, occluders, num_frames) << " tri/ms" << std::endl;
+}
@@ -0,0 +1,373 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/context.h>
+#include <dviglo/graphics/octree.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+// Простейший Drawable с кубом единичного размера
+class TestBox : public Drawable
+{
+    DV_OBJECT(TestBox, Drawable);
+
+public:
+    TestBox() :
+        Drawable(DrawableTypes::Geometry)
+    {
+        boundingBox_ = BoundingBox(-0.5f, 0.5f);
+    }
+
+    static void RegisterObject()
+    {
+        DV_CONTEXT.RegisterFactory<TestBox>();
+        DV_COPY_BASE_ATTRIBUTES(Drawable);
+    }
+
+protected:
+    void OnWorldBoundingBoxUpdate() override
+    {
+        worldBoundingBox_ = boundingBox_.Transformed(node_->GetWorldTransform());
+    }
+};
+
+// Запрос, который проверяет каждый Drawable по отдельности, как это делалось до появления DrawableBounds
+class ScalarFrustumQuery : public OctreeQuery
+{
+public:
+    ScalarFrustumQuery(Vector<Drawable*>& result, const Frustum& frustum) :
+        OctreeQuery(result, DrawableTypes::Any, DEFAULT_VIEWMASK),
+        frustum_(frustum)
+    {
+    }
+
+    Intersection TestOctant(const BoundingBox& box, bool inside) override
+    {
+        return inside ? INSIDE : frustum_.IsInside(box);
+    }
+
+    void TestDrawables(Drawable** start, Drawable** end, bool inside) override
+    {
+        for (; start != end; ++start)
+        {
+            if ((*start)->GetViewMask() & viewMask_)
+            {
+                if (inside || frustum_.IsInsideFast((*start)->GetWorldBoundingBox()))
+                    result_.Push(*start);
+            }
+        }
+    }
+
+    Frustum frustum_;
+};
+
+} // namespace
+
+static Frustum camera_frustum(float yaw)
+{
+    // Камера как в примере HugeObjectCount
+    Frustum frustum;
+    Matrix3x4 transform(Vector3(0.f, 10.f, -100.f), Quaternion(10.f, yaw, 0.f), 1.f);
+    frustum.Define(45.f, 16.f / 9.f, 1.f, 0.1f, 300.f, transform);
+    return frustum;
+}
+
+static void update_octree(Octree* octree)
+{
+    FrameInfo frame{};
+    octree->Update(frame);
+}
+
+// Результаты SIMD-запроса должны совпадать с поэлементной проверкой
+static void check_frustum(Octree* octree, const Frustum& frustum)
+{
+    Vector<Drawable*> expected;
+    ScalarFrustumQuery scalar_query(expected, frustum);
+    octree->GetDrawables(scalar_query);
+
+    Vector<Drawable*> actual;
+    FrustumOctreeQuery query(actual, frustum, DrawableTypes::Geometry);
+    octree->GetDrawables(query);
+
+    assert(actual == expected);
+}
+
+// Каждый Drawable должен полностью помещаться в свой октант
+static void check_fit(Octree* octree, const Vector<Node*>& nodes)
+{
+    for (Node* node : nodes)
+    {
+        Drawable* drawable = node->GetComponent<TestBox>();
+        Octant* octant = drawable->GetOctant();
+        assert(octant->GetRoot() == octree);
+        assert(octant == octree || octant->GetCullingBox().IsInside(drawable->GetWorldBoundingBox()) == INSIDE);
+    }
+}
+
+// Вращает все объекты как в примере HugeObjectCount и двигает их по кругу.
+// Возвращает время обновления октодерева в микросекундах
+static i64 animate(Octree* octree, const Vector<Node*>& nodes, i32 num_frames)
+{
+    i64 usec = 0;
+
+    for (i32 frame = 0; frame < num_frames; ++frame)
+    {
+        Quaternion rotation(15.f / 60.f, Vector3::FORWARD);
+        float angle = frame * 360.f / num_frames;
+        Vector3 offset(Cos(angle) * 0.05f, 0.f, Sin(angle) * 0.05f);
+
+        for (Node* node : nodes)
+        {
+            node->Rotate(rotation);
+            node->Translate(offset, TransformSpace::World);
+        }
+
+        // Мировые AABB пересчитываются заранее, чтобы замерялась только перевставка
+        for (Node* node : nodes)
+            node->GetComponent<TestBox>()->GetWorldBoundingBox();
+
+        auto start_time = std::chrono::steady_clock::now();
+        update_octree(octree);
+        usec += std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    return usec;
+}
+
+template <class Query>
+static i64 benchmark(Octree* octree, i32 num_queries, i32& num_found)
+{
+    Vector<Drawable*> result;
+    num_found = 0;
+
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (i32 i = 0; i < num_queries; ++i)
+    {
+        Query query(result, camera_frustum(i * 360.f / num_queries));
+        octree->GetDrawables(query);
+        num_found += result.Size();
+    }
+
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+}
+
+void test_graphics_octree()
+{
+    Drawable::RegisterObject();
+    TestBox::RegisterObject();
+    Octree::RegisterObject();
+
+    SharedPtr<Scene> scene(new Scene());
+    Octree* octree = scene->CreateComponent<Octree>();
+    Vector<Node*> nodes;
+
+    // Сцена из примера HugeObjectCount
+    for (i32 y = -125; y < 125; ++y)
+    {
+        for (i32 x = -125; x < 125; ++x)
+        {
+            Node* node = scene->CreateChild("Box");
+            node->SetPosition(Vector3(x * 0.3f, 0.f, y * 0.3f));
+            node->SetScale(0.25f);
+            node->CreateComponent<TestBox>();
+            nodes.Push(node);
+        }
+    }
+
+    update_octree(octree);
+
+    for (i32 i = 0; i < 16; ++i)
+        check_frustum(octree, camera_frustum(i * 22.5f));
+
+    // Сфера и AABB
+    {
+        Vector<Drawable*> result;
+
+        SphereOctreeQuery sphere_query(result, Sphere(Vector3(0.f, 0.f, 0.f), 1.f));
+        octree->GetDrawables(sphere_query);
+        assert(result.Size() == 7 * 7 - 4); // Квадрат 7x7 кубов без угловых
+
+        BoxOctreeQuery box_query(result, BoundingBox(Vector3(0.f, -1.f, 0.f), Vector3(0.9f, 1.f, 0.9f)));
+        octree->GetDrawables(box_query);
+        assert(result.Size() == 4 * 4);
+    }
+
+    // Изменённый AABB должен учитываться сразу, ещё до обновления октодерева
+    {
+        Node* node = nodes[10 * 250 + 10];
+        Vector3 new_position = node->GetPosition() + Vector3(0.f, 0.2f, 0.f);
+        node->SetPosition(new_position);
+
+        Vector<Drawable*> result;
+        SphereOctreeQuery query(result, Sphere(new_position + Vector3(0.f, 0.1f, 0.f), 0.01f));
+        octree->GetDrawables(query);
+        assert(result.Size() == 1 && result[0]->GetNode() == node);
+    }
+
+    // Маски видимости и типы объектов хранятся в октантах и должны обновляться при изменении
+    {
+        Drawable* masked = nodes[20 * 250 + 20]->GetComponent<TestBox>();
+        Drawable* attr_masked = nodes[20 * 250 + 21]->GetComponent<TestBox>();
+        masked->SetViewMask(0);
+        attr_masked->SetAttribute("View Mask", 0u);
+        assert(attr_masked->GetViewMask() == 0);
+
+        Vector<Drawable*> result;
+        AllContentOctreeQuery all_query(result, DrawableTypes::Any, DEFAULT_VIEWMASK);
+        octree->GetDrawables(all_query);
+        assert(result.Size() == nodes.Size() - 2 && !result.Contains(masked) && !result.Contains(attr_masked));
+
+        for (i32 i = 0; i < 16; ++i)
+            check_frustum(octree, camera_frustum(i * 22.5f));
+
+        masked->SetViewMask(2);
+        attr_masked->SetAttribute("View Mask", 2u);
+        SphereOctreeQuery sphere_query(result, Sphere(masked->GetNode()->GetWorldPosition(), 0.1f), DrawableTypes::Geometry, 2);
+        octree->GetDrawables(sphere_query);
+        assert(result.Size() == 1 && result[0] == masked);
+
+        AllContentOctreeQuery light_query(result, DrawableTypes::Light, DEFAULT_VIEWMASK);
+        octree->GetDrawables(light_query);
+        assert(result.Empty());
+
+        masked->SetViewMask(DEFAULT_VIEWMASK);
+        attr_masked->SetViewMask(DEFAULT_VIEWMASK);
+    }
+
+    // Перемещение и удаление объектов
+    for (i32 i = 0; i < nodes.Size(); i += 3)
+        nodes[i]->Translate(Vector3(1.f, 0.f, 5.f));
+
+    for (i32 i = 1; i < nodes.Size(); i += 4)
+        nodes[i]->Remove();
+
+    update_octree(octree);
+
+    for (i32 i = 0; i < 16; ++i)
+        check_frustum(octree, camera_frustum(i * 22.5f));
+
+    // Свободное октодерево: объекты переносятся в корень при изменении параметра и затем снова распределяются
+    nodes.Clear();
+    for (const SharedPtr<Node>& node : scene->GetChildren())
+        nodes.Push(node.Get());
+
+    for (float looseness : {3.f, 1.f, 1.5f})
+    {
+        octree->SetLooseness(looseness);
+        assert(octree->GetLooseness() == looseness);
+        update_octree(octree);
+        check_fit(octree, nodes);
+
+        for (i32 i = 0; i < nodes.Size(); i += 2)
+            nodes[i]->Translate(Vector3(0.1f * (i % 7), 0.f, -0.2f * (i % 5)));
+
+        update_octree(octree);
+        check_fit(octree, nodes);
+
+        for (i32 i = 0; i < 16; ++i)
+            check_frustum(octree, camera_frustum(i * 22.5f));
+    }
+
+    octree->SetLooseness(0.5f);
+    assert(octree->GetLooseness() == 1.f);
+
+    // При свободности 1 октодерево плотное: объект опускается в октант, который содержит его целиком
+    {
+        SharedPtr<Scene> tight_scene(new Scene());
+        Octree* tight_octree = tight_scene->CreateComponent<Octree>();
+        tight_octree->SetLooseness(1.f);
+
+        Node* inside_node = tight_scene->CreateChild("Box");
+        inside_node->SetPosition(Vector3(100.5f, 100.5f, 100.5f));
+        inside_node->CreateComponent<TestBox>();
+
+        // Пересекает центр корневого октанта
+        Node* crossing_node = tight_scene->CreateChild("Box");
+        crossing_node->SetPosition(Vector3(0.f, 100.5f, 100.5f));
+        crossing_node->CreateComponent<TestBox>();
+
+        update_octree(tight_octree);
+
+        Octant* octant = inside_node->GetComponent<TestBox>()->GetOctant();
+        assert(octant->GetLevel() == tight_octree->GetNumLevels());
+        assert(octant->GetCullingBox() == octant->GetWorldBoundingBox());
+        assert(octant->GetWorldBoundingBox().IsInside(inside_node->GetComponent<TestBox>()->GetWorldBoundingBox()) == INSIDE);
+        assert(crossing_node->GetComponent<TestBox>()->GetOctant() == tight_octree);
+
+        // Объект, вышедший за границу октанта, переносится в родительский
+        inside_node->Translate(Vector3(1.f, 0.f, 0.f));
+        update_octree(tight_octree);
+        octant = inside_node->GetComponent<TestBox>()->GetOctant();
+        assert(octant->GetLevel() < tight_octree->GetNumLevels());
+        assert(octant->GetWorldBoundingBox().IsInside(inside_node->GetComponent<TestBox>()->GetWorldBoundingBox()) == INSIDE);
+    }
+
+    // Замер производительности на исходной сцене
+    scene.Reset();
+    scene = new Scene();
+    octree = scene->CreateComponent<Octree>();
+
+    for (i32 y = -125; y < 125; ++y)
+    {
+        for (i32 x = -125; x < 125; ++x)
+        {
+            Node* node = scene->CreateChild("Box");
+            node->SetPosition(Vector3(x * 0.3f, 0.f, y * 0.3f));
+            node->SetScale(0.25f);
+            node->CreateComponent<TestBox>();
+        }
+    }
+
+    update_octree(octree);
+    nodes.Clear();
+    for (const SharedPtr<Node>& node : scene->GetChildren())
+        nodes.Push(node.Get());
+
+    // Октодерево по размеру сцены, чтобы движущиеся объекты переходили между октантами
+    octree->SetSize(BoundingBox(-40.f, 40.f), 6);
+
+    for (float looseness : {DEFAULT_OCTREE_LOOSENESS, 3.f})
+    {
+        octree->SetLooseness(looseness);
+        update_octree(octree);
+
+        const i32 num_frames = benchmarks_enabled() ? 60 : 4;
+        i64 usec = animate(octree, nodes, num_frames);
+        check_fit(octree, nodes);
+
+        if (benchmarks_enabled())
+        {
+            std::cout << "Octree (" << nodes.Size() << " animated drawables, looseness " << looseness << "): update "
+                      << usec / num_frames << " us per frame" << std::endl;
+        }
+    }
+
+    octree->SetLooseness(DEFAULT_OCTREE_LOOSENESS);
+    update_octree(octree);
+
+    const i32 num_queries = benchmarks_enabled() ? 100 : 8;
+    i32 scalar_found;
+    i32 simd_found;
+    i64 scalar_usec = benchmark<ScalarFrustumQuery>(octree, num_queries, scalar_found);
+    i64 simd_usec = benchmark<FrustumOctreeQuery>(octree, num_queries, simd_found);
+    assert(scalar_found == simd_found);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Octree (" << 250 * 250 << " drawables): frustum query " << scalar_usec / num_queries << " us scalar, "
+                  << simd_usec / num_queries << " us SIMD, " << simd_found / num_queries << " drawables found" << std::endl;
+    }
+}
@@ -2,21 +2,84 @@
 // Copyright (c) 2022-2023 the Dviglo project
 // License: MIT
 
+#include "benchmarks.h"
+
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 void Test_Container_Str();
+void test_container_flat_hash_map();
+void test_container_frame_arena();
+void test_core_context();
+void test_core_event();
+void test_core_work_queue();
+void test_graphics_animated_model();
+void test_graphics_animation_compression();
+void test_graphics_batch_queue();
+void test_graphics_instancing_storage();
+void test_graphics_occlusion_buffer();
+void test_graphics_octree();
 void Test_Math_BigInt();
+void test_math_simd();
+void test_network_interest_grid();
+void test_network_quantization();
+void test_network_server_update();
+void test_network_snapshot();
+void test_scene_async_loading();
+void test_scene_attribute_accessor();
+void test_scene_compact_scene();
+void test_scene_logic_component();
+void test_scene_transform_update();
 void test_third_party_sdl();
 
+static bool run_benchmarks = false;
+
+bool benchmarks_enabled()
+{
+    return run_benchmarks;
+}
+
 void Run()
 {
     Test_Container_Str();
+    test_container_flat_hash_map();
+    test_container_frame_arena();
+    test_core_context();
+    test_core_event();
+    test_core_work_queue();
+    test_graphics_animated_model();
+    test_graphics_animation_compression();
+    test_graphics_batch_queue();
+    test_graphics_instancing_storage();
+    test_graphics_occlusion_buffer();
+    test_graphics_octree();
     Test_Math_BigInt();
+    test_math_simd();
+    test_network_interest_grid();
+    test_network_quantization();
+    test_network_server_update();
+    test_network_snapshot();
+    test_scene_async_loading();
+    test_scene_attribute_accessor();
+    test_scene_compact_scene();
+    test_scene_logic_component();
+    test_scene_transform_update();
     test_third_party_sdl();
 }
 
 int main(int argc, char* argv[])
 {
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "-benchmarks") == 0)
+            run_benchmarks = true;
+    }
+
+    const char* env_benchmarks = std::getenv("DV_TEST_BENCHMARKS");
+    if (env_benchmarks && *env_benchmarks && std::strcmp(env_benchmarks, "0") != 0)
+        run_benchmarks = true;
+
     Run();
 
     std::setlocale(LC_ALL, "en_US.UTF-8");
@@ -0,0 +1,221 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/math/bounding_box.h>
+#include <dviglo/math/matrix3x4.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Детерминированный генератор, чтобы тесты не зависели от глобального состояния Random()
+static u32 rng_state = 12345;
+
+static float random_float(float min, float max)
+{
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return min + (max - min) * (rng_state >> 8) / 16777216.f;
+}
+
+static Vector3 random_vector3(float min, float max)
+{
+    return Vector3(random_float(min, max), random_float(min, max), random_float(min, max));
+}
+
+static Quaternion random_rotation()
+{
+    return Quaternion(random_float(-180.f, 180.f), random_float(-180.f, 180.f), random_float(-180.f, 180.f));
+}
+
+static Matrix3x4 random_transform()
+{
+    return Matrix3x4(random_vector3(-100.f, 100.f), random_rotation(), random_vector3(0.1f, 10.f));
+}
+
+// Сравнение с относительной погрешностью
+static bool near(float a, float b, float eps)
+{
+    return Abs(a - b) <= eps * Max(1.f, Max(Abs(a), Abs(b)));
+}
+
+static bool near(const float* a, const float* b, i32 count, float eps)
+{
+    for (i32 i = 0; i < count; ++i)
+    {
+        if (!near(a[i], b[i], eps))
+            return false;
+    }
+
+    return true;
+}
+
+// Скалярные версии для сравнения
+
+static Matrix4 reference_mul(const Matrix4& lhs, const Matrix4& rhs)
+{
+    float out[16];
+
+    for (i32 i = 0; i < 4; ++i)
+    {
+        for (i32 j = 0; j < 4; ++j)
+        {
+            float sum = 0.f;
+            for (i32 k = 0; k < 4; ++k)
+                sum += lhs.Element(i, k) * rhs.Element(k, j);
+            out[i * 4 + j] = sum;
+        }
+    }
+
+    return Matrix4(out);
+}
+
+static Quaternion reference_slerp(const Quaternion& lhs, const Quaternion& rhs, float t)
+{
+    float cos_angle = lhs.DotProduct(rhs);
+    float sign = 1.f;
+
+    if (cos_angle < 0.f)
+    {
+        cos_angle = -cos_angle;
+        sign = -1.f;
+    }
+
+    float angle = acosf(cos_angle);
+    float sin_angle = sinf(angle);
+    float t1 = 1.f - t;
+    float t2 = t;
+
+    if (sin_angle > 0.001f)
+    {
+        t1 = sinf((1.f - t) * angle) / sin_angle;
+        t2 = sinf(t * angle) / sin_angle;
+    }
+
+    return Quaternion(lhs.w_ * t1 + rhs.w_ * sign * t2, lhs.x_ * t1 + rhs.x_ * sign * t2,
+                      lhs.y_ * t1 + rhs.y_ * sign * t2, lhs.z_ * t1 + rhs.z_ * sign * t2);
+}
+
+static BoundingBox reference_transformed(const BoundingBox& box, const Matrix3x4& transform)
+{
+    BoundingBox ret;
+
+    for (i32 i = 0; i < 8; ++i)
+    {
+        Vector3 corner((i & 1) ? box.max_.x_ : box.min_.x_, (i & 2) ? box.max_.y_ : box.min_.y_,
+                       (i & 4) ? box.max_.z_ : box.min_.z_);
+        ret.Merge(transform * corner);
+    }
+
+    return ret;
+}
+
+// Выводит время выполнения count итераций функции
+template <class Func>
+static void benchmark(const char* name, i32 count, const Func& func)
+{
+    auto start_time = std::chrono::steady_clock::now();
+
+    for (i32 i = 0; i < count; ++i)
+        func(i);
+
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    if (benchmarks_enabled())
+        std::cout << "Math: " << count << " x " << name << " " << usec << " us" << std::endl;
+}
+
+void test_math_simd()
+{
+    const i32 num_samples = 1000;
+
+    // Умножение матриц
+    for (i32 i = 0; i < num_samples; ++i)
+    {
+        Matrix3x4 a = random_transform();
+        Matrix3x4 b = random_transform();
+
+        Matrix4 expected = reference_mul(a.ToMatrix4(), b.ToMatrix4());
+        assert(near((a * b).ToMatrix4().Data(), expected.Data(), 16, 1e-5f));
+        assert(near((a.ToMatrix4() * b.ToMatrix4()).Data(), expected.Data(), 16, 1e-5f));
+        assert(near((a * b.ToMatrix4()).Data(), expected.Data(), 16, 1e-5f));
+    }
+
+    // Обращение матриц
+    for (i32 i = 0; i < num_samples; ++i)
+    {
+        Matrix3x4 a = random_transform();
+        Matrix3x4 inverse = a.Inverse();
+        assert(near((a * inverse).Data(), Matrix3x4::IDENTITY.Data(), 12, 1e-4f));
+        assert(near(inverse.ToMatrix4().Data(), a.ToMatrix4().Inverse().Data(), 16, 1e-4f));
+
+        // Матрица общего вида. Диагональное преобладание гарантирует обратимость
+        float data[16];
+        for (i32 j = 0; j < 16; ++j)
+            data[j] = random_float(-1.f, 1.f) + (j % 5 == 0 ? 4.f : 0.f);
+        Matrix4 b(data);
+        assert(near((b * b.Inverse()).Data(), Matrix4::IDENTITY.Data(), 16, 1e-5f));
+    }
+
+    assert(Matrix4::IDENTITY.Inverse() == Matrix4::IDENTITY);
+    assert(Matrix3x4::IDENTITY.Inverse() == Matrix3x4::IDENTITY);
+
+    // Сферическая интерполяция
+    for (i32 i = 0; i < num_samples; ++i)
+    {
+        Quaternion a = random_rotation();
+        Quaternion b = (i % 10 == 0) ? a : random_rotation(); // Иногда совпадают
+        float t = random_float(0.f, 1.f);
+
+        Quaternion actual = a.Slerp(b, t);
+        Quaternion expected = reference_slerp(a, b, t);
+        assert(near(&actual.w_, &expected.w_, 4, 1e-5f));
+    }
+
+    // Преобразование AABB
+    for (i32 i = 0; i < num_samples; ++i)
+    {
+        Vector3 min = random_vector3(-10.f, 10.f);
+        BoundingBox box(min, min + random_vector3(0.f, 10.f));
+        Matrix3x4 transform = random_transform();
+
+        BoundingBox actual = box.Transformed(transform);
+        BoundingBox expected = reference_transformed(box, transform);
+        assert(near(actual.min_.Data(), expected.min_.Data(), 3, 1e-5f));
+        assert(near(actual.max_.Data(), expected.max_.Data(), 3, 1e-5f));
+    }
+
+    // Замеры производительности
+    {
+        const i32 count = benchmarks_enabled() ? 1 << 20 : 1 << 12;
+        const i32 mask = 255;
+        Matrix3x4 transforms[mask + 1];
+        Quaternion rotations[mask + 1];
+        BoundingBox box(Vector3(-1.f, -2.f, -3.f), Vector3(3.f, 2.f, 1.f));
+
+        for (i32 i = 0; i <= mask; ++i)
+        {
+            transforms[i] = random_transform();
+            rotations[i] = random_rotation();
+        }
+
+        // Результаты накапливаются, чтобы компилятор не выбросил вычисления
+        Matrix3x4 m34 = Matrix3x4::ZERO;
+        Matrix4 m4 = Matrix4::ZERO;
+        Quaternion q(0.f, 0.f, 0.f, 0.f);
+        BoundingBox b;
+
+        benchmark("Matrix3x4 * Matrix3x4", count, [&](i32 i) { m34 = m34 + transforms[i & mask] * transforms[(i + 1) & mask]; });
+        benchmark("Matrix4 * Matrix4", count, [&](i32 i) { m4 = m4 + transforms[i & mask].ToMatrix4() * transforms[(i + 1) & mask].ToMatrix4(); });
+        benchmark("Matrix3x4::Inverse()", count, [&](i32 i) { m34 = m34 + transforms[i & mask].Inverse(); });
+        benchmark("Matrix4::Inverse()", count, [&](i32 i) { m4 = m4 + transforms[i & mask].ToMatrix4().Inverse(); });
+        benchmark("Quaternion::Slerp()", count, [&](i32 i) { q += rotations[i & mask].Slerp(rotations[(i + 1) & mask], 0.3f); });
+        benchmark("BoundingBox::Transformed()", count, [&](i32 i) { b.Merge(box.Transformed(transforms[i & mask])); });
+
+        assert(!m34.IsNaN() && !m4.IsNaN() && !q.IsNaN() && b.Defined());
+    }
+}
@@ -0,0 +1,183 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+#include "network_utils.h"
+
+#if DV_NETWORK
+
+#include <dviglo/core/context.h>
+#include <dviglo/core/work_queue.h>
+#include <dviglo/math/random.h>
+#include <dviglo/network/connection.h>
+#include <dviglo/network/interest_grid.h>
+#include <dviglo/network/network.h>
+#include <dviglo/scene/replication_state.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+static constexpr float world_size = 1000.f;
+
+static void test_relevancy()
+{
+    SharedPtr<Scene> scene(new Scene());
+    auto* grid = scene->CreateComponent<InterestGrid>(LOCAL);
+    grid->SetCellSize(10.f);
+    grid->SetInterestDistance(10.f);
+
+    Node* near_node = scene->CreateChild("Near");
+    Node* far_node = scene->CreateChild("Far");
+    Node* owned_node = scene->CreateChild("Owned");
+    far_node->SetPosition(Vector3(100.f, 0.f, 100.f));
+    owned_node->SetPosition(Vector3(-100.f, 0.f, 0.f));
+
+    Connection* connection = connect_client(scene, 0);
+    owned_node->SetOwner(connection);
+
+    // Новые узлы отправляются клиенту независимо от расстояния
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(near_node, connection) && is_up_to_date(far_node, connection) && is_up_to_date(owned_node, connection));
+
+    // Изменения далёких узлов откладываются, кроме узлов, которыми владеет клиент
+    near_node->Translate(Vector3(1.f, 0.f, 0.f));
+    far_node->Translate(Vector3(1.f, 0.f, 0.f));
+    owned_node->Translate(Vector3(1.f, 0.f, 0.f));
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(near_node, connection));
+    assert(!is_up_to_date(far_node, connection));
+    assert(is_up_to_date(owned_node, connection));
+
+    // Клиент подходит к узлу и получает отложенные изменения
+    connection->SetPosition(Vector3(95.f, 0.f, 95.f));
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(far_node, connection));
+
+    // Узел уходит от клиента: последние изменения откладываются до его возвращения
+    far_node->SetPosition(Vector3(500.f, 0.f, 500.f));
+    DV_NET.SendServerUpdates();
+    assert(!is_up_to_date(far_node, connection));
+    far_node->SetPosition(Vector3(100.f, 0.f, 100.f));
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(far_node, connection));
+
+    // Дочерний узел переходит в другую ячейку вместе с родителем
+    Node* child_node = far_node->CreateChild("Child");
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(child_node, connection));
+    far_node->SetPosition(Vector3(500.f, 0.f, 500.f));
+    DV_NET.SendServerUpdates();
+    assert(child_node->GetNetworkState()->interestCell_ == grid->GetCell(Vector3(500.f, 0.f, 500.f)));
+    far_node->SetPosition(Vector3(100.f, 0.f, 100.f));
+    DV_NET.SendServerUpdates();
+    assert(child_node->GetNetworkState()->interestCell_ == grid->GetCell(Vector3(100.f, 0.f, 100.f)));
+
+    // Ячейки назначаются заново только изменившимся узлам, пока не изменится размер ячейки
+    near_node->GetNetworkState()->interestCell_ = IntVector2(1000, 1000);
+    DV_NET.SendServerUpdates();
+    assert(near_node->GetNetworkState()->interestCell_ == IntVector2(1000, 1000));
+    grid->SetCellSize(20.f);
+    DV_NET.SendServerUpdates();
+    assert(near_node->GetNetworkState()->interestCell_ == grid->GetCell(near_node->GetWorldPosition()));
+    grid->SetCellSize(10.f);
+
+    // Выключенная сетка больше не откладывает изменения
+    far_node->SetPosition(Vector3(500.f, 0.f, 500.f));
+    DV_NET.SendServerUpdates();
+    assert(!is_up_to_date(far_node, connection));
+    grid->SetEnabled(false);
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(far_node, connection));
+
+    disconnect_clients(1);
+}
+
+// Возвращает среднее время обновления сервера за тик в миллисекундах
+static double benchmark_server_update(Scene* scene, const Vector<Node*>& nodes, i32 num_clients)
+{
+    // Первые тики, в которых каждый узел перемещается впервые, не замеряются
+    constexpr i32 num_warmup_ticks = 4;
+    constexpr i32 num_ticks = 8;
+
+    SetRandomSeed(1);
+    Vector<Connection*> connections;
+    for (i32 i = 0; i < num_clients; ++i)
+        connections.Push(connect_client(scene, i));
+    for (Connection* connection : connections)
+        connection->SetPosition(Vector3(Random(world_size), 0.f, Random(world_size)));
+
+    DV_NET.SendServerUpdates();
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 tick = 0; tick < num_warmup_ticks + num_ticks; ++tick)
+    {
+        if (tick == num_warmup_ticks)
+            start_time = std::chrono::steady_clock::now();
+
+        // Часть узлов и клиентов перемещается
+        for (i32 i = tick % 4; i < nodes.Size(); i += 4)
+            nodes[i]->Translate(Vector3(Random(-2.f, 2.f), 0.f, Random(-2.f, 2.f)));
+        for (Connection* connection : connections)
+            connection->SetPosition(connection->GetPosition() + Vector3(Random(-2.f, 2.f), 0.f, Random(-2.f, 2.f)));
+
+        DV_NET.SendServerUpdates();
+    }
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    disconnect_clients(num_clients);
+    return usec / 1000.0 / num_ticks;
+}
+
+void test_network_interest_grid()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(Scene::GetTypeStatic()))
+        Scene::RegisterObject();
+
+    // Сетевая подсистема регистрирует свои компоненты при создании
+    Network::get_instance();
+
+    test_relevancy();
+
+    if (!benchmarks_enabled())
+        return;
+
+    // Замер производительности: узлы разбросаны по миру, каждый клиент видит небольшую его часть
+    constexpr i32 num_nodes = 10000;
+    constexpr i32 num_clients = 100;
+
+    SharedPtr<Scene> scene(new Scene());
+    auto* grid = scene->CreateComponent<InterestGrid>(LOCAL);
+
+    SetRandomSeed(1);
+    Vector<Node*> nodes;
+    for (i32 i = 0; i < num_nodes; ++i)
+    {
+        Node* node = scene->CreateChild("Node");
+        node->SetPosition(Vector3(Random(world_size), 0.f, Random(world_size)));
+        nodes.Push(node);
+    }
+
+    double grid_msec = benchmark_server_update(scene, nodes, num_clients);
+    grid->SetEnabled(false);
+    double no_grid_msec = benchmark_server_update(scene, nodes, num_clients);
+
+    std::cout << "Interest grid (" << num_nodes << " nodes, " << num_clients << " clients, "
+              << DV_WORK_QUEUE.GetNumThreads() << " worker threads): with grid " << grid_msec << " ms/tick, without grid "
+              << no_grid_msec << " ms/tick" << std::endl;
+}
+
+#else
+
+void test_network_interest_grid()
+{
+}
+
+#endif // DV_NETWORK
@@ -0,0 +1,59 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "network_utils.h"
+
+#if DV_NETWORK
+
+#include <dviglo/io/memory_buffer.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/network/network.h>
+#include <dviglo/network/protocol.h>
+#include <dviglo/scene/replication_state.h>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+static constexpr unsigned short first_client_port = 40000;
+
+SLNet::AddressOrGUID client_address(i32 index)
+{
+    return SLNet::AddressOrGUID(SLNet::SystemAddress("127.0.0.1", first_client_port + index));
+}
+
+Connection* connect_client(Scene* scene, i32 index)
+{
+    DV_NET.NewConnectionEstablished(client_address(index));
+    Connection* connection = DV_NET.GetConnection(client_address(index));
+    connection->SetScene(scene);
+
+    VectorBuffer packed;
+    packed.WriteU32(MSG_SCENELOADED);
+    packed.WriteU32(sizeof(u32));
+    packed.WriteU32(scene->GetChecksum());
+    MemoryBuffer msg(packed.GetData(), packed.GetSize());
+    assert(connection->ProcessMessage(MSG_PACKED_MESSAGE, msg));
+
+    return connection;
+}
+
+void disconnect_clients(i32 num_clients)
+{
+    for (i32 i = 0; i < num_clients; ++i)
+        DV_NET.ClientDisconnected(client_address(i));
+}
+
+bool is_up_to_date(Node* node, Connection* connection)
+{
+    for (ReplicationState* state : node->GetNetworkState()->replicationStates_)
+    {
+        if (state->connection_ == connection)
+            return !static_cast<NodeReplicationState*>(state)->markedDirty_;
+    }
+
+    return false;
+}
+
+#endif // DV_NETWORK
@@ -0,0 +1,28 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#if DV_NETWORK
+
+#include <dviglo/network/connection.h>
+#include <dviglo/scene/scene.h>
+
+#include <slikenet/peerinterface.h>
+
+// Общие функции тестов репликации. Клиенты не подключаются по-настоящему: сервер создаёт соединения
+// с фиктивными адресами, и тесты передают соединениям сообщения клиентов напрямую
+
+// Возвращает фиктивный адрес клиента
+SLNet::AddressOrGUID client_address(dviglo::i32 index);
+
+// Клиент подключается к серверу и сообщает, что сцена загружена
+dviglo::Connection* connect_client(dviglo::Scene* scene, dviglo::i32 index);
+
+// Отключает клиентов с индексами от 0 до num_clients - 1
+void disconnect_clients(dviglo::i32 num_clients);
+
+// Возвращает, получил ли клиент все изменения узла
+bool is_up_to_date(dviglo::Node* node, dviglo::Connection* connection);
+
+#endif // DV_NETWORK
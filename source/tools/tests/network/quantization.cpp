@@ -0,0 +1,195 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#if DV_NETWORK
+
+#include <dviglo/core/context.h>
+#include <dviglo/io/bit_reader.h>
+#include <dviglo/io/bit_writer.h>
+#include <dviglo/io/memory_buffer.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/scene/replication_state.h>
+#include <dviglo/scene/scene.h>
+
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+class QuantizationTestComponent : public Component
+{
+    DV_OBJECT(QuantizationTestComponent, Component);
+
+public:
+    static void RegisterObject()
+    {
+        DV_CONTEXT.RegisterFactory<QuantizationTestComponent>();
+        DV_ATTRIBUTE("Health", health, 0.f, AM_DEFAULT).SetQuantization(AttributeQuantization::Range(0.f, 100.f, 0.5f));
+        DV_ATTRIBUTE("Label", label, String::EMPTY, AM_DEFAULT);
+        DV_ATTRIBUTE("Velocity", velocity, Vector2::ZERO, AM_DEFAULT).SetQuantization(AttributeQuantization::Range(-10.f, 10.f, 0.01f));
+    }
+
+    float health = 0.f;
+    String label;
+    Vector2 velocity = Vector2::ZERO;
+};
+
+}
+
+// Возвращает, отличаются ли повороты меньше чем на заданный угол в градусах
+static bool is_near(const Quaternion& a, const Quaternion& b, float max_angle)
+{
+    // Угол считается через векторную часть разности поворотов: арккосинус близкого к единице числа неточен
+    Quaternion diff = a.Inverse() * b;
+    return 2.f * Asin(Min(Vector3(diff.x_, diff.y_, diff.z_).Length(), 1.f)) < max_angle;
+}
+
+static void test_bit_stream()
+{
+    VectorBuffer buffer;
+    {
+        BitWriter writer(buffer);
+        writer.WriteBits(5, 3);
+        writer.WriteBool(true);
+        writer.WriteBits(0xFFFFFFFF, 32);
+        writer.WriteBits(0x1234, 13);
+        writer.WriteQuantizedFloat(0.25f, -1.f, 1.f, 12);
+        writer.WriteSmallestThreeQuaternion(Quaternion(30.f, Vector3(1.f, 2.f, -3.f).Normalized()), 12);
+        assert(writer.GetNumBits() == 3 + 1 + 32 + 13 + 12 + 2 + 3 * 12);
+    }
+
+    // После упакованных битов поток читается обычным образом
+    buffer.WriteU32(0xDEADBEEF);
+    assert(buffer.GetSize() == (3 + 1 + 32 + 13 + 12 + 2 + 3 * 12 + 7) / 8 + 4);
+
+    MemoryBuffer source(buffer.GetData(), buffer.GetSize());
+    BitReader reader(source);
+    assert(reader.ReadBits(3) == 5);
+    assert(reader.ReadBool());
+    assert(reader.ReadBits(32) == 0xFFFFFFFF);
+    assert(reader.ReadBits(13) == 0x1234);
+    assert(Abs(reader.ReadQuantizedFloat(-1.f, 1.f, 12) - 0.25f) < 0.001f);
+    Quaternion rotation = reader.ReadSmallestThreeQuaternion(12);
+    assert(is_near(rotation, Quaternion(30.f, Vector3(1.f, 2.f, -3.f).Normalized()), 0.1f));
+    assert(source.ReadU32() == 0xDEADBEEF);
+
+    // Число бит выбирается по точности
+    assert(AttributeQuantization::Range(-1000.f, 1000.f, 0.01f).bits_ == 17);
+    assert(AttributeQuantization::Range(0.f, 100.f, 0.5f).bits_ == 7);
+}
+
+// Записывает последние данные узла на сервере и применяет их к узлу на клиенте. Возвращает размер обновления в байтах
+static i32 replicate_transform(Node* server_node, Node* client_node)
+{
+    server_node->GetScene()->PrepareNetworkUpdate();
+
+    VectorBuffer update;
+    server_node->WriteLatestDataUpdate(update, 0);
+    MemoryBuffer msg(update.GetData(), update.GetSize());
+    client_node->ReadLatestDataUpdate(msg);
+    assert(msg.IsEof());
+
+    return update.GetSize();
+}
+
+static void test_node_transform()
+{
+    SharedPtr<Scene> server_scene(new Scene());
+    SharedPtr<Scene> client_scene(new Scene());
+    Node* server_node = server_scene->CreateChild("Node");
+    Node* client_node = client_scene->CreateChild("Node", LOCAL);
+
+    server_node->SetPosition(Vector3(123.456f, -7.89f, 500.f));
+    server_node->SetRotation(Quaternion(10.f, 20.f, 30.f));
+
+    // Без квантования: полные Vector3 и Quaternion
+    DV_CONTEXT.SetAttributeQuantization<Node>("Network Rotation", AttributeQuantization());
+    i32 full_size = replicate_transform(server_node, client_node);
+    assert(client_node->GetPosition() == server_node->GetPosition());
+    assert(client_node->GetRotation() == server_node->GetRotation());
+
+    // По умолчанию квантуется только поворот
+    DV_CONTEXT.SetAttributeQuantization<Node>("Network Rotation", AttributeQuantization::SmallestThree(15));
+    server_node->Translate(Vector3::ONE);
+    i32 default_size = replicate_transform(server_node, client_node);
+    assert(client_node->GetPosition() == server_node->GetPosition());
+    assert(is_near(client_node->GetRotation(), server_node->GetRotation(), 0.01f));
+
+    // Игра с ограниченным миром квантует и позицию
+    DV_CONTEXT.SetAttributeQuantization<Node>("Network Position", AttributeQuantization::Range(-1000.f, 1000.f, 0.01f));
+    DV_CONTEXT.SetAttributeQuantization<Node>("Network Rotation", AttributeQuantization::SmallestThree(10));
+    server_node->Translate(Vector3::ONE);
+    i32 quantized_size = replicate_transform(server_node, client_node);
+    assert((client_node->GetPosition() - server_node->GetPosition()).Length() < 0.02f);
+    assert(is_near(client_node->GetRotation(), server_node->GetRotation(), 0.3f));
+
+    // Значения вне диапазона ограничиваются
+    server_node->SetPosition(Vector3(2000.f, 0.f, -2000.f));
+    replicate_transform(server_node, client_node);
+    assert((client_node->GetPosition() - Vector3(1000.f, 0.f, -1000.f)).Length() < 0.02f);
+
+    DV_CONTEXT.SetAttributeQuantization<Node>("Network Position", AttributeQuantization());
+    DV_CONTEXT.SetAttributeQuantization<Node>("Network Rotation", AttributeQuantization::SmallestThree(15));
+
+    assert(full_size == 1 + 12 + 16);
+    assert(quantized_size == 1 + (3 * 17 + 2 + 3 * 10 + 7) / 8);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Node transform update: " << full_size << " bytes full precision, " << default_size
+                  << " bytes by default, " << quantized_size << " bytes quantized" << std::endl;
+    }
+}
+
+static void test_component_delta()
+{
+    SharedPtr<Scene> server_scene(new Scene());
+    SharedPtr<Scene> client_scene(new Scene());
+    auto* server_component = server_scene->CreateChild("Node")->CreateComponent<QuantizationTestComponent>();
+    auto* client_component = client_scene->CreateChild("Node", LOCAL)->CreateComponent<QuantizationTestComponent>(LOCAL);
+
+    server_component->health = 42.3f;
+    server_component->label = "Label";
+    server_component->velocity = Vector2(-3.21f, 9.87f);
+    server_component->MarkNetworkUpdate();
+    server_scene->PrepareNetworkUpdate();
+
+    // Квантованные и обычные атрибуты в одном обновлении
+    VectorBuffer update;
+    server_component->WriteInitialDeltaUpdate(update, 0);
+    MemoryBuffer msg(update.GetData(), update.GetSize());
+    assert(client_component->ReadDeltaUpdate(msg));
+    assert(msg.IsEof());
+
+    assert(Abs(client_component->health - 42.3f) <= 0.5f);
+    assert(client_component->label == "Label");
+    assert((client_component->velocity - Vector2(-3.21f, 9.87f)).Length() < 0.02f);
+}
+
+void test_network_quantization()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(Scene::GetTypeStatic()))
+        Scene::RegisterObject();
+    QuantizationTestComponent::RegisterObject();
+
+    test_bit_stream();
+    test_node_transform();
+    test_component_delta();
+}
+
+#else
+
+void test_network_quantization()
+{
+}
+
+#endif // DV_NETWORK
@@ -0,0 +1,211 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+#include "network_utils.h"
+
+#if DV_NETWORK
+
+#include <dviglo/containers/allocator.h>
+#include <dviglo/core/context.h>
+#include <dviglo/core/work_queue.h>
+#include <dviglo/graphics/animation_controller.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/network/connection.h>
+#include <dviglo/network/network.h>
+#include <dviglo/network/network_priority.h>
+#include <dviglo/scene/replication_state.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+class ServerUpdateTestComponent : public Component
+{
+    DV_OBJECT(ServerUpdateTestComponent, Component);
+
+public:
+    static void RegisterObject()
+    {
+        DV_CONTEXT.RegisterFactory<ServerUpdateTestComponent>();
+        DV_ATTRIBUTE("Speed", speed, 0.f, AM_DEFAULT);
+        DV_ATTRIBUTE("Label", label, String::EMPTY, AM_DEFAULT);
+    }
+
+    float speed = 0.f;
+    String label;
+};
+
+}
+
+static constexpr i32 num_nodes = 2000;
+static constexpr i32 num_ticks = 10;
+
+// Изменяет часть реплицируемых узлов, как это делала бы игровая логика за один тик
+static void move_nodes(const Vector<Node*>& nodes, i32 tick)
+{
+    for (i32 i = tick % 4; i < nodes.Size(); i += 4)
+    {
+        nodes[i]->Translate(Vector3(0.f, 0.f, 1.f));
+        auto* component = nodes[i]->GetComponent<ServerUpdateTestComponent>();
+        if (component)
+        {
+            component->speed += 1.f;
+            component->MarkNetworkUpdate();
+        }
+    }
+}
+
+// Общие для всех соединений обновления должны совпадать с обновлениями, которые соединение записало бы само
+static void check_shared_update(Serializable* serializable)
+{
+    const NetworkState* state = serializable->GetNetworkState();
+
+    VectorBuffer delta;
+    serializable->WriteDeltaUpdate(delta, state->deltaBits_, 0);
+    assert(delta.GetSize() > 1);
+    assert(!memcmp(delta.GetData() + 1, state->deltaUpdate_.GetData(), delta.GetSize() - 1));
+}
+
+// Многие клиенты подключаются в одном тике, и первое обновление отправляет одни и те же узлы всем клиентам сразу
+static void test_concurrent_clients()
+{
+    SharedPtr<Scene> scene(new Scene());
+    Node* parent = scene->CreateChild("Parent");
+    Node* local_parent = parent->CreateChild("Local parent", LOCAL);
+
+    Vector<Node*> nodes;
+    for (i32 i = 0; i < 100; ++i)
+    {
+        // Для дочернего узла локального родителя атрибут родителя содержит ещё и хеш имени
+        Node* node = (i % 2 ? parent : local_parent)->CreateChild("Child " + String(i));
+        node->CreateComponent<AnimationController>();
+        nodes.Push(node);
+    }
+
+    // Каждый клиент должен получить собственные состояния репликации узлов и компонентов
+    constexpr i32 num_clients = 32;
+    for (i32 i = 0; i < num_clients; ++i)
+        connect_client(scene, i);
+
+    DV_NET.SendServerUpdates();
+    for (Node* node : nodes)
+    {
+        assert(node->GetNetworkState()->replicationStates_.Size() == num_clients);
+        assert(node->GetComponent<AnimationController>()->GetNetworkState()->replicationStates_.Size() == num_clients);
+    }
+
+    disconnect_clients(num_clients);
+}
+
+struct UpdateResult
+{
+    double msec_per_tick;
+    i64 allocations_per_tick;
+};
+
+// Подключает клиентов к серверу и возвращает среднее время обновления сервера и число выделений памяти за тик
+static UpdateResult benchmark_server_update(Scene* scene, const Vector<Node*>& nodes, i32 num_clients)
+{
+    Network& network = DV_NET;
+
+    for (i32 i = 0; i < num_clients; ++i)
+        connect_client(scene, i);
+
+    // Первое обновление отправляет клиентам все узлы. Каждый клиент должен получить собственное состояние репликации
+    network.SendServerUpdates();
+    for (Node* node : nodes)
+        assert(node->GetNetworkState()->replicationStates_.Size() == num_clients);
+
+    i64 num_allocations = GetNumContainerAllocations();
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 tick = 0; tick < num_ticks; ++tick)
+    {
+        move_nodes(nodes, tick);
+        network.SendServerUpdates();
+    }
+    i64 usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    num_allocations = GetNumContainerAllocations() - num_allocations;
+
+    for (i32 i = (num_ticks - 1) % 4; i < nodes.Size(); i += 4)
+    {
+        auto* component = nodes[i]->GetComponent<ServerUpdateTestComponent>();
+        if (component)
+            check_shared_update(component);
+    }
+
+    disconnect_clients(num_clients);
+
+    // Отключённые клиенты не оставляют состояний репликации
+    for (Node* node : nodes)
+        assert(node->GetNetworkState()->replicationStates_.Empty());
+
+    return {usec / 1000.0 / num_ticks, num_allocations / num_ticks};
+}
+
+void test_network_server_update()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(Scene::GetTypeStatic()))
+        Scene::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(AnimationController::GetTypeStatic()))
+        AnimationController::RegisterObject();
+    ServerUpdateTestComponent::RegisterObject();
+
+    test_concurrent_clients();
+
+    SharedPtr<Scene> scene(new Scene());
+    Vector<Node*> nodes;
+    for (i32 i = 0; i < num_nodes; ++i)
+    {
+        Node* parent = i < 100 ? scene : nodes[i / 2];
+        Node* node = parent->CreateChild("Node " + String(i));
+        nodes.Push(node);
+        node->SetPosition(Vector3((float)i, 0.f, 0.f));
+
+        if (i % 2)
+        {
+            auto* component = node->CreateComponent<ServerUpdateTestComponent>();
+            component->label = "Label " + String(i % 10);
+        }
+
+        // Узлы с приоритетом обращаются к мировым координатам в рабочих потоках
+        if (i % 5 == 0)
+            node->CreateComponent<NetworkPriority>();
+    }
+
+    const i32 client_counts[] = {1, 16, 64};
+    UpdateResult results[std::size(client_counts)];
+    for (size_t i = 0; i < std::size(client_counts); ++i)
+        results[i] = benchmark_server_update(scene, nodes, client_counts[i]);
+
+    if (!benchmarks_enabled())
+        return;
+
+    std::cout << "Server update (" << num_nodes << " nodes, " << DV_WORK_QUEUE.GetNumThreads() << " worker threads):";
+    for (size_t i = 0; i < std::size(client_counts); ++i)
+    {
+        std::cout << " " << client_counts[i] << " clients " << results[i].msec_per_tick << " ms, "
+                  << results[i].allocations_per_tick << " allocations per tick;";
+    }
+    std::cout << std::endl;
+}
+
+#else
+
+void test_network_server_update()
+{
+}
+
+#endif // DV_NETWORK
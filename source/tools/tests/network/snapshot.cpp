@@ -0,0 +1,351 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+#include "network_utils.h"
+
+#if DV_NETWORK
+
+#include <dviglo/core/context.h>
+#include <dviglo/core/timer.h>
+#include <dviglo/io/memory_buffer.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/network/connection.h>
+#include <dviglo/network/network.h>
+#include <dviglo/network/protocol.h>
+#include <dviglo/scene/replication_state.h>
+#include <dviglo/scene/scene.h>
+#include <dviglo/scene/smoothed_transform.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+class SnapshotTestComponent : public Component
+{
+    DV_OBJECT(SnapshotTestComponent, Component);
+
+public:
+    static void RegisterObject()
+    {
+        DV_CONTEXT.RegisterFactory<SnapshotTestComponent>();
+        DV_ATTRIBUTE("Speed", speed, 0.f, AM_DEFAULT);
+    }
+
+    float speed = 0.f;
+};
+
+}
+
+static constexpr unsigned short first_server_port = 42100;
+
+// Клиент подтверждает получение снимка
+static void acknowledge(Connection* connection, unsigned sequence)
+{
+    VectorBuffer packed;
+    packed.WriteU32(MSG_SNAPSHOTACK);
+    packed.WriteU32(sizeof(u32));
+    packed.WriteU32(sequence);
+    MemoryBuffer msg(packed.GetData(), packed.GetSize());
+    assert(connection->ProcessMessage(MSG_PACKED_MESSAGE, msg));
+}
+
+static void test_acknowledgement()
+{
+    SharedPtr<Scene> scene(new Scene());
+    Node* node = scene->CreateChild("Node");
+    auto* component = node->CreateComponent<SnapshotTestComponent>();
+
+    DV_NET.SetSnapshotReplication(true);
+    Connection* connection = connect_client(scene, 0);
+    assert(connection->GetSnapshotReplication());
+
+    // Узлы создаются надёжными сообщениями, снимок не нужен
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 0);
+    assert(is_up_to_date(node, connection));
+
+    // Пока клиент не подтвердит изменения, они отправляются в каждом снимке
+    node->Translate(Vector3(1.f, 0.f, 0.f));
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 1);
+    assert(!is_up_to_date(node, connection));
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 2);
+
+    // Подтверждения могут теряться: подтверждение первого снимка тоже содержит изменения
+    acknowledge(connection, 1);
+    assert(connection->GetAckedSnapshot() == 1);
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 2);
+    assert(is_up_to_date(node, connection));
+
+    // Изменения компонентов подтверждаются вместе с узлом
+    component->speed = 5.f;
+    component->MarkNetworkUpdate();
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 3);
+    assert(!is_up_to_date(node, connection));
+    acknowledge(connection, 3);
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 3);
+    assert(is_up_to_date(node, connection));
+
+    // Забытые снимки нельзя подтвердить
+    node->Translate(Vector3(1.f, 0.f, 0.f));
+    for (unsigned i = 0; i <= SNAPSHOT_HISTORY_SIZE; ++i)
+        DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == 4 + SNAPSHOT_HISTORY_SIZE);
+    acknowledge(connection, 4);
+    assert(connection->GetAckedSnapshot() == 3);
+    DV_NET.SendServerUpdates();
+    assert(!is_up_to_date(node, connection));
+    acknowledge(connection, connection->GetSnapshotSequence());
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(node, connection));
+
+    // Пользовательские переменные отправляются надёжно, без снимков
+    unsigned sequence = connection->GetSnapshotSequence();
+    node->SetVar("Score", 1);
+    DV_NET.SendServerUpdates();
+    assert(connection->GetSnapshotSequence() == sequence);
+    assert(is_up_to_date(node, connection));
+
+    // При смене режима сцена отправляется заново
+    DV_NET.SetSnapshotReplication(false);
+    assert(!connection->GetSnapshotReplication());
+    assert(node->GetNetworkState()->replicationStates_.Empty());
+    DV_NET.SendServerUpdates();
+    assert(is_up_to_date(node, connection));
+
+    disconnect_clients(1);
+}
+
+// Клиент получает снимок от сервера
+static void receive_snapshot(Connection* connection, const VectorBuffer& snapshot)
+{
+    VectorBuffer packed;
+    packed.WriteU32(MSG_SNAPSHOT);
+    packed.WriteU32(snapshot.GetSize());
+    packed.Write(snapshot.GetData(), snapshot.GetSize());
+    MemoryBuffer msg(packed.GetData(), packed.GetSize());
+    assert(connection->ProcessMessage(MSG_PACKED_MESSAGE, msg));
+}
+
+static void test_truncated_snapshot()
+{
+    SharedPtr<Scene> scene(new Scene());
+    Node* node = scene->CreateChild("Node", REPLICATED);
+    SharedPtr<Connection> connection(new Connection(false, client_address(0), nullptr));
+    connection->SetScene(scene);
+
+    // Размер данных узла больше остатка сообщения: снимок не применяется и не подтверждается
+    VectorBuffer snapshot;
+    snapshot.WriteU32(1);
+    snapshot.WriteVLE(1);
+    snapshot.WriteNetID(node->GetID());
+    snapshot.WriteVLE(1000);
+    snapshot.WriteU32(0);
+    receive_snapshot(connection, snapshot);
+    assert(connection->GetAckedSnapshot() == 0);
+    assert(node->GetPosition() == Vector3::ZERO);
+
+    // Полный снимок подтверждается
+    snapshot.Clear();
+    snapshot.WriteU32(2);
+    snapshot.WriteVLE(0);
+    snapshot.WriteVLE(0);
+    receive_snapshot(connection, snapshot);
+    assert(connection->GetAckedSnapshot() == 2);
+
+    connection->SetScene(nullptr);
+}
+
+struct LoopbackResult
+{
+    float kbytes_per_sec;
+    float mean_staleness_ms;
+    float max_staleness_ms;
+};
+
+// Обрабатывает входящие сообщения и отправляет обновления сервера и клиента
+static void pump(Scene* server_scene)
+{
+    DV_NET.Update(0.f);
+
+    for (Connection* connection : DV_NET.GetClientConnections())
+    {
+        if (!connection->GetScene())
+            connection->SetScene(server_scene);
+    }
+
+    // Шаг времени равен интервалу обновления, поэтому обновление отправляется при каждом вызове
+    DV_NET.PostUpdate(1.f / DV_NET.GetUpdateFps());
+}
+
+// Сервер и клиент в одном процессе обмениваются данными через петлевой интерфейс.
+// Узлы перемещаются каждый тик, отставание клиента измеряется по последней полученной позиции
+static LoopbackResult benchmark_loopback(const Vector<Node*>& nodes, unsigned short port, bool snapshots)
+{
+    // Медленный атрибут меняется раз в 10 тиков, поэтому даже без замеров нужно хотя бы 10 тиков
+    const i32 num_warmup_ticks = benchmarks_enabled() ? 30 : 5;
+    const i32 num_ticks = benchmarks_enabled() ? 60 : 10;
+
+    Network& network = DV_NET;
+    Scene* server_scene = nodes[0]->GetScene();
+    network.SetSnapshotReplication(snapshots);
+    assert(network.StartServer(port));
+
+    SharedPtr<Scene> client_scene(new Scene());
+    assert(network.Connect("127.0.0.1", port, client_scene));
+
+    // Ждём, пока клиент получит все узлы
+    Node* last_node = nodes.Back();
+    auto start_time = std::chrono::steady_clock::now();
+    while (!client_scene->GetNode(last_node->GetID()))
+    {
+        assert(std::chrono::steady_clock::now() - start_time < std::chrono::seconds(10));
+        pump(server_scene);
+        Time::Sleep(5);
+    }
+
+    i32 tick_ms = 1000 / network.GetUpdateFps();
+    float bytes_per_sec = 0.f;
+    float staleness_sum = 0.f;
+    float max_staleness = 0.f;
+    i32 num_samples = 0;
+
+    for (i32 tick = 1; tick <= num_warmup_ticks + num_ticks; ++tick)
+    {
+        for (Node* node : nodes)
+            node->SetPosition(Vector3((float)tick, node->GetPosition().y_, node->GetPosition().z_));
+
+        // Медленно меняющийся атрибут: в режиме снимков он отправляется, пока клиент не подтвердит изменение
+        if (tick % 10 == 0)
+        {
+            for (Node* node : nodes)
+            {
+                auto* component = node->GetComponent<SnapshotTestComponent>();
+                component->speed = (float)tick;
+                component->MarkNetworkUpdate();
+            }
+        }
+
+        pump(server_scene);
+        Time::Sleep(tick_ms);
+
+        // Клиент обрабатывает полученные за тик сообщения
+        network.Update(0.f);
+
+        if (tick <= num_warmup_ticks)
+            continue;
+
+        Vector<SharedPtr<Connection>> connections = network.GetClientConnections();
+        assert(connections.Size() == 1);
+        bytes_per_sec += connections[0]->GetBytesOutPerSec();
+
+        // Отставание в тиках от последнего отправленного состояния
+        for (Node* node : nodes)
+        {
+            Node* client_node = client_scene->GetNode(node->GetID());
+            auto* transform = client_node->GetComponent<SmoothedTransform>();
+            float staleness = (float)tick - transform->GetTargetPosition().x_;
+            staleness_sum += staleness;
+            max_staleness = Max(max_staleness, staleness);
+        }
+        ++num_samples;
+    }
+
+    // Клиент получил изменения медленного атрибута
+    Node* client_node = client_scene->GetNode(last_node->GetID());
+    assert(client_node->GetComponent<SnapshotTestComponent>()->speed > 0.f);
+    if (snapshots)
+    {
+        assert(network.GetServerConnection()->GetAckedSnapshot() > 0);
+        assert(network.GetClientConnections()[0]->GetAckedSnapshot() > 0);
+    }
+
+    network.Disconnect(100);
+    network.StopServer();
+    network.Update(0.f);
+
+    return {bytes_per_sec / num_samples / 1000.f, staleness_sum / (num_samples * nodes.Size()) * tick_ms,
+        max_staleness * tick_ms};
+}
+
+void test_network_snapshot()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(Scene::GetTypeStatic()))
+        Scene::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(SmoothedTransform::GetTypeStatic()))
+        SmoothedTransform::RegisterObject();
+    SnapshotTestComponent::RegisterObject();
+
+    test_acknowledgement();
+    test_truncated_snapshot();
+
+    // Замер: обычная репликация и снимки при одинаковых условиях сети
+    constexpr i32 num_nodes = 200;
+
+    SharedPtr<Scene> scene(new Scene());
+    Vector<Node*> nodes;
+    for (i32 i = 0; i < num_nodes; ++i)
+    {
+        Node* node = scene->CreateChild("Node");
+        node->SetPosition(Vector3(0.f, (float)(i / 20), (float)(i % 20)));
+        node->CreateComponent<SnapshotTestComponent>();
+        nodes.Push(node);
+    }
+
+    struct Condition
+    {
+        int latency_ms;
+        float packet_loss;
+    };
+
+    const Condition conditions[] = {{0, 0.f}, {100, 0.1f}};
+    unsigned short port = first_server_port;
+
+    for (const Condition& condition : conditions)
+    {
+        // Без замеров обе репликации проверяются только в идеальной сети
+        if (!benchmarks_enabled() && condition.latency_ms > 0)
+            break;
+
+        DV_NET.SetSimulatedLatency(condition.latency_ms);
+        DV_NET.SetSimulatedPacketLoss(condition.packet_loss);
+
+        LoopbackResult reliable = benchmark_loopback(nodes, port++, false);
+        LoopbackResult snapshot = benchmark_loopback(nodes, port++, true);
+
+        if (benchmarks_enabled())
+        {
+            std::cout << "Loopback replication (" << num_nodes << " nodes, latency " << condition.latency_ms << " ms, loss "
+                      << condition.packet_loss * 100.f << "%" << (DV_NET.IsNetworkSimulatorActive() ? "" : ", simulator inactive in this build")
+                      << "): reliable " << reliable.kbytes_per_sec << " KB/s, staleness " << reliable.mean_staleness_ms << " ms mean "
+                      << reliable.max_staleness_ms << " ms max; snapshots " << snapshot.kbytes_per_sec << " KB/s, staleness "
+                      << snapshot.mean_staleness_ms << " ms mean " << snapshot.max_staleness_ms << " ms max" << std::endl;
+        }
+    }
+
+    DV_NET.SetSimulatedLatency(0);
+    DV_NET.SetSimulatedPacketLoss(0.f);
+    DV_NET.SetSnapshotReplication(false);
+}
+
+#else
+
+void test_network_snapshot()
+{
+}
+
+#endif // DV_NETWORK
@@ -0,0 +1,83 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+#include "scene_utils.h"
+
+#include <dviglo/core/work_queue.h>
+#include <dviglo/io/file.h>
+#include <dviglo/io/file_system.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+void test_scene_async_loading()
+{
+    register_scene_test_objects();
+
+    // Без замеров проверки выполняются на сцене меньшего размера
+    const i32 num_nodes = benchmarks_enabled() ? 50000 : 5000;
+    SharedPtr<Scene> scene(new Scene());
+    create_test_scene(scene, num_nodes);
+
+    String file_name = DV_FILE_SYSTEM.GetTemporaryDir() + "dviglo_test_async_loading.bin";
+    {
+        File file(file_name, FILE_WRITE);
+        assert(scene->Save(file));
+    }
+
+    // Синхронная загрузка для сравнения
+    auto start_time = std::chrono::steady_clock::now();
+    {
+        SharedPtr<Scene> loaded(new Scene());
+        File file(file_name);
+        assert(loaded->Load(file));
+    }
+    i64 sync_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    // Асинхронная загрузка. Идентификаторы, атрибуты и ссылки на узлы должны восстановиться
+    SharedPtr<Scene> loaded(new Scene());
+    loaded->CreateChild("Removed on load");
+    start_time = std::chrono::steady_clock::now();
+    assert(loaded->LoadAsync(new File(file_name), LOAD_SCENE));
+
+    i32 num_frames = 0;
+    i64 max_frame_usec = 0;
+    while (loaded->IsAsyncLoading())
+    {
+        auto frame_start = std::chrono::steady_clock::now();
+        loaded->Update(0.f);
+        i64 frame_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - frame_start).count();
+        max_frame_usec = Max(max_frame_usec, frame_usec);
+        ++num_frames;
+    }
+
+    i64 async_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    assert(equal_nodes(scene, loaded));
+
+    // Прерванная загрузка дожидается рабочих потоков и не оставляет узлов
+    {
+        SharedPtr<Scene> aborted(new Scene());
+        assert(aborted->LoadAsync(new File(file_name), LOAD_SCENE));
+        aborted->Update(0.f);
+        aborted->StopAsyncLoading();
+        aborted->Clear();
+        assert(aborted->GetNumChildren() == 0);
+        assert(aborted->LoadAsync(new File(file_name), LOAD_SCENE));
+    }
+
+    DV_FILE_SYSTEM.Delete(file_name);
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Scene async load (" << num_nodes << " nodes, " << DV_WORK_QUEUE.GetNumThreads() << " worker threads): sync "
+                  << sync_usec << " us; async " << async_usec << " us in " << num_frames << " frames, longest frame "
+                  << max_frame_usec << " us" << std::endl;
+    }
+}
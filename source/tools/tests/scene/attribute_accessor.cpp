@@ -0,0 +1,240 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/context.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/scene/replication_state.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+// Компонент с побочными эффектами в OnSetAttribute() и OnGetAttribute()
+class HookTestComponent : public Component
+{
+    DV_OBJECT(HookTestComponent, Component);
+
+public:
+    static void RegisterObject()
+    {
+        DV_CONTEXT.RegisterFactory<HookTestComponent>();
+        DV_ATTRIBUTE("Speed", speed, 0.f, AM_DEFAULT);
+    }
+
+    void OnSetAttribute(const AttributeInfo& attr, const Variant& src) override
+    {
+        ++num_sets;
+        Component::OnSetAttribute(attr, src);
+    }
+
+    void OnGetAttribute(const AttributeInfo& attr, Variant& dest) const override
+    {
+        ++num_gets;
+        Component::OnGetAttribute(attr, dest);
+    }
+
+    float speed = 0.f;
+    i32 num_sets = 0;
+    mutable i32 num_gets = 0;
+};
+
+// Подкласс узла без собственного разрешения типизированного доступа
+class DerivedTestNode : public Node
+{
+    DV_OBJECT(DerivedTestNode, Node);
+};
+
+}
+
+static constexpr i32 num_benchmark_nodes = 100000;
+
+static void create_nodes(Scene* scene, i32 num_nodes)
+{
+    for (i32 i = 0; i < num_nodes; ++i)
+    {
+        Node* node = scene->CreateChild("Node " + String(i));
+        node->SetPosition(Vector3((float)i, (float)(i % 100), 1.f));
+        node->SetRotation(Quaternion((float)(i % 360), Vector3::UP));
+        node->SetScale((float)(i % 10) * 0.1f + 1.f);
+        node->SetEnabled(i % 7 != 0);
+        node->SetVar("Index", i);
+    }
+}
+
+// Сохраняет атрибуты узла так, как это делалось до типизированных аксессоров: через Variant
+static void save_variant_attributes(const Serializable* serializable, Serializer& dest)
+{
+    const Vector<AttributeInfo>* attributes = serializable->GetAttributes();
+    for (i32 i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (!(attr.mode_ & AM_FILE) || (attr.mode_ & AM_FILEREADONLY) == AM_FILEREADONLY)
+            continue;
+
+        Variant value;
+        serializable->OnGetAttribute(attr, value);
+        dest.WriteVariantData(value);
+    }
+}
+
+static void load_variant_attributes(Serializable* serializable, Deserializer& source)
+{
+    const Vector<AttributeInfo>* attributes = serializable->GetAttributes();
+    for (i32 i = 0; i < attributes->Size(); ++i)
+    {
+        const AttributeInfo& attr = attributes->At(i);
+        if (attr.mode_ & AM_FILE)
+            serializable->OnSetAttribute(attr, source.ReadVariant(attr.type_));
+    }
+}
+
+void test_scene_attribute_accessor()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+
+    // Аксессоры, созданные макросами, типизированы, кроме аксессоров с принудительным типом и неподдерживаемых типов
+    {
+        const Vector<AttributeInfo>* attributes = DV_CONTEXT.GetAttributes(Node::GetTypeStatic());
+        assert(attributes);
+
+        for (const AttributeInfo& attr : *attributes)
+        {
+            if (attr.name_ == "Variables")
+                assert(!attr.accessor_->IsTyped());
+            else
+                assert(attr.accessor_->IsTyped());
+        }
+    }
+
+    // Двоичный формат совпадает с форматом Serializer::WriteVariantData()
+    {
+        SharedPtr<Scene> scene(new Scene());
+        create_nodes(scene, 10);
+
+        for (Node* node : scene->GetChildren())
+        {
+            VectorBuffer typed;
+            VectorBuffer variant;
+            assert(node->Serializable::Save(typed));
+            save_variant_attributes(node, variant);
+            assert(typed.GetBuffer() == variant.GetBuffer());
+
+            SharedPtr<Node> loaded(new Node());
+            typed.Seek(0);
+            assert(loaded->Serializable::Load(typed));
+            assert(typed.IsEof());
+            assert(loaded->GetName() == node->GetName());
+            assert(loaded->GetPosition() == node->GetPosition());
+            assert(loaded->GetRotation() == node->GetRotation());
+            assert(loaded->GetScale() == node->GetScale());
+            assert(loaded->IsEnabled() == node->IsEnabled());
+            assert(loaded->GetVar("Index") == node->GetVar("Index"));
+        }
+    }
+
+    // Сравнение для сетевой репликации замечает изменения без чтения значения в Variant
+    {
+        SharedPtr<Scene> scene(new Scene());
+        Node* node = scene->CreateChild("Name");
+        node->PrepareNetworkUpdate();
+
+        const Vector<AttributeInfo>* attributes = node->GetNetworkAttributes();
+        i32 name_index = NINDEX;
+        for (i32 i = 0; i < attributes->Size(); ++i)
+        {
+            if (attributes->At(i).name_ == String("Name"))
+                name_index = i;
+        }
+        assert(name_index != NINDEX);
+
+        NetworkState* state = node->GetNetworkState();
+        assert(state->previousValues_[name_index] == String("Name"));
+        assert(attributes->At(name_index).accessor_->Equals(node, state->previousValues_[name_index]));
+
+        node->SetName("Other");
+        assert(!attributes->At(name_index).accessor_->Equals(node, state->previousValues_[name_index]));
+        node->PrepareNetworkUpdate();
+        assert(state->previousValues_[name_index] == String("Other"));
+        assert(state->currentValues_[name_index] == String("Other"));
+    }
+
+    // Типизированный доступ разрешается классом явно и не наследуется
+    {
+        HookTestComponent::RegisterObject();
+
+        SharedPtr<Node> node(new Node());
+        SharedPtr<DerivedTestNode> derived_node(new DerivedTestNode());
+        SharedPtr<HookTestComponent> component(new HookTestComponent());
+        assert(node->HasTypedAttributeAccess());
+        assert(!derived_node->HasTypedAttributeAccess());
+        assert(!component->HasTypedAttributeAccess());
+
+        // Переопределённые OnSetAttribute() и OnGetAttribute() вызываются, хотя аксессор типизирован
+        component->speed = 2.f;
+        VectorBuffer buffer;
+        assert(component->Serializable::Save(buffer));
+        assert(component->num_gets == 1);
+
+        SharedPtr<HookTestComponent> loaded(new HookTestComponent());
+        buffer.Seek(0);
+        assert(loaded->Serializable::Load(buffer));
+        assert(loaded->num_sets == 1);
+        assert(loaded->speed == 2.f);
+
+        component->PrepareNetworkUpdate();
+        component->PrepareNetworkUpdate();
+        assert(component->num_gets == 3);
+
+        DV_CONTEXT.RemoveAllAttributes<HookTestComponent>();
+    }
+
+    // Замер производительности. Без замеров проверяется только совпадение результатов
+    const i32 num_nodes = benchmarks_enabled() ? num_benchmark_nodes : 1000;
+    SharedPtr<Scene> scene(new Scene());
+    create_nodes(scene, num_nodes);
+    const Vector<SharedPtr<Node>>& nodes = scene->GetChildren();
+
+    VectorBuffer variant_buffer;
+    auto start_time = std::chrono::steady_clock::now();
+    for (Node* node : nodes)
+        save_variant_attributes(node, variant_buffer);
+    i64 variant_save_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    VectorBuffer typed_buffer;
+    start_time = std::chrono::steady_clock::now();
+    for (Node* node : nodes)
+        node->Serializable::Save(typed_buffer);
+    i64 typed_save_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    assert(typed_buffer.GetBuffer() == variant_buffer.GetBuffer());
+
+    variant_buffer.Seek(0);
+    start_time = std::chrono::steady_clock::now();
+    for (Node* node : nodes)
+        load_variant_attributes(node, variant_buffer);
+    i64 variant_load_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    typed_buffer.Seek(0);
+    start_time = std::chrono::steady_clock::now();
+    for (Node* node : nodes)
+        node->Serializable::Load(typed_buffer);
+    i64 typed_load_usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+
+    if (benchmarks_enabled())
+    {
+        std::cout << "Attribute serialization (" << num_nodes << " nodes): save variant " << variant_save_usec
+                  << " us, typed " << typed_save_usec << " us; load variant " << variant_load_usec << " us, typed "
+                  << typed_load_usec << " us" << std::endl;
+    }
+}
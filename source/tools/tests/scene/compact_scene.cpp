@@ -0,0 +1,169 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+#include "scene_utils.h"
+
+#include <dviglo/containers/allocator.h>
+#include <dviglo/io/file.h>
+#include <dviglo/io/file_system.h>
+#include <dviglo/io/vector_buffer.h>
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+static constexpr i32 num_benchmark_nodes = 20000;
+
+struct LoadResult
+{
+    i64 usec;
+    i64 allocations;
+};
+
+// Загружает сцену из файла и возвращает время загрузки и число выделений памяти контейнерами
+static LoadResult benchmark_load(const String& file_name, const Scene* reference)
+{
+    SharedPtr<Scene> scene(new Scene());
+    i64 num_allocations = GetNumContainerAllocations();
+    auto start_time = std::chrono::steady_clock::now();
+
+    bool success;
+    String extension = GetExtension(file_name);
+    if (extension == ".cscn")
+    {
+        success = scene->LoadCompact(file_name);
+    }
+    else
+    {
+        File file(file_name);
+        if (extension == ".xml")
+            success = scene->LoadXML(file);
+        else if (extension == ".json")
+            success = scene->LoadJSON(file);
+        else
+            success = scene->Load(file);
+    }
+
+    LoadResult result;
+    result.usec = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count();
+    result.allocations = GetNumContainerAllocations() - num_allocations;
+
+    // Текстовые форматы округляют числа с плавающей точкой, поэтому для них проверяется только иерархия
+    assert(success);
+    if (extension == ".xml" || extension == ".json")
+        assert(scene->GetNumChildren(true) == reference->GetNumChildren(true) - 1);
+    else
+        assert(equal_nodes(reference, scene));
+    return result;
+}
+
+void test_scene_compact_scene()
+{
+    register_scene_test_objects();
+
+    // Загрузка из памяти восстанавливает идентификаторы, атрибуты и иерархию
+    {
+        SharedPtr<Scene> scene(new Scene());
+        create_test_scene(scene, 1000);
+
+        VectorBuffer buffer;
+        assert(scene->SaveCompact(buffer));
+
+        SharedPtr<Scene> loaded(new Scene());
+        loaded->CreateChild("Removed on load");
+        assert(loaded->LoadCompact(buffer.GetData(), buffer.GetSize()));
+        assert(equal_nodes(scene, loaded));
+        assert(loaded->GetTimeScale() == 0.5f);
+
+        // Повреждённые данные отклоняются
+        Vector<byte> corrupt = buffer.GetBuffer();
+        corrupt[4] = (byte)99;
+        assert(!loaded->LoadCompact(corrupt.Buffer(), corrupt.Size()));
+        assert(!loaded->LoadCompact(buffer.GetData(), 16));
+
+        // Ошибки в таблицах обнаруживаются до очистки сцены, поэтому сцена остаётся прежней.
+        // Смещения полей соответствуют CompactSceneHeader, CompactType, CompactNode и CompactComponent
+        auto read_u32 = [](const Vector<byte>& data, i32 offset)
+        {
+            u32 value;
+            memcpy(&value, &data[offset], sizeof value);
+            return value;
+        };
+        auto write_u32 = [](Vector<byte>& data, i32 offset, u32 value)
+        {
+            memcpy(&data[offset], &value, sizeof value);
+        };
+
+        const Vector<byte>& valid = buffer.GetBuffer();
+        u32 num_nodes = read_u32(valid, 16);
+        i32 types_offset = (i32)read_u32(valid, 24);
+        i32 nodes_offset = (i32)read_u32(valid, 32);
+        i32 components_offset = (i32)read_u32(valid, 36);
+
+        // Последний узел ссылается на себя как на родителя
+        corrupt = valid;
+        write_u32(corrupt, nodes_offset + (i32)(num_nodes - 1) * 24 + 4, num_nodes - 1);
+        assert(!loaded->LoadCompact(corrupt.Buffer(), corrupt.Size()));
+        assert(equal_nodes(scene, loaded));
+
+        // Два компонента одного класса занимают одну строку
+        corrupt = valid;
+        write_u32(corrupt, components_offset + 12 + 8, read_u32(valid, components_offset + 8));
+        assert(!loaded->LoadCompact(corrupt.Buffer(), corrupt.Size()));
+        assert(equal_nodes(scene, loaded));
+
+        // Строк больше, чем объектов
+        corrupt = valid;
+        write_u32(corrupt, types_offset + 4, M_MAX_UNSIGNED);
+        assert(!loaded->LoadCompact(corrupt.Buffer(), corrupt.Size()));
+        assert(equal_nodes(scene, loaded));
+    }
+
+    // Замер производительности: время загрузки и число выделений памяти для всех форматов.
+    // Без замеров проверяется только загрузка каждого формата
+    const i32 num_nodes = benchmarks_enabled() ? num_benchmark_nodes : 1000;
+    SharedPtr<Scene> scene(new Scene());
+    create_test_scene(scene, num_nodes);
+
+    String dir = DV_FILE_SYSTEM.GetTemporaryDir();
+    const char* extensions[] = {".bin", ".xml", ".json", ".cscn"};
+    if (benchmarks_enabled())
+        std::cout << "Scene load (" << num_nodes << " nodes):";
+
+    for (const char* extension : extensions)
+    {
+        String file_name = dir + "dviglo_test_compact_scene" + extension;
+        {
+            File file(file_name, FILE_WRITE);
+            assert(file.IsOpen());
+            if (String(extension) == ".cscn")
+                assert(scene->SaveCompact(file));
+            else if (String(extension) == ".xml")
+                assert(scene->SaveXML(file));
+            else if (String(extension) == ".json")
+                assert(scene->SaveJSON(file));
+            else
+                assert(scene->Save(file));
+        }
+
+        i64 file_size = File(file_name).GetSize();
+        LoadResult result = benchmark_load(file_name, scene);
+        DV_FILE_SYSTEM.Delete(file_name);
+
+        if (benchmarks_enabled())
+        {
+            std::cout << " " << extension << " " << result.usec << " us, " << result.allocations << " allocations, "
+                      << file_size << " bytes;";
+        }
+    }
+
+    if (benchmarks_enabled())
+        std::cout << std::endl;
+}
@@ -0,0 +1,246 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/core/context.h>
+#include <dviglo/physics/physics_world.h>
+#include <dviglo/scene/scene.h>
+#include <dviglo/scene/scene_events.h>
+
+#include <chrono>
+#include <iostream>
+#include <type_traits>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+// Считает вызовы функций обновления
+class CountingLogic : public LogicComponent
+{
+    DV_OBJECT(CountingLogic, LogicComponent);
+
+public:
+    void DelayedStart() override
+    {
+        // Отложенный старт вызывается до первого обновления
+        assert(!num_updates && !num_fixed_updates);
+        ++num_delayed_starts;
+    }
+
+    void Update(float timeStep) override
+    {
+        ++num_updates;
+
+        if (remove_in_update)
+        {
+            remove_in_update->Remove();
+            remove_in_update = nullptr;
+        }
+
+        if (create_in_update)
+        {
+            create_in_update = false;
+            GetNode()->CreateComponent<CountingLogic>();
+        }
+    }
+
+    void PostUpdate(float timeStep) override { ++num_post_updates; }
+    void FixedUpdate(float timeStep) override { ++num_fixed_updates; }
+    void FixedPostUpdate(float timeStep) override { ++num_fixed_post_updates; }
+
+    i32 num_delayed_starts = 0;
+    i32 num_updates = 0;
+    i32 num_post_updates = 0;
+    i32 num_fixed_updates = 0;
+    i32 num_fixed_post_updates = 0;
+    Component* remove_in_update = nullptr;
+    bool create_in_update = false;
+};
+
+// Вращает свой узел. Может обновляться в рабочих потоках
+class RotatingLogic : public LogicComponent
+{
+    DV_OBJECT(RotatingLogic, LogicComponent);
+
+public:
+    RotatingLogic()
+    {
+        SetUpdateEventMask(LogicComponentEvents::Update);
+    }
+
+    void Update(float timeStep) override
+    {
+        node_->Rotate(Quaternion(timeStep * 90.f, Vector3::UP));
+        ++num_updates;
+    }
+
+    i32 num_updates = 0;
+};
+
+// Обновление через подписку на событие, как это делал LogicComponent раньше
+class EventLogic : public Component
+{
+    DV_OBJECT(EventLogic, Component);
+
+protected:
+    void OnSceneSet(Scene* scene) override
+    {
+        if (scene)
+            SubscribeToEvent(scene, E_SCENEUPDATE, DV_HANDLER(EventLogic, HandleSceneUpdate));
+        else
+            UnsubscribeFromEvent(E_SCENEUPDATE);
+    }
+
+private:
+    void HandleSceneUpdate(StringHash eventType, VariantMap& eventData)
+    {
+        using namespace SceneUpdate;
+        node_->Rotate(Quaternion(eventData[P_TIMESTEP].GetFloat() * 90.f, Vector3::UP));
+    }
+};
+
+} // namespace
+
+static constexpr i32 num_benchmark_components = 50000;
+static constexpr i32 num_benchmark_frames = 10;
+
+template <class T>
+static i64 benchmark(bool thread_safe)
+{
+    SharedPtr<Scene> scene(new Scene());
+    for (i32 i = 0; i < num_benchmark_components; ++i)
+    {
+        T* component = scene->CreateChild()->CreateComponent<T>();
+        if constexpr (std::is_base_of_v<LogicComponent, T>)
+            component->SetThreadSafeUpdate(thread_safe);
+    }
+
+    // Первое обновление вызывает DelayedStart()
+    scene->Update(0.01f);
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 i = 0; i < num_benchmark_frames; ++i)
+        scene->Update(0.01f);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count()
+           / num_benchmark_frames;
+}
+
+void test_scene_logic_component()
+{
+    DV_CONTEXT.RegisterFactory<CountingLogic>();
+    DV_CONTEXT.RegisterFactory<RotatingLogic>();
+    DV_CONTEXT.RegisterFactory<EventLogic>();
+
+    {
+        SharedPtr<Scene> scene(new Scene());
+        Node* node = scene->CreateChild();
+        CountingLogic* all = node->CreateComponent<CountingLogic>();
+        CountingLogic* none = node->CreateComponent<CountingLogic>();
+        none->SetUpdateEventMask(LogicComponentEvents::None);
+        CountingLogic* disabled = node->CreateComponent<CountingLogic>();
+        disabled->SetEnabled(false);
+        assert(scene->GetNumLogicComponents(LogicComponentEvents::Update) == 2);
+        assert(scene->GetNumLogicComponents(LogicComponentEvents::PostUpdate) == 1);
+
+        scene->Update(0.01f);
+        scene->Update(0.01f);
+        assert(all->num_delayed_starts == 1 && all->num_updates == 2 && all->num_post_updates == 2);
+        assert(none->num_delayed_starts == 1 && none->num_updates == 0 && none->num_post_updates == 0);
+        assert(disabled->num_delayed_starts == 0 && disabled->num_updates == 0);
+
+        // После отложенного старта компонент без событий удаляется из списков
+        assert(scene->GetNumLogicComponents(LogicComponentEvents::Update) == 1);
+
+        disabled->SetEnabled(true);
+        node->SetEnabled(false);
+        scene->Update(0.01f);
+        assert(all->num_updates == 2 && disabled->num_updates == 0);
+        node->SetEnabled(true);
+        scene->Update(0.01f);
+        assert(all->num_updates == 3 && disabled->num_delayed_starts == 1 && disabled->num_updates == 1);
+
+        // Удаление и создание компонентов во время обновления
+        CountingLogic* victim = node->CreateComponent<CountingLogic>();
+        CountingLogic* killer = node->CreateComponent<CountingLogic>();
+        scene->Update(0.01f);
+        assert(victim->num_updates == 1);
+        killer->remove_in_update = victim;
+        killer->create_in_update = true;
+        i32 num_components = node->GetNumComponents();
+        scene->Update(0.01f);
+        assert(node->GetNumComponents() == num_components);
+        assert(scene->GetNumLogicComponents(LogicComponentEvents::Update) == num_components - 1);
+
+        // Компонент, созданный во время обновления, обновляется в том же кадре
+        CountingLogic* created = static_cast<CountingLogic*>(node->GetComponents().Back().Get());
+        assert(created->num_delayed_starts == 1 && created->num_updates == 1);
+
+        // Перенос узла в другую сцену
+        SharedPtr<Scene> other_scene(new Scene());
+        other_scene->AddChild(node);
+        assert(scene->GetNumLogicComponents(LogicComponentEvents::Update) == 0);
+        assert(other_scene->GetNumLogicComponents(LogicComponentEvents::Update) == num_components - 1);
+        other_scene->Update(0.01f);
+        assert(all->num_updates == 6);
+    }
+
+    // Фиксированное обновление вызывает физический мир сцены
+    {
+        PhysicsWorld::RegisterObject();
+
+        SharedPtr<Scene> scene(new Scene());
+        CountingLogic* logic = scene->CreateChild()->CreateComponent<CountingLogic>();
+        scene->Update(0.01f);
+        assert(logic->num_fixed_updates == 0);
+
+        // Физический мир может быть создан после компонента
+        PhysicsWorld* world = scene->CreateComponent<PhysicsWorld>();
+        world->SetFps(100);
+        scene->Update(0.01f);
+        assert(logic->num_fixed_updates >= 1 && logic->num_fixed_post_updates == logic->num_fixed_updates);
+    }
+
+    // Потокобезопасные компоненты
+    {
+        SharedPtr<Scene> scene(new Scene());
+        Vector<RotatingLogic*> components;
+        for (i32 i = 0; i < 1000; ++i)
+        {
+            RotatingLogic* component = scene->CreateChild()->CreateComponent<RotatingLogic>();
+            component->SetThreadSafeUpdate(true);
+            components.Push(component);
+        }
+
+        for (i32 i = 0; i < 3; ++i)
+            scene->Update(1.f);
+
+        for (RotatingLogic* component : components)
+        {
+            assert(component->num_updates == 3);
+            assert(component->GetNode()->GetWorldRotation().Equals(Quaternion(270.f, Vector3::UP)));
+        }
+
+        components[0]->SetThreadSafeUpdate(false);
+        components[1]->GetNode()->Remove();
+        assert(scene->GetNumLogicComponents(LogicComponentEvents::Update) == 999);
+        scene->Update(1.f);
+        assert(components[0]->num_updates == 4 && components[2]->num_updates == 4);
+    }
+
+    if (!benchmarks_enabled())
+        return;
+
+    // Замер производительности
+    i64 event_usec = benchmark<EventLogic>(false);
+    i64 batched_usec = benchmark<RotatingLogic>(false);
+    i64 thread_safe_usec = benchmark<RotatingLogic>(true);
+
+    std::cout << "Logic components (" << num_benchmark_components << " components): events " << event_usec << " us, direct calls "
+              << batched_usec << " us, thread-safe " << thread_safe_usec << " us per frame" << std::endl;
+}
@@ -0,0 +1,140 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "scene_utils.h"
+
+#include <dviglo/core/context.h>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+namespace
+{
+
+// Компонент с атрибутами фиксированного и переменного размера и ссылкой на узел
+class SceneTestComponent : public Component
+{
+    DV_OBJECT(SceneTestComponent, Component);
+    DV_TYPED_ATTRIBUTE_ACCESS();
+
+public:
+    static void RegisterObject()
+    {
+        DV_CONTEXT.RegisterFactory<SceneTestComponent>();
+        DV_ATTRIBUTE("Speed", speed, 0.f, AM_DEFAULT);
+        DV_ATTRIBUTE("Count", count, 0, AM_DEFAULT);
+        DV_ATTRIBUTE("Offset", offset, Vector3::ZERO, AM_DEFAULT);
+        DV_ATTRIBUTE("Label", label, String::EMPTY, AM_DEFAULT);
+        DV_ATTRIBUTE("Tags", tags, Variant::emptyStringVector, AM_DEFAULT);
+        DV_ATTRIBUTE("Data", data, Variant::emptyVariantMap, AM_FILE);
+        DV_ATTRIBUTE("Target", target, 0u, AM_DEFAULT | AM_NODEID);
+    }
+
+    float speed = 0.f;
+    i32 count = 0;
+    Vector3 offset = Vector3::ZERO;
+    String label;
+    StringVector tags;
+    VariantMap data;
+    NodeId target = 0;
+};
+
+}
+
+void register_scene_test_objects()
+{
+    if (!DV_CONTEXT.GetAttributes(Node::GetTypeStatic()))
+        Node::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(Scene::GetTypeStatic()))
+        Scene::RegisterObject();
+    if (!DV_CONTEXT.GetAttributes(SceneTestComponent::GetTypeStatic()))
+        SceneTestComponent::RegisterObject();
+}
+
+void create_test_scene(Scene* scene, i32 num_nodes)
+{
+    scene->SetName("Test");
+    scene->SetTimeScale(0.5f);
+
+    Vector<Node*> nodes;
+    for (i32 i = 0; i < num_nodes; ++i)
+    {
+        // Корневых узлов немного, у каждого своя иерархия
+        Node* parent = i < 10 ? scene : nodes[i / 10];
+        Node* node = parent->CreateChild("Node " + String(i % 100), i % 5 ? REPLICATED : LOCAL);
+        nodes.Push(node);
+        node->SetPosition(Vector3((float)i, (float)(i % 10), 0.f));
+        node->SetRotation(Quaternion((float)(i % 360), Vector3::UP));
+        node->SetEnabled(i % 7 != 0);
+
+        if (i % 3 == 0)
+            node->AddTag("Tag " + String(i % 4));
+        if (i % 11 == 0)
+            node->SetVar("Index", i);
+
+        auto* component = node->CreateComponent<SceneTestComponent>();
+        component->speed = (float)i * 0.5f;
+        component->count = i;
+        component->offset = Vector3(1.f, (float)i, 2.f);
+        component->label = "Label " + String(i % 50);
+        if (i % 2)
+            component->tags.Push("Tag");
+        if (i % 13 == 0)
+            component->data["Value"] = (float)i;
+        component->target = nodes[i / 2]->GetID();
+    }
+
+    // Временные узлы и компоненты не сохраняются
+    scene->CreateTemporaryChild("Temporary");
+}
+
+static bool equal_attributes(const Serializable* lhs, const Serializable* rhs)
+{
+    if (lhs->GetType() != rhs->GetType() || lhs->GetNumAttributes() != rhs->GetNumAttributes())
+        return false;
+
+    const Vector<AttributeInfo>* attributes = lhs->GetAttributes();
+    for (i32 i = 0; i < attributes->Size(); ++i)
+    {
+        if ((attributes->At(i).mode_ & AM_FILE) && lhs->GetAttribute(i) != rhs->GetAttribute(i))
+            return false;
+    }
+
+    return true;
+}
+
+bool equal_nodes(const Node* lhs, const Node* rhs)
+{
+    if (lhs->GetID() != rhs->GetID() || !equal_attributes(lhs, rhs) || lhs->GetNumComponents() != rhs->GetNumComponents())
+        return false;
+
+    for (i32 i = 0; i < lhs->GetNumComponents(); ++i)
+    {
+        const Component* lhs_component = lhs->GetComponents()[i];
+        const Component* rhs_component = rhs->GetComponents()[i];
+        if (lhs_component->GetID() != rhs_component->GetID() || !equal_attributes(lhs_component, rhs_component))
+            return false;
+    }
+
+    Vector<Node*> lhs_children;
+    Vector<Node*> rhs_children;
+    for (Node* child : lhs->GetChildren())
+    {
+        if (!child->IsTemporary())
+            lhs_children.Push(child);
+    }
+    for (Node* child : rhs->GetChildren())
+        rhs_children.Push(child);
+
+    if (lhs_children.Size() != rhs_children.Size())
+        return false;
+
+    for (i32 i = 0; i < lhs_children.Size(); ++i)
+    {
+        if (!equal_nodes(lhs_children[i], rhs_children[i]))
+            return false;
+    }
+
+    return true;
+}
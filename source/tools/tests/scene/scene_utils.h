@@ -0,0 +1,18 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#pragma once
+
+#include <dviglo/scene/scene.h>
+
+// Общие функции тестов загрузки и сохранения сцен
+
+// Регистрирует узел, сцену и компонент, который создаёт create_test_scene()
+void register_scene_test_objects();
+
+// Заполняет сцену иерархией узлов с компонентами, атрибуты которых имеют фиксированный и переменный размер
+// и ссылаются на другие узлы. Временный узел сцены не сохраняется
+void create_test_scene(dviglo::Scene* scene, dviglo::i32 num_nodes);
+
+// Возвращает, совпадают ли идентификаторы, сохраняемые атрибуты и иерархия узлов. Временные узлы lhs пропускаются
+bool equal_nodes(const dviglo::Node* lhs, const dviglo::Node* rhs);
@@ -0,0 +1,177 @@
+// Copyright (c) 2022-2023 the Dviglo project
+// License: MIT
+
+#include "../force_assert.h"
+#include "../benchmarks.h"
+
+#include <dviglo/scene/scene.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include <dviglo/common/debug_new.h>
+
+using namespace dviglo;
+
+// Создаёт одинаковую иерархию в двух сценах. Каждый корень имеет поддерево из nodes_per_root узлов
+static void create_hierarchy(Scene* scene, Vector<Node*>& nodes, i32 num_roots, i32 nodes_per_root, u32 seed)
+{
+    std::mt19937 random(seed);
+
+    for (i32 i = 0; i < num_roots; ++i)
+    {
+        i32 first = nodes.Size();
+        nodes.Push(scene->CreateChild());
+
+        // Родитель выбирается среди последних узлов, поэтому иерархия получается глубокой
+        for (i32 j = 1; j < nodes_per_root; ++j)
+        {
+            i32 last = nodes.Size() - 1;
+            i32 parent = Max(first, last - (i32)(random() % 8));
+            nodes.Push(nodes[parent]->CreateChild());
+        }
+    }
+
+    for (i32 i = 0; i < nodes.Size(); ++i)
+    {
+        nodes[i]->SetPosition(Vector3((float)(random() % 100) * 0.1f, (float)(random() % 100) * 0.1f, 1.f));
+        nodes[i]->SetRotation(Quaternion((float)(random() % 360), Vector3::UP));
+        nodes[i]->SetScale((float)(random() % 10) * 0.01f + 0.95f);
+    }
+}
+
+static bool equal_transforms(const Vector<Node*>& nodes, const Vector<Node*>& reference)
+{
+    for (i32 i = 0; i < nodes.Size(); ++i)
+    {
+        if (!nodes[i]->GetWorldTransform().Equals(reference[i]->GetWorldTransform())
+            || !nodes[i]->GetWorldRotation().Equals(reference[i]->GetWorldRotation()))
+            return false;
+    }
+
+    return true;
+}
+
+static constexpr i32 num_benchmark_roots = 1000;
+static constexpr i32 num_benchmark_nodes_per_root = 100;
+static constexpr i32 num_benchmark_frames = 10;
+
+// Двигает часть узлов и читает мировые трансформы всех узлов, как это делают компоненты при отрисовке
+static i64 benchmark(bool transform_update, i32 move_step)
+{
+    SharedPtr<Scene> scene(new Scene());
+    scene->SetTransformUpdateEnabled(transform_update);
+    Vector<Node*> nodes;
+    create_hierarchy(scene, nodes, num_benchmark_roots, num_benchmark_nodes_per_root, 789);
+    scene->UpdateTransforms();
+
+    float checksum = 0.f;
+    auto start_time = std::chrono::steady_clock::now();
+    for (i32 frame = 0; frame < num_benchmark_frames; ++frame)
+    {
+        for (i32 i = frame % move_step; i < nodes.Size(); i += move_step)
+            nodes[i]->Translate(Vector3(0.f, 0.01f, 0.f));
+
+        scene->UpdateTransforms();
+
+        for (Node* node : nodes)
+            checksum += node->GetWorldTransform().m03_;
+    }
+
+    assert(checksum != 0.f);
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start_time).count()
+           / num_benchmark_frames;
+}
+
+void test_scene_transform_update()
+{
+    // Результат совпадает с ленивым обновлением при перемещениях, переносах и удалениях узлов
+    {
+        SharedPtr<Scene> scene(new Scene());
+        SharedPtr<Scene> reference_scene(new Scene());
+        scene->SetTransformUpdateEnabled(true);
+        assert(scene->IsTransformUpdateEnabled() && !reference_scene->IsTransformUpdateEnabled());
+
+        Vector<Node*> nodes;
+        Vector<Node*> reference;
+        create_hierarchy(scene, nodes, 20, 300, 123);
+        create_hierarchy(reference_scene, reference, 20, 300, 123);
+
+        scene->UpdateTransforms();
+        assert(equal_transforms(nodes, reference));
+
+        std::mt19937 random(321);
+        for (i32 frame = 0; frame < 20; ++frame)
+        {
+            for (i32 i = 0; i < 50; ++i)
+            {
+                i32 index = (i32)(random() % nodes.Size());
+                Vector3 delta((float)(random() % 10) * 0.1f, 0.f, 0.f);
+                nodes[index]->Translate(delta);
+                reference[index]->Translate(delta);
+                nodes[index]->Rotate(Quaternion(10.f, Vector3::FORWARD));
+                reference[index]->Rotate(Quaternion(10.f, Vector3::FORWARD));
+            }
+
+            // Перенос узла к другому родителю в той же сцене
+            i32 child = (i32)(random() % nodes.Size());
+            i32 parent = (i32)(random() % nodes.Size());
+            if (!nodes[parent]->IsChildOf(nodes[child]) && parent != child)
+            {
+                nodes[child]->SetParent(nodes[parent]);
+                reference[child]->SetParent(reference[parent]);
+            }
+
+            // Узлы, прочитанные до обновления, уже имеют правильный мировой трансформ
+            if (frame % 2)
+                assert(nodes[child]->GetWorldTransform().Equals(reference[child]->GetWorldTransform()));
+
+            scene->UpdateTransforms();
+            for (Node* node : nodes)
+                assert(!node->IsDirty());
+            assert(equal_transforms(nodes, reference));
+        }
+
+        // Удаление поддерева
+        Node* removed = nodes[0]->GetChildren()[0];
+        Node* reference_removed = reference[0]->GetChildren()[0];
+        Vector<Node*> removed_nodes;
+        removed->GetChildren(removed_nodes, true);
+        removed_nodes.Push(removed);
+        for (i32 i = nodes.Size() - 1; i >= 0; --i)
+        {
+            if (removed_nodes.Contains(nodes[i]))
+            {
+                nodes.Erase(i);
+                reference.Erase(i);
+            }
+        }
+
+        removed->Remove();
+        reference_removed->Remove();
+        nodes[0]->Translate(Vector3::ONE);
+        reference[0]->Translate(Vector3::ONE);
+        scene->UpdateTransforms();
+        assert(equal_transforms(nodes, reference));
+
+        // Отключение возвращает ленивое обновление
+        scene->SetTransformUpdateEnabled(false);
+        nodes[1]->Translate(Vector3::ONE);
+        reference[1]->Translate(Vector3::ONE);
+        assert(equal_transforms(nodes, reference));
+    }
+
+    if (!benchmarks_enabled())
+        return;
+
+    // Замер производительности
+    i64 lazy_all_usec = benchmark(false, 1);
+    i64 linear_all_usec = benchmark(true, 1);
+    i64 lazy_few_usec = benchmark(false, 100);
+    i64 linear_few_usec = benchmark(true, 100);
+
+    std::cout << "Transform update (" << num_benchmark_roots * num_benchmark_nodes_per_root << " nodes): all moved: lazy "
+              << lazy_all_usec << " us, scene-level " << linear_all_usec << " us; 1% moved: lazy " << lazy_few_usec
+              << " us, scene-level " << linear_few_usec << " us per frame" << std::endl;
+}